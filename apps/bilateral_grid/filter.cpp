@@ -27,9 +27,11 @@ int main(int argc, char **argv) {
 
     // Timing code. Timing doesn't include copying the input data to
     // the gpu or copying the output back.
-    double min_t = benchmark(timing_iterations, 10, [&]() {
+    BenchmarkConfig config;
+    config.min_samples = timing_iterations;
+    double min_t = benchmark("bilateral_grid", [&]() {
         bilateral_grid(atof(argv[3]), input, output);
-    });
+    }, config);
     printf("Time: %gms\n", min_t * 1e3);
 
     save_image(output, argv[2]);
@@ -0,0 +1,78 @@
+#include "Halide.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Halide;
+
+// Searches for a schedule for the blur in halide_blur.cpp that suits
+// this machine, and prints it as C++. Usage:
+//   ./autotune_blur [grid|random|evolutionary] [max_candidates]
+int main(int argc, char **argv) {
+    ImageParam input(UInt(16), 2);
+    Func blur_x("blur_x"), blur_y("blur_y");
+    Var x("x"), y("y"), xi("xi"), yi("yi");
+
+    // The algorithm
+    blur_x(x, y) = (input(x, y) + input(x+1, y) + input(x+2, y))/3;
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y+1) + blur_x(x, y+2))/3;
+
+    // The space of schedules to search. The hand-written schedule in
+    // halide_blur.cpp is rows=8 vec=8 blur_x=sliding.
+    Autotuner tuner(blur_y, [&](const AutotuneConfig &c) {
+        blur_y.split(y, y, yi, c["rows"]).parallel(y).vectorize(x, c["vec"]);
+        switch (c["blur_x"]) {
+        case 0:
+            // Inline
+            break;
+        case 1:
+            blur_x.compute_root().parallel(y).vectorize(x, c["vec"]);
+            break;
+        case 2:
+            blur_x.compute_at(blur_y, y).vectorize(x, c["vec"]);
+            break;
+        case 3:
+            blur_x.store_at(blur_y, y).compute_at(blur_y, yi).vectorize(x, c["vec"]);
+            break;
+        }
+    });
+    tuner.add_knob("rows", {2, 4, 8, 16, 32, 64})
+        .add_knob("vec", {8, 16, 32})
+        .add_choice("blur_x", {"inline", "root", "strip", "sliding"});
+
+    AutotuneOptions options;
+    if (argc > 1) {
+        if (!strcmp(argv[1], "grid")) {
+            options.strategy = AutotuneStrategy::Grid;
+        } else if (!strcmp(argv[1], "random")) {
+            options.strategy = AutotuneStrategy::Random;
+        } else if (!strcmp(argv[1], "evolutionary")) {
+            options.strategy = AutotuneStrategy::Evolutionary;
+        } else {
+            fprintf(stderr, "Unknown search strategy: %s\n", argv[1]);
+            return -1;
+        }
+    }
+    if (argc > 2) {
+        options.max_candidates = atoi(argv[2]);
+    }
+
+    // Tune on an input the same size as the one in test.cpp.
+    Image<uint16_t> in(6408, 4802);
+    for (int y = 0; y < in.height(); y++) {
+        for (int x = 0; x < in.width(); x++) {
+            in(x, y) = rand() & 0xfff;
+        }
+    }
+    input.set(in);
+    Image<uint16_t> out(in.width() - 8, in.height() - 2);
+
+    AutotuneResult r = tuner.tune(out, options);
+
+    printf("Tried %d configurations. Best: %s (%f ms)\n\n%s",
+           (int)r.candidates.size(), tuner.describe(r.best).c_str(),
+           r.best_time * 1000, r.schedule_source.c_str());
+
+    return 0;
+}
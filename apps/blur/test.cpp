@@ -21,7 +21,7 @@ Image<uint16_t> blur(Image<uint16_t> in) {
     Image<uint16_t> tmp(in.width()-8, in.height());
     Image<uint16_t> out(in.width()-8, in.height()-2);
 
-    t = benchmark(10, 1, [&]() {
+    t = benchmark("blur: naive", [&]() {
         for (int y = 0; y < tmp.height(); y++)
             for (int x = 0; x < tmp.width(); x++)
                 tmp(x, y) = (in(x, y) + in(x+1, y) + in(x+2, y))/3;
@@ -38,7 +38,7 @@ Image<uint16_t> blur(Image<uint16_t> in) {
 Image<uint16_t> blur_fast(Image<uint16_t> in) {
     Image<uint16_t> out(in.width()-8, in.height()-2);
 
-    t = benchmark(10, 1, [&]() {
+    t = benchmark("blur: fast", [&]() {
         __m128i one_third = _mm_set1_epi16(21846);
 #pragma omp parallel for
         for (int yTile = 0; yTile < out.height(); yTile += 32) {
@@ -127,7 +127,7 @@ Image<uint16_t> blur_fast2(const Image<uint16_t> &in) {
         return out;
     }
 
-    t = benchmark(10, 1, [&]() {
+    t = benchmark("blur: fast2", [&]() {
         // multiplying by 21846 then taking the top 16 bits is equivalent to
         // dividing by three
         __m128i one_third = _mm_set1_epi16(21846);
@@ -181,7 +181,7 @@ Image<uint16_t> blur_halide(Image<uint16_t> in) {
     // Call it once to initialize the halide runtime stuff
     halide_blur(in, out);
 
-    t = benchmark(10, 1, [&]() {
+    t = benchmark("blur: halide", [&]() {
         // Compute the same region of the output as blur_fast (i.e., we're
         // still being sloppy with boundary conditions)
         halide_blur(in, out);
@@ -27,5 +27,21 @@ int main(int argc, char **argv) {
     g.compile_to_header("pipeline_c.h", args, "pipeline_c");
     g.compile_to_object("pipeline_native.o", args, "pipeline_native");
     g.compile_to_c("pipeline_c.cpp", args, "pipeline_c");
+
+    // Also compile a vectorized and parallelized pipeline, so that we
+    // can compare the throughput and thread scaling of the C backend's
+    // output against llvm's.
+    Func blur_x, blur_y;
+    blur_x(x, y) = (input(x, y) + input(x+1, y) + input(x+2, y))/3;
+    blur_y(x, y) = (blur_x(x, y) + blur_x(x, y+1) + blur_x(x, y+2))/3;
+
+    Var xi, yi;
+    blur_y.tile(x, y, xi, yi, 128, 32).vectorize(xi, 8).parallel(y);
+    blur_x.compute_at(blur_y, x).vectorize(x, 8);
+
+    blur_y.compile_to_header("pipeline_vectorized_native.h", args, "pipeline_vectorized_native");
+    blur_y.compile_to_header("pipeline_vectorized_c.h", args, "pipeline_vectorized_c");
+    blur_y.compile_to_object("pipeline_vectorized_native.o", args, "pipeline_vectorized_native");
+    blur_y.compile_to_c("pipeline_vectorized_c.cpp", args, "pipeline_vectorized_c");
     return 0;
 }
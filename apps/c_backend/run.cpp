@@ -2,12 +2,17 @@
 #include <cstdio>
 #include <cstdlib>
 
+#include "benchmark.h"
 #include "halide_image.h"
 #include "pipeline_c.h"
 #include "pipeline_native.h"
+#include "pipeline_vectorized_c.h"
+#include "pipeline_vectorized_native.h"
 
 using namespace Halide::Tools;
 
+extern "C" int halide_set_num_threads(int n);
+
 extern "C" int an_extern_func(int x, int y) {
     return x + y;
 }
@@ -62,6 +67,45 @@ int main(int argc, char **argv) {
         }
     }
 
+    // Check the vectorized pipeline matches too, and compare the
+    // throughput of the two backends on it as the number of threads
+    // in Halide's thread pool grows.
+    Image<uint16_t> big_in(1922, 1986);
+    for (int y = 0; y < big_in.height(); y++) {
+        for (int x = 0; x < big_in.width(); x++) {
+            big_in(x, y) = (uint16_t)rand();
+        }
+    }
+
+    Image<uint16_t> vec_native(1920, 1984);
+    Image<uint16_t> vec_c(1920, 1984);
+
+    pipeline_vectorized_native(big_in, vec_native);
+
+    pipeline_vectorized_c(big_in, vec_c);
+
+    for (int y = 0; y < vec_native.height(); y++) {
+        for (int x = 0; x < vec_native.width(); x++) {
+            if (vec_native(x, y) != vec_c(x, y)) {
+                printf("vec_native(%d, %d) = %d, but vec_c(%d, %d) = %d\n",
+                       x, y, vec_native(x, y),
+                       x, y, vec_c(x, y));
+                return -1;
+            }
+        }
+    }
+
+    double mpix = (vec_native.width() * vec_native.height()) / 1e6;
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        halide_set_num_threads(threads);
+        double t_native = benchmark(10, 10, [&]() { pipeline_vectorized_native(big_in, vec_native); });
+        double t_c = benchmark(10, 10, [&]() { pipeline_vectorized_c(big_in, vec_c); });
+        printf("%d threads: llvm %f ms (%f MP/s), C %f ms (%f MP/s)\n",
+               threads,
+               t_native * 1e3, mpix / t_native,
+               t_c * 1e3, mpix / t_c);
+    }
+
     printf("Success!\n");
     return 0;
 }
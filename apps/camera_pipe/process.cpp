@@ -61,30 +61,32 @@ int main(int argc, char **argv) {
     int whiteLevel = 1023;
 
     double best;
+    BenchmarkConfig config;
+    config.min_samples = timing_iterations;
 
-    best = benchmark(timing_iterations, 1, [&]() {
+    best = benchmark("camera_pipe: halide", [&]() {
         curved(color_temp, gamma, contrast, blackLevel, whiteLevel,
                input, matrix_3200, matrix_7000,
                output);
-    });
+    }, config);
     fprintf(stderr, "Halide:\t%gus\n", best * 1e6);
     fprintf(stderr, "output: %s\n", argv[6]);
     save_image(output, argv[6]);
     fprintf(stderr, "        %d %d\n", output.width(), output.height());
 
     Image<uint8_t> output_c(output.width(), output.height(), output.channels());
-    best = benchmark(timing_iterations, 1, [&]() {
+    best = benchmark("camera_pipe: c++", [&]() {
         FCam::demosaic(input, output_c, color_temp, contrast, true, blackLevel, whiteLevel, gamma);
-    });
+    }, config);
     fprintf(stderr, "C++:\t%gus\n", best * 1e6);
     fprintf(stderr, "output_c: fcam_c.png\n");
     save_image(output_c, "fcam_c.png");
     fprintf(stderr, "        %d %d\n", output_c.width(), output_c.height());
 
     Image<uint8_t> output_asm(output.width(), output.height(), output.channels());
-    best = benchmark(timing_iterations, 1, [&]() {
+    best = benchmark("camera_pipe: asm", [&]() {
         FCam::demosaic_ARM(input, output_asm, color_temp, contrast, true, blackLevel, whiteLevel, gamma);
-    });
+    }, config);
     fprintf(stderr, "ASM:\t%gus\n", best * 1e6);
     fprintf(stderr, "output_asm: fcam_arm.png\n");
     save_image(output_asm, "fcam_arm.png");
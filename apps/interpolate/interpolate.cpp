@@ -14,7 +14,7 @@ using std::vector;
 
 int main(int argc, char **argv) {
     if (argc < 3) {
-        std::cerr << "Usage:\n\t./interpolate in.png out.png\n" << std::endl;
+        std::cerr << "Usage:\n\t./interpolate in.png out.png [autotune]\n" << std::endl;
         return 1;
     }
 
@@ -74,9 +74,16 @@ int main(int argc, char **argv) {
 
     std::cout << "Finished function setup." << std::endl;
 
+    Image<float> in_png = load_image(argv[1]);
+    Image<float> out(in_png.width(), in_png.height(), 3);
+    assert(in_png.channels() == 4);
+    input.set(in_png);
+
     int sched;
     Target target = get_target_from_environment();
-    if (target.has_gpu_feature()) {
+    if (argc > 3 && std::string(argv[3]) == "autotune") {
+        sched = 5;
+    } else if (target.has_gpu_feature()) {
         sched = 4;
     } else {
         sched = 2;
@@ -198,6 +205,55 @@ int main(int argc, char **argv) {
 
         break;
     }
+    case 5:
+    {
+        std::cout << "Autotuned version of the flat schedule with parallelization + vectorization." << std::endl;
+        Autotuner tuner(normalize, [&](const AutotuneConfig &cfg) {
+            for (int l = 1; l < levels-1; ++l) {
+                downsampled[l]
+                    .compute_root()
+                    .parallel(y, cfg["rows"])
+                    .vectorize(x, cfg["vec"]);
+                interpolated[l]
+                    .compute_root()
+                    .parallel(y, cfg["rows"])
+                    .vectorize(x, cfg["vec"]);
+                if (cfg["downx"] == 1) {
+                    downx[l].compute_at(downsampled[l], y).vectorize(x, cfg["vec"]);
+                }
+                if (cfg["upsampledx"] == 1) {
+                    upsampledx[l].compute_at(interpolated[l], y).vectorize(x, cfg["vec"]);
+                }
+            }
+            // Named, so that the printed schedule is readable.
+            Var xi("xi"), yi("yi");
+            normalize
+                .reorder(c, x, y)
+                .bound(c, 0, 3)
+                .unroll(c)
+                .tile(x, y, xi, yi, cfg["tile"], cfg["tile"])
+                .unroll(xi)
+                .unroll(yi)
+                .parallel(y, cfg["rows"])
+                .vectorize(x, cfg["vec"])
+                .bound(x, 0, input.width())
+                .bound(y, 0, input.height());
+        });
+        tuner.add_knob("rows", {2, 4, 8, 16, 32})
+            .add_knob("vec", {4, 8, 16})
+            .add_knob("tile", {1, 2, 4})
+            .add_choice("downx", {"inline", "row"})
+            .add_choice("upsampledx", {"inline", "row"});
+
+        AutotuneOptions options;
+        options.strategy = AutotuneStrategy::Evolutionary;
+        options.max_candidates = 48;
+        options.target = target;
+        AutotuneResult r = tuner.tune(out, options);
+        std::cout << "Best of " << r.candidates.size() << " schedules took "
+                  << r.best_time * 1e3 << " msec:\n" << r.schedule_source << std::endl;
+        break;
+    }
     default:
         assert(0 && "No schedule with this number.");
     }
@@ -205,11 +261,6 @@ int main(int argc, char **argv) {
     // JIT compile the pipeline eagerly, so we don't interfere with timing
     normalize.compile_jit(target);
 
-    Image<float> in_png = load_image(argv[1]);
-    Image<float> out(in_png.width(), in_png.height(), 3);
-    assert(in_png.channels() == 4);
-    input.set(in_png);
-
     std::cout << "Running... " << std::endl;
     double best = benchmark(20, 1, [&]() { normalize.realize(out); });
     std::cout << " took " << best * 1e3 << " msec." << std::endl;
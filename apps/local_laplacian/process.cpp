@@ -23,9 +23,11 @@ int main(int argc, char **argv) {
     int timing = atoi(argv[5]);
 
     // Timing code
-    double best = benchmark(timing, 1, [&]() {
+    BenchmarkConfig config;
+    config.min_samples = timing;
+    double best = benchmark("local_laplacian", [&]() {
         local_laplacian(levels, alpha/(levels-1), beta, input, output);
-    });
+    }, config);
     printf("%gus\n", best * 1e6);
 
 
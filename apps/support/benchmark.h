@@ -1,12 +1,16 @@
 #ifndef BENCHMARK_H
 #define BENCHMARK_H
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 #include <limits>
+#include <string>
+#include <vector>
 
-// Benchmark the operation 'op'. The number of iterations refers to
-// how many times the operation is run for each time measurement, the
-// result is the minimum over a number of samples runs. The result is the
-// amount of time in seconds for one iteration.
+// Get the current time in seconds, from an arbitrary starting point.
 #ifdef _WIN32
 
 union _LARGE_INTEGER;
@@ -14,45 +18,253 @@ typedef union _LARGE_INTEGER LARGE_INTEGER;
 extern "C" int __stdcall QueryPerformanceCounter(LARGE_INTEGER*);
 extern "C" int __stdcall QueryPerformanceFrequency(LARGE_INTEGER*);
 
-template <typename F>
-double benchmark(int samples, int iterations, F op) {
-    int64_t freq;
+inline double benchmark_now() {
+    int64_t freq, t;
     QueryPerformanceFrequency((LARGE_INTEGER*)&freq);
+    QueryPerformanceCounter((LARGE_INTEGER*)&t);
+    return t / static_cast<double>(freq);
+}
 
+#else
+
+#include <chrono>
+
+inline double benchmark_now() {
+    auto t = std::chrono::high_resolution_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count() / 1e9;
+}
+
+#endif
+
+// Benchmark the operation 'op'. The number of iterations refers to
+// how many times the operation is run for each time measurement, the
+// result is the minimum over a number of samples runs. The result is the
+// amount of time in seconds for one iteration.
+template <typename F>
+double benchmark(int samples, int iterations, F op) {
     double best = std::numeric_limits<double>::infinity();
     for (int i = 0; i < samples; i++) {
-        int64_t t1;
-        QueryPerformanceCounter((LARGE_INTEGER*)&t1);
+        double t1 = benchmark_now();
         for (int j = 0; j < iterations; j++) {
             op();
         }
-        int64_t t2;
-        QueryPerformanceCounter((LARGE_INTEGER*)&t2);
-        double dt = (t2 - t1) / static_cast<double>(freq);
+        double t2 = benchmark_now();
+        double dt = t2 - t1;
         if (dt < best) best = dt;
     }
     return best / iterations;
 }
 
-#else
+// Controls for the adaptive version of benchmark below. All times are
+// in seconds.
+struct BenchmarkConfig {
+    // Untimed calls of the operation before sampling starts.
+    int warmup = 1;
 
-#include <chrono>
+    // Each sample runs the operation enough times to take at least
+    // this long, so that short operations aren't swamped by timer
+    // resolution.
+    double min_sample_time = 0.002;
+
+    // At least min_samples samples are always taken. After that,
+    // sampling continues until at least min_time has been spent and
+    // the 95% confidence interval on the median is within 'accuracy'
+    // (as a fraction of the median), or until max_time has been
+    // spent.
+    int min_samples = 7;
+    double min_time = 0.05;
+    double max_time = 2.0;
+    double accuracy = 0.02;
+};
+
+// The statistics gathered by the adaptive version of benchmark. Times
+// are in seconds for one call of the operation.
+struct BenchmarkResult {
+    double min = 0, median = 0, mean = 0, stddev = 0;
+
+    // A 95% confidence interval on the median.
+    double median_low = 0, median_high = 0;
+
+    // The time per call measured by each sample, in the order they
+    // were taken.
+    std::vector<double> samples;
+
+    // How many calls each sample made.
+    uint64_t iterations = 0;
+
+    // Set if the samples are spread widely enough relative to the
+    // median that the machine is probably busy doing something else.
+    bool noisy = false;
+
+    // Set if the last samples were significantly slower or faster
+    // than the first ones, which suggests the CPU frequency changed
+    // during the run (e.g. thermal throttling or a power governor
+    // ramping up).
+    bool drifted = false;
+
+    // Most existing code just wants a single number.
+    operator double() const { return median; }
+};
+
+inline void benchmark_compute_statistics(BenchmarkResult &r) {
+    std::vector<double> sorted = r.samples;
+    std::sort(sorted.begin(), sorted.end());
+    const size_t n = sorted.size();
+    if (n == 0) {
+        return;
+    }
+
+    r.min = sorted[0];
+    r.median = (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+
+    double sum = 0, sum_sq = 0;
+    for (double s : sorted) {
+        sum += s;
+    }
+    r.mean = sum / n;
+    for (double s : sorted) {
+        sum_sq += (s - r.mean) * (s - r.mean);
+    }
+    r.stddev = n > 1 ? std::sqrt(sum_sq / (n - 1)) : 0;
 
+    // A distribution-free confidence interval on the median, using
+    // the normal approximation to the binomial distribution of the
+    // number of samples below it.
+    double half_width = 0.98 * std::sqrt((double)n);
+    int lo = (int)std::floor(n / 2.0 - half_width);
+    int hi = (int)std::ceil(n / 2.0 + half_width);
+    r.median_low = sorted[std::max(lo, 0)];
+    r.median_high = sorted[std::min(hi, (int)n - 1)];
+
+    // The interquartile range of a quiet machine is a few percent of
+    // the median at most.
+    double q1 = sorted[n / 4], q3 = sorted[(3 * n) / 4];
+    r.noisy = (q3 - q1) > 0.1 * r.median;
+
+    // Compare the medians of the first and last thirds of the run.
+    if (n >= 9) {
+        std::vector<double> first(r.samples.begin(), r.samples.begin() + n / 3);
+        std::vector<double> last(r.samples.end() - n / 3, r.samples.end());
+        std::sort(first.begin(), first.end());
+        std::sort(last.begin(), last.end());
+        double a = first[first.size() / 2], b = last[last.size() / 2];
+        r.drifted = std::abs(a - b) > 0.1 * std::min(a, b);
+    }
+}
+
+// Benchmark the operation 'op', adaptively choosing how many times to
+// run it per sample and how many samples to take. See BenchmarkConfig.
 template <typename F>
-double benchmark(int samples, int iterations, F op) {
-    double best = std::numeric_limits<double>::infinity();
-    for (int i = 0; i < samples; i++) {
-        auto t1 = std::chrono::high_resolution_clock::now();
-        for (int j = 0; j < iterations; j++) {
+BenchmarkResult benchmark(F op, const BenchmarkConfig &config = BenchmarkConfig()) {
+    for (int i = 0; i < config.warmup; i++) {
+        op();
+    }
+
+    // Pick the number of iterations per sample, growing it until a
+    // sample takes long enough.
+    BenchmarkResult r;
+    r.iterations = 1;
+    double start = benchmark_now();
+    while (true) {
+        double t1 = benchmark_now();
+        for (uint64_t j = 0; j < r.iterations; j++) {
             op();
         }
-        auto t2 = std::chrono::high_resolution_clock::now();
-        double dt = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() / 1e6;
-        if (dt < best) best = dt;
+        double dt = benchmark_now() - t1;
+        if (dt >= config.min_sample_time || benchmark_now() - start > config.max_time) {
+            r.samples.push_back(dt / r.iterations);
+            break;
+        }
+        // Aim a little past the target so that we rarely need
+        // another round.
+        double scale = dt > 0 ? 1.5 * config.min_sample_time / dt : 2;
+        r.iterations = (uint64_t)std::ceil(r.iterations * std::max(2.0, std::min(scale, 100.0)));
     }
-    return best / iterations;
+
+    while (true) {
+        double t1 = benchmark_now();
+        for (uint64_t j = 0; j < r.iterations; j++) {
+            op();
+        }
+        double t2 = benchmark_now();
+        r.samples.push_back((t2 - t1) / r.iterations);
+
+        double elapsed = t2 - start;
+        if ((int)r.samples.size() < config.min_samples) {
+            continue;
+        }
+        if (elapsed > config.max_time) {
+            break;
+        }
+        if (elapsed >= config.min_time) {
+            benchmark_compute_statistics(r);
+            if (r.median_high - r.median_low <= 2 * config.accuracy * r.median) {
+                break;
+            }
+        }
+    }
+
+    benchmark_compute_statistics(r);
+    return r;
 }
 
+// Record a benchmark result. Prints a warning to stderr if the result
+// looks unreliable, and if the environment variable
+// HL_BENCHMARK_OUTPUT names a file, appends the result to it as a
+// line of JSON. tools/compare_benchmarks.py compares two such files.
+inline void benchmark_report(const std::string &name, const BenchmarkResult &r) {
+    std::string governor;
+#ifdef __linux__
+    // Frequency scaling makes timings unreliable.
+    if (FILE *f = fopen("/sys/devices/system/cpu/cpu0/cpufreq/scaling_governor", "r")) {
+        char buf[64] = {0};
+        if (fgets(buf, sizeof(buf), f)) {
+            governor = buf;
+            governor.erase(governor.find_last_not_of(" \n") + 1);
+        }
+        fclose(f);
+    }
 #endif
 
+    if (r.noisy || r.drifted) {
+        fprintf(stderr, "Warning: benchmark %s %s; its results may be unreliable.\n",
+                name.c_str(), r.noisy ? "was noisy" : "drifted over the run");
+    }
+    if (!governor.empty() && governor != "performance") {
+        fprintf(stderr, "Warning: the CPU frequency governor is \"%s\", not \"performance\".\n",
+                governor.c_str());
+    }
+
+    const char *path = getenv("HL_BENCHMARK_OUTPUT");
+    if (!path || !path[0]) {
+        return;
+    }
+    FILE *f = fopen(path, "a");
+    if (!f) {
+        fprintf(stderr, "Warning: could not open %s to record benchmark %s\n", path, name.c_str());
+        return;
+    }
+    fprintf(f, "{\"name\": \"%s\", \"min\": %g, \"median\": %g, \"mean\": %g, \"stddev\": %g, "
+            "\"median_low\": %g, \"median_high\": %g, \"iterations\": %llu, "
+            "\"noisy\": %s, \"drifted\": %s, \"governor\": \"%s\", \"samples\": [",
+            name.c_str(), r.min, r.median, r.mean, r.stddev, r.median_low, r.median_high,
+            (unsigned long long)r.iterations,
+            r.noisy ? "true" : "false", r.drifted ? "true" : "false", governor.c_str());
+    for (size_t i = 0; i < r.samples.size(); i++) {
+        fprintf(f, "%s%g", i ? ", " : "", r.samples[i]);
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+}
+
+// Benchmark the operation 'op' adaptively, record the result under
+// the given name using benchmark_report, and return the median time
+// in seconds for one call.
+template <typename F>
+double benchmark(const std::string &name, F op, const BenchmarkConfig &config = BenchmarkConfig()) {
+    BenchmarkResult r = benchmark(op, config);
+    benchmark_report(name, r);
+    return r.median;
+}
+
 #endif
@@ -0,0 +1,107 @@
+#!/usr/bin/python3
+"""
+Measures how throughput scales when several Python threads run Halide
+pipelines at the same time. Func.realize and Pipeline.realize release the
+GIL, so the threads run concurrently; the inputs and outputs are numpy
+arrays used in place, without copies.
+
+Each thread owns its Pipeline (running one Pipeline object from several
+threads at once is not supported). The pipelines are scheduled serially, so
+any speedup comes from the Python threads alone.
+"""
+
+from halide import *
+
+import numpy as np
+import os
+import sys
+import threading
+import time
+
+
+def get_blur(input):
+
+    x, y = Var("x"), Var("y")
+
+    blur_x = Func("blur_x")
+    blur_y = Func("blur_y")
+
+    blur_x[x, y] = (input[x, y] + input[x+1, y] + input[x+2, y]) / 3
+    blur_y[x, y] = (blur_x[x, y] + blur_x[x, y+1] + blur_x[x, y+2]) / 3
+
+    xi, yi = Var("xi"), Var("yi")
+    blur_y.tile(x, y, xi, yi, 64, 32).vectorize(xi, 8)
+    blur_x.compute_at(blur_y, x).vectorize(x, 8)
+
+    return blur_y
+
+
+def make_pipeline(input_data):
+
+    input = ImageParam(Float(32), 2, "input")
+    pipeline = Pipeline(get_blur(input))
+    pipeline.compile_jit()
+    input.set(input_data)
+
+    output_data = np.empty((input_data.shape[0] - 2, input_data.shape[1] - 2),
+                           dtype=np.float32, order="F")
+    return pipeline, output_data
+
+
+def run_thread(pipeline, output_data, iterations, results, index):
+
+    start = time.perf_counter()
+    for i in range(iterations):
+        pipeline.realize(output_data)
+    results[index] = time.perf_counter() - start
+
+    return
+
+
+def measure(num_threads, input_data, iterations):
+
+    # Compile up front, so that only the realizes are timed
+    pipelines = [make_pipeline(input_data) for i in range(num_threads)]
+
+    results = [0.0] * num_threads
+    threads = [threading.Thread(target=run_thread,
+                                args=(pipeline, output_data, iterations, results, i))
+               for i, (pipeline, output_data) in enumerate(pipelines)]
+
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+
+    return (num_threads * iterations) / max(results)
+
+
+def main():
+
+    iterations = int(sys.argv[1]) if len(sys.argv) > 1 else 20
+    max_threads = os.cpu_count() or 1
+
+    input_data = np.random.random((1536, 1026)).astype(np.float32)
+    input_data = np.asfortranarray(input_data)
+
+    # Check the result once against numpy
+    pipeline, output = make_pipeline(input_data)
+    pipeline.realize(output)
+    blur_x = (input_data[:-2, :] + input_data[1:-1, :] + input_data[2:, :]) / 3
+    expected = (blur_x[:, :-2] + blur_x[:, 1:-1] + blur_x[:, 2:]) / 3
+    assert np.allclose(output, expected, atol=1e-5)
+
+    print("threads  realizes/s  speedup")
+    base = None
+    num_threads = 1
+    while num_threads <= max_threads:
+        throughput = measure(num_threads, input_data, iterations)
+        base = base or throughput
+        print("%7d  %10.1f  %7.2f" % (num_threads, throughput, throughput / base))
+        num_threads *= 2
+
+    return
+
+
+if __name__ == "__main__":
+    main()
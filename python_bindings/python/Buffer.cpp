@@ -21,6 +21,11 @@ h::Argument buffer_to_argument(h::Buffer &that)
     return that;
 }
 
+void buffer_set_min(h::Buffer &that, int m0, int m1 = 0, int m2 = 0, int m3 = 0)
+{
+    that.set_min(m0, m1, m2, m3);
+}
+
 size_t host_ptr_as_int(h::Buffer &that)
 {
     return reinterpret_cast<size_t>(that.host_ptr());
@@ -188,7 +193,7 @@ void defineBuffer()
             .def("min", &Buffer::min, p::args("self", "dim"),
                  "Get the coordinate in the function that this buffer represents "
                  "that corresponds to the base address of the buffer.")
-            .def("set_min", &Buffer::set_min,
+            .def("set_min", &buffer_set_min,
                  (p::arg("self"), p::arg("m0"), p::arg("m1")=0, p::arg("m2")=0, p::arg("m3")=0),
                  "Set the coordinate in the function that this buffer represents "
                  "that corresponds to the base address of the buffer.")
@@ -12,6 +12,7 @@
 #include "Func_Stage.h"
 #include "Func_VarOrRVar.h"
 #include "Func_gpu.h"
+#include "ReleaseGIL.h"
 
 #include <vector>
 #include <string>
@@ -22,6 +23,7 @@ namespace p = boost::python;
 
 h::Realization func_realize0(h::Func &that, std::vector<int32_t> sizes, const h::Target &target = h::Target())
 {
+    ReleaseGIL release_gil;
     return that.realize(sizes, target);
 }
 
@@ -31,6 +33,7 @@ BOOST_PYTHON_FUNCTION_OVERLOADS( func_realize0_overloads, func_realize0, 2, 3)
 h::Realization func_realize1(h::Func &that, int x_size=0, int y_size=0, int z_size=0, int w_size=0,
                              const h::Target &target = h::Target())
 {
+    ReleaseGIL release_gil;
     return that.realize(x_size, y_size, z_size, w_size, target);
 }
 
@@ -39,6 +42,7 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize1_overloads, func_realize1, 1, 6)
 
 void func_realize2(h::Func &that, h::Realization dst, const h::Target &target = h::Target())
 {
+    ReleaseGIL release_gil;
     that.realize(dst, target);
     return;
 }
@@ -48,6 +52,7 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize2_overloads, func_realize2, 2, 3)
 
 void func_realize3(h::Func &that, h::Buffer dst, const h::Target &target = h::Target())
 {
+    ReleaseGIL release_gil;
     that.realize(dst, target);
     return;
 }
@@ -57,12 +62,14 @@ BOOST_PYTHON_FUNCTION_OVERLOADS(func_realize3_overloads, func_realize3, 2, 3)
 
 void func_compile_jit0(h::Func &that)
 {
+    ReleaseGIL release_gil;
     that.compile_jit();
     return;
 }
 
 void func_compile_jit1(h::Func &that, const h::Target &target = h::get_target_from_environment())
 {
+    ReleaseGIL release_gil;
     that.compile_jit(target);
     return;
 }
@@ -410,7 +417,9 @@ void defineFunc()
                        "Evaluate this function over some rectangular domain and return"
                        "the resulting buffer. The buffer should probably be instantly"
                        "wrapped in an Image class.\n\n" \
-                       "One can use f.realize(Buffer) to realize into an existing buffer."))
+                       "One can use f.realize(Buffer) to realize into an existing buffer.\n\n" \
+                       "The GIL is released while the pipeline is compiled and run, so "
+                       "other Python threads can make progress (or realize other Funcs)."))
             .def("realize", &func_realize0, func_realize0_overloads(
                      p::args("self", "sizes", "target")))
             .def("realize", &func_realize3, func_realize3_overloads(
@@ -419,7 +428,8 @@ void defineFunc()
                      "buffers. If the buffer is also one of the arguments to the "
                      "function, strange things may happen, as the pipeline isn't "
                      "necessarily safe to run in-place. If you pass multiple buffers, "
-                     "they must have matching sizes."))
+                     "they must have matching sizes. dst may be a numpy array, in which "
+                     "case the results are written directly into its memory."))
             .def("realize", &func_realize2, func_realize2_overloads(
                      p::args("self", "dst", "target")));
 
@@ -12,6 +12,7 @@
 #include "IROperator.h"
 #include "Lambda.h"
 #include "Param.h"
+#include "Pipeline.h"
 #include "RDom.h"
 #include "Target.h"
 #include "Tuple.h"
@@ -57,6 +58,7 @@ BOOST_PYTHON_MODULE(halide)
     defineLambda();
     defineOperators();
     defineParam();
+    definePipeline();
     defineRDom();
     defineTarget();
     defineTuple();
@@ -23,10 +23,13 @@
 #include "Type.h"
 #include "Func.h"
 
-#include <vector>
-#include <unordered_map>
-#include <string>
+#include <algorithm>
+#include <cstdlib>
 #include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace h = Halide;
 namespace p = boost::python;
@@ -205,6 +208,12 @@ T image_to_setitem_operator4(h::Image<T> &that, p::tuple &args_passed, T value)
 }
 
 
+template<typename T>
+void image_set_min(h::Image<T> &that, int m0, int m1 = 0, int m2 = 0, int m3 = 0)
+{
+    that.set_min(m0, m1, m2, m3);
+}
+
 template<typename T>
 std::string image_repr(const h::Image<T> &image)
 {
@@ -332,7 +341,7 @@ void defineImage_impl(const std::string suffix, const h::Type type)
                  "Get the min coordinate of a dimension. The top left of the "
                  "image represents this point in a function that was realized "
                  "into this image.")
-            .def("set_min", &Image<T>::set_min,
+            .def("set_min", &image_set_min<T>,
                  (p::arg("self"), p::arg("m0"), p::arg("m1")=0, p::arg("m2")=0, p::arg("m3")=0),
                  "Set the min coordinates of a dimension.")
             ;
@@ -456,8 +465,23 @@ void defineImage_impl(const std::string suffix, const h::Type type)
 
 #ifdef USE_NUMPY
 
-// To be used with care, since return object uses a  C++ pointer to data,
-// use p::with_custodian_and_ward_postcall to link the objects lifetime
+/// Makes a Buffer that points into the array memory, and keeps the array
+/// alive for as long as the Buffer (or anything holding it) exists.
+h::Buffer array_to_buffer(bn::ndarray &array, h::Type t, const buffer_t &raw_buffer,
+                          const std::string &name = "")
+{
+    h::Buffer buffer(t, &raw_buffer, name);
+    // The last reference to the Buffer may be dropped by C++ code that
+    // doesn't hold the GIL, so take it before releasing the array.
+    buffer.set_owner(std::shared_ptr<void>(new p::object(array), [](void *ref) {
+        PyGILState_STATE state = PyGILState_Ensure();
+        delete (p::object *)ref;
+        PyGILState_Release(state);
+    }));
+    return buffer;
+}
+
+// The returned Image points to the array data, and keeps the array alive.
 p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const std::string &name)
 {
     PyObject* obj = NULL;
@@ -465,7 +489,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     if(array.get_dtype() == bn::dtype::get_builtin<boost::uint8_t>())
     {
         h::Type t = h::UInt(8);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<boost::uint8_t> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -474,7 +498,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<boost::uint16_t>())
     {
         h::Type t = h::UInt(16);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<boost::uint16_t> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -483,7 +507,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<boost::uint32_t>())
     {
         h::Type t = h::UInt(32);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<boost::uint32_t> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -492,7 +516,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<boost::int8_t>())
     {
         h::Type t = h::Int(8);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<boost::int8_t> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -501,7 +525,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<boost::int16_t>())
     {
         h::Type t = h::Int(16);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<boost::int16_t> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -510,7 +534,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<boost::int32_t>())
     {
         h::Type t = h::Int(32);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<boost::int32_t> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -519,7 +543,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<float>())
     {
         h::Type t = h::Float(32);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<float> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -528,7 +552,7 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
     else if(array.get_dtype() == bn::dtype::get_builtin<double>())
     {
         h::Type t = h::Float(64);
-        h::Buffer buffer(t, &raw_buffer, name);
+        h::Buffer buffer = array_to_buffer(array, t, raw_buffer, name);
         typedef h::Image<double> image_t;
 
         p::manage_new_object::apply<image_t *>::type converter;
@@ -561,19 +585,16 @@ p::object raw_buffer_to_image(bn::ndarray &array, buffer_t &raw_buffer, const st
 }
 
 
-buffer_t ndarray_to_buffer_t(bn::ndarray &array)
+/// Fills nd_buffer so that it describes the array memory, without copying it.
+/// Dimensions past the fourth are stored in extra_dims, which must outlive nd_buffer.
+void ndarray_to_buffer_t(bn::ndarray &array, halide_nd_buffer_t &nd_buffer,
+                         std::vector<halide_dimension_t> &extra_dims)
 {
-    size_t num_elements = 0;
-    for (size_t i = 0; i < (size_t)array.get_nd(); i += 1)
+    const int dimensions = array.get_nd();
+    size_t num_elements = dimensions > 0 ? 1 : 0;
+    for (int i = 0; i < dimensions; i += 1)
     {
-        if (i == 0)
-        {
-            num_elements = array.shape(i);
-        }
-        else
-        {
-            num_elements *= array.shape(i);
-        }
+        num_elements *= array.shape(i);
     }
 
     if (num_elements == 0)
@@ -581,45 +602,81 @@ buffer_t ndarray_to_buffer_t(bn::ndarray &array)
         throw std::invalid_argument("numpy_to_image recieved an empty array");
     }
 
-    if (array.get_nd() > 4)
+    if (dimensions > HALIDE_BUFFER_MAX_DIMENSIONS)
     {
-        throw std::invalid_argument("numpy_to_image received array with more than 4 dimensions. "
-                                    "Halide only supports 4 or less dimensions");
+        throw std::invalid_argument("numpy_to_image received array with more than " +
+                                    std::to_string(HALIDE_BUFFER_MAX_DIMENSIONS) + " dimensions.");
+    }
+
+    if (!(array.get_flags() & bn::ndarray::ALIGNED))
+    {
+        // Halide generated code assumes elements are naturally aligned
+        throw std::invalid_argument("numpy_to_image received an unaligned array. "
+                                    "Use numpy.require(array, requirements='A') to get an aligned copy.");
     }
 
     // buffer_t initialization based on BufferContents::BufferContents
-    buffer_t raw_buffer;
+    nd_buffer = halide_nd_buffer_t();
+    buffer_t &raw_buffer = nd_buffer.buf;
     raw_buffer.dev = 0;
     raw_buffer.host = reinterpret_cast<boost::uint8_t *>(array.get_data());
     raw_buffer.elem_size = array.get_dtype().get_itemsize(); // in bytes
     raw_buffer.host_dirty = false;
     raw_buffer.dev_dirty = false;
 
-    for (int c=0; c < 4; c += 1)
+    extra_dims.clear();
+    for (int c = 0; c < std::max(dimensions, 4); c += 1)
     {
-        if (c < array.get_nd())
+        halide_dimension_t dim = {0, 0, 0};
+        if (c < dimensions)
+        {
+            // numpy counts stride in bytes, while Halide counts in number of elements.
+            // Strides may be negative (reversed views) or zero (broadcast views).
+            const Py_intptr_t stride = array.strides(c);
+            if ((stride % raw_buffer.elem_size) != 0)
+            {
+                throw std::invalid_argument("numpy_to_image received an array whose strides "
+                                            "are not a multiple of its element size.");
+            }
+            if (array.shape(c) > std::numeric_limits<int32_t>::max() ||
+                std::abs(stride / raw_buffer.elem_size) > std::numeric_limits<int32_t>::max())
+            {
+                throw std::invalid_argument("numpy_to_image received an array whose shape or "
+                                            "strides do not fit in 32 bits.");
+            }
+            dim.extent = array.shape(c);
+            dim.stride = stride / raw_buffer.elem_size;
+        }
+
+        if (c < 4)
         {
-            raw_buffer.extent[c] = array.shape(c);
-            // numpy counts stride in bytes, while Halide counts in number of elements
-            user_assert((array.strides(c) % raw_buffer.elem_size) == 0);
-            raw_buffer.stride[c] = array.strides(c) / raw_buffer.elem_size;
+            raw_buffer.min[c] = dim.min;
+            raw_buffer.extent[c] = dim.extent;
+            raw_buffer.stride[c] = dim.stride;
         }
         else
         {
-            raw_buffer.extent[c] = 0;
-            raw_buffer.stride[c] = 0;
+            extra_dims.push_back(dim);
         }
-        raw_buffer.min[c] = 0;
     }
 
-    return raw_buffer;
+    if (!extra_dims.empty())
+    {
+        nd_buffer.extra_dim = &extra_dims[0];
+        raw_buffer.extra_dimensions = (uint8_t)extra_dims.size();
+    }
+
+    return;
 }
 
 /// Will create a Halide::Image object pointing to the array data
 p::object ndarray_to_image(bn::ndarray &array, const std::string name="")
 {
-    buffer_t raw_buffer = ndarray_to_buffer_t(array);
-    return raw_buffer_to_image(array, raw_buffer, name);
+    halide_nd_buffer_t nd_buffer;
+    std::vector<halide_dimension_t> extra_dims;
+    ndarray_to_buffer_t(array, nd_buffer, extra_dims);
+    // The Halide::Buffer keeps its own copy of extra_dims
+    return raw_buffer_to_image(array, nd_buffer.buf, name);
 }
 
 
@@ -685,27 +742,15 @@ bn::ndarray image_to_ndarray(p::object image_object)
 
     const h::Type& t = p::extract<h::Type &>(image_object.attr("type")());
 
-    buffer_t &raw_buffer = *b.raw_buffer();
-    std::vector<std::int32_t> shape_array(4), stride_array(4);
-    std::copy(raw_buffer.extent, raw_buffer.extent + 4, shape_array.begin());
-    std::copy(raw_buffer.stride, raw_buffer.stride + 4, stride_array.begin());
-
-
-    // we make sure the array shape does not include the "0 extent" dimensions
-    // we always keep at least one dimension (even if zero size)
-    for(size_t i = 3; i > 0; i -= 1)
+    // the array shape does not include the "0 extent" dimensions,
+    // but we always keep at least one dimension (even if zero size)
+    const int dimensions = std::max(b.dimensions(), 1);
+    std::vector<Py_intptr_t> shape_array(dimensions), stride_array(dimensions);
+    for(int i = 0; i < dimensions; i += 1)
     {
-        if(shape_array[i] == 0)
-        {
-            shape_array.pop_back();
-            stride_array.pop_back();
-        }
-    }
-
-    // numpy counts stride in bytes, while Halide counts in number of elements
-    for(size_t i = 0; i < 4; i += 1)
-    {
-        stride_array[i] *= raw_buffer.elem_size;
+        shape_array[i] = b.extent(i);
+        // numpy counts stride in bytes, while Halide counts in number of elements
+        stride_array[i] = (Py_intptr_t)b.stride(i) * t.bytes();
     }
 
     return bn::from_data(
@@ -717,6 +762,51 @@ bn::ndarray image_to_ndarray(p::object image_object)
 }
 
 
+h::Type dtype_to_type(const bn::dtype &dt)
+{
+    for(const h::Type &t : {h::UInt(8), h::UInt(16), h::UInt(32),
+                            h::Int(8), h::Int(16), h::Int(32),
+                            h::Float(32), h::Float(64)})
+    {
+        if(dt == type_to_dtype(t))
+        {
+            return t;
+        }
+    }
+
+    const std::string type_repr = p::extract<std::string>(p::str(dt));
+    printf("dtype_to_type received %s\n", type_repr.c_str());
+    throw std::invalid_argument("dtype_to_type received a numpy dtype with no Halide::Type equivalent");
+}
+
+
+/// Lets a numpy array be passed wherever a Halide::Buffer is expected
+/// (Func.realize, ImageParam.set, ...). The Buffer aliases the array memory,
+/// and keeps the array alive.
+struct ndarray_to_buffer_converter
+{
+    static void *convertible(PyObject *obj)
+    {
+        p::object o{p::handle<>(p::borrowed(obj))};
+        return p::extract<bn::ndarray>(o).check() ? obj : nullptr;
+    }
+
+    static void construct(PyObject *obj, p::converter::rvalue_from_python_stage1_data *data)
+    {
+        p::object o{p::handle<>(p::borrowed(obj))};
+        bn::ndarray array = p::extract<bn::ndarray>(o);
+
+        halide_nd_buffer_t nd_buffer;
+        std::vector<halide_dimension_t> extra_dims;
+        ndarray_to_buffer_t(array, nd_buffer, extra_dims);
+
+        void *storage = ((p::converter::rvalue_from_python_storage<h::Buffer> *)data)->storage.bytes;
+        new (storage) h::Buffer(array_to_buffer(array, dtype_to_type(array.get_dtype()), nd_buffer.buf));
+        data->convertible = storage;
+    }
+};
+
+
 #endif
 
 
@@ -881,16 +971,18 @@ void defineImage()
 #ifdef USE_NUMPY
     bn::initialize();
 
+    p::converter::registry::push_back(&ndarray_to_buffer_converter::convertible,
+                                      &ndarray_to_buffer_converter::construct,
+                                      p::type_id<h::Buffer>());
+
     p::def("ndarray_to_image", &ndarray_to_image, (p::arg("array"), p::arg("name")=""),
-           p::with_custodian_and_ward_postcall<0, 1>(), // the array reference count is increased
            "Converts a numpy array into a Halide::Image."
-           "Will take into account the array size, dimensions, and type."
+           "Will take into account the array size, dimensions, strides, and type."
            "Created Image refers to the array data (no copy).");
 
     p::def("Image", &ndarray_to_image, (p::arg("array"), p::arg("name")=""),
-           p::with_custodian_and_ward_postcall<0, 1>(), // the array reference count is increased
            "Wrap numpy array in a Halide::Image."
-           "Will take into account the array size, dimensions, and type."
+           "Will take into account the array size, dimensions, strides, and type."
            "Created Image refers to the array data (no copy).");
 
     p::def("image_to_ndarray", &image_to_ndarray, p::arg("image"),
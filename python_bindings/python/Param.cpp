@@ -108,7 +108,9 @@ void defineImageParam()
                  "by convention is the bottom of the image")
 
             .def("set", &ImageParam::set, p::args("self", "b"),
-                 "Get the buffer bound to this ImageParam. Only relevant for jitting.")
+                 "Bind a buffer, Image or numpy array to this ImageParam. Only relevant "
+                 "for jitting. A numpy array is used in place, without copying, and "
+                 "is kept alive by the buffer for as long as the buffer is bound.")
             .def("get", &ImageParam::get, p::arg("self"),
                  "Get the buffer bound to this ImageParam. Only relevant for jitting.")
             .def("__getitem__", &imageparam_to_expr_operator0, p::args("self", "tuple"),
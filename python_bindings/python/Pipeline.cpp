@@ -0,0 +1,155 @@
+#include "Pipeline.h"
+
+// to avoid compiler confusion, python.hpp must be include before Halide headers
+#include <boost/python.hpp>
+
+#include "../../src/Pipeline.h"
+#include "../../src/Func.h"
+
+#include "ReleaseGIL.h"
+
+#include <vector>
+#include <string>
+
+namespace h = Halide;
+namespace p = boost::python;
+
+
+h::Pipeline *pipeline_constructor0(p::list outputs_passed)
+{
+    std::vector<h::Func> outputs;
+    const size_t outputs_len = p::len(outputs_passed);
+    for(size_t i=0; i < outputs_len; i+=1)
+    {
+        p::extract<h::Func> func_extract(outputs_passed[i]);
+        if(not func_extract.check())
+        {
+            throw std::invalid_argument("Pipeline() only handles a list of Func.");
+        }
+        outputs.push_back(func_extract());
+    }
+
+    return new h::Pipeline(outputs);
+}
+
+p::list pipeline_outputs(h::Pipeline &that)
+{
+    p::list outputs;
+    for(const h::Func &f : that.outputs())
+    {
+        outputs.append(f);
+    }
+    return outputs;
+}
+
+
+// All the realize and compile_jit variants release the GIL, so that
+// several Python threads can run (different) pipelines concurrently.
+
+h::Realization pipeline_realize0(h::Pipeline &that, std::vector<int32_t> sizes, const h::Target &target = h::Target())
+{
+    ReleaseGIL release_gil;
+    return that.realize(sizes, target);
+}
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(pipeline_realize0_overloads, pipeline_realize0, 2, 3)
+
+
+h::Realization pipeline_realize1(h::Pipeline &that, int x_size=0, int y_size=0, int z_size=0, int w_size=0,
+                                 const h::Target &target = h::Target())
+{
+    ReleaseGIL release_gil;
+    return that.realize(x_size, y_size, z_size, w_size, target);
+}
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(pipeline_realize1_overloads, pipeline_realize1, 1, 6)
+
+
+void pipeline_realize2(h::Pipeline &that, h::Realization dst, const h::Target &target = h::Target())
+{
+    ReleaseGIL release_gil;
+    that.realize(dst, target);
+    return;
+}
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(pipeline_realize2_overloads, pipeline_realize2, 2, 3)
+
+
+void pipeline_realize3(h::Pipeline &that, h::Buffer dst, const h::Target &target = h::Target())
+{
+    ReleaseGIL release_gil;
+    that.realize(dst, target);
+    return;
+}
+
+BOOST_PYTHON_FUNCTION_OVERLOADS(pipeline_realize3_overloads, pipeline_realize3, 2, 3)
+
+
+void pipeline_compile_jit0(h::Pipeline &that)
+{
+    ReleaseGIL release_gil;
+    that.compile_jit();
+    return;
+}
+
+void pipeline_compile_jit1(h::Pipeline &that, const h::Target &target)
+{
+    ReleaseGIL release_gil;
+    that.compile_jit(target);
+    return;
+}
+
+
+void definePipeline()
+{
+    using Halide::Pipeline;
+
+    auto pipeline_class =
+            p::class_<Pipeline>("Pipeline",
+                                "A class representing a Halide pipeline. Constructed from the Func "
+                                "or Funcs that it outputs.\n"
+                                "Constructors::\n\n"
+                                "  Pipeline()        -- Make an undefined Pipeline object.\n"
+                                "  Pipeline(f)       -- Make a pipeline that computes the given Func.\n"
+                                "  Pipeline([f, g])  -- Make a pipeline that computes the given Funcs as outputs.",
+                                p::init<>(p::arg("self")))
+            .def(p::init<h::Func>(p::args("self", "output")))
+            .def("__init__", p::make_constructor(&pipeline_constructor0, p::default_call_policies(),
+                                                 p::args("outputs")));
+
+    p::implicitly_convertible<h::Func, Pipeline>();
+
+    pipeline_class.def("outputs", &pipeline_outputs, p::arg("self"),
+                       "Get the Funcs this pipeline outputs.")
+            .def("defined", &Pipeline::defined, p::arg("self"),
+                 "Check if this pipeline is defined.")
+            .def("invalidate_cache", &Pipeline::invalidate_cache, p::arg("self"),
+                 "Invalidate the cache of previously JIT-compiled code.");
+
+    pipeline_class.def("realize", &pipeline_realize1,
+                       pipeline_realize1_overloads(
+                           p::args("self", "x_size", "y_size", "z_size", "w_size", "target"),
+                           "Evaluate this pipeline over some rectangular domain and return "
+                           "the resulting buffer or buffers.\n\n"
+                           "The GIL is released while the pipeline is compiled and run, so "
+                           "other Python threads can make progress. Running the same Pipeline "
+                           "from several threads at once is not supported; give each thread "
+                           "its own."))
+            .def("realize", &pipeline_realize0, pipeline_realize0_overloads(
+                     p::args("self", "sizes", "target")))
+            .def("realize", &pipeline_realize3, pipeline_realize3_overloads(
+                     p::args("self", "dst", "target"),
+                     "Evaluate this pipeline into an existing allocated buffer. dst may "
+                     "be a numpy array, in which case the results are written directly "
+                     "into its memory."))
+            .def("realize", &pipeline_realize2, pipeline_realize2_overloads(
+                     p::args("self", "dst", "target"),
+                     "Evaluate this pipeline into existing allocated buffers, one per output."));
+
+    pipeline_class.def("compile_jit", &pipeline_compile_jit1, p::args("self", "target"),
+                       "Eagerly jit compile the pipeline to machine code. This normally "
+                       "happens on the first call to realize.")
+            .def("compile_jit", &pipeline_compile_jit0, p::arg("self"));
+
+    return;
+}
@@ -0,0 +1,8 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+
+void definePipeline();
+
+
+#endif // PIPELINE_H
@@ -0,0 +1,23 @@
+#ifndef RELEASE_GIL_H
+#define RELEASE_GIL_H
+
+#include <boost/python.hpp>
+
+/// Releases the Python global interpreter lock for the lifetime of the object,
+/// so that other Python threads can run while we are busy in Halide code.
+/// Nothing in that scope may touch Python objects. The lock is re-acquired
+/// on destruction, including when a Halide error unwinds the stack.
+class ReleaseGIL
+{
+public:
+    ReleaseGIL() : state(PyEval_SaveThread()) {}
+    ~ReleaseGIL() { PyEval_RestoreThread(state); }
+
+private:
+    ReleaseGIL(const ReleaseGIL &) = delete;
+    ReleaseGIL &operator=(const ReleaseGIL &) = delete;
+
+    PyThreadState *state;
+};
+
+#endif // RELEASE_GIL_H
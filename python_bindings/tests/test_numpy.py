@@ -0,0 +1,177 @@
+#!/usr/bin/python3
+
+# to be called via nose, for example
+# nosetests-3.4 -v path_to/tests/test_numpy.py
+
+from halide import *
+import numpy as np
+import gc
+import weakref
+
+
+def test_ndarray_aliasing():
+    """
+    Images built from numpy arrays alias the array memory,
+    honoring the array strides.
+    """
+
+    data = np.arange(4 * 6, dtype=np.int32).reshape((4, 6))
+
+    for view in [data, data.T, data[::-1, :], data[1:3, ::2]]:
+        image = Image(view)
+        assert image.dimensions() == view.ndim
+        for i in range(view.ndim):
+            assert image.extent(i) == view.shape[i]
+            assert image.stride(i) * view.itemsize == view.strides[i]
+
+        # Writes through the image are visible in the array.
+        image_view = image_to_ndarray(image)
+        assert image_view.shape == view.shape
+        assert (image_view == view).all()
+        image_view[0, 0] = -1
+        assert view[0, 0] == -1
+
+    return
+
+
+def test_realize_into_ndarray():
+
+    x, y = Var("x"), Var("y")
+    f = Func("f")
+    f[x, y] = x + 10 * y
+
+    output = np.zeros((8, 5), dtype=np.int32, order="F")
+    f.realize(output)
+    expected = np.fromfunction(lambda i, j: i + 10 * j, output.shape, dtype=np.int32)
+    assert (output == expected).all()
+
+    # Non-contiguous destinations work too.
+    output = np.zeros((5, 8), dtype=np.int32)
+    f.realize(output.T)
+    assert (output.T == expected).all()
+
+    # Output buffers must be dense in dimension 0, but the other
+    # dimensions can skip over memory.
+    wide = np.zeros((10, 8), dtype=np.int32)
+    Pipeline(f).realize(wide.T[:, ::2])
+    assert (wide.T[:, ::2] == expected).all()
+    assert (wide.T[:, 1::2] == 0).all()
+
+    return
+
+
+def test_imageparam_keeps_array_alive():
+
+    input = ImageParam(Float(32), 2, "input")
+    x, y = Var("x"), Var("y")
+    f = Func("f")
+    f[x, y] = input[x, y] * 2
+
+    input.set(np.full((16, 16), 3, dtype=np.float32))
+    gc.collect()
+
+    output = np.zeros((16, 16), dtype=np.float32)
+    f.realize(output)
+    assert (output == 6).all()
+
+    return
+
+
+def test_buffer_keeps_array_alive():
+    """
+    The array is kept alive by the buffer bound to the parameter,
+    not by the Python ImageParam object.
+    """
+
+    x, y = Var("x"), Var("y")
+
+    def make_input():
+        input = ImageParam(Float(32), 2, "input")
+        input.set(np.full((16, 16), 3, dtype=np.float32))
+        return input[x, y]
+
+    f = Func("f")
+    f[x, y] = make_input() * 2
+    gc.collect()
+
+    output = np.zeros((16, 16), dtype=np.float32)
+    f.realize(output)
+    assert (output == 6).all()
+
+    # Binding another buffer releases the array.
+    input = ImageParam(Float(32), 2, "input")
+    data = np.zeros((4, 4), dtype=np.float32)
+    data_ref = weakref.ref(data)
+    input.set(data)
+    del data
+    gc.collect()
+    assert data_ref() is not None
+    input.set(np.zeros((4, 4), dtype=np.float32))
+    gc.collect()
+    assert data_ref() is None
+
+    return
+
+
+def test_image_outlives_array():
+    """
+    Images and Buffers made from a numpy array keep reading the array
+    after the last Python reference to it is dropped.
+    """
+
+    data = np.arange(6 * 4, dtype=np.int32).reshape((6, 4))
+    expected = data.copy()
+    data_ref = weakref.ref(data)
+
+    image = Image(data)
+    buffer = image.buffer()
+    del data
+    gc.collect()
+    assert data_ref() is not None
+    assert (image_to_ndarray(image) == expected).all()
+
+    # The Buffer alone keeps the array alive, and a pipeline can read it.
+    del image
+    gc.collect()
+    assert data_ref() is not None
+
+    input = ImageParam(Int(32), 2, "input")
+    input.set(buffer)
+    x, y = Var("x"), Var("y")
+    f = Func("f")
+    f[x, y] = input[x, y]
+    output = np.zeros(expected.shape, dtype=np.int32)
+    f.realize(output)
+    assert (output == expected).all()
+
+    del f, input, buffer
+    gc.collect()
+    assert data_ref() is None
+
+    return
+
+
+def test_many_dimensions():
+
+    data = np.random.randint(0, 100, size=(2, 3, 4, 2, 3)).astype(np.int32)
+    input = ImageParam(Int(32), 5, "input")
+    input.set(data)
+
+    v = [Var() for i in range(5)]
+    f = Func("f")
+    f[tuple(v)] = input[tuple(v)] + 1
+
+    output = np.zeros(data.shape, dtype=np.int32)
+    f.realize(output)
+    assert (output == data + 1).all()
+
+    return
+
+
+if __name__ == "__main__":
+    test_ndarray_aliasing()
+    test_realize_into_ndarray()
+    test_imageparam_keeps_array_alive()
+    test_buffer_keeps_array_alive()
+    test_image_outlives_array()
+    test_many_dimensions()
@@ -75,13 +75,6 @@ Stmt add_image_checks(Stmt s,
 
     // Add the output buffer(s).
     for (Function f : outputs) {
-        // Check that their dimensionality
-        // doesn't exceed what buffer_t can handle.
-        user_assert(f.dimensions() <= 4)
-            << "Output Func " << f.name()
-            << " has " << f.dimensions()
-            << " dimensions. Output buffers may not currently have more than four dimensions.\n";
-
         for (size_t i = 0; i < f.values().size(); i++) {
             FindBuffers::Result output_buffer;
             output_buffer.type = f.values()[i].type();
@@ -124,7 +117,7 @@ Stmt add_image_checks(Stmt s,
     for (const pair<string, FindBuffers::Result> &buf : bufs) {
         const string &name = buf.first;
 
-        for (int i = 0; i < 4; i++) {
+        for (int i = 0; i < std::max(4, buf.second.dimensions); i++) {
             string dim = std::to_string(i);
 
             Expr min_required = Variable::make(Int(32), name + ".min." + dim + ".required");
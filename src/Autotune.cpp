@@ -0,0 +1,632 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <set>
+#include <sstream>
+
+#include "Autotune.h"
+#include "Debug.h"
+#include "Error.h"
+#include "FindCalls.h"
+#include "Func.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "Schedule.h"
+
+namespace Halide {
+
+using namespace Internal;
+
+using std::map;
+using std::ostringstream;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+double now() {
+    auto t = std::chrono::high_resolution_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t).count() / 1e9;
+}
+
+// A copy of a schedule that shares nothing mutable with the
+// original. Wrappers are shared, because they are Funcs in their own
+// right.
+Schedule copy_schedule(const Schedule &s) {
+    Schedule copy;
+    copy.store_level() = s.store_level();
+    copy.compute_level() = s.compute_level();
+    copy.rvars() = s.rvars();
+    copy.splits() = s.splits();
+    copy.dims() = s.dims();
+    copy.storage_dims() = s.storage_dims();
+    copy.bounds() = s.bounds();
+    copy.wrappers() = s.wrappers();
+    copy.memoized() = s.memoized();
+    copy.touched() = s.touched();
+    copy.allow_race_conditions() = s.allow_race_conditions();
+    copy.atomic() = s.atomic();
+    return copy;
+}
+
+// Scheduling directives refer to the innermost component of a
+// dimension's name, e.g. "yi" for the dimension "y.yi".
+string base_name(const string &name) {
+    size_t dot = name.rfind('.');
+    return dot == string::npos ? name : name.substr(dot + 1);
+}
+
+string identifier(const string &name) {
+    string id = name;
+    for (char &c : id) {
+        if (!isalnum(c) && c != '_') {
+            c = '_';
+        }
+    }
+    if (id.empty() || isdigit(id[0])) {
+        id = "_" + id;
+    }
+    return id;
+}
+
+// The order of the loops of a stage before any scheduling
+// directives.
+vector<string> initial_dims(const Function &f, int stage) {
+    vector<string> dims;
+    if (stage == 0) {
+        dims = f.args();
+    } else {
+        const Definition &def = f.update(stage - 1);
+        for (const ReductionVariable &rv : def.schedule().rvars()) {
+            dims.push_back(rv.var);
+        }
+        const vector<string> pure_args = f.args();
+        for (size_t i = 0; i < def.args().size(); i++) {
+            const Variable *v = def.args()[i].as<Variable>();
+            if (v && i < pure_args.size() && v->name == pure_args[i]) {
+                dims.push_back(v->name);
+            }
+        }
+    }
+    dims.push_back(Var::outermost().name());
+    return dims;
+}
+
+// Writes out a Func's schedule as a sequence of scheduling
+// directives, recording the names of the Vars and RVars it uses. If
+// canonical is set, the Vars are instead numbered in order of
+// appearance, so that schedules that differ only in the names of
+// Vars (e.g. the anonymous ones made by vectorize(x, 8)) print the
+// same.
+class SchedulePrinter {
+    bool canonical;
+    set<string> vars, rvars;
+    map<string, int> numbering;
+    ostringstream body;
+
+    string loop_var(const string &name, bool is_rvar) {
+        string b = base_name(name);
+        if (canonical) {
+            auto it = numbering.emplace(b, (int)numbering.size()).first;
+            return (is_rvar ? "r" : "v") + std::to_string(it->second);
+        }
+        (is_rvar ? rvars : vars).insert(b);
+        return identifier(b);
+    }
+
+    string loop_level(const LoopLevel &l, const map<string, Function> &env) {
+        bool is_rvar = false;
+        auto it = env.find(l.func);
+        if (it != env.end()) {
+            for (size_t i = 0; i < it->second.updates().size(); i++) {
+                for (const Dim &d : it->second.update((int)i).schedule().dims()) {
+                    is_rvar |= d.is_rvar() && base_name(d.var) == l.var;
+                }
+            }
+        }
+        return identifier(l.func) + ", " + loop_var(l.var, is_rvar);
+    }
+
+public:
+    SchedulePrinter(bool canonical) : canonical(canonical) {}
+
+    void print_stage(const Function &f, int stage, const map<string, Function> &env) {
+        const Schedule &s = stage == 0 ? f.schedule() : f.update(stage - 1).schedule();
+        vector<string> directives;
+
+        // Replay the splits, tracking which names are RVars and what
+        // the loop order would be without a reorder.
+        set<string> is_rvar;
+        for (const ReductionVariable &rv : s.rvars()) {
+            is_rvar.insert(rv.var);
+        }
+        vector<string> order = initial_dims(f, stage);
+        auto replace = [&](const string &from, const string &to) {
+            std::replace(order.begin(), order.end(), from, to);
+        };
+        for (const Split &split : s.splits()) {
+            bool r = is_rvar.count(split.old_var) || is_rvar.count(split.inner);
+            if (split.is_split()) {
+                if (r) {
+                    is_rvar.insert(split.outer);
+                    is_rvar.insert(split.inner);
+                }
+                ostringstream d;
+                d << "split(" << loop_var(split.old_var, r) << ", "
+                  << loop_var(split.outer, r) << ", "
+                  << loop_var(split.inner, r) << ", " << split.factor;
+                if (split.tail != TailStrategy::Auto && !split.exact) {
+                    const char *tails[] = {"RoundUp", "GuardWithIf", "ShiftInwards"};
+                    d << ", TailStrategy::" << tails[(int)split.tail];
+                }
+                d << ")";
+                directives.push_back(d.str());
+                auto it = std::find(order.begin(), order.end(), split.old_var);
+                if (it != order.end()) {
+                    *it = split.outer;
+                    order.insert(it, split.inner);
+                }
+            } else if (split.is_rename()) {
+                if (r) {
+                    is_rvar.insert(split.outer);
+                }
+                directives.push_back("rename(" + loop_var(split.old_var, r) + ", " +
+                                     loop_var(split.outer, r) + ")");
+                replace(split.old_var, split.outer);
+            } else if (split.is_fuse()) {
+                if (r) {
+                    is_rvar.insert(split.old_var);
+                }
+                directives.push_back("fuse(" + loop_var(split.inner, r) + ", " +
+                                     loop_var(split.outer, r) + ", " +
+                                     loop_var(split.old_var, r) + ")");
+                order.erase(std::remove(order.begin(), order.end(), split.outer), order.end());
+                replace(split.inner, split.old_var);
+            } else {
+                // Purifying an RVar is a side-effect of rfactor, not
+                // something that can be written down as a directive.
+                replace(split.old_var, split.outer);
+            }
+        }
+
+        vector<string> actual;
+        for (const Dim &d : s.dims()) {
+            actual.push_back(d.var);
+        }
+        if (actual != order) {
+            string d = "reorder(";
+            for (const Dim &dim : s.dims()) {
+                if (dim.var == Var::outermost().name()) continue;
+                if (d.back() != '(') d += ", ";
+                d += loop_var(dim.var, dim.is_rvar());
+            }
+            directives.push_back(d + ")");
+        }
+
+        for (const Dim &dim : s.dims()) {
+            if (dim.for_type == ForType::Parallel) {
+                directives.push_back("parallel(" + loop_var(dim.var, dim.is_rvar()) + ")");
+            } else if (dim.for_type == ForType::Vectorized) {
+                directives.push_back("vectorize(" + loop_var(dim.var, dim.is_rvar()) + ")");
+            } else if (dim.for_type == ForType::Unrolled) {
+                directives.push_back("unroll(" + loop_var(dim.var, dim.is_rvar()) + ")");
+            }
+        }
+
+        if (stage == 0) {
+            for (const Bound &b : s.bounds()) {
+                ostringstream d;
+                d << "bound(" << loop_var(b.var, false) << ", " << b.min << ", " << b.extent << ")";
+                directives.push_back(d.str());
+            }
+
+            const LoopLevel &compute = s.compute_level(), &store = s.store_level();
+            if (!store.match(compute) && !store.is_inline()) {
+                directives.push_back(store.is_root() ? "store_root()" :
+                                     "store_at(" + loop_level(store, env) + ")");
+            }
+            if (compute.is_root()) {
+                directives.push_back("compute_root()");
+            } else if (!compute.is_inline()) {
+                directives.push_back("compute_at(" + loop_level(compute, env) + ")");
+            }
+            if (s.memoized()) {
+                directives.push_back("memoize()");
+            }
+        }
+
+        if (s.allow_race_conditions()) {
+            directives.push_back("allow_race_conditions()");
+        }
+        if (s.atomic()) {
+            directives.push_back("atomic()");
+        }
+
+        if (directives.empty()) {
+            return;
+        }
+        body << identifier(f.name());
+        if (stage > 0) {
+            body << ".update(" << (stage - 1) << ")";
+        }
+        for (const string &d : directives) {
+            body << "\n    ." << d;
+        }
+        body << ";\n";
+    }
+
+    string str() const {
+        ostringstream s;
+        auto declare = [&](const char *type, const set<string> &names) {
+            if (names.empty()) return;
+            s << type;
+            const char *sep = " ";
+            for (const string &n : names) {
+                s << sep << identifier(n) << "(\"" << n << "\")";
+                sep = ", ";
+            }
+            s << ";\n";
+        };
+        declare("Var", vars);
+        declare("RVar", rvars);
+        s << body.str();
+        return s.str();
+    }
+};
+
+// Find the parameters a pipeline reads, which may change between
+// calls to tune().
+class FindParameters : public IRGraphVisitor {
+public:
+    map<string, Parameter> params;
+
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) {
+        if (op->param.defined()) {
+            params[op->param.name()] = op->param;
+        }
+    }
+
+    void visit(const Call *op) {
+        IRGraphVisitor::visit(op);
+        if (op->param.defined()) {
+            params[op->param.name()] = op->param;
+        }
+    }
+};
+
+void describe_buffer(ostringstream &s, const Buffer &b) {
+    if (!b.defined()) {
+        s << "undefined";
+        return;
+    }
+    s << b.type();
+    for (int i = 0; i < b.dimensions(); i++) {
+        s << " [" << b.min(i) << ", " << b.extent(i) << ", " << b.stride(i) << "]";
+    }
+}
+
+double time_pipeline(Pipeline p, Realization dst, const AutotuneOptions &options, double give_up_time) {
+    // The first run also tells us how many runs make up a sample.
+    double t1 = now();
+    p.realize(dst, options.target);
+    double first = now() - t1;
+    if (first > give_up_time) {
+        return first;
+    }
+    int iterations = 1;
+    if (first < options.min_sample_time) {
+        iterations = (int)std::min(1000.0, std::ceil(options.min_sample_time / std::max(first, 1e-9)));
+    }
+
+    double best = std::numeric_limits<double>::infinity();
+    for (int i = 0; i < options.samples; i++) {
+        double t1 = now();
+        for (int j = 0; j < iterations; j++) {
+            p.realize(dst, options.target);
+        }
+        best = std::min(best, (now() - t1) / iterations);
+        if (best > give_up_time) {
+            break;
+        }
+    }
+    return best;
+}
+
+}  // namespace
+
+int AutotuneConfig::operator[](const string &knob) const {
+    auto it = values.find(knob);
+    user_assert(it != values.end())
+        << "Autotuner configuration has no knob named " << knob << "\n";
+    return it->second;
+}
+
+void AutotuneConfig::set(const string &knob, int value) {
+    values[knob] = value;
+}
+
+Autotuner::Autotuner(Pipeline p, ScheduleFunction s) : pipeline(p), schedule(s) {
+    user_assert(pipeline.defined()) << "Can't autotune an undefined Pipeline\n";
+    user_assert(schedule != nullptr) << "Autotuner requires a schedule function\n";
+    for (Func out : pipeline.outputs()) {
+        for (const auto &it : find_transitive_calls(out.function())) {
+            Function f = it.second;
+            vector<Schedule> schedules;
+            schedules.push_back(copy_schedule(f.schedule()));
+            for (size_t i = 0; i < f.updates().size(); i++) {
+                schedules.push_back(copy_schedule(f.update((int)i).schedule()));
+            }
+            original[it.first] = {f, schedules};
+
+            FindParameters finder;
+            f.accept(&finder);
+            for (const auto &p : finder.params) {
+                inputs[p.first] = p.second;
+            }
+        }
+    }
+}
+
+Autotuner &Autotuner::add_knob(const string &name, const vector<int> &values) {
+    user_assert(!values.empty()) << "Autotuner knob " << name << " has no values\n";
+    for (const Knob &k : knobs) {
+        user_assert(k.name != name) << "Autotuner already has a knob named " << name << "\n";
+    }
+    knobs.push_back({name, values, {}});
+    return *this;
+}
+
+Autotuner &Autotuner::add_choice(const string &name, const vector<string> &choices) {
+    vector<int> indices;
+    for (size_t i = 0; i < choices.size(); i++) {
+        indices.push_back((int)i);
+    }
+    add_knob(name, indices);
+    knobs.back().choices = choices;
+    return *this;
+}
+
+void Autotuner::restore() {
+    for (auto &it : original) {
+        Function &f = it.second.first;
+        const vector<Schedule> &schedules = it.second.second;
+        f.definition().schedule() = copy_schedule(schedules[0]);
+        for (size_t i = 1; i < schedules.size(); i++) {
+            f.update((int)i - 1).schedule() = copy_schedule(schedules[i]);
+        }
+    }
+    pipeline.invalidate_cache();
+}
+
+void Autotuner::apply(const AutotuneConfig &config) {
+    for (const Knob &k : knobs) {
+        user_assert(config.knobs().count(k.name))
+            << "Autotuner configuration has no value for knob " << k.name << "\n";
+    }
+    restore();
+    schedule(config);
+    pipeline.invalidate_cache();
+}
+
+string Autotuner::print_schedule(bool canonical) const {
+    map<string, Function> env;
+    for (const auto &it : original) {
+        env[it.first] = it.second.first;
+    }
+    SchedulePrinter printer(canonical);
+    for (const auto &it : env) {
+        const Function &f = it.second;
+        for (size_t i = 0; i <= f.updates().size(); i++) {
+            printer.print_stage(f, (int)i, env);
+        }
+    }
+    return printer.str();
+}
+
+string Autotuner::schedule_source(const AutotuneConfig &config) {
+    apply(config);
+    return "// Schedule for " + describe(config) + "\n" + print_schedule(false);
+}
+
+string Autotuner::describe(const AutotuneConfig &config) const {
+    ostringstream s;
+    for (const Knob &k : knobs) {
+        auto it = config.knobs().find(k.name);
+        if (it == config.knobs().end()) continue;
+        if (s.tellp() > 0) s << " ";
+        s << k.name << "=";
+        if (!k.choices.empty() && it->second >= 0 && it->second < (int)k.choices.size()) {
+            s << k.choices[it->second];
+        } else {
+            s << it->second;
+        }
+    }
+    return s.str();
+}
+
+string Autotuner::describe_problem(Realization dst, const AutotuneOptions &options) const {
+    ostringstream s;
+    s << options.target.to_string() << "\n";
+    for (size_t i = 0; i < dst.size(); i++) {
+        s << "output " << i << ": ";
+        describe_buffer(s, dst[i]);
+        s << "\n";
+    }
+    for (const auto &it : inputs) {
+        const Parameter &p = it.second;
+        s << it.first << ": ";
+        if (p.is_buffer()) {
+            describe_buffer(s, p.get_buffer());
+        } else {
+            s << p.get_scalar_expr();
+        }
+        s << "\n";
+    }
+    return s.str();
+}
+
+double Autotuner::evaluate(const AutotuneConfig &config, Realization dst,
+                           const AutotuneOptions &options, const string &problem,
+                           double best_so_far, double *compile_time) {
+    *compile_time = 0;
+    apply(config);
+
+    // Different configurations may produce the same schedule (e.g. a
+    // choice that makes another knob irrelevant), so the timings are
+    // keyed on the schedule itself, along with the target and the
+    // shapes and values the pipeline was run on.
+    string key = problem + print_schedule(true);
+    auto it = timings.find(key);
+    if (it != timings.end()) {
+        debug(1) << "Autotuner: " << describe(config) << " has the same schedule as an earlier candidate\n";
+        return it->second;
+    }
+
+    double t = std::numeric_limits<double>::infinity();
+#ifdef WITH_EXCEPTIONS
+    try {
+#endif
+        double t1 = now();
+        pipeline.compile_jit(options.target);
+        *compile_time = now() - t1;
+        t = time_pipeline(pipeline, dst, options, best_so_far * options.give_up_factor);
+#ifdef WITH_EXCEPTIONS
+    } catch (const Error &e) {
+        debug(1) << "Autotuner: " << describe(config) << " failed: " << e.what() << "\n";
+    }
+#endif
+    debug(1) << "Autotuner: " << describe(config) << " took " << t * 1000 << " ms"
+             << " (compiled in " << *compile_time * 1000 << " ms)\n";
+    timings[key] = t;
+    return t;
+}
+
+AutotuneResult Autotuner::tune(Buffer dst, const AutotuneOptions &options) {
+    return tune(Realization({dst}), options);
+}
+
+AutotuneResult Autotuner::tune(Realization dst, const AutotuneOptions &options) {
+    user_assert(!knobs.empty()) << "Autotuner has no knobs to tune\n";
+    user_assert(options.max_candidates > 0) << "Autotuner needs a positive max_candidates\n";
+    user_assert(options.samples > 0) << "Autotuner needs a positive number of samples\n";
+
+    std::mt19937 rng(options.seed);
+    double space = 1;
+    for (const Knob &k : knobs) {
+        space *= k.values.size();
+    }
+
+    AutotuneResult result;
+    result.best_time = std::numeric_limits<double>::infinity();
+    set<AutotuneConfig> seen;
+    const string problem = describe_problem(dst, options);
+
+    auto budget_left = [&]() {
+        return (int)result.candidates.size() < options.max_candidates &&
+            (double)seen.size() < space;
+    };
+
+    auto try_config = [&](const AutotuneConfig &c) {
+        seen.insert(c);
+        AutotuneCandidate candidate;
+        candidate.config = c;
+        candidate.time = evaluate(c, dst, options, problem, result.best_time, &candidate.compile_time);
+        if (candidate.time < result.best_time) {
+            result.best = c;
+            result.best_time = candidate.time;
+        }
+        result.candidates.push_back(candidate);
+    };
+
+    auto random_value = [&](const Knob &k) {
+        return k.values[std::uniform_int_distribution<int>(0, (int)k.values.size() - 1)(rng)];
+    };
+
+    auto random_config = [&]() {
+        AutotuneConfig c;
+        for (const Knob &k : knobs) {
+            c.set(k.name, random_value(k));
+        }
+        return c;
+    };
+
+    // Once most of a small space has been seen, finding a new
+    // configuration by chance can take a while, so bound the
+    // attempts.
+    const int max_attempts = 100 + 10 * (int)std::min(space, 1e6);
+
+    if (options.strategy == AutotuneStrategy::Grid) {
+        for (uint64_t index = 0; budget_left(); index++) {
+            AutotuneConfig c;
+            uint64_t i = index;
+            for (const Knob &k : knobs) {
+                c.set(k.name, k.values[i % k.values.size()]);
+                i /= k.values.size();
+            }
+            try_config(c);
+        }
+    } else if (options.strategy == AutotuneStrategy::Random) {
+        for (int attempt = 0; attempt < max_attempts && budget_left(); attempt++) {
+            AutotuneConfig c = random_config();
+            if (!seen.count(c)) {
+                try_config(c);
+            }
+        }
+    } else {
+        const int population = std::max(2, options.population);
+        for (int attempt = 0; attempt < max_attempts && budget_left() &&
+                 (int)result.candidates.size() < population; attempt++) {
+            AutotuneConfig c = random_config();
+            if (!seen.count(c)) {
+                try_config(c);
+            }
+        }
+
+        for (int attempt = 0; attempt < max_attempts && budget_left(); attempt++) {
+            // The parents are the fastest configurations so far.
+            vector<AutotuneCandidate> parents = result.candidates;
+            std::stable_sort(parents.begin(), parents.end(),
+                             [](const AutotuneCandidate &a, const AutotuneCandidate &b) {
+                                 return a.time < b.time;
+                             });
+            if ((int)parents.size() > population) {
+                parents.resize(population);
+            }
+            std::uniform_int_distribution<int> pick(0, (int)parents.size() - 1);
+            const AutotuneConfig &a = parents[pick(rng)].config;
+            const AutotuneConfig &b = parents[pick(rng)].config;
+
+            // Take each knob from either parent, then mutate one
+            // knob, plus each other knob with low probability.
+            AutotuneConfig child;
+            std::uniform_int_distribution<int> coin(0, 1);
+            std::uniform_real_distribution<double> uniform(0, 1);
+            int mutated = std::uniform_int_distribution<int>(0, (int)knobs.size() - 1)(rng);
+            for (int i = 0; i < (int)knobs.size(); i++) {
+                const Knob &k = knobs[i];
+                if (i == mutated || uniform(rng) < 1.0 / knobs.size()) {
+                    child.set(k.name, random_value(k));
+                } else {
+                    child.set(k.name, coin(rng) ? a[k.name] : b[k.name]);
+                }
+            }
+            if (!seen.count(child)) {
+                try_config(child);
+            }
+        }
+    }
+
+    user_assert(result.best_time < std::numeric_limits<double>::infinity())
+        << "None of the " << result.candidates.size()
+        << " configurations tried by the Autotuner could be compiled and run\n";
+
+    result.schedule_source = schedule_source(result.best);
+    return result;
+}
+
+}
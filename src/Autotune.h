@@ -0,0 +1,238 @@
+#ifndef HALIDE_AUTOTUNE_H
+#define HALIDE_AUTOTUNE_H
+
+/** \file
+ *
+ * Defines an autotuner that searches over a space of schedules for a
+ * Pipeline by JIT-compiling and timing candidates.
+ */
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "IR.h"
+#include "Function.h"
+#include "Pipeline.h"
+
+namespace Halide {
+
+/** An assignment of a value to each knob of an Autotuner. For knobs
+ * declared with Autotuner::add_choice, the value is the index of the
+ * choice. */
+class AutotuneConfig {
+    std::map<std::string, int> values;
+
+public:
+    /** Get the value of a knob. It is an error to ask for a knob that
+     * was not declared. */
+    EXPORT int operator[](const std::string &knob) const;
+
+    /** Set the value of a knob. */
+    EXPORT void set(const std::string &knob, int value);
+
+    /** The values of all knobs, by name. */
+    const std::map<std::string, int> &knobs() const {
+        return values;
+    }
+
+    bool operator<(const AutotuneConfig &other) const {
+        return values < other.values;
+    }
+};
+
+/** The ways an Autotuner can search the space of configurations. */
+enum class AutotuneStrategy {
+    /** Try every configuration in order, up to the evaluation
+     * budget. Good for small spaces. */
+    Grid,
+
+    /** Try configurations drawn uniformly at random, without
+     * repetition. */
+    Random,
+
+    /** Start from a random population, then repeatedly breed new
+     * candidates from the fastest configurations found so far by
+     * crossover and mutation. Good for large spaces in which the
+     * knobs are mostly independent. */
+    Evolutionary
+};
+
+/** Controls for Autotuner::tune. */
+struct AutotuneOptions {
+    AutotuneStrategy strategy = AutotuneStrategy::Random;
+
+    /** The maximum number of configurations to try. Configurations
+     * that produce a schedule already timed are cheap, but still
+     * count. */
+    int max_candidates = 64;
+
+    /** The number of configurations kept as parents by the
+     * evolutionary strategy. It is also the size of the initial
+     * random population. */
+    int population = 8;
+
+    /** Seed for the random and evolutionary strategies, so that
+     * tuning runs are reproducible. */
+    uint32_t seed = 0;
+
+    /** Each candidate is timed as the minimum over this many
+     * samples. A sample runs the pipeline enough times to take at
+     * least min_sample_time seconds. */
+    int samples = 5;
+    double min_sample_time = 0.002;
+
+    /** Stop timing a candidate after its first sample if it is more
+     * than this many times slower than the best found so far. */
+    double give_up_factor = 4.0;
+
+    Target target = get_jit_target_from_environment();
+};
+
+/** One configuration evaluated by the Autotuner. */
+struct AutotuneCandidate {
+    AutotuneConfig config;
+
+    /** Seconds per run of the pipeline. Infinite if the schedule
+     * failed to compile or run. */
+    double time;
+
+    /** Seconds spent lowering and JIT-compiling the schedule. Zero if
+     * the timing was reused from an identical schedule. */
+    double compile_time;
+};
+
+/** The outcome of Autotuner::tune. */
+struct AutotuneResult {
+    AutotuneConfig best;
+
+    /** Seconds per run of the pipeline using the best schedule. */
+    double best_time;
+
+    /** The best schedule, as C++ source that can be pasted into the
+     * program that defines the pipeline. See
+     * Autotuner::schedule_source. */
+    std::string schedule_source;
+
+    /** Every configuration visited, in the order tried. */
+    std::vector<AutotuneCandidate> candidates;
+};
+
+/** Searches for a fast schedule of a Pipeline. The caller declares a
+ * set of knobs, each with a small list of values (split factors,
+ * vector widths, an index into a list of loop levels to compute a
+ * Func at, and so on), and a function that schedules the pipeline
+ * given a value for every knob. The tuner then JIT-compiles and times
+ * candidate configurations on whatever inputs the pipeline's
+ * parameters are currently bound to, so those should be set to
+ * realistic data before calling tune. E.g:
+ *
+ \code
+ Autotuner tuner(blur_y, [&](const AutotuneConfig &c) {
+     blur_y.split(y, y, yi, c["rows"]).parallel(y).vectorize(x, c["vec"]);
+     if (c["blur_x"] == 1) {
+         blur_x.compute_at(blur_y, y).vectorize(x, c["vec"]);
+     } else if (c["blur_x"] == 2) {
+         blur_x.compute_at(blur_y, yi).vectorize(x, c["vec"]);
+     }
+ });
+ tuner.add_knob("rows", {4, 8, 16, 32, 64});
+ tuner.add_knob("vec", {4, 8, 16});
+ tuner.add_choice("blur_x", {"inline", "y", "yi"});
+ AutotuneResult r = tuner.tune(output);
+ std::cout << r.schedule_source;
+ \endcode
+ *
+ * Before each candidate is scheduled, every Func in the pipeline is
+ * returned to the schedule it had when the Autotuner was
+ * constructed, so the schedule function only needs to describe the
+ * differences from that. Candidates that produce a schedule
+ * identical to one already timed are not compiled again.
+ *
+ * Compilation and timing happen one candidate at a time on the
+ * calling thread: the schedule function mutates the Funcs of the
+ * pipeline in place, so candidates cannot be lowered concurrently.
+ *
+ * If libHalide was built with exceptions, candidates that fail to
+ * compile or run are recorded with an infinite time and the search
+ * continues. Otherwise, they abort the program, as any other Halide
+ * error would.
+ */
+class Autotuner {
+public:
+    typedef std::function<void(const AutotuneConfig &)> ScheduleFunction;
+
+    /** Construct an autotuner for the given pipeline. The current
+     * schedules of all Funcs in the pipeline are taken as the
+     * starting point for each candidate. */
+    EXPORT Autotuner(Pipeline pipeline, ScheduleFunction schedule);
+
+    /** Declare a knob that takes one of the given values. */
+    EXPORT Autotuner &add_knob(const std::string &name, const std::vector<int> &values);
+
+    /** Declare a knob that selects among named choices, such as a set
+     * of loop levels to compute a Func at. The value seen by the
+     * schedule function is the index of the choice. The names are
+     * used to describe configurations. */
+    EXPORT Autotuner &add_choice(const std::string &name, const std::vector<std::string> &choices);
+
+    /** Search for the fastest configuration, timing the pipeline
+     * realizing into the given buffers. Leaves the pipeline scheduled
+     * with the best configuration found. May be called repeatedly;
+     * the timing of a schedule is reused if it was seen before with
+     * the same target, output buffer shapes, and input buffer shapes
+     * and parameter values. */
+    // @{
+    EXPORT AutotuneResult tune(Realization dst, const AutotuneOptions &options = AutotuneOptions());
+    EXPORT AutotuneResult tune(Buffer dst, const AutotuneOptions &options = AutotuneOptions());
+    // @}
+
+    /** Return every Func in the pipeline to its original schedule,
+     * then schedule it with the given configuration. */
+    EXPORT void apply(const AutotuneConfig &config);
+
+    /** Apply the configuration, and return the resulting schedule of
+     * every Func in the pipeline as C++ source. Funcs and Vars are
+     * referred to by their names. Loops placed on a GPU are not
+     * reproduced. */
+    EXPORT std::string schedule_source(const AutotuneConfig &config);
+
+    /** Describe a configuration as a list of knob=value pairs. */
+    EXPORT std::string describe(const AutotuneConfig &config) const;
+
+private:
+    struct Knob {
+        std::string name;
+        std::vector<int> values;
+        std::vector<std::string> choices;
+    };
+
+    Pipeline pipeline;
+    ScheduleFunction schedule;
+    std::vector<Knob> knobs;
+
+    /** The schedules of every stage of every Func at construction. */
+    std::map<std::string, std::pair<Internal::Function, std::vector<Internal::Schedule>>> original;
+
+    /** The parameters read by the pipeline. */
+    std::map<std::string, Internal::Parameter> inputs;
+
+    /** The time taken by each distinct schedule seen so far, keyed on
+     * the problem it was timed on (see describe_problem) and its
+     * source. */
+    std::map<std::string, double> timings;
+
+    void restore();
+    std::string print_schedule(bool canonical) const;
+    /** Describe what a tune() call times the pipeline on: the
+     * target, the output buffers, and the current inputs. */
+    std::string describe_problem(Realization dst, const AutotuneOptions &options) const;
+    double evaluate(const AutotuneConfig &config, Realization dst,
+                    const AutotuneOptions &options, const std::string &problem,
+                    double best_so_far, double *compile_time);
+};
+
+}
+
+#endif
@@ -210,6 +210,26 @@ Func mirror_interior(const Func &source,
     return bounded;
 }
 
+Func padded_copy(const Func &bounded, int vector_width) {
+    user_assert(bounded.defined())
+        << "padded_copy called with undefined Func " << bounded.name() << "\n";
+    user_assert(vector_width >= 1)
+        << "Vector width for the padded copy of Func " << bounded.name() << " must be positive\n";
+
+    std::vector<Var> args(bounded.args());
+    Func padded(bounded.name() + "_padded");
+    padded(args) = bounded(args);
+
+    // Only the edges need the boundary condition, and that's
+    // partitioned out of the steady state of this simple loop.
+    padded.compute_root();
+    if (!args.empty() && vector_width > 1) {
+        padded.vectorize(args[0], vector_width);
+    }
+
+    return padded;
+}
+
 }
 
 }
@@ -263,6 +263,35 @@ inline NO_INLINE Func mirror_interior(T func_like, Bounds... bounds) {
 }
 // @}
 
+/** Materialize a Func with a boundary condition into a padded copy.
+ *
+ *  The functions above wrap every access to the source in clamps or
+ *  selects, and rely on loop partitioning to remove them from the
+ *  steady state of the consumer. That often fails for stencils with
+ *  many taps, or that are computed per tile, leaving the boundary
+ *  logic in the inner loop. This instead returns a wrapper around
+ *  'bounded' (the result of one of the functions above) that is
+ *  computed as a separate stage, so the border is filled in once by
+ *  a simple loop that partitions well, and consumers read dense,
+ *  unclamped memory that can be vectorized.
+ *
+ *  The copy is computed at root. If 'vector_width' is greater than
+ *  one, it is vectorized by that factor along its innermost
+ *  dimension. Pass the natural vector width of the target for the
+ *  element type, e.g. target.natural_vector_size(type). To pad each
+ *  tile's footprint instead of the whole input, call compute_at on
+ *  the result, e.g.:
+ *
+ \code
+ Func padded = BoundaryConditions::padded_copy(BoundaryConditions::repeat_edge(input),
+                                               target.natural_vector_size<uint8_t>());
+ g(x, y) = padded(x - 1, y) + padded(x, y) + padded(x + 1, y);
+ g.tile(x, y, xi, yi, 64, 64);
+ padded.compute_at(g, x);
+ \endcode
+ */
+EXPORT Func padded_copy(const Func &bounded, int vector_width = 1);
+
 }
 
 }
@@ -1,4 +1,5 @@
 #include <iostream>
+#include <set>
 
 #include "Bounds.h"
 #include "IRVisitor.h"
@@ -569,6 +570,40 @@ private:
         op->value.accept(this);
     }
 
+    void visit(const VectorReduce *op) {
+        op->value.accept(this);
+        int factor = op->value.type().lanes() / op->type.lanes();
+        switch (op->op) {
+        case VectorReduce::Add:
+            // The sum of factor lanes, provided it can't overflow.
+            if (op->type.is_float() || op->type.bits() >= 32) {
+                Expr f = make_const(op->type.element_of(), factor);
+                if (interval.has_lower_bound()) {
+                    interval.min *= f;
+                }
+                if (interval.has_upper_bound()) {
+                    interval.max *= f;
+                }
+            } else {
+                bounds_of_type(op->type);
+            }
+            break;
+        case VectorReduce::Min:
+        case VectorReduce::Max:
+            // The result is one of the lanes.
+            break;
+        case VectorReduce::And:
+        case VectorReduce::Or:
+            if (!op->type.is_bool()) {
+                bounds_of_type(op->type);
+            }
+            break;
+        case VectorReduce::Mul:
+            bounds_of_type(op->type);
+            break;
+        }
+    }
+
     void visit(const Call *op) {
         // If the args are const we can return the call of those args
         // for pure functions. For other types of functions, the same
@@ -771,7 +806,9 @@ private:
     }
 };
 
-Interval bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const FuncValueBounds &fb) {
+namespace {
+
+Interval compute_bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const FuncValueBounds &fb) {
     //debug(3) << "computing bounds_of_expr_in_scope " << expr << "\n";
     Bounds b(&scope, fb);
     expr.accept(&b);
@@ -789,6 +826,158 @@ Interval bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const
     return b.interval;
 }
 
+// Find the names of the variables an expression refers to. Names
+// defined by lets inside the expression are included too, which
+// just makes the cache key more specific than it needs to be.
+class FindVariableNames : public IRGraphVisitor {
+    using IRGraphVisitor::visit;
+
+    void visit(const Variable *op) {
+        names.insert(op->name);
+    }
+public:
+    std::set<string> names;
+};
+
+// Simplify both ends of an interval, keeping single points as single
+// points.
+Interval simplify_interval(const Interval &i) {
+    Interval result = i;
+    bool fixed = i.min.same_as(i.max);
+    result.min = simplify(i.min);
+    result.max = fixed ? result.min : simplify(i.max);
+    return result;
+}
+
+// The key of a cached query: the expression, everything in scope
+// that its bounds depend on, and the kind of query.
+struct BoundsCacheKey {
+    bool with_func_bounds, simplified;
+    // The variables the expression refers to, in order of name, and
+    // whether each of them is in scope.
+    vector<std::pair<string, bool>> vars;
+    // The expression, followed by the min and max of each variable
+    // that is in scope. Unbounded ends are Interval::neg_inf and
+    // Interval::pos_inf, which compare equal to themselves.
+    vector<ExprWithCompareCache> exprs;
+
+    bool operator<(const BoundsCacheKey &other) const {
+        if (with_func_bounds != other.with_func_bounds) {
+            return with_func_bounds < other.with_func_bounds;
+        }
+        if (simplified != other.simplified) {
+            return simplified < other.simplified;
+        }
+        if (vars != other.vars) {
+            return vars < other.vars;
+        }
+        return exprs < other.exprs;
+    }
+};
+
+}  // namespace
+
+struct BoundsCache::Contents {
+    const FuncValueBounds *func_bounds;
+    IRCompareCache compare_cache;
+    map<BoundsCacheKey, Interval> intervals;
+
+    Contents(const FuncValueBounds *fb) : func_bounds(fb), compare_cache(8) {}
+
+    BoundsCacheKey make_key(Expr expr, const Scope<Interval> &scope, bool with_func_bounds, bool simplified) {
+        BoundsCacheKey key;
+        key.with_func_bounds = with_func_bounds;
+        key.simplified = simplified;
+        key.exprs.push_back(ExprWithCompareCache(expr, &compare_cache));
+        FindVariableNames vars;
+        expr.accept(&vars);
+        for (const string &v : vars.names) {
+            bool in_scope = scope.contains(v);
+            key.vars.push_back({v, in_scope});
+            if (in_scope) {
+                Interval i = scope.get(v);
+                key.exprs.push_back(ExprWithCompareCache(i.min, &compare_cache));
+                key.exprs.push_back(ExprWithCompareCache(i.max, &compare_cache));
+            }
+        }
+        return key;
+    }
+
+    Interval get(Expr expr, const Scope<Interval> &scope, const FuncValueBounds &fb, bool simplified) {
+        // Don't let the cache grow without bound.
+        const size_t max_entries = 16384;
+        if (intervals.size() >= max_entries) {
+            intervals.clear();
+            compare_cache.clear();
+        }
+
+        BoundsCacheKey key = make_key(expr, scope, !fb.empty(), simplified);
+        auto iter = intervals.find(key);
+        Interval result;
+        if (iter == intervals.end()) {
+            result = compute_bounds_of_expr_in_scope(expr, scope, fb);
+            if (simplified) {
+                result = simplify_interval(result);
+            }
+            intervals.emplace(std::move(key), result);
+        } else {
+            result = iter->second;
+            // A point interval of the cached expression is a point
+            // interval of this one, and callers check for it by identity.
+            const Expr &cached = iter->first.exprs[0].expr;
+            if (result.is_single_point(cached)) {
+                result = Interval::single_point(expr);
+            }
+        }
+        return result;
+    }
+};
+
+namespace {
+
+// The innermost cache alive on this thread, if any. Each thread
+// lowers independently, so no locking is needed.
+thread_local BoundsCache::Contents *active_bounds_cache = nullptr;
+
+}  // namespace
+
+BoundsCache::BoundsCache() : contents(new Contents(nullptr)), enclosing(active_bounds_cache) {
+    active_bounds_cache = contents.get();
+}
+
+BoundsCache::BoundsCache(const FuncValueBounds &fb) : contents(new Contents(&fb)), enclosing(active_bounds_cache) {
+    active_bounds_cache = contents.get();
+}
+
+BoundsCache::~BoundsCache() {
+    internal_assert(active_bounds_cache == contents.get())
+        << "BoundsCache destroyed out of order, or on another thread\n";
+    active_bounds_cache = enclosing;
+}
+
+namespace {
+
+Interval cached_bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope,
+                                        const FuncValueBounds &fb, bool simplified) {
+    // Leaves are cheaper to compute than to look up.
+    bool is_leaf = (expr.as<Variable>() || is_const(expr));
+    BoundsCache::Contents *cache = is_leaf ? nullptr : active_bounds_cache;
+    if (cache && (fb.empty() || &fb == cache->func_bounds)) {
+        return cache->get(expr, scope, fb, simplified);
+    }
+    Interval result = compute_bounds_of_expr_in_scope(expr, scope, fb);
+    if (simplified) {
+        result = simplify_interval(result);
+    }
+    return result;
+}
+
+}  // namespace
+
+Interval bounds_of_expr_in_scope(Expr expr, const Scope<Interval> &scope, const FuncValueBounds &fb) {
+    return cached_bounds_of_expr_in_scope(expr, scope, fb, false);
+}
+
 Region region_union(const Region &a, const Region &b) {
     internal_assert(a.size() == b.size()) << "Mismatched dimensionality in region union\n";
     Region result;
@@ -1038,11 +1227,11 @@ private:
         if (consider_calls) {
             op->value.accept(this);
         }
-        Interval value_bounds = bounds_of_expr_in_scope(op->value, scope, func_bounds);
+        // Every query over an enclosing statement revisits this let,
+        // so the simplified bounds are worth caching too.
+        Interval value_bounds = cached_bounds_of_expr_in_scope(op->value, scope, func_bounds, true);
 
         bool fixed = value_bounds.min.same_as(value_bounds.max);
-        value_bounds.min = simplify(value_bounds.min);
-        value_bounds.max = fixed ? value_bounds.min : simplify(value_bounds.max);
 
         if (is_small_enough_to_substitute(value_bounds.min) &&
             (fixed || is_small_enough_to_substitute(value_bounds.max))) {
@@ -1549,6 +1738,17 @@ void bounds_test() {
     internal_assert(equal(simplify(r2[0].min), 4));
     internal_assert(equal(simplify(r2[0].max), 19));
 
+    // Check that cached bounds respect the scope they were computed in.
+    {
+        BoundsCache cache;
+        Scope<Interval> other_scope;
+        other_scope.push("x", Interval(Expr(5), Expr(6)));
+        check(scope, (x+1)*2, 2, 22);
+        check(other_scope, (x+1)*2, 12, 14);
+        check(scope, (x+1)*2, 2, 22);
+        check(Scope<Interval>(), (x+1)*2, simplify((x+1)*2), simplify((x+1)*2));
+    }
+
     std::cout << "Bounds test passed" << std::endl;
 }
 
@@ -6,6 +6,8 @@
  * and the regions of a function read or written by a statement.
  */
 
+#include <memory>
+
 #include "IROperator.h"
 #include "Scope.h"
 #include "Interval.h"
@@ -31,6 +33,37 @@ Interval bounds_of_expr_in_scope(Expr expr,
                                  const Scope<Interval> &scope,
                                  const FuncValueBounds &func_bounds = FuncValueBounds());
 
+/** Memoizes bounds_of_expr_in_scope. The bounds inference passes
+ * repeatedly ask for the bounds of structurally equal expressions
+ * over the same loop scopes, so while an instance of this class is
+ * alive, queries made on the thread that constructed it are cached,
+ * keyed on the expression, the bounds in scope of the variables it
+ * refers to, and whether function value bounds were used. Boxes are
+ * built from the bounds of each call's arguments, so they benefit
+ * too, and the simplified bounds of let values are cached as
+ * well. Instances must be destroyed in the reverse order of
+ * construction, on the same thread. */
+class BoundsCache {
+public:
+    /** Cache the queries that use no function value bounds. */
+    BoundsCache();
+
+    /** Also cache the queries that use these function value
+     * bounds. They must outlive this object and not change. */
+    explicit BoundsCache(const FuncValueBounds &func_bounds);
+
+    ~BoundsCache();
+
+    struct Contents;
+
+private:
+    std::unique_ptr<Contents> contents;
+    Contents *enclosing;
+
+    BoundsCache(const BoundsCache &) = delete;
+    BoundsCache &operator=(const BoundsCache &) = delete;
+};
+
 /* Given a varying expression, try to find a constant that is either:
  * An upper bound (always greater than or equal to the expression), or
  * A lower bound (always less than or equal to the expression)
@@ -477,9 +477,16 @@ public:
                     Function input(args[j].func);
                     for (int k = 0; k < input.outputs(); k++) {
                         string name = input.name() + ".o" + std::to_string(k) + ".bounds_query." + func.name();
+                        vector<Expr> buf_args = {null_handle, make_zero(input.output_types()[k])};
+                        if (input.dimensions() > 4) {
+                            // Make room for the extern stage to fill
+                            // in the dimensions beyond the fourth.
+                            for (int d = 0; d < input.dimensions() * 3; d++) {
+                                buf_args.push_back(0);
+                            }
+                        }
                         Expr buf = Call::make(type_of<struct buffer_t *>(), Call::create_buffer_t,
-                                              {null_handle, make_zero(input.output_types()[k])},
-                                              Call::Intrinsic);
+                                              buf_args, Call::Intrinsic);
                         lets.push_back(make_pair(name, buf));
                         bounds_inference_args.push_back(Variable::make(type_of<struct buffer_t *>(), name));
                     }
@@ -487,12 +494,13 @@ public:
                     Parameter p = args[j].image_param;
                     Buffer b = args[j].buffer;
                     string name = args[j].is_image_param() ? p.name() : b.name();
+                    int dims = args[j].is_image_param() ? p.dimensions() : b.dimensions();
 
                     Expr in_buf = Variable::make(type_of<struct buffer_t *>(), name + ".buffer");
 
                     // Copy the input buffer into a query buffer to mutate.
                     string query_name = name + ".bounds_query." + func.name();
-                    Expr query_buf = Call::make(type_of<struct buffer_t *>(), Call::copy_buffer_t, {in_buf}, Call::Intrinsic);
+                    Expr query_buf = Call::make(type_of<struct buffer_t *>(), Call::copy_buffer_t, {in_buf, dims}, Call::Intrinsic);
                     lets.push_back(make_pair(query_name, query_buf));
                     Expr buf = Variable::make(type_of<struct buffer_t *>(), query_name, b, p, ReductionDomain());
                     bounds_inference_args.push_back(buf);
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "Buffer.h"
 #include "Debug.h"
 #include "Error.h"
@@ -37,8 +39,13 @@ uint64_t multiply_buffer_size_check_overflow(uint64_t size, uint64_t factor, con
 }
 
 struct BufferContents {
-    /** The buffer_t object we're wrapping. */
-    buffer_t buf;
+    /** The buffer_t object we're wrapping, along with any dimensions
+     * beyond the fourth. */
+    halide_nd_buffer_t nd_buf;
+
+    /** Storage for the dimensions beyond the fourth, which
+     * nd_buf.extra_dim points to. */
+    std::vector<halide_dimension_t> extra_dims;
 
     /** The type of the allocation. buffer_t's don't currently track this so we do it here. */
     Type type;
@@ -49,22 +56,26 @@ struct BufferContents {
      * nullptr. */
     uint8_t *allocation;
 
+    /** An object that owns the memory the buffer points to, if it
+     * wasn't allocated here. Released when the buffer dies. */
+    std::shared_ptr<void> owner;
+
     /** How many Buffer objects point to this BufferContents */
     mutable RefCount ref_count;
 
     /** What is the name of the buffer? Useful for debugging symbols. */
     std::string name;
 
-    BufferContents(Type t, int x_size, int y_size, int z_size, int w_size,
+    BufferContents(Type t, const std::vector<int32_t> &sizes,
                    uint8_t* data, const std::string &n) :
-        type(t), allocation(nullptr), name(n.empty() ? unique_name('b') : n) {
+        nd_buf(), type(t), allocation(nullptr), name(n.empty() ? unique_name('b') : n) {
         user_assert(t.lanes() == 1) << "Can't create of a buffer of a vector type";
+        buffer_t &buf = nd_buf.buf;
         buf.elem_size = t.bytes();
         uint64_t size = 1;
-        size = multiply_buffer_size_check_overflow(size, x_size, name);
-        size = multiply_buffer_size_check_overflow(size, y_size, name);
-        size = multiply_buffer_size_check_overflow(size, z_size, name);
-        size = multiply_buffer_size_check_overflow(size, w_size, name);
+        for (int32_t s : sizes) {
+            size = multiply_buffer_size_check_overflow(size, s, name);
+        }
         size = multiply_buffer_size_check_overflow(size, buf.elem_size, name);
 
         if (!data) {
@@ -80,25 +91,52 @@ struct BufferContents {
         buf.dev = 0;
         buf.host_dirty = false;
         buf.dev_dirty = false;
-        buf.extent[0] = x_size;
-        buf.extent[1] = y_size;
-        buf.extent[2] = z_size;
-        buf.extent[3] = w_size;
-        buf.stride[0] = 1;
-        buf.stride[1] = x_size;
-        buf.stride[2] = x_size*y_size;
-        buf.stride[3] = x_size*y_size*z_size;
-        buf.min[0] = 0;
-        buf.min[1] = 0;
-        buf.min[2] = 0;
-        buf.min[3] = 0;
+        if (sizes.size() > 4) {
+            user_assert(sizes.size() <= HALIDE_BUFFER_MAX_DIMENSIONS)
+                << "Buffer " << name << " has " << sizes.size()
+                << " dimensions. At most " << HALIDE_BUFFER_MAX_DIMENSIONS << " are supported.\n";
+            for (size_t i = 0; i < sizes.size(); i++) {
+                user_assert(sizes[i] != 0)
+                    << "Buffer " << name << " has more than four dimensions, so "
+                    << "the extent of each of its dimensions must be non-zero\n";
+            }
+            extra_dims.resize(sizes.size() - 4);
+            nd_buf.extra_dim = &extra_dims[0];
+            buf.extra_dimensions = (uint8_t)extra_dims.size();
+        }
+        int32_t stride = 1;
+        for (size_t i = 0; i < std::max(sizes.size(), (size_t)4); i++) {
+            int32_t extent = i < sizes.size() ? sizes[i] : 0;
+            if (i < 4) {
+                buf.extent[i] = extent;
+                buf.stride[i] = stride;
+                buf.min[i] = 0;
+            } else {
+                extra_dims[i - 4].extent = extent;
+                extra_dims[i - 4].stride = stride;
+                extra_dims[i - 4].min = 0;
+            }
+            stride *= extent;
+        }
     }
 
     BufferContents(Type t, const buffer_t *b, const std::string &n) :
-        type(t), allocation(nullptr), name(n.empty() ? unique_name('b') : n) {
-        buf = *b;
+        nd_buf(), type(t), allocation(nullptr), name(n.empty() ? unique_name('b') : n) {
+        nd_buf.buf = *b;
         user_assert(t.lanes() == 1) << "Can't create of a buffer of a vector type";
+        int dims = halide_buffer_dimensions(b);
+        user_assert(dims >= 0)
+            << "buffer_t for Buffer " << name << " has " << (int)b->extra_dimensions
+            << " extra dimensions. At most " << HALIDE_BUFFER_MAX_DIMENSIONS - 4
+            << " are supported. Make sure the buffer_t is zero-initialized.\n";
+        if (dims > 4) {
+            for (int i = 4; i < dims; i++) {
+                extra_dims.push_back(halide_buffer_dim(b, i));
+            }
+            nd_buf.extra_dim = &extra_dims[0];
+        }
     }
+
 };
 
 template<>
@@ -110,7 +148,7 @@ template<>
 EXPORT void destroy<BufferContents>(const BufferContents *p) {
     // Ignore errors. We may be cleaning up a buffer after an earlier
     // error, and asserting would re-raise it.
-    halide_device_free(nullptr, const_cast<buffer_t *>(&p->buf));
+    halide_device_free(nullptr, const_cast<buffer_t *>(&p->nd_buf.buf));
     free(p->allocation);
     delete p;
 }
@@ -118,10 +156,6 @@ EXPORT void destroy<BufferContents>(const BufferContents *p) {
 }
 
 namespace {
-int32_t size_or_zero(const std::vector<int32_t> &sizes, size_t index) {
-    return (index < sizes.size()) ? sizes[index] : 0;
-}
-
 std::string make_buffer_name(const std::string &n, Buffer *b) {
     if (n.empty()) {
         return Internal::make_entity_name(b, "Halide::Buffer", 'b');
@@ -133,20 +167,14 @@ std::string make_buffer_name(const std::string &n, Buffer *b) {
 
 Buffer::Buffer(Type t, int x_size, int y_size, int z_size, int w_size,
                uint8_t* data, const std::string &name) :
-    contents(new Internal::BufferContents(t, x_size, y_size, z_size, w_size, data,
+    contents(new Internal::BufferContents(t, {x_size, y_size, z_size, w_size}, data,
                                           make_buffer_name(name, this))) {
 }
 
 Buffer::Buffer(Type t, const std::vector<int32_t> &sizes,
                uint8_t* data, const std::string &name) :
-    contents(new Internal::BufferContents(t,
-                                          size_or_zero(sizes, 0),
-                                          size_or_zero(sizes, 1),
-                                          size_or_zero(sizes, 2),
-                                          size_or_zero(sizes, 3),
-                                          data,
+    contents(new Internal::BufferContents(t, sizes, data,
                                           make_buffer_name(name, this))) {
-    user_assert(sizes.size() <= 4) << "Buffer dimensions greater than 4 are not supported.";
 }
 
 Buffer::Buffer(Type t, const buffer_t *buf, const std::string &name) :
@@ -154,72 +182,92 @@ Buffer::Buffer(Type t, const buffer_t *buf, const std::string &name) :
                                           make_buffer_name(name, this))) {
 }
 
+void Buffer::set_owner(std::shared_ptr<void> owner) {
+    user_assert(defined()) << "Buffer is undefined\n";
+    contents->owner = owner;
+}
+
 void *Buffer::host_ptr() const {
     user_assert(defined()) << "Buffer is undefined\n";
-    return (void *)contents->buf.host;
+    return (void *)contents->nd_buf.buf.host;
 }
 
 buffer_t *Buffer::raw_buffer() const {
     user_assert(defined()) << "Buffer is undefined\n";
-    return &(contents->buf);
+    return &(contents->nd_buf.buf);
 }
 
 uint64_t Buffer::device_handle() const {
     user_assert(defined()) << "Buffer is undefined\n";
-    return contents->buf.dev;
+    return contents->nd_buf.buf.dev;
 }
 
 bool Buffer::host_dirty() const {
     user_assert(defined()) << "Buffer is undefined\n";
-    return contents->buf.host_dirty;
+    return contents->nd_buf.buf.host_dirty;
 }
 
 void Buffer::set_host_dirty(bool dirty) {
     user_assert(defined()) << "Buffer is undefined\n";
-    contents->buf.host_dirty = dirty;
+    contents->nd_buf.buf.host_dirty = dirty;
 }
 
 bool Buffer::device_dirty() const {
     user_assert(defined()) << "Buffer is undefined\n";
-    return contents->buf.dev_dirty;
+    return contents->nd_buf.buf.dev_dirty;
 }
 
 void Buffer::set_device_dirty(bool dirty) {
     user_assert(defined()) << "Buffer is undefined\n";
-    contents->buf.dev_dirty = dirty;
+    contents->nd_buf.buf.dev_dirty = dirty;
 }
 
 int Buffer::dimensions() const {
-    for (int i = 0; i < 4; i++) {
-        if (extent(i) == 0) return i;
-    }
-    return 4;
+    user_assert(defined()) << "Buffer is undefined\n";
+    return halide_buffer_dimensions(&contents->nd_buf.buf);
 }
 
 int Buffer::extent(int dim) const {
     user_assert(defined()) << "Buffer is undefined\n";
-    user_assert(dim >= 0 && dim < 4) << "We only support 4-dimensional buffers for now";
-    return contents->buf.extent[dim];
+    user_assert(dim >= 0 && dim < std::max(4, dimensions()))
+        << "Dimension " << dim << " is out of range for buffer " << name() << "\n";
+    return halide_buffer_dim(&contents->nd_buf.buf, dim).extent;
 }
 
 int Buffer::stride(int dim) const {
     user_assert(defined());
-    user_assert(dim >= 0 && dim < 4) << "We only support 4-dimensional buffers for now";
-    return contents->buf.stride[dim];
+    user_assert(dim >= 0 && dim < std::max(4, dimensions()))
+        << "Dimension " << dim << " is out of range for buffer " << name() << "\n";
+    return halide_buffer_dim(&contents->nd_buf.buf, dim).stride;
 }
 
 int Buffer::min(int dim) const {
     user_assert(defined()) << "Buffer is undefined\n";
-    user_assert(dim >= 0 && dim < 4) << "We only support 4-dimensional buffers for now";
-    return contents->buf.min[dim];
+    user_assert(dim >= 0 && dim < std::max(4, dimensions()))
+        << "Dimension " << dim << " is out of range for buffer " << name() << "\n";
+    return halide_buffer_dim(&contents->nd_buf.buf, dim).min;
 }
 
 void Buffer::set_min(int m0, int m1, int m2, int m3) {
     user_assert(defined()) << "Buffer is undefined\n";
-    contents->buf.min[0] = m0;
-    contents->buf.min[1] = m1;
-    contents->buf.min[2] = m2;
-    contents->buf.min[3] = m3;
+    contents->nd_buf.buf.min[0] = m0;
+    contents->nd_buf.buf.min[1] = m1;
+    contents->nd_buf.buf.min[2] = m2;
+    contents->nd_buf.buf.min[3] = m3;
+}
+
+void Buffer::set_min(const std::vector<int32_t> &mins) {
+    user_assert(defined()) << "Buffer is undefined\n";
+    user_assert((int)mins.size() <= std::max(4, dimensions()))
+        << "Can't set " << mins.size() << " mins of buffer " << name()
+        << ", which has " << dimensions() << " dimensions\n";
+    for (size_t i = 0; i < mins.size(); i++) {
+        if (i < 4) {
+            contents->nd_buf.buf.min[i] = mins[i];
+        } else {
+            contents->extra_dims[i - 4].min = mins[i];
+        }
+    }
 }
 
 Type Buffer::type() const {
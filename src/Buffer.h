@@ -5,6 +5,7 @@
  * Defines Buffer - A c++ wrapper around a buffer_t.
  */
 
+#include <memory>
 #include <stdint.h>
 
 #include "runtime/HalideRuntime.h" // For buffer_t
@@ -38,11 +39,20 @@ public:
     EXPORT Buffer(Type t, int x_size = 0, int y_size = 0, int z_size = 0, int w_size = 0,
                   uint8_t* data = nullptr, const std::string &name = "");
 
+    /** Make a buffer with the given extents, which may have more
+     * than four dimensions. The raw buffer_t of a buffer of more than
+     * four dimensions is the first member of a halide_nd_buffer_t. */
     EXPORT Buffer(Type t, const std::vector<int32_t> &sizes,
                   uint8_t* data = nullptr, const std::string &name = "");
 
     EXPORT Buffer(Type t, const buffer_t *buf, const std::string &name = "");
 
+    /** Keep the given object alive for as long as this buffer
+     * exists. Use this when the buffer points to memory owned by
+     * something else, e.g. an array from another language's
+     * runtime. Replaces any previous owner. */
+    EXPORT void set_owner(std::shared_ptr<void> owner);
+
     /** Get a pointer to the host-side memory. */
     EXPORT void *host_ptr() const;
 
@@ -77,7 +87,8 @@ public:
 
     /** Get the dimensionality of this buffer. Uses the convention
      * that the extent field of a buffer_t should contain zero when
-     * the dimensions end. */
+     * the dimensions end, and includes any dimensions beyond the
+     * fourth (see halide_nd_buffer_t). */
     EXPORT int dimensions() const;
 
     /** Get the extent of this buffer in the given dimension. */
@@ -97,6 +108,10 @@ public:
      * that corresponds to the base address of the buffer. */
     EXPORT void set_min(int m0, int m1 = 0, int m2 = 0, int m3 = 0);
 
+    /** Set the mins of the first mins.size() dimensions of this
+     * buffer, which may include dimensions beyond the fourth. */
+    EXPORT void set_min(const std::vector<int32_t> &mins);
+
     /** Get the Halide type of the contents of this buffer. */
     EXPORT Type type() const;
 
@@ -549,6 +549,81 @@ void CodeGen_ARM::visit(const Min *op) {
     CodeGen_Posix::visit(op);
 }
 
+namespace {
+// The llvm name mangling for a vector type, e.g. v8i16
+string mangle_vector_type(Type t) {
+    return "v" + std::to_string(t.lanes()) + (t.is_float() ? "f" : "i") + std::to_string(t.bits());
+}
+}
+
+void CodeGen_ARM::visit(const VectorReduce *op) {
+    const int input_lanes = op->value.type().lanes();
+    const int factor = input_lanes / op->type.lanes();
+
+    if (neon_intrinsics_disabled() ||
+        op->op != VectorReduce::Add ||
+        factor % 2 != 0) {
+        CodeGen_Posix::visit(op);
+        return;
+    }
+
+    // Sums of adjacent pairs of lanes are pairwise adds, widening
+    // (vpaddl/[us]addlp) if the value is a widening cast.
+    Value *partial = nullptr;
+    const Cast *cast = op->value.as<Cast>();
+    Type narrow = cast ? cast->value.type() : Type();
+    if (cast && (narrow.is_int() || narrow.is_uint()) &&
+        (op->type.is_int() || op->type.is_uint()) &&
+        narrow.bits() * 2 == op->type.bits() &&
+        input_lanes % (128 / narrow.bits()) == 0) {
+        int chunk = 128 / narrow.bits();
+        Type result_t = op->type.with_lanes(chunk / 2);
+        string intrin;
+        if (target.bits == 32) {
+            intrin = narrow.is_uint() ? "llvm.arm.neon.vpaddlu." : "llvm.arm.neon.vpaddls.";
+        } else {
+            intrin = narrow.is_uint() ? "llvm.aarch64.neon.uaddlp." : "llvm.aarch64.neon.saddlp.";
+        }
+        intrin += mangle_vector_type(result_t) + "." + mangle_vector_type(narrow.with_lanes(chunk));
+
+        Value *v = codegen(cast->value);
+        vector<Value *> pieces;
+        for (int i = 0; i < input_lanes; i += chunk) {
+            pieces.push_back(call_intrin(llvm_type_of(result_t), chunk / 2, intrin,
+                                         {slice_vector(v, i, chunk)}));
+        }
+        partial = concat_vectors(pieces);
+    } else if ((op->type.is_float() && op->type.bits() == 32) ||
+               ((op->type.is_int() || op->type.is_uint()) && op->type.bits() <= 32)) {
+        // vpadd works on 64-bit vectors, addp on 128-bit ones.
+        int chunk = (target.bits == 32 ? 64 : 128) / op->type.bits();
+        if (input_lanes % (chunk * 2) == 0) {
+            Type t = op->value.type().with_lanes(chunk);
+            string intrin;
+            if (target.bits == 32) {
+                intrin = "llvm.arm.neon.vpadd.";
+            } else {
+                intrin = t.is_float() ? "llvm.aarch64.neon.faddp." : "llvm.aarch64.neon.addp.";
+            }
+            intrin += mangle_vector_type(t);
+
+            Value *v = codegen(op->value);
+            vector<Value *> pieces;
+            for (int i = 0; i < input_lanes; i += chunk * 2) {
+                pieces.push_back(call_intrin(llvm_type_of(t), chunk, intrin,
+                                             {slice_vector(v, i, chunk), slice_vector(v, i + chunk, chunk)}));
+            }
+            partial = concat_vectors(pieces);
+        }
+    }
+
+    if (partial) {
+        value = codegen_vector_reduce(op->op, partial, op->type.with_lanes(input_lanes / 2), op->type.lanes());
+    } else {
+        CodeGen_Posix::visit(op);
+    }
+}
+
 void CodeGen_ARM::visit(const Max *op) {
     if (neon_intrinsics_disabled()) {
         CodeGen_Posix::visit(op);
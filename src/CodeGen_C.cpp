@@ -3,6 +3,7 @@
 
 #include "CodeGen_C.h"
 #include "CodeGen_Internal.h"
+#include "Closure.h"
 #include "Substitute.h"
 #include "IROperator.h"
 #include "Param.h"
@@ -42,8 +43,16 @@ const string buffer_t_definition =
     "    int32_t elem_size;\n"
     "    HALIDE_ATTRIBUTE_ALIGN(1) bool host_dirty;\n"
     "    HALIDE_ATTRIBUTE_ALIGN(1) bool dev_dirty;\n"
-    "    HALIDE_ATTRIBUTE_ALIGN(1) uint8_t _padding[10 - sizeof(void *)];\n"
+    "    HALIDE_ATTRIBUTE_ALIGN(1) uint8_t extra_dimensions;\n"
+    "    HALIDE_ATTRIBUTE_ALIGN(1) uint8_t _padding[9 - sizeof(void *)];\n"
     "} buffer_t;\n"
+    "typedef struct halide_dimension_t {\n"
+    "    int32_t min, extent, stride;\n"
+    "} halide_dimension_t;\n"
+    "typedef struct halide_nd_buffer_t {\n"
+    "    buffer_t buf;\n"
+    "    halide_dimension_t *extra_dim;\n"
+    "} halide_nd_buffer_t;\n"
     "#endif\n";
 
 const string headers =
@@ -59,12 +68,16 @@ const string globals =
     "extern \"C\" {\n"
     "void *halide_malloc(void *ctx, size_t);\n"
     "void halide_free(void *ctx, void *ptr);\n"
+    "void halide_device_host_nop_free(void *ctx, void *obj);\n"
     "void *halide_print(void *ctx, const void *str);\n"
     "void *halide_error(void *ctx, const void *str);\n"
+    "int halide_error_bad_dimensions(void *ctx, const char *buffer_name, int, int);\n"
     "int halide_debug_to_file(void *ctx, const char *filename, int, struct buffer_t *buf);\n"
     "int halide_start_clock(void *ctx);\n"
     "int64_t halide_current_time_ns(void *ctx);\n"
     "void halide_profiler_pipeline_end(void *, void *);\n"
+    "typedef int (*halide_task_t)(void *user_context, int task_number, uint8_t *closure);\n"
+    "int halide_do_par_for(void *ctx, halide_task_t task, int min, int size, uint8_t *closure);\n"
     "}\n"
     "\n"
 
@@ -158,7 +171,101 @@ const string globals =
     " b->stride[2] = stride2;\n"
     " b->stride[3] = stride3;\n"
     " return true;\n"
+    "}\n"
+    "\n"
+    "static bool halide_rewrite_buffer_dim(buffer_t *b, int d,\n"
+    "                               int32_t min, int32_t extent, int32_t stride) {\n"
+    " halide_dimension_t *dim = &((halide_nd_buffer_t *)b)->extra_dim[d - 4];\n"
+    " dim->min = min;\n"
+    " dim->extent = extent;\n"
+    " dim->stride = stride;\n"
+    " return true;\n"
     "}\n";
+
+// Vector types for the C backend. Where the compiler supports GCC/Clang
+// vector extensions, power-of-two vectors are backed by a native vector
+// type so arithmetic compiles to SIMD instructions. Otherwise (or if
+// HALIDE_C_NO_VECTOR_EXTENSIONS is defined) they fall back to a struct
+// of lanes operated on with scalar loops. Boolean vectors are stored
+// as one byte per lane.
+const string vector_types =
+    "#if !defined(HALIDE_C_NO_VECTOR_EXTENSIONS) && (defined(__GNUC__) || defined(__clang__))\n"
+    "#define HALIDE_C_VECTOR_EXTENSIONS 1\n"
+    "#else\n"
+    "#define HALIDE_C_VECTOR_EXTENSIONS 0\n"
+    "#endif\n"
+    "template<typename T> struct halide_lane_type {typedef T type;};\n"
+    "template<> struct halide_lane_type<bool> {typedef uint8_t type;};\n"
+    "template<typename T, int N> struct halide_lane_array {\n"
+    " T x[N];\n"
+    " T &operator[](int i) {return x[i];}\n"
+    " const T &operator[](int i) const {return x[i];}\n"
+    "#define HALIDE_LANE_ARRAY_BINOP(OP) \\\n"
+    " friend halide_lane_array operator OP(const halide_lane_array &a, const halide_lane_array &b) { \\\n"
+    "  halide_lane_array r; for (int i = 0; i < N; i++) r.x[i] = a.x[i] OP b.x[i]; return r;}\n"
+    " HALIDE_LANE_ARRAY_BINOP(+) HALIDE_LANE_ARRAY_BINOP(-) HALIDE_LANE_ARRAY_BINOP(*) HALIDE_LANE_ARRAY_BINOP(/)\n"
+    " HALIDE_LANE_ARRAY_BINOP(%) HALIDE_LANE_ARRAY_BINOP(&) HALIDE_LANE_ARRAY_BINOP(|) HALIDE_LANE_ARRAY_BINOP(^)\n"
+    " HALIDE_LANE_ARRAY_BINOP(<<) HALIDE_LANE_ARRAY_BINOP(>>)\n"
+    "#undef HALIDE_LANE_ARRAY_BINOP\n"
+    " friend halide_lane_array operator>>(const halide_lane_array &a, int b) {\n"
+    "  halide_lane_array r; for (int i = 0; i < N; i++) r.x[i] = a.x[i] >> b; return r;}\n"
+    " friend halide_lane_array operator~(const halide_lane_array &a) {\n"
+    "  halide_lane_array r; for (int i = 0; i < N; i++) r.x[i] = ~a.x[i]; return r;}\n"
+    "};\n"
+    "template<typename T, int N, bool native = HALIDE_C_VECTOR_EXTENSIONS && ((N & (N - 1)) == 0)>\n"
+    "struct halide_vector_storage {typedef halide_lane_array<T, N> type;};\n"
+    "#if HALIDE_C_VECTOR_EXTENSIONS\n"
+    "template<typename T, int N> struct halide_vector_storage<T, N, true> {\n"
+    " typedef T type __attribute__((vector_size(N * sizeof(T))));\n"
+    "};\n"
+    "#endif\n"
+    "template<typename T, int N> struct halide_vector {\n"
+    " typedef typename halide_lane_type<T>::type lane_t;\n"
+    " typedef typename halide_vector_storage<lane_t, N>::type storage_t;\n"
+    " storage_t v;\n"
+    " T operator[](int i) const {return (T)v[i];}\n"
+    " void set_lane(int i, T x) {v[i] = (lane_t)x;}\n"
+    " static halide_vector broadcast(T x) {\n"
+    "  halide_vector r; for (int i = 0; i < N; i++) r.v[i] = (lane_t)x; return r;}\n"
+    " static halide_vector ramp(T base, T stride) {\n"
+    "  halide_vector r; for (int i = 0; i < N; i++) r.v[i] = (lane_t)(base + stride * i); return r;}\n"
+    " static halide_vector load(const void *base, int32_t offset) {\n"
+    "  halide_vector r; memcpy(&r.v, (const lane_t *)base + offset, sizeof(r.v)); return r;}\n"
+    " static halide_vector load_gather(const void *base, const halide_vector<int32_t, N> &offset) {\n"
+    "  halide_vector r; for (int i = 0; i < N; i++) r.v[i] = ((const lane_t *)base)[offset.v[i]]; return r;}\n"
+    " void store(void *base, int32_t offset) const {\n"
+    "  memcpy((lane_t *)base + offset, &v, sizeof(v));}\n"
+    " void store_scatter(void *base, const halide_vector<int32_t, N> &offset) const {\n"
+    "  for (int i = 0; i < N; i++) ((lane_t *)base)[offset.v[i]] = v[i];}\n"
+    " template<typename U> static halide_vector convert_from(const halide_vector<U, N> &x) {\n"
+    "  halide_vector r; for (int i = 0; i < N; i++) r.v[i] = (lane_t)(T)(U)x.v[i]; return r;}\n"
+    " static halide_vector select(const halide_vector<bool, N> &c, const halide_vector &a, const halide_vector &b) {\n"
+    "  halide_vector r; for (int i = 0; i < N; i++) r.v[i] = c.v[i] ? a.v[i] : b.v[i]; return r;}\n"
+    "#define HALIDE_VECTOR_BINOP(OP) \\\n"
+    " friend halide_vector operator OP(const halide_vector &a, const halide_vector &b) { \\\n"
+    "  halide_vector r; r.v = a.v OP b.v; return r;}\n"
+    " HALIDE_VECTOR_BINOP(+) HALIDE_VECTOR_BINOP(-) HALIDE_VECTOR_BINOP(*) HALIDE_VECTOR_BINOP(/)\n"
+    " HALIDE_VECTOR_BINOP(%) HALIDE_VECTOR_BINOP(&) HALIDE_VECTOR_BINOP(|) HALIDE_VECTOR_BINOP(^)\n"
+    " HALIDE_VECTOR_BINOP(<<) HALIDE_VECTOR_BINOP(>>)\n"
+    "#undef HALIDE_VECTOR_BINOP\n"
+    " friend halide_vector operator>>(const halide_vector &a, int b) {\n"
+    "  halide_vector r; r.v = a.v >> b; return r;}\n"
+    " friend halide_vector operator~(const halide_vector &a) {\n"
+    "  halide_vector r; r.v = ~a.v; return r;}\n"
+    "#define HALIDE_VECTOR_LOGICAL_OP(OP) \\\n"
+    " friend halide_vector<bool, N> operator OP(const halide_vector &a, const halide_vector &b) { \\\n"
+    "  halide_vector<bool, N> r; for (int i = 0; i < N; i++) r.v[i] = a.v[i] OP b.v[i]; return r;}\n"
+    " HALIDE_VECTOR_LOGICAL_OP(==) HALIDE_VECTOR_LOGICAL_OP(!=) HALIDE_VECTOR_LOGICAL_OP(<)\n"
+    " HALIDE_VECTOR_LOGICAL_OP(<=) HALIDE_VECTOR_LOGICAL_OP(>) HALIDE_VECTOR_LOGICAL_OP(>=)\n"
+    " HALIDE_VECTOR_LOGICAL_OP(&&) HALIDE_VECTOR_LOGICAL_OP(||)\n"
+    "#undef HALIDE_VECTOR_LOGICAL_OP\n"
+    " friend halide_vector<bool, N> operator!(const halide_vector &a) {\n"
+    "  halide_vector<bool, N> r; for (int i = 0; i < N; i++) r.v[i] = !a.v[i]; return r;}\n"
+    "};\n"
+    "template<typename T, int N> halide_vector<T, N> max(const halide_vector<T, N> &a, const halide_vector<T, N> &b) {\n"
+    " return halide_vector<T, N>::select(a > b, a, b);}\n"
+    "template<typename T, int N> halide_vector<T, N> min(const halide_vector<T, N> &a, const halide_vector<T, N> &b) {\n"
+    " return halide_vector<T, N>::select(a < b, a, b);}\n";
 }
 
 CodeGen_C::CodeGen_C(ostream &s, OutputKind output_kind, const std::string &guard) : IRPrinter(s), id("$$ BAD ID $$"), output_kind(output_kind) {
@@ -181,6 +288,7 @@ CodeGen_C::CodeGen_C(ostream &s, OutputKind output_kind, const std::string &guar
 
     if (!is_header()) {
         stream << globals;
+        stream << vector_types;
     }
 
     // Throw in a default (empty) definition of HALIDE_FUNCTION_ATTRS
@@ -213,8 +321,11 @@ namespace {
 string type_to_c_type(Type type, bool include_space, bool c_plus_plus = true) {
     bool needs_space = true;
     ostringstream oss;
-    user_assert(type.lanes() == 1) << "Can't use vector types when compiling to C (yet)\n";
-    if (type.is_float()) {
+    if (type.is_vector()) {
+        user_assert(!type.is_handle()) << "Can't use vectors of handles when compiling to C\n";
+        oss << "halide_vector<" << type_to_c_type(type.element_of(), false, c_plus_plus)
+            << ", " << type.lanes() << ">";
+    } else if (type.is_float()) {
         if (type.bits() == 32) {
             oss << "float";
         } else if (type.bits() == 64) {
@@ -367,7 +478,7 @@ class ExternCallPrototypes : public IRGraphVisitor {
             }
 
             if (!emitted.count(name)) {
-                stream << type_to_c_type(op->type, true) << " " << name << "(";
+                stream << type_to_c_type(op->type.element_of(), true) << " " << name << "(";
                 if (function_takes_user_context(name)) {
                     stream << "void *";
                     if (op->args.size()) {
@@ -381,7 +492,7 @@ class ExternCallPrototypes : public IRGraphVisitor {
                     if (op->args[i].as<StringImm>()) {
                         stream << "const char *";
                     } else {
-                      stream << type_to_c_type(op->args[i].type(), true);
+                      stream << type_to_c_type(op->args[i].type().element_of(), true);
                     }
                 }
                 stream << ");";
@@ -532,7 +643,7 @@ void CodeGen_C::compile(const LoweredFunc &f) {
         // Unpack the buffer_t's
         for (size_t i = 0; i < args.size(); i++) {
             if (args[i].is_buffer()) {
-                push_buffer(args[i].type, args[i].name);
+                push_buffer(args[i].type, args[i].name, args[i].dimensions);
             }
         }
         // Emit the body
@@ -590,11 +701,12 @@ void CodeGen_C::compile(const Buffer &buffer) {
 
     string name = print_name(buffer.name());
     buffer_t b = *(buffer.raw_buffer());
+    int dims = buffer.dimensions();
 
     // Figure out the offset of the last pixel.
     size_t num_elems = 1;
-    for (int d = 0; b.extent[d]; d++) {
-        num_elems += b.stride[d] * (b.extent[d] - 1);
+    for (int d = 0; d < dims; d++) {
+        num_elems += buffer.stride(d) * (buffer.extent(d) - 1);
     }
 
     // Emit the data
@@ -608,21 +720,40 @@ void CodeGen_C::compile(const Buffer &buffer) {
     // Emit the buffer_t
     user_assert(b.host) << "Can't embed image: " << buffer.name() << " because it has a null host pointer\n";
     user_assert(!b.dev_dirty) << "Can't embed image: " << buffer.name() << "because it has a dirty device pointer\n";
-    stream << "static buffer_t " << name << "_buffer = {"
-           << "0, " // dev
+    std::ostringstream fields;
+    fields << "0, " // dev
            << "&" << name << "_data[0], " // host
            << "{" << b.extent[0] << ", " << b.extent[1] << ", " << b.extent[2] << ", " << b.extent[3] << "}, "
            << "{" << b.stride[0] << ", " << b.stride[1] << ", " << b.stride[2] << ", " << b.stride[3] << "}, "
            << "{" << b.min[0] << ", " << b.min[1] << ", " << b.min[2] << ", " << b.min[3] << "}, "
            << b.elem_size << ", "
            << "0, " // host_dirty
-           << "0};\n"; //dev_dirty
+           << "0"; // dev_dirty
+
+    if (dims > 4) {
+        // Emit the dimensions beyond the fourth, and a
+        // halide_nd_buffer_t that points to them.
+        stream << "static halide_dimension_t " << name << "_extra_dim[] = {";
+        for (int d = 4; d < dims; d++) {
+            if (d > 4) stream << ", ";
+            stream << "{" << buffer.min(d) << ", " << buffer.extent(d) << ", " << buffer.stride(d) << "}";
+        }
+        stream << "};\n";
+        stream << "static halide_nd_buffer_t " << name << "_nd_buffer = {{"
+               << fields.str() << ", "
+               << dims - 4 << "}, " // extra_dimensions
+               << "&" << name << "_extra_dim[0]};\n";
+        stream << "static buffer_t *" << name << " = &" << name << "_nd_buffer.buf;\n";
+    } else {
+        stream << "static buffer_t " << name << "_buffer = {"
+               << fields.str() << "};\n";
 
-    // Make a global pointer to it
-    stream << "static buffer_t *" << name << " = &" << name << "_buffer;\n";
+        // Make a global pointer to it
+        stream << "static buffer_t *" << name << " = &" << name << "_buffer;\n";
+    }
 }
 
-void CodeGen_C::push_buffer(Type t, const std::string &buffer_name) {
+void CodeGen_C::push_buffer(Type t, const std::string &buffer_name, int dimensions) {
     string name = print_name(buffer_name);
     string buf_name = name + "_buffer";
     string type = print_type(t);
@@ -650,6 +781,27 @@ void CodeGen_C::push_buffer(Type t, const std::string &buffer_name) {
     do_indent();
     stream << "(void)" << name << "_host_and_dev_are_null;\n";
 
+    // Buffers of more than four dimensions must say where the rest
+    // are before we can look at them. Buffers of four or fewer must
+    // not claim to have more, or the runtime's device copies and
+    // cache will look for the rest past the end of the buffer_t.
+    {
+        string user_context = have_user_context ? "(void *)" + print_name("__user_context") : "nullptr";
+        do_indent();
+        if (dimensions > 4) {
+            stream << "if (" << buf_name << "->extra_dimensions != " << dimensions - 4 << ") ";
+        } else {
+            stream << "if (" << buf_name << "->extent[3] != 0 && "
+                   << buf_name << "->extra_dimensions != 0) ";
+        }
+        open_scope();
+        do_indent();
+        stream << "return halide_error_bad_dimensions("
+               << user_context << ", \"" << buffer_name << "\", "
+               << buf_name << "->extra_dimensions + 4, " << dimensions << ");\n";
+        close_scope("");
+    }
+
     for (int j = 0; j < 4; j++) {
         do_indent();
         stream << "const int32_t "
@@ -681,6 +833,19 @@ void CodeGen_C::push_buffer(Type t, const std::string &buffer_name) {
         do_indent();
         stream << "(void)" << name << "_stride_" << j << ";\n";
     }
+    for (int j = 4; j < dimensions; j++) {
+        const char *fields[] = {"min", "extent", "stride"};
+        for (const char *field : fields) {
+            do_indent();
+            stream << "const int32_t "
+                   << name
+                   << "_" << field << "_" << j << " = "
+                   << "((halide_nd_buffer_t *)" << buf_name << ")"
+                   << "->extra_dim[" << j - 4 << "]." << field << ";\n";
+            do_indent();
+            stream << "(void)" << name << "_" << field << "_" << j << ";\n";
+        }
+    }
     do_indent();
     stream << "const int32_t "
            << name
@@ -743,7 +908,51 @@ void CodeGen_C::visit(const Variable *op) {
 }
 
 void CodeGen_C::visit(const Cast *op) {
-    print_assignment(op->type, "(" + print_type(op->type) + ")(" + print_expr(op->value) + ")");
+    if (op->type.is_vector()) {
+        print_assignment(op->type, print_type(op->type) + "::convert_from(" + print_expr(op->value) + ")");
+    } else {
+        print_assignment(op->type, "(" + print_type(op->type) + ")(" + print_expr(op->value) + ")");
+    }
+}
+
+string CodeGen_C::print_shuffle(Type t, const vector<Expr> &vecs, const vector<int> &indices) {
+    internal_assert((int)indices.size() == t.lanes());
+
+    // Evaluate each input, and note where its lanes start in the
+    // concatenation of all of the inputs.
+    vector<string> ids;
+    vector<int> first_lane;
+    int total_lanes = 0;
+    for (Expr v : vecs) {
+        ids.push_back(print_expr(v));
+        first_lane.push_back(total_lanes);
+        total_lanes += v.type().lanes();
+    }
+
+    auto lane = [&](int idx) {
+        internal_assert(idx >= 0 && idx < total_lanes) << "Shuffle index out of range\n";
+        size_t i = 0;
+        while (i + 1 < vecs.size() && first_lane[i + 1] <= idx) i++;
+        if (vecs[i].type().is_scalar()) {
+            return ids[i];
+        } else {
+            return ids[i] + "[" + std::to_string(idx - first_lane[i]) + "]";
+        }
+    };
+
+    if (t.is_scalar()) {
+        return print_assignment(t, lane(indices[0]));
+    }
+
+    string result_id = unique_name('_');
+    do_indent();
+    stream << print_type(t, AppendSpace) << result_id << ";\n";
+    for (size_t i = 0; i < indices.size(); i++) {
+        do_indent();
+        stream << result_id << ".set_lane(" << i << ", " << lane(indices[i]) << ");\n";
+    }
+    id = result_id;
+    return id;
 }
 
 void CodeGen_C::visit_binop(Type t, Expr a, Expr b, const char * op) {
@@ -779,7 +988,10 @@ void CodeGen_C::visit(const Div *op) {
 
 void CodeGen_C::visit(const Mod *op) {
     int bits;
-    if (is_const_power_of_two_integer(op->b, &bits)) {
+    if (op->type.is_vector() && is_const_power_of_two_integer(op->b, &bits)) {
+        Expr mask = make_const(op->type, (1 << bits) - 1);
+        print_expr(Call::make(op->type, Call::bitwise_and, {op->a, mask}, Call::PureIntrinsic));
+    } else if (is_const_power_of_two_integer(op->b, &bits)) {
         ostringstream oss;
         oss << print_expr(op->a) << " & " << ((1 << bits)-1);
         print_assignment(op->type, oss.str());
@@ -791,11 +1003,25 @@ void CodeGen_C::visit(const Mod *op) {
 }
 
 void CodeGen_C::visit(const Max *op) {
-    print_expr(Call::make(op->type, "max", {op->a, op->b}, Call::Extern));
+    if (op->type.is_vector()) {
+        // Vector max is a template in the vector preamble, not an
+        // extern call to be scalarized.
+        string a = print_expr(op->a);
+        string b = print_expr(op->b);
+        print_assignment(op->type, "max(" + a + ", " + b + ")");
+    } else {
+        print_expr(Call::make(op->type, "max", {op->a, op->b}, Call::Extern));
+    }
 }
 
 void CodeGen_C::visit(const Min *op) {
-    print_expr(Call::make(op->type, "min", {op->a, op->b}, Call::Extern));
+    if (op->type.is_vector()) {
+        string a = print_expr(op->a);
+        string b = print_expr(op->b);
+        print_assignment(op->type, "min(" + a + ", " + b + ")");
+    } else {
+        print_expr(Call::make(op->type, "min", {op->a, op->b}, Call::Extern));
+    }
 }
 
 void CodeGen_C::visit(const EQ *op) {
@@ -846,6 +1072,66 @@ void CodeGen_C::visit(const UIntImm *op) {
     print_assignment(op->type, "(" + print_type(op->type) + ")(" + std::to_string(op->value) + ")");
 }
 
+void CodeGen_C::visit(const Ramp *op) {
+    string base = print_expr(op->base);
+    string stride = print_expr(op->stride);
+    print_assignment(op->type, print_type(op->type) + "::ramp(" + base + ", " + stride + ")");
+}
+
+void CodeGen_C::visit(const Broadcast *op) {
+    string value = print_expr(op->value);
+    print_assignment(op->type, print_type(op->type) + "::broadcast(" + value + ")");
+}
+
+void CodeGen_C::visit(const VectorReduce *op) {
+    // Slice out every factor-th lane of the value, starting at each
+    // lane of a group, and combine the slices pairwise.
+    int lanes = op->type.lanes();
+    int factor = op->value.type().lanes() / lanes;
+    Expr value = Variable::make(op->value.type(), print_expr(op->value));
+
+    vector<Expr> slices(factor);
+    for (int i = 0; i < factor; i++) {
+        vector<Expr> args = {value};
+        for (int j = 0; j < lanes; j++) {
+            args.push_back(j * factor + i);
+        }
+        slices[i] = Call::make(op->type, Call::shuffle_vector, args, Call::PureIntrinsic);
+    }
+
+    while (slices.size() > 1) {
+        vector<Expr> combined;
+        for (size_t i = 0; i + 1 < slices.size(); i += 2) {
+            Expr a = slices[i], b = slices[i + 1];
+            switch (op->op) {
+            case VectorReduce::Add:
+                combined.push_back(a + b);
+                break;
+            case VectorReduce::Mul:
+                combined.push_back(a * b);
+                break;
+            case VectorReduce::Min:
+                combined.push_back(Min::make(a, b));
+                break;
+            case VectorReduce::Max:
+                combined.push_back(Max::make(a, b));
+                break;
+            case VectorReduce::And:
+                combined.push_back(op->type.is_bool() ? (a && b) : (a & b));
+                break;
+            case VectorReduce::Or:
+                combined.push_back(op->type.is_bool() ? (a || b) : (a | b));
+                break;
+            }
+        }
+        if (slices.size() % 2) {
+            combined.push_back(slices.back());
+        }
+        slices.swap(combined);
+    }
+    print_expr(slices[0]);
+}
+
 void CodeGen_C::visit(const StringImm *op) {
     ostringstream oss;
     oss << Expr(op);
@@ -949,7 +1235,6 @@ void CodeGen_C::visit(const Call *op) {
         int dims = ((int)(op->args.size())-2)/3;
         (void)dims; // In case internal_assert is ifdef'd to do nothing
         internal_assert((int)(op->args.size()) == dims*3 + 2);
-        internal_assert(dims <= 4);
         vector<string> args(op->args.size());
         const Variable *v = op->args[0].as<Variable>();
         internal_assert(v);
@@ -967,6 +1252,46 @@ void CodeGen_C::visit(const Call *op) {
             }
         }
         rhs << ")";
+        for (int i = 4; i < dims; i++) {
+            rhs << " && halide_rewrite_buffer_dim(" << args[0] << ", " << i << ", "
+                << args[i*3+2] << ", " << args[i*3+3] << ", " << args[i*3+4] << ")";
+        }
+    } else if (op->is_intrinsic(Call::shuffle_vector)) {
+        internal_assert((int)op->args.size() == 1 + op->type.lanes());
+        vector<int> indices;
+        for (size_t i = 1; i < op->args.size(); i++) {
+            const int64_t *idx = as_const_int(op->args[i]);
+            internal_assert(idx);
+            indices.push_back((int)*idx);
+        }
+        rhs << print_shuffle(op->type, {op->args[0]}, indices);
+    } else if (op->is_intrinsic(Call::slice_vector)) {
+        internal_assert(op->args.size() == 4);
+        const int64_t *start = as_const_int(op->args[1]);
+        const int64_t *stride = as_const_int(op->args[2]);
+        internal_assert(start && stride) << "argument to slice_vector must be a constant.\n";
+        vector<int> indices;
+        for (int i = 0; i < op->type.lanes(); i++) {
+            indices.push_back((int)(*start + *stride * i));
+        }
+        rhs << print_shuffle(op->type, {op->args[0]}, indices);
+    } else if (op->is_intrinsic(Call::concat_vectors)) {
+        vector<int> indices;
+        for (int i = 0; i < op->type.lanes(); i++) {
+            indices.push_back(i);
+        }
+        rhs << print_shuffle(op->type, op->args, indices);
+    } else if (op->is_intrinsic(Call::interleave_vectors)) {
+        internal_assert(!op->args.empty());
+        int arg_lanes = op->args[0].type().lanes();
+        int num_args = (int)op->args.size();
+        vector<int> indices;
+        for (int i = 0; i < arg_lanes; i++) {
+            for (int j = 0; j < num_args; j++) {
+                indices.push_back(j * arg_lanes + i);
+            }
+        }
+        rhs << print_shuffle(op->type, op->args, indices);
     } else if (op->is_intrinsic(Call::lerp)) {
         internal_assert(op->args.size() == 3);
         Expr e = lower_lerp(op->args[0], op->args[1], op->args[2]);
@@ -1022,11 +1347,32 @@ void CodeGen_C::visit(const Call *op) {
 
         rhs << result_id;
     } else if (op->is_intrinsic(Call::copy_buffer_t)) {
-        internal_assert(op->args.size() == 1);
+        internal_assert(op->args.size() == 1 || op->args.size() == 2);
         string arg = print_expr(op->args[0]);
+        int dims = 4;
+        if (op->args.size() > 1) {
+            const IntImm *d = op->args[1].as<IntImm>();
+            internal_assert(d) << "The second argument to copy_buffer_t must be a constant\n";
+            dims = (int)d->value;
+        }
         string buf_id = unique_name('B');
-        stream << "buffer_t " << buf_id << " = *((buffer_t *)(" << arg << "))\n";
-        rhs << "(&" << buf_id << ")";
+        if (dims > 4) {
+            // Copy the dimensions beyond the fourth too, so that the
+            // copy can be mutated independently of the original.
+            do_indent();
+            stream << "halide_dimension_t " << buf_id << "_extra_dim[" << dims - 4 << "];\n";
+            do_indent();
+            stream << "memcpy(" << buf_id << "_extra_dim, ((halide_nd_buffer_t *)(" << arg << "))->extra_dim, "
+                   << "sizeof(" << buf_id << "_extra_dim));\n";
+            do_indent();
+            stream << "halide_nd_buffer_t " << buf_id << " = {*((buffer_t *)(" << arg << ")), "
+                   << buf_id << "_extra_dim};\n";
+            rhs << "(&" << buf_id << ".buf)";
+        } else {
+            do_indent();
+            stream << "buffer_t " << buf_id << " = *((buffer_t *)(" << arg << "));\n";
+            rhs << "(&" << buf_id << ")";
+        }
     } else if (op->is_intrinsic(Call::create_buffer_t)) {
         internal_assert(op->args.size() >= 2);
         vector<string> args;
@@ -1036,33 +1382,66 @@ void CodeGen_C::visit(const Call *op) {
             args.push_back(print_expr(op->args[i]));
         }
         string buf_id = unique_name('B');
-        do_indent();
-        stream << "buffer_t " << buf_id << " = {0};\n";
+        int dims = ((int)op->args.size() - 2)/3;
+        if (dims > 4) {
+            do_indent();
+            stream << "halide_dimension_t " << buf_id << "_extra_dim[" << dims - 4 << "];\n";
+            do_indent();
+            stream << "halide_nd_buffer_t " << buf_id << "_nd = {{0}, " << buf_id << "_extra_dim};\n";
+            do_indent();
+            stream << "buffer_t &" << buf_id << " = " << buf_id << "_nd.buf;\n";
+            do_indent();
+            stream << buf_id << ".extra_dimensions = " << dims - 4 << ";\n";
+        } else {
+            do_indent();
+            stream << "buffer_t " << buf_id << " = {0};\n";
+        }
         do_indent();
         stream << buf_id << ".host = const_cast<uint8_t *>((const uint8_t *)(" << args[0] << "));\n";
         do_indent();
         stream << buf_id << ".elem_size = " << args[1] << ";\n";
-        int dims = ((int)op->args.size() - 2)/3;
         for (int i = 0; i < dims; i++) {
             do_indent();
-            stream << buf_id << ".min[" << i << "] = " << args[i*3+2] << ";\n";
-            do_indent();
-            stream << buf_id << ".extent[" << i << "] = " << args[i*3+3] << ";\n";
-            do_indent();
-            stream << buf_id << ".stride[" << i << "] = " << args[i*3+4] << ";\n";
+            if (i < 4) {
+                stream << buf_id << ".min[" << i << "] = " << args[i*3+2] << ";\n";
+                do_indent();
+                stream << buf_id << ".extent[" << i << "] = " << args[i*3+3] << ";\n";
+                do_indent();
+                stream << buf_id << ".stride[" << i << "] = " << args[i*3+4] << ";\n";
+            } else {
+                string dim = buf_id + "_extra_dim[" + std::to_string(i - 4) + "]";
+                stream << dim << ".min = " << args[i*3+2] << ";\n";
+                do_indent();
+                stream << dim << ".extent = " << args[i*3+3] << ";\n";
+                do_indent();
+                stream << dim << ".stride = " << args[i*3+4] << ";\n";
+            }
         }
         rhs << "(&" + buf_id + ")";
     } else if (op->is_intrinsic(Call::extract_buffer_max)) {
         internal_assert(op->args.size() == 2);
+        const IntImm *idx = op->args[1].as<IntImm>();
+        internal_assert(idx);
         string a0 = print_expr(op->args[0]);
-        string a1 = print_expr(op->args[1]);
-        rhs << "(((buffer_t *)(" << a0 << "))->min[" << a1 << "] + " <<
-            "((buffer_t *)(" << a0 << "))->extent[" << a1 << "] - 1)";
+        if (idx->value >= 4) {
+            string dim = "((halide_nd_buffer_t *)(" + a0 + "))->extra_dim[" + std::to_string(idx->value - 4) + "]";
+            rhs << "(" << dim << ".min + " << dim << ".extent - 1)";
+        } else {
+            string a1 = print_expr(op->args[1]);
+            rhs << "(((buffer_t *)(" << a0 << "))->min[" << a1 << "] + " <<
+                "((buffer_t *)(" << a0 << "))->extent[" << a1 << "] - 1)";
+        }
     } else if (op->is_intrinsic(Call::extract_buffer_min)) {
         internal_assert(op->args.size() == 2);
+        const IntImm *idx = op->args[1].as<IntImm>();
+        internal_assert(idx);
         string a0 = print_expr(op->args[0]);
-        string a1 = print_expr(op->args[1]);
-        rhs << "((buffer_t *)(" << a0 << "))->min[" << a1 << "]";
+        if (idx->value >= 4) {
+            rhs << "((halide_nd_buffer_t *)(" << a0 << "))->extra_dim[" << idx->value - 4 << "].min";
+        } else {
+            string a1 = print_expr(op->args[1]);
+            rhs << "((buffer_t *)(" << a0 << "))->min[" << a1 << "]";
+        }
     } else if (op->is_intrinsic(Call::extract_buffer_host)) {
         internal_assert(op->args.size() == 1);
         string a0 = print_expr(op->args[0]);
@@ -1206,6 +1585,32 @@ void CodeGen_C::visit(const Call *op) {
         for (size_t i = 0; i < op->args.size(); i++) {
             args[i] = print_expr(op->args[i]);
         }
+
+        if (op->type.is_vector()) {
+            // There are no vector versions of extern functions, so
+            // call the scalar version once per lane.
+            string result_id = unique_name('_');
+            do_indent();
+            stream << print_type(op->type, AppendSpace) << result_id << ";\n";
+            for (int lane = 0; lane < op->type.lanes(); lane++) {
+                do_indent();
+                stream << result_id << ".set_lane(" << lane << ", " << name << "(";
+                if (function_takes_user_context(op->name)) {
+                    stream << (have_user_context ? "__user_context_, " : "nullptr, ");
+                }
+                for (size_t i = 0; i < op->args.size(); i++) {
+                    if (i > 0) stream << ", ";
+                    stream << args[i];
+                    if (op->args[i].type().is_vector()) {
+                        stream << "[" << lane << "]";
+                    }
+                }
+                stream << "));\n";
+            }
+            id = result_id;
+            return;
+        }
+
         rhs << name << "(";
 
         if (function_takes_user_context(op->name)) {
@@ -1225,6 +1630,23 @@ void CodeGen_C::visit(const Call *op) {
 void CodeGen_C::visit(const Load *op) {
 
     Type t = op->type;
+
+    if (t.is_vector()) {
+        // Dense vector loads are a single unaligned load of the whole
+        // vector. Everything else is a gather.
+        ostringstream rhs;
+        const Ramp *ramp = op->index.as<Ramp>();
+        if (ramp && is_one(ramp->stride)) {
+            string base = print_expr(ramp->base);
+            rhs << print_type(t) << "::load(" << print_name(op->name) << ", " << base << ")";
+        } else {
+            string index = print_expr(op->index);
+            rhs << print_type(t) << "::load_gather(" << print_name(op->name) << ", " << index << ")";
+        }
+        print_assignment(t, rhs.str());
+        return;
+    }
+
     bool type_cast_needed =
         !allocations.contains(op->name) ||
         allocations.get(op->name).type != t;
@@ -1250,6 +1672,27 @@ void CodeGen_C::visit(const Store *op) {
 
     Type t = op->value.type();
 
+    if (op->name == atomic_producer) {
+        visit_atomic_store(op);
+        return;
+    }
+
+    if (t.is_vector()) {
+        string id_value = print_expr(op->value);
+        const Ramp *ramp = op->index.as<Ramp>();
+        if (ramp && is_one(ramp->stride)) {
+            string id_base = print_expr(ramp->base);
+            do_indent();
+            stream << id_value << ".store(" << print_name(op->name) << ", " << id_base << ");\n";
+        } else {
+            string id_index = print_expr(op->index);
+            do_indent();
+            stream << id_value << ".store_scatter(" << print_name(op->name) << ", " << id_index << ");\n";
+        }
+        cache.clear();
+        return;
+    }
+
     bool type_cast_needed =
         t.is_handle() ||
         !allocations.contains(op->name) ||
@@ -1277,6 +1720,41 @@ void CodeGen_C::visit(const Store *op) {
     cache.clear();
 }
 
+void CodeGen_C::visit_atomic_store(const Store *op) {
+    Type t = op->value.type();
+    internal_assert(t.is_scalar() && t.bits() >= 8 && !t.is_handle())
+        << "Atomic store to " << op->name << " of unsupported type " << t << "\n";
+
+    string id_index = print_expr(op->index);
+    string id_ptr = unique_name('_');
+    string id_old = unique_name('_');
+    string id_new = unique_name('_');
+    do_indent();
+    stream << print_type(t) << " *" << id_ptr << " = (("
+           << print_type(t) << " *)" << print_name(op->name) << ") + " << id_index << ";\n";
+    do_indent();
+    stream << print_type(t) << " " << id_old << " = __atomic_load_n(" << id_ptr << ", __ATOMIC_RELAXED);\n";
+    do_indent();
+    stream << print_type(t) << " " << id_new << ";\n";
+
+    // Recompute the new value from the old one until no other
+    // thread has changed it in the meantime.
+    Expr value = substitute_self_load(op->value, op->name, Variable::make(t, id_old));
+    do_indent();
+    stream << "do {\n";
+    indent++;
+    string id_value = print_expr(value);
+    do_indent();
+    stream << id_new << " = " << id_value << ";\n";
+    indent--;
+    do_indent();
+    stream << "} while (!__atomic_compare_exchange(" << id_ptr << ", &" << id_old << ", &" << id_new
+           << ", false, __ATOMIC_RELAXED, __ATOMIC_RELAXED));\n";
+
+    // Values computed inside the loop body are out of scope now.
+    cache.clear();
+}
+
 void CodeGen_C::visit(const Let *op) {
     string id_value = print_expr(op->value);
     Expr new_var = Variable::make(op->value.type(), id_value);
@@ -1289,6 +1767,12 @@ void CodeGen_C::visit(const Select *op) {
     string true_val = print_expr(op->true_value);
     string false_val = print_expr(op->false_value);
     string cond = print_expr(op->condition);
+    if (op->condition.type().is_vector()) {
+        rhs << print_type(op->type) << "::select("
+            << cond << ", " << true_val << ", " << false_val << ")";
+        print_assignment(op->type, rhs.str());
+        return;
+    }
     rhs << "(" << print_type(op->type) << ")"
         << "(" << cond
         << " ? " << true_val
@@ -1338,18 +1822,139 @@ void CodeGen_C::visit(const ProducerConsumer *op) {
     print_stmt(op->consume);
 }
 
-void CodeGen_C::visit(const For *op) {
-    if (op->for_type == ForType::Parallel) {
+namespace {
+// Lets are substituted into their bodies as fake Variables named
+// after whatever print_expr returned, which may be a literal (e.g. a
+// constant, or a call to float_from_bits) rather than the name of a C
+// variable. Those don't need to go in closures.
+bool names_c_variable(const string &name) {
+    if (name.empty() || !(isalpha(name[0]) || name[0] == '_')) {
+        return false;
+    }
+    return name.find_first_of("()*/ ") == string::npos;
+}
+}
+
+void CodeGen_C::visit_parallel_for(const For *op, const string &id_min, const string &id_extent) {
+    // Find every symbol that the body of this loop refers to.
+    Closure closure(op->body, op->name);
+
+    vector<string> member_types, member_names, member_values;
+    for (const auto &v : closure.vars) {
+        // The task function gets the user context as an argument.
+        if (v.first == "__user_context" || !names_c_variable(v.first)) continue;
+        member_types.push_back(print_type(v.second, AppendSpace));
+        member_names.push_back(print_name(v.first));
+        member_values.push_back(print_name(v.first));
+    }
+    for (const auto &b : closure.buffers) {
+        Type t = allocations.contains(b.first) ? allocations.get(b.first).type : b.second.type;
+        string type = print_type(t.element_of());
+        member_types.push_back(type + " *");
+        member_names.push_back(print_name(b.first));
+        member_values.push_back("(" + type + " *)" + print_name(b.first));
+    }
+
+    string closure_type = unique_name('c') + "_t";
+    string closure_id = unique_name('c');
+    string task_id = unique_name('t');
+    string closure_arg = unique_name('a');
+    string result_id = unique_name('r');
+    string user_context = have_user_context ? "(void *)" + print_name("__user_context") : "nullptr";
+
+    open_scope();
+
+    // Pack the closure
+    do_indent();
+    stream << "struct " << closure_type << " {\n";
+    for (size_t i = 0; i < member_names.size(); i++) {
+        do_indent();
+        stream << " " << member_types[i] << member_names[i] << ";\n";
+    }
+    do_indent();
+    stream << "} " << closure_id << " = {";
+    for (size_t i = 0; i < member_values.size(); i++) {
+        if (i > 0) stream << ", ";
+        stream << member_values[i];
+    }
+    stream << "};\n";
+
+    // Outline the loop body into a task function. A lambda with no
+    // captures converts to a halide_task_t, so it can be handed to
+    // halide_do_par_for like the task functions the llvm backend
+    // makes.
+    do_indent();
+    stream << "auto " << task_id << " = [](void *" << print_name("__user_context")
+           << ", int32_t " << print_name(op->name)
+           << ", uint8_t *" << closure_arg << ") -> int32_t {\n";
+    indent++;
+    cache.clear();
+    if (!member_names.empty()) {
+        string closure_ptr = unique_name('p');
         do_indent();
-        stream << "#pragma omp parallel for\n";
+        stream << closure_type << " *" << closure_ptr << " = ("
+               << closure_type << " *)" << closure_arg << ";\n";
+        for (size_t i = 0; i < member_names.size(); i++) {
+            do_indent();
+            stream << member_types[i] << member_names[i] << " = "
+                   << closure_ptr << "->" << member_names[i] << ";\n";
+        }
     } else {
-        internal_assert(op->for_type == ForType::Serial)
-            << "Can only emit serial or parallel for loops to C\n";
+        do_indent();
+        stream << "(void)" << closure_arg << ";\n";
     }
+    op->body.accept(this);
+    do_indent();
+    stream << "return 0;\n";
+    cache.clear();
+    indent--;
+    do_indent();
+    stream << "};\n";
 
+    // Run it. Defining HALIDE_C_USE_OPENMP when compiling the
+    // generated code runs the tasks from an OpenMP loop instead of
+    // Halide's thread pool.
+    stream << "#ifdef HALIDE_C_USE_OPENMP\n";
+    do_indent();
+    stream << "int32_t " << result_id << " = 0;\n";
+    do_indent();
+    stream << "#pragma omp parallel for\n";
+    do_indent();
+    stream << "for (int " << print_name(op->name) << " = " << id_min << "; "
+           << print_name(op->name) << " < " << id_min << " + " << id_extent << "; "
+           << print_name(op->name) << "++)\n";
+    open_scope();
+    do_indent();
+    stream << "int32_t " << result_id << "_task = " << task_id << "("
+           << user_context << ", " << print_name(op->name)
+           << ", (uint8_t *)&" << closure_id << ");\n";
+    do_indent();
+    stream << "if (" << result_id << "_task) " << result_id << " = " << result_id << "_task;\n";
+    close_scope("for " + print_name(op->name));
+    stream << "#else\n";
+    do_indent();
+    stream << "int32_t " << result_id << " = halide_do_par_for("
+           << user_context << ", " << task_id << ", "
+           << id_min << ", " << id_extent << ", (uint8_t *)&" << closure_id << ");\n";
+    stream << "#endif\n";
+    do_indent();
+    stream << "if (" << result_id << ") return " << result_id << ";\n";
+
+    close_scope("parallel for " + print_name(op->name));
+}
+
+void CodeGen_C::visit(const For *op) {
     string id_min = print_expr(op->min);
     string id_extent = print_expr(op->extent);
 
+    if (op->for_type == ForType::Parallel) {
+        visit_parallel_for(op, id_min, id_extent);
+        return;
+    } else {
+        internal_assert(op->for_type == ForType::Serial)
+            << "Can only emit serial or parallel for loops to C\n";
+    }
+
     do_indent();
     stream << "for (int "
            << print_name(op->name)
@@ -1385,7 +1990,10 @@ void CodeGen_C::visit(const Allocate *op) {
         alloc.free_function = op->free_function;
         allocations.push(op->name, alloc);
         heap_allocations.push(op->name, 0);
-        stream << print_type(op->type) << "*" << print_name(op->name) << " = (" << print_expr(op->new_expr) << ");\n";
+        string new_expr = print_expr(op->new_expr);
+        do_indent();
+        stream << print_type(op->type) << " *" << print_name(op->name)
+               << " = (" << print_type(op->type) << " *)(" << new_expr << ");\n";
     } else {
         constant_size = op->constant_allocation_size();
         if (constant_size > 0) {
@@ -1515,6 +2123,13 @@ void CodeGen_C::visit(const IfThenElse *op) {
     }
 }
 
+void CodeGen_C::visit(const Atomic *op) {
+    string old_producer = atomic_producer;
+    atomic_producer = op->producer_name;
+    print_stmt(op->body);
+    atomic_producer = old_producer;
+}
+
 void CodeGen_C::visit(const Evaluate *op) {
     if (is_const(op->value)) return;
     string id = print_expr(op->value);
@@ -1554,6 +2169,7 @@ void CodeGen_C::test() {
         buffer_t_definition +
         "struct halide_filter_metadata_t;\n" +
         globals +
+        vector_types +
         "#ifndef HALIDE_FUNCTION_ATTRS\n"
         "#define HALIDE_FUNCTION_ATTRS\n"
         "#endif\n"
@@ -89,6 +89,11 @@ protected:
     /** Emit an SSA-style assignment, and set id to the freshly generated name. Return id. */
     std::string print_assignment(Type t, const std::string &rhs);
 
+    /** Emit a vector (or scalar) of type t whose lanes are selected
+     * by index from the concatenation of the given vectors. Sets id
+     * to the result and returns it. */
+    std::string print_shuffle(Type t, const std::vector<Expr> &vecs, const std::vector<int> &indices);
+
     /** Return true if only generating an interface, which may be extern "C" or C++ */
     bool is_header() {
         return output_kind == CHeader ||
@@ -108,7 +113,7 @@ protected:
     void close_scope(const std::string &comment);
 
     /** Unpack a buffer into its constituent parts and push it on the allocations stack. */
-    void push_buffer(Type t, const std::string &buffer_name);
+    void push_buffer(Type t, const std::string &buffer_name, int dimensions);
 
     /** Pop a buffer from the stack. */
     void pop_buffer(const std::string &buffer_name);
@@ -127,12 +132,19 @@ protected:
     /** True if there is a void * __user_context parameter in the arguments. */
     bool have_user_context;
 
+    /** The buffer whose stores must currently be atomic, or the
+     * empty string outside of an Atomic node. */
+    std::string atomic_producer;
+
     using IRPrinter::visit;
 
     void visit(const Variable *);
     void visit(const IntImm *);
     void visit(const UIntImm *);
     void visit(const StringImm *);
+    void visit(const Ramp *);
+    void visit(const Broadcast *);
+    void visit(const VectorReduce *);
     void visit(const FloatImm *);
     void visit(const Cast *);
     void visit(const Add *);
@@ -166,8 +178,17 @@ protected:
     void visit(const Realize *);
     void visit(const IfThenElse *);
     void visit(const Evaluate *);
+    void visit(const Atomic *);
 
     void visit_binop(Type t, Expr a, Expr b, const char *op);
+
+    /** Emit a parallel for loop by outlining the body into a task
+     * function and calling halide_do_par_for. */
+    void visit_parallel_for(const For *op, const std::string &id_min, const std::string &id_extent);
+
+    /** Emit a scalar store as a compare-and-swap loop that recomputes
+     * the stored value from the value it read. */
+    void visit_atomic_store(const Store *op);
 };
 
 }
@@ -2,6 +2,7 @@
 #include "IROperator.h"
 #include "CSE.h"
 #include "Debug.h"
+#include "IRMutator.h"
 
 namespace Halide {
 namespace Internal {
@@ -250,6 +251,32 @@ Expr lower_euclidean_mod(Expr a, Expr b) {
     }
 }
 
+namespace {
+
+class SubstituteSelfLoad : public IRMutator {
+    const string &buffer;
+    Expr replacement;
+
+    using IRMutator::visit;
+
+    void visit(const Load *op) {
+        if (op->name == buffer) {
+            internal_assert(op->type == replacement.type());
+            expr = replacement;
+        } else {
+            IRMutator::visit(op);
+        }
+    }
+public:
+    SubstituteSelfLoad(const string &b, Expr r) : buffer(b), replacement(r) {}
+};
+
+}  // namespace
+
+Expr substitute_self_load(Expr e, const string &buffer, Expr replacement) {
+    return SubstituteSelfLoad(buffer, replacement).mutate(e);
+}
+
 bool get_md_bool(LLVMMDNodeArgumentType value, bool &result) {
     if (!value) {
         return false;
@@ -57,6 +57,12 @@ Expr lower_euclidean_div(Expr a, Expr b);
 Expr lower_euclidean_mod(Expr a, Expr b);
 ///@}
 
+/** Replace every load from the named buffer in an expression with
+ * the given replacement. Used to express the value stored by an
+ * atomic update in terms of the value it read, which associativity
+ * checking guarantees is the only site of the buffer referenced. */
+Expr substitute_self_load(Expr e, const std::string &buffer, Expr replacement);
+
 /** Given an llvm::Module, set llvm:TargetOptions, cpu and attr information */
 void get_target_options(const llvm::Module &module, llvm::TargetOptions &options, std::string &mcpu, std::string &mattrs);
 
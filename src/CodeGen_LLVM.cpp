@@ -588,7 +588,7 @@ void CodeGen_LLVM::begin_func(LoweredFunc::LinkageType linkage, const std::strin
         for (auto &arg : function->args()) {
             sym_push(args[i].name, &arg);
             if (args[i].is_buffer()) {
-                push_buffer(args[i].name, &arg);
+                push_buffer(args[i].name, args[i].dimensions, &arg);
             }
 
             if (args[i].alignment.modulus != 0) {
@@ -607,7 +607,7 @@ void CodeGen_LLVM::end_func(const std::vector<LoweredArgument>& args) {
     for (size_t i = 0; i < args.size(); i++) {
         sym_pop(args[i].name);
         if (args[i].is_buffer()) {
-            pop_buffer(args[i].name);
+            pop_buffer(args[i].name, args[i].dimensions);
         }
 
         if (args[i].alignment.modulus != 0) {
@@ -736,14 +736,23 @@ void CodeGen_LLVM::compile_buffer(const Buffer &buf) {
         << " because it has a dirty device pointer\n";
 
     // Figure out the offset of the last pixel.
+    int dims = buf.dimensions();
     size_t num_elems = 1;
-    for (int d = 0; b.extent[d]; d++) {
-        num_elems += b.stride[d] * (b.extent[d] - 1);
+    for (int d = 0; d < dims; d++) {
+        num_elems += buf.stride(d) * (buf.extent(d) - 1);
     }
     vector<char> array(b.host, b.host + num_elems * b.elem_size);
 
-    // Embed the buffer_t and make it point to the data array.
-    GlobalVariable *global = new GlobalVariable(*module, buffer_t_type,
+    // Embed the buffer_t and make it point to the data array. Buffers
+    // of more than four dimensions are embedded as a
+    // halide_nd_buffer_t pointing to an array of the rest.
+    llvm::Type *global_type = buffer_t_type;
+    StructType *nd_buffer_t_type = nullptr;
+    if (dims > 4) {
+        nd_buffer_t_type = StructType::get(*context, {buffer_t_type, i32_t->getPointerTo()});
+        global_type = nd_buffer_t_type;
+    }
+    GlobalVariable *global = new GlobalVariable(*module, global_type,
                                                 false, GlobalValue::PrivateLinkage,
                                                 0, buf.name() + ".buffer");
     llvm::ArrayType *i32_array = ArrayType::get(i32_t, 4);
@@ -766,19 +775,33 @@ void CodeGen_LLVM::compile_buffer(const Buffer &buf) {
         ConstantInt::get(i32_t, b.elem_size),
         ConstantInt::get(i8_t, 1), // host_dirty
         ConstantInt::get(i8_t, 0), // dev_dirty
+        ConstantInt::get(i8_t, b.extra_dimensions),
         Constant::getNullValue(padding_bytes_type)
     };
     Constant *buffer_struct = ConstantStruct::get(buffer_t_type, fields);
-    global->setInitializer(buffer_struct);
 
+    if (nd_buffer_t_type) {
+        vector<int32_t> extra_dims;
+        for (int d = 4; d < dims; d++) {
+            extra_dims.push_back(buf.min(d));
+            extra_dims.push_back(buf.extent(d));
+            extra_dims.push_back(buf.stride(d));
+        }
+        llvm::ArrayType *extra_dims_type = ArrayType::get(i32_t, extra_dims.size());
+        GlobalVariable *extra_dims_global =
+            new GlobalVariable(*module, extra_dims_type,
+                               true, GlobalValue::PrivateLinkage,
+                               ConstantArray::get(extra_dims_type, get_constants(i32_t, extra_dims.begin(), extra_dims.end())),
+                               buf.name() + ".extra_dims");
+        Constant *extra_dims_ptr = ConstantExpr::getPointerCast(extra_dims_global, i32_t->getPointerTo());
+        Constant *nd_fields[] = {buffer_struct, extra_dims_ptr};
+        global->setInitializer(ConstantStruct::get(nd_buffer_t_type, nd_fields));
+    } else {
+        global->setInitializer(buffer_struct);
+    }
 
     // Finally, dump it in the symbol table
-    Constant *zero[] = {ConstantInt::get(i32_t, 0)};
-#if LLVM_VERSION >= 37
-    Constant *global_ptr = ConstantExpr::getInBoundsGetElementPtr(buffer_t_type, global, zero);
-#else
-    Constant *global_ptr = ConstantExpr::getInBoundsGetElementPtr(global, zero);
-#endif
+    Constant *global_ptr = ConstantExpr::getPointerCast(global, buffer_t_type->getPointerTo());
     sym_push(buf.name(), global_ptr);
     sym_push(buf.name() + ".buffer", global_ptr);
 }
@@ -1041,12 +1064,35 @@ bool CodeGen_LLVM::sym_exists(const string &name) const {
 
 // Take an llvm Value representing a pointer to a buffer_t,
 // and populate the symbol table with its constituent parts
-void CodeGen_LLVM::push_buffer(const string &name, llvm::Value *buffer) {
+void CodeGen_LLVM::push_buffer(const string &name, int dimensions, llvm::Value *buffer) {
     // Make sure the buffer object itself is not null
     create_assertion(builder->CreateIsNotNull(buffer),
                      Call::make(Int(32), "halide_error_buffer_argument_is_null",
                                 {name}, Call::Extern));
 
+    // Buffers of more than four dimensions must say where the rest
+    // are before we can look at them. Buffers of four or fewer must
+    // not claim to have more, or the runtime's device copies and
+    // cache will look for the rest past the end of the buffer_t.
+    Value *extra = builder->CreateLoad(buffer_extra_dimensions_ptr(buffer));
+    extra = builder->CreateZExt(extra, i32_t);
+    sym_push(name + ".extra_dimensions", extra);
+    Expr extra_var = Variable::make(Int(32), name + ".extra_dimensions");
+    if (dimensions > 4) {
+        create_assertion(codegen(extra_var == dimensions - 4),
+                         Call::make(Int(32), "halide_error_bad_dimensions",
+                                    {name, extra_var + 4, dimensions}, Call::Extern));
+    } else {
+        // extra_dimensions is ignored unless all four extents are non-zero.
+        sym_push(name + ".extent.3", buffer_extent(buffer, 3));
+        Expr extent_var = Variable::make(Int(32), name + ".extent.3");
+        create_assertion(codegen(extent_var == 0 || extra_var == 0),
+                         Call::make(Int(32), "halide_error_bad_dimensions",
+                                    {name, extra_var + 4, dimensions}, Call::Extern));
+        sym_pop(name + ".extent.3");
+    }
+    sym_pop(name + ".extra_dimensions");
+
     Value *host_ptr = buffer_host(buffer);
     Value *dev_ptr = buffer_dev(buffer);
 
@@ -1064,40 +1110,28 @@ void CodeGen_LLVM::push_buffer(const string &name, llvm::Value *buffer) {
     sym_push(name + ".host_and_dev_are_null", nullity_test);
     sym_push(name + ".host_dirty", buffer_host_dirty(buffer));
     sym_push(name + ".dev_dirty", buffer_dev_dirty(buffer));
-    sym_push(name + ".extent.0", buffer_extent(buffer, 0));
-    sym_push(name + ".extent.1", buffer_extent(buffer, 1));
-    sym_push(name + ".extent.2", buffer_extent(buffer, 2));
-    sym_push(name + ".extent.3", buffer_extent(buffer, 3));
-    sym_push(name + ".stride.0", buffer_stride(buffer, 0));
-    sym_push(name + ".stride.1", buffer_stride(buffer, 1));
-    sym_push(name + ".stride.2", buffer_stride(buffer, 2));
-    sym_push(name + ".stride.3", buffer_stride(buffer, 3));
-    sym_push(name + ".min.0", buffer_min(buffer, 0));
-    sym_push(name + ".min.1", buffer_min(buffer, 1));
-    sym_push(name + ".min.2", buffer_min(buffer, 2));
-    sym_push(name + ".min.3", buffer_min(buffer, 3));
+    for (int i = 0; i < std::max(4, dimensions); i++) {
+        string dim = std::to_string(i);
+        sym_push(name + ".extent." + dim, buffer_extent(buffer, i));
+        sym_push(name + ".stride." + dim, buffer_stride(buffer, i));
+        sym_push(name + ".min." + dim, buffer_min(buffer, i));
+    }
     sym_push(name + ".elem_size", buffer_elem_size(buffer));
 }
 
-void CodeGen_LLVM::pop_buffer(const string &name) {
+void CodeGen_LLVM::pop_buffer(const string &name, int dimensions) {
     sym_pop(name + ".buffer");
     sym_pop(name + ".host");
     sym_pop(name + ".dev");
     sym_pop(name + ".host_and_dev_are_null");
     sym_pop(name + ".host_dirty");
     sym_pop(name + ".dev_dirty");
-    sym_pop(name + ".extent.0");
-    sym_pop(name + ".extent.1");
-    sym_pop(name + ".extent.2");
-    sym_pop(name + ".extent.3");
-    sym_pop(name + ".stride.0");
-    sym_pop(name + ".stride.1");
-    sym_pop(name + ".stride.2");
-    sym_pop(name + ".stride.3");
-    sym_pop(name + ".min.0");
-    sym_pop(name + ".min.1");
-    sym_pop(name + ".min.2");
-    sym_pop(name + ".min.3");
+    for (int i = 0; i < std::max(4, dimensions); i++) {
+        string dim = std::to_string(i);
+        sym_pop(name + ".extent." + dim);
+        sym_pop(name + ".stride." + dim);
+        sym_pop(name + ".min." + dim);
+    }
     sym_pop(name + ".elem_size");
 }
 
@@ -1179,6 +1213,9 @@ Value *CodeGen_LLVM::buffer_dev_dirty_ptr(Value *buffer) {
 }
 
 Value *CodeGen_LLVM::buffer_extent_ptr(Value *buffer, int i) {
+    if (i >= 4) {
+        return buffer_extra_dim_ptr(buffer, i, 1);
+    }
     llvm::Value *zero = ConstantInt::get(i32_t, 0);
     llvm::Value *field = ConstantInt::get(i32_t, 2);
     llvm::Value *idx = ConstantInt::get(i32_t, i);
@@ -1193,6 +1230,9 @@ Value *CodeGen_LLVM::buffer_extent_ptr(Value *buffer, int i) {
 }
 
 Value *CodeGen_LLVM::buffer_stride_ptr(Value *buffer, int i) {
+    if (i >= 4) {
+        return buffer_extra_dim_ptr(buffer, i, 2);
+    }
     llvm::Value *zero = ConstantInt::get(i32_t, 0);
     llvm::Value *field = ConstantInt::get(i32_t, 3);
     llvm::Value *idx = ConstantInt::get(i32_t, i);
@@ -1207,6 +1247,9 @@ Value *CodeGen_LLVM::buffer_stride_ptr(Value *buffer, int i) {
 }
 
 Value *CodeGen_LLVM::buffer_min_ptr(Value *buffer, int i) {
+    if (i >= 4) {
+        return buffer_extra_dim_ptr(buffer, i, 0);
+    }
     llvm::Value *zero = ConstantInt::get(i32_t, 0);
     llvm::Value *field = ConstantInt::get(i32_t, 4);
     llvm::Value *idx = ConstantInt::get(i32_t, i);
@@ -1231,6 +1274,64 @@ Value *CodeGen_LLVM::buffer_elem_size_ptr(Value *buffer) {
         "buf_elem_size");
 }
 
+Value *CodeGen_LLVM::buffer_extra_dimensions_ptr(Value *buffer) {
+    return builder->CreateConstInBoundsGEP2_32(
+#if LLVM_VERSION >= 37
+        buffer_t_type,
+#endif
+        buffer,
+        0,
+        8,
+        "buf_extra_dimensions");
+}
+
+Value *CodeGen_LLVM::buffer_extra_dim_ptr(Value *buffer, int i, int field) {
+    internal_assert(i >= 4 && field >= 0 && field < 3);
+    // The pointer to the extra dimensions directly follows the
+    // buffer_t in a halide_nd_buffer_t.
+    Value *extra_dim_ptr = builder->CreateConstInBoundsGEP1_32(
+#if LLVM_VERSION >= 37
+        buffer_t_type,
+#endif
+        buffer,
+        1);
+    extra_dim_ptr = builder->CreatePointerCast(extra_dim_ptr, i32_t->getPointerTo()->getPointerTo());
+    Value *extra_dim = builder->CreateLoad(extra_dim_ptr);
+    return builder->CreateConstInBoundsGEP1_32(
+#if LLVM_VERSION >= 37
+        i32_t,
+#endif
+        extra_dim,
+        (i - 4) * 3 + field,
+        "buf_extra_dim");
+}
+
+Value *CodeGen_LLVM::create_buffer_t_at_entry(int dimensions) {
+    if (dimensions <= 4) {
+        Value *buffer = create_alloca_at_entry(buffer_t_type, 1);
+        builder->CreateStore(ConstantInt::get(i8_t, 0), buffer_extra_dimensions_ptr(buffer));
+        return buffer;
+    }
+
+    // Make a halide_nd_buffer_t, and the array of extra dimensions
+    // it points to.
+    llvm::Type *extra_dim_ptr_type = i32_t->getPointerTo();
+    StructType *nd_buffer_t_type = StructType::get(*context, {buffer_t_type, extra_dim_ptr_type});
+    Value *nd_buffer = create_alloca_at_entry(nd_buffer_t_type, 1);
+    Value *extra_dim = create_alloca_at_entry(i32_t, (dimensions - 4) * 3);
+    Value *buffer = builder->CreatePointerCast(nd_buffer, buffer_t_type->getPointerTo());
+    Value *extra_dim_ptr = builder->CreateConstInBoundsGEP2_32(
+#if LLVM_VERSION >= 37
+        nd_buffer_t_type,
+#endif
+        nd_buffer,
+        0,
+        1);
+    builder->CreateStore(extra_dim, extra_dim_ptr);
+    builder->CreateStore(ConstantInt::get(i8_t, dimensions - 4), buffer_extra_dimensions_ptr(buffer));
+    return buffer;
+}
+
 Value *CodeGen_LLVM::codegen(Expr e) {
     internal_assert(e.defined());
     debug(4) << "Codegen: " << e.type() << ", " << e << "\n";
@@ -1949,6 +2050,97 @@ void CodeGen_LLVM::visit(const Broadcast *op) {
     value = create_broadcast(codegen(op->value), op->lanes);
 }
 
+void CodeGen_LLVM::visit(const VectorReduce *op) {
+    value = codegen_vector_reduce(op->op, codegen(op->value), op->value.type(), op->type.lanes());
+}
+
+Value *CodeGen_LLVM::codegen_vector_reduce(VectorReduce::Operator op, Value *vec, Type t, int lanes) {
+    internal_assert(t.lanes() % lanes == 0);
+
+    // Extract lanes start, start + stride, ... as a value of the
+    // given Halide type.
+    auto slice = [&](Value *v, int start, int stride, Type slice_t) {
+        if (slice_t.is_scalar()) {
+            return builder->CreateExtractElement(v, ConstantInt::get(i32_t, start));
+        }
+        vector<int> indices(slice_t.lanes());
+        for (int i = 0; i < slice_t.lanes(); i++) {
+            indices[i] = start + i * stride;
+        }
+        return shuffle_vectors(v, indices);
+    };
+
+    // Combine two values using the Halide IR for the operator, so
+    // that we get any peephole optimizations for it.
+    auto combine = [&](Value *a, Value *b, Type ab_t) {
+        string a_name = unique_name('a'), b_name = unique_name('b');
+        Expr a_var = Variable::make(ab_t, a_name);
+        Expr b_var = Variable::make(ab_t, b_name);
+        Expr e;
+        switch (op) {
+        case VectorReduce::Add:
+            e = Add::make(a_var, b_var);
+            break;
+        case VectorReduce::Mul:
+            e = Mul::make(a_var, b_var);
+            break;
+        case VectorReduce::Min:
+            e = Min::make(a_var, b_var);
+            break;
+        case VectorReduce::Max:
+            e = Max::make(a_var, b_var);
+            break;
+        case VectorReduce::And:
+            e = ab_t.is_bool() ? And::make(a_var, b_var) : (a_var & b_var);
+            break;
+        case VectorReduce::Or:
+            e = ab_t.is_bool() ? Or::make(a_var, b_var) : (a_var | b_var);
+            break;
+        }
+        sym_push(a_name, a);
+        sym_push(b_name, b);
+        Value *result = codegen(e);
+        sym_pop(a_name);
+        sym_pop(b_name);
+        return result;
+    };
+
+    int factor = t.lanes() / lanes;
+    while (factor > 1) {
+        if (factor % 2 == 0) {
+            // Combine pairs of lanes within each group. When reducing
+            // to a scalar we can use the two halves of the vector,
+            // which is cheaper to shuffle. Otherwise combine the even
+            // and odd lanes.
+            Type half_t = t.with_lanes(t.lanes() / 2);
+            Value *a, *b;
+            if (lanes == 1) {
+                a = slice(vec, 0, 1, half_t);
+                b = slice(vec, half_t.lanes(), 1, half_t);
+            } else {
+                a = slice(vec, 0, 2, half_t);
+                b = slice(vec, 1, 2, half_t);
+            }
+            vec = combine(a, b, half_t);
+            t = half_t;
+            factor /= 2;
+        } else {
+            // For an odd factor, combine the first lane of each
+            // group with each of its other lanes in turn.
+            Type result_t = t.with_lanes(lanes);
+            Value *result = slice(vec, 0, factor, result_t);
+            for (int i = 1; i < factor; i++) {
+                result = combine(result, slice(vec, i, factor, result_t), result_t);
+            }
+            vec = result;
+            t = result_t;
+            factor = 1;
+        }
+    }
+
+    return vec;
+}
+
 // Pass through scalars, and unpack broadcasts. Assert if it's a non-vector broadcast.
 Expr unbroadcast(Expr e) {
     if (e.type().is_vector()) {
@@ -2257,16 +2449,34 @@ void CodeGen_LLVM::visit(const Call *op) {
             internal_error << "mod_round_to_zero of non-integer type.\n";
         }
     } else if (op->is_intrinsic(Call::copy_buffer_t)) {
+        // The optional second argument is the number of dimensions of
+        // the buffer.
+        int dims = 4;
+        if (op->args.size() > 1) {
+            const IntImm *d = op->args[1].as<IntImm>();
+            internal_assert(d) << "The second argument to copy_buffer_t must be a constant\n";
+            dims = (int)d->value;
+        }
+
         // Make some memory for this buffer_t
-        Value *dst = create_alloca_at_entry(buffer_t_type, 1);
+        Value *dst = create_buffer_t_at_entry(dims);
         Value *src = codegen(op->args[0]);
         src = builder->CreatePointerCast(src, buffer_t_type->getPointerTo());
-        src = builder->CreateLoad(src);
-        builder->CreateStore(src, dst);
+        builder->CreateStore(builder->CreateLoad(src), dst);
+        // Copy any dimensions beyond the fourth too, so that the copy
+        // can be mutated independently of the original.
+        for (int i = 4; i < dims; i++) {
+            for (int f = 0; f < 3; f++) {
+                Value *v = builder->CreateLoad(buffer_extra_dim_ptr(src, i, f));
+                builder->CreateStore(v, buffer_extra_dim_ptr(dst, i, f));
+            }
+        }
         value = dst;
     } else if (op->is_intrinsic(Call::create_buffer_t)) {
+        int dims = (op->args.size() - 2) / 3;
+
         // Make some memory for this buffer_t
-        Value *buffer = create_alloca_at_entry(buffer_t_type, 1);
+        Value *buffer = create_buffer_t_at_entry(dims);
 
         // Populate the fields
         internal_assert(op->args[0].type().is_handle())
@@ -2287,11 +2497,7 @@ void CodeGen_LLVM::visit(const Call *op) {
         Value *elem_size = codegen(op->args[1].type().bytes());
         builder->CreateStore(elem_size, buffer_elem_size_ptr(buffer));
 
-        int dims = (op->args.size() - 2) / 3;
-        user_assert(dims <= 4)
-            << "Halide currently has a limit of four dimensions on "
-            << "Funcs used on the GPU or passed to extern stages.\n";
-        for (int i = 0; i < 4; i++) {
+        for (int i = 0; i < std::max(4, dims); i++) {
             Value *min, *extent, *stride;
             if (i < dims) {
                 min    = codegen(op->args[i*3+2]);
@@ -2335,7 +2541,6 @@ void CodeGen_LLVM::visit(const Call *op) {
     } else if (op->is_intrinsic(Call::rewrite_buffer)) {
         int dims = ((int)(op->args.size())-2)/3;
         internal_assert((int)(op->args.size()) == dims*3 + 2);
-        internal_assert(dims <= 4);
 
         Value *buffer = codegen(op->args[0]);
 
@@ -3281,6 +3486,11 @@ void CodeGen_LLVM::visit(const Store *op) {
         return;
     }
 
+    if (op->name == atomic_producer) {
+        codegen_atomic_store(op);
+        return;
+    }
+
     Halide::Type value_type = op->value.type();
     Value *val = codegen(op->value);
     bool is_external = (external_buffer.find(op->name) != external_buffer.end());
@@ -3417,6 +3627,120 @@ void CodeGen_LLVM::visit(const Evaluate *op) {
     value = nullptr;
 }
 
+void CodeGen_LLVM::visit(const Atomic *op) {
+    string old_producer = atomic_producer;
+    atomic_producer = op->producer_name;
+    codegen(op->body);
+    atomic_producer = old_producer;
+}
+
+void CodeGen_LLVM::codegen_atomic_store(const Store *op) {
+    Halide::Type t = op->value.type();
+    internal_assert(t.is_scalar() && t.bits() >= 8)
+        << "Atomic store to " << op->name << " of unsupported type " << t << "\n";
+
+    #if LLVM_VERSION >= 39
+    const llvm::AtomicOrdering ordering = llvm::AtomicOrdering::Monotonic;
+    #else
+    const llvm::AtomicOrdering ordering = llvm::Monotonic;
+    #endif
+
+    Value *ptr = codegen_buffer_pointer(op->name, t, op->index);
+
+    // Returns true if e is the value being updated.
+    auto is_self_load = [&](Expr e) {
+        const Load *load = e.as<Load>();
+        return load && load->name == op->name;
+    };
+    // Returns true if e doesn't depend on the value being updated.
+    auto is_independent = [&](Expr e) {
+        return substitute_self_load(e, op->name, make_zero(t)).same_as(e);
+    };
+
+    if (t.is_int() || t.is_uint()) {
+        // Try to find a single read-modify-write instruction.
+        bool found = false;
+        AtomicRMWInst::BinOp rmw_op = AtomicRMWInst::Add;
+        Expr operand;
+        const Add *add = op->value.as<Add>();
+        const Sub *sub = op->value.as<Sub>();
+        const Min *min = op->value.as<Min>();
+        const Max *max = op->value.as<Max>();
+        const Call *call = op->value.as<Call>();
+        Expr a, b;
+        if (add) {
+            a = add->a;
+            b = add->b;
+            rmw_op = AtomicRMWInst::Add;
+        } else if (min) {
+            a = min->a;
+            b = min->b;
+            rmw_op = t.is_int() ? AtomicRMWInst::Min : AtomicRMWInst::UMin;
+        } else if (max) {
+            a = max->a;
+            b = max->b;
+            rmw_op = t.is_int() ? AtomicRMWInst::Max : AtomicRMWInst::UMax;
+        } else if (call && call->args.size() == 2 &&
+                   (call->is_intrinsic(Call::bitwise_and) ||
+                    call->is_intrinsic(Call::bitwise_or) ||
+                    call->is_intrinsic(Call::bitwise_xor))) {
+            a = call->args[0];
+            b = call->args[1];
+            rmw_op = (call->is_intrinsic(Call::bitwise_and) ? AtomicRMWInst::And :
+                      call->is_intrinsic(Call::bitwise_or) ? AtomicRMWInst::Or :
+                      AtomicRMWInst::Xor);
+        }
+        if (a.defined()) {
+            // These are all commutative.
+            if (is_self_load(b)) {
+                std::swap(a, b);
+            }
+            if (is_self_load(a) && is_independent(b)) {
+                operand = b;
+                found = true;
+            }
+        } else if (sub && is_self_load(sub->a) && is_independent(sub->b)) {
+            operand = sub->b;
+            rmw_op = AtomicRMWInst::Sub;
+            found = true;
+        }
+
+        if (found) {
+            builder->CreateAtomicRMW(rmw_op, ptr, codegen(operand), ordering);
+            return;
+        }
+    }
+
+    // Fall back to a compare-and-swap loop on the bits of the value.
+    llvm::Type *bits_t = llvm::Type::getIntNTy(*context, t.bits());
+    Value *bits_ptr = builder->CreatePointerCast(ptr, bits_t->getPointerTo());
+    Value *orig = builder->CreateAlignedLoad(bits_ptr, t.bytes());
+
+    BasicBlock *preheader_bb = builder->GetInsertBlock();
+    BasicBlock *loop_bb = BasicBlock::Create(*context, "atomic " + op->name, function);
+    BasicBlock *after_bb = BasicBlock::Create(*context, "end atomic " + op->name, function);
+    builder->CreateBr(loop_bb);
+    builder->SetInsertPoint(loop_bb);
+
+    PHINode *old_bits = builder->CreatePHI(bits_t, 2);
+    old_bits->addIncoming(orig, preheader_bb);
+
+    // Compute the new value in terms of the old one.
+    string old_name = unique_name('o');
+    sym_push(old_name, builder->CreateBitCast(old_bits, llvm_type_of(t)));
+    Value *new_val = codegen(substitute_self_load(op->value, op->name, Variable::make(t, old_name)));
+    sym_pop(old_name);
+    Value *new_bits = builder->CreateBitCast(new_val, bits_t);
+
+    Value *cas = builder->CreateAtomicCmpXchg(bits_ptr, old_bits, new_bits, ordering, ordering);
+    Value *seen = builder->CreateExtractValue(cas, {0});
+    Value *success = builder->CreateExtractValue(cas, {1});
+    old_bits->addIncoming(seen, builder->GetInsertBlock());
+    builder->CreateCondBr(success, after_bb, loop_bb, very_likely_branch);
+
+    builder->SetInsertPoint(after_bb);
+}
+
 Value *CodeGen_LLVM::create_alloca_at_entry(llvm::Type *t, int n, bool zero_initialize, const string &name) {
     IRBuilderBase::InsertPoint here = builder->saveIP();
     BasicBlock *entry = &builder->GetInsertBlock()->getParent()->getEntryBlock();
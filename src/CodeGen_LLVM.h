@@ -225,10 +225,12 @@ protected:
     void scalarize(Expr);
 
     /** Take an llvm Value representing a pointer to a buffer_t,
-     * and populate the symbol table with its constituent parts.
+     * and populate the symbol table with its constituent parts. A
+     * buffer of more than four dimensions must be the first member
+     * of a halide_nd_buffer_t; this is checked at runtime.
      */
-    void push_buffer(const std::string &name, llvm::Value *buffer);
-    void pop_buffer(const std::string &name);
+    void push_buffer(const std::string &name, int dimensions, llvm::Value *buffer);
+    void pop_buffer(const std::string &name, int dimensions);
 
     /** Some destructors should always be called. Others should only
      * be called if the pipeline is exiting with an error code. */
@@ -294,8 +296,20 @@ protected:
     llvm::Value *buffer_extent_ptr(llvm::Value *, int);
     llvm::Value *buffer_stride_ptr(llvm::Value *, int);
     llvm::Value *buffer_elem_size_ptr(llvm::Value *);
+    llvm::Value *buffer_extra_dimensions_ptr(llvm::Value *);
     // @}
 
+    /** Get a pointer to field (0 for the min, 1 for the extent, 2
+     * for the stride) of dimension i >= 4 of a buffer_t that is the
+     * first member of a halide_nd_buffer_t. */
+    llvm::Value *buffer_extra_dim_ptr(llvm::Value *buffer, int i, int field);
+
+    /** Make stack space for a buffer_t of the given number of
+     * dimensions. If there are more than four, it is the first
+     * member of a halide_nd_buffer_t, and its extra_dimensions and
+     * extra_dim fields are set. */
+    llvm::Value *create_buffer_t_at_entry(int dimensions);
+
     /** Generate a pointer into a named buffer at a given index, of a
      * given type. The index counts according to the scalar type of
      * the type passed in. */
@@ -304,6 +318,11 @@ protected:
     llvm::Value *codegen_buffer_pointer(std::string buffer, Type type, Expr index);
     // @}
 
+    /** Store a scalar value atomically. Simple integer updates become
+     * a single atomicrmw; everything else is a compare-and-swap loop
+     * that recomputes the value from the one it read. */
+    void codegen_atomic_store(const Store *);
+
     /** Mark a load or store with type-based-alias-analysis metadata
      * so that llvm knows it can reorder loads and stores across
      * different buffers */
@@ -357,6 +376,7 @@ protected:
     virtual void visit(const Load *);
     virtual void visit(const Ramp *);
     virtual void visit(const Broadcast *);
+    virtual void visit(const VectorReduce *);
     virtual void visit(const Call *);
     virtual void visit(const Let *);
     virtual void visit(const LetStmt *);
@@ -367,6 +387,7 @@ protected:
     virtual void visit(const Block *);
     virtual void visit(const IfThenElse *);
     virtual void visit(const Evaluate *);
+    virtual void visit(const Atomic *);
     // @}
 
     /** Generate code for an allocate node. It has no default
@@ -386,6 +407,14 @@ protected:
     virtual void visit(const Realize *);
     // @}
 
+    /** Generate code for a horizontal reduction of the given vector
+     * value down to the given number of lanes, by repeatedly
+     * combining pairs of slices of it. Architecture-specific
+     * subclasses may call this to finish off a reduction after
+     * doing part of it with a widening or horizontal
+     * instruction. */
+    llvm::Value *codegen_vector_reduce(VectorReduce::Operator op, llvm::Value *vec, Type t, int lanes);
+
     /** If we have to bail out of a pipeline midway, this should
      * inject the appropriate target-specific cleanup code. */
     virtual void prepare_for_early_exit() {}
@@ -471,6 +500,10 @@ private:
     /** Alignment info for Int(32) variables in scope. */
     Scope<ModulusRemainder> alignment_info;
 
+    /** The buffer whose stores must currently be atomic, or the
+     * empty string outside of an Atomic node. */
+    std::string atomic_producer;
+
     /** String constants already emitted to the module. Tracked to
      * prevent emitting the same string many times. */
     std::map<std::string, llvm::Constant *> string_constants;
@@ -333,6 +333,11 @@ void CodeGen_Metal_Dev::CodeGen_Metal_C::visit(const Store *op) {
     cache.clear();
 }
 
+void CodeGen_Metal_Dev::CodeGen_Metal_C::visit(const Atomic *op) {
+    user_error << "Atomic update of " << op->producer_name
+               << " is not supported by the Metal backend.\n";
+}
+
 void CodeGen_Metal_Dev::CodeGen_Metal_C::visit(const Select *op) {
     ostringstream rhs;
     string true_val = print_expr(op->true_value);
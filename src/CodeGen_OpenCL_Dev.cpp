@@ -290,6 +290,13 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Load *op) {
 }
 
 void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Store *op) {
+    // Private allocations aren't visible to other work-items, so
+    // stores to them don't need to be atomic.
+    if (op->name == atomic_producer && !private_allocations.contains(op->name)) {
+        visit_atomic_store(op);
+        return;
+    }
+
     string id_value = print_expr(op->value);
     Type t = op->value.type();
 
@@ -347,6 +354,72 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Store *op) {
     cache.clear();
 }
 
+void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit_atomic_store(const Store *op) {
+    Type t = op->value.type();
+    user_assert(t.is_scalar() && t.bits() == 32)
+        << "Atomic update of " << op->name << " has type " << t
+        << ", but OpenCL only has atomic operations on 32-bit types.\n";
+
+    // The atomic functions only take ints, so floats are compared and
+    // swapped as their bits.
+    Type bits_t = t.is_float() ? UInt(32) : t;
+    string mem = "volatile " + get_memory_space(op->name) + " " + print_type(bits_t) + " *";
+    string id_index = print_expr(op->index);
+    string id_ptr = unique_name('_');
+    do_indent();
+    stream << mem << id_ptr << " = ((" << mem << ")" << print_name(op->name) << ") + " << id_index << ";\n";
+
+    // An integer add of a value that doesn't depend on the old one
+    // is a single atomic_add.
+    const Add *add = op->value.as<Add>();
+    if (add && !t.is_float()) {
+        Expr a = add->a, b = add->b;
+        const Load *load = b.as<Load>();
+        if (load && load->name == op->name) {
+            std::swap(a, b);
+        }
+        load = a.as<Load>();
+        bool independent = substitute_self_load(b, op->name, make_zero(t)).same_as(b);
+        if (load && load->name == op->name && independent) {
+            string id_b = print_expr(b);
+            do_indent();
+            stream << "atomic_add(" << id_ptr << ", " << id_b << ");\n";
+            cache.clear();
+            return;
+        }
+    }
+
+    string id_old = unique_name('_');
+    string id_seen = unique_name('_');
+    do_indent();
+    stream << print_type(bits_t) << " " << id_seen << ", " << id_old << " = *" << id_ptr << ";\n";
+
+    // Recompute the new value from the old one until no other
+    // work-item has changed it in the meantime.
+    Expr old_value = Variable::make(bits_t, id_old);
+    if (t.is_float()) {
+        old_value = reinterpret(t, old_value);
+    }
+    Expr value = substitute_self_load(op->value, op->name, old_value);
+    if (t.is_float()) {
+        value = reinterpret(bits_t, value);
+    }
+    do_indent();
+    stream << "do {\n";
+    indent++;
+    string id_value = print_expr(value);
+    do_indent();
+    stream << id_seen << " = " << id_old << ";\n";
+    do_indent();
+    stream << id_old << " = atomic_cmpxchg(" << id_ptr << ", " << id_seen << ", " << id_value << ");\n";
+    indent--;
+    do_indent();
+    stream << "} while (" << id_old << " != " << id_seen << ");\n";
+
+    // Values computed inside the loop body are out of scope now.
+    cache.clear();
+}
+
 namespace {
 }
 
@@ -429,6 +502,7 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Allocate *op) {
         Allocation alloc;
         alloc.type = op->type;
         allocations.push(op->name, alloc);
+        private_allocations.push(op->name, 0);
 
         op->body.accept(this);
 
@@ -446,6 +520,7 @@ void CodeGen_OpenCL_Dev::CodeGen_OpenCL_C::visit(const Free *op) {
         // Should have been freed internally
         internal_assert(allocations.contains(op->name));
         allocations.pop(op->name);
+        private_allocations.pop(op->name);
         do_indent();
         stream << "#undef " << get_memory_space(op->name) << "\n";
     }
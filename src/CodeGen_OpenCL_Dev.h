@@ -73,6 +73,14 @@ protected:
         void visit(const Allocate *op);
         void visit(const Free *op);
         void visit(const AssertStmt *op);
+
+        /** The allocations in __private memory. */
+        Scope<int> private_allocations;
+
+        /** Emit a store to a buffer shared between work-items as an
+         * atomic_add, or as an atomic_cmpxchg loop that recomputes
+         * the stored value from the value it read. */
+        void visit_atomic_store(const Store *op);
     };
 
     std::ostringstream src_stream;
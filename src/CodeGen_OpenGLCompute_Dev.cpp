@@ -232,6 +232,11 @@ void CodeGen_OpenGLCompute_Dev::CodeGen_OpenGLCompute_C::visit(const Store *op)
     cache.clear();
 }
 
+void CodeGen_OpenGLCompute_Dev::CodeGen_OpenGLCompute_C::visit(const Atomic *op) {
+    user_error << "Atomic update of " << op->producer_name
+               << " is not supported by the OpenGLCompute backend.\n";
+}
+
 void CodeGen_OpenGLCompute_Dev::CodeGen_OpenGLCompute_C::visit(const Select *op) {
     ostringstream rhs;
     string true_val = print_expr(op->true_value);
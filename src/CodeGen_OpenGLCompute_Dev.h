@@ -56,6 +56,7 @@ protected:
         void visit(const Broadcast *op);
         void visit(const Load *op);
         void visit(const Store *op);
+        void visit(const Atomic *op);
         void visit(const Cast *op);
         void visit(const Call *op);
         void visit(const Allocate *op);
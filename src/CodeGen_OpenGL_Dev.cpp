@@ -413,6 +413,11 @@ void CodeGen_GLSL::visit(const Store *) {
     internal_error << "GLSL: unexpected Store node encountered.\n";
 }
 
+void CodeGen_GLSL::visit(const Atomic *op) {
+    user_error << "Atomic update of " << op->producer_name
+               << " is not supported by the OpenGL backend.\n";
+}
+
 void CodeGen_GLSL::visit(const Evaluate *op) {
     print_expr(op->value);
 }
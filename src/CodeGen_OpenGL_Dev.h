@@ -95,6 +95,7 @@ protected:
 
     void visit(const Load *);
     void visit(const Store *);
+    void visit(const Atomic *);
 
     void visit(const Call *);
     void visit(const AssertStmt *);
@@ -92,6 +92,67 @@ void CodeGen_X86::visit(const Sub *op) {
     }
 }
 
+void CodeGen_X86::visit(const VectorReduce *op) {
+    const int input_lanes = op->value.type().lanes();
+    const int factor = input_lanes / op->type.lanes();
+    const bool avx2 = target.has_feature(Target::AVX2);
+
+    if (op->op == VectorReduce::Add && factor % 2 == 0 &&
+        op->type.is_int() && op->type.bits() == 32 && input_lanes % 8 == 0) {
+        // Sums of adjacent pairs of products of 16-bit values (or of
+        // 16-bit values themselves) are pmaddwd.
+        Type narrow = Int(16, input_lanes);
+        Expr a, b;
+        if (const Mul *mul = op->value.as<Mul>()) {
+            a = lossless_cast(narrow, mul->a);
+            b = lossless_cast(narrow, mul->b);
+        }
+        if (!a.defined() || !b.defined()) {
+            a = lossless_cast(narrow, op->value);
+            b = make_const(narrow, 1);
+        }
+        if (a.defined()) {
+            const int chunk = (avx2 && input_lanes % 16 == 0) ? 16 : 8;
+            const char *intrin = chunk == 16 ? "llvm.x86.avx2.pmadd.wd" : "llvm.x86.sse2.pmadd.wd";
+            llvm::Type *result_t = VectorType::get(i32_t, chunk / 2);
+            Value *va = codegen(a), *vb = codegen(b);
+            vector<Value *> pieces;
+            for (int i = 0; i < input_lanes; i += chunk) {
+                pieces.push_back(call_intrin(result_t, chunk / 2, intrin,
+                                             {slice_vector(va, i, chunk), slice_vector(vb, i, chunk)}));
+            }
+            value = codegen_vector_reduce(op->op, concat_vectors(pieces),
+                                          op->type.with_lanes(input_lanes / 2), op->type.lanes());
+            return;
+        }
+    }
+
+    if (op->op == VectorReduce::Add && factor % 8 == 0 &&
+        (op->type.is_int() || op->type.is_uint()) && op->type.bits() >= 16 &&
+        input_lanes % 16 == 0) {
+        // Sums of groups of eight 8-bit values are psadbw against zero.
+        Expr a = lossless_cast(UInt(8, input_lanes), op->value);
+        if (a.defined()) {
+            const int chunk = (avx2 && input_lanes % 32 == 0) ? 32 : 16;
+            const char *intrin = chunk == 32 ? "llvm.x86.avx2.psad.bw" : "llvm.x86.sse2.psad.bw";
+            llvm::Type *result_t = VectorType::get(i64_t, chunk / 8);
+            Value *va = codegen(a);
+            Value *zero = Constant::getNullValue(VectorType::get(i8_t, chunk));
+            vector<Value *> pieces;
+            for (int i = 0; i < input_lanes; i += chunk) {
+                pieces.push_back(call_intrin(result_t, chunk / 8, intrin,
+                                             {slice_vector(va, i, chunk), zero}));
+            }
+            Type partial_t = op->type.with_lanes(input_lanes / 8);
+            Value *partial = builder->CreateIntCast(concat_vectors(pieces), llvm_type_of(partial_t), false);
+            value = codegen_vector_reduce(op->op, partial, partial_t, op->type.lanes());
+            return;
+        }
+    }
+
+    CodeGen_Posix::visit(op);
+}
+
 void CodeGen_X86::visit(const GT *op) {
     if (op->type.is_vector()) {
         // Non-native vector widths get legalized poorly by llvm. We
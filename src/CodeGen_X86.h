@@ -48,6 +48,7 @@ protected:
     void visit(const EQ *);
     void visit(const NE *);
     void visit(const Select *);
+    void visit(const VectorReduce *);
     // @}
 };
 
@@ -0,0 +1,152 @@
+#include "CombineChecks.h"
+#include "ExprUsesVar.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Check if an expression is safe to evaluate early, and more than
+// once. The conditions of the validation asserts are arithmetic on
+// the buffer fields and parameters, but asserts on the results of
+// runtime calls (e.g. device copies) must be left alone. Combining
+// the checks also evaluates later conditions (and hoists lets) before
+// the earlier asserts that may protect them, so anything that can
+// fault when those asserts fail, such as a load or an integer
+// division by something that may be zero, is unsafe too.
+class SafeToHoist : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        if (!op->is_pure() ||
+            op->call_type == Call::Image ||
+            op->call_type == Call::Halide) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Load *op) {
+        result = false;
+    }
+
+    template<typename T>
+    void visit_division(const T *op) {
+        if (!op->type.is_float() && !is_positive_const(op->b)) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Div *op) {
+        visit_division(op);
+    }
+
+    void visit(const Mod *op) {
+        visit_division(op);
+    }
+
+public:
+    bool result = true;
+};
+
+bool safe_to_hoist(Expr e) {
+    SafeToHoist check;
+    e.accept(&check);
+    return check.result;
+}
+
+class CombineChecks : public IRMutator {
+    using IRMutator::visit;
+
+    // Gather the straight-line run of asserts and lets starting at
+    // s. The run stops at the first let or condition that isn't safe
+    // to evaluate before the asserts above it. Returns the statement
+    // that follows the run.
+    Stmt gather(Stmt s, vector<pair<string, Expr>> &lets, vector<Stmt> &asserts) {
+        while (s.defined()) {
+            Stmt first = s, rest;
+            if (const Block *b = s.as<Block>()) {
+                first = b->first;
+                rest = b->rest;
+            }
+            if (const LetStmt *let = first.as<LetStmt>()) {
+                // The let gets hoisted above the asserts before it,
+                // so it mustn't shadow anything they use.
+                if (rest.defined() || !safe_to_hoist(let->value)) break;
+                bool shadows = false;
+                for (Stmt a : asserts) {
+                    shadows = shadows || stmt_uses_var(a, let->name);
+                }
+                if (shadows) break;
+                lets.push_back({let->name, let->value});
+                s = let->body;
+            } else if (const AssertStmt *a = first.as<AssertStmt>()) {
+                if (!safe_to_hoist(a->condition)) break;
+                asserts.push_back(first);
+                s = rest;
+            } else {
+                break;
+            }
+        }
+        return s;
+    }
+
+    Stmt combine(Stmt s) {
+        vector<pair<string, Expr>> lets;
+        vector<Stmt> asserts;
+        Stmt rest = gather(s, lets, asserts);
+        if (asserts.size() < 2) {
+            return Stmt();
+        }
+
+        // Check all the conditions at once, and only run the
+        // original asserts (which report the first failure) if
+        // that fails.
+        Expr all_ok;
+        for (Stmt a : asserts) {
+            Expr c = a.as<AssertStmt>()->condition;
+            all_ok = all_ok.defined() ? (all_ok && c) : c;
+        }
+        Stmt result = IfThenElse::make(!all_ok, Block::make(asserts));
+        if (rest.defined()) {
+            result = Block::make(result, mutate(rest));
+        }
+        for (size_t i = lets.size(); i > 0; i--) {
+            result = LetStmt::make(lets[i-1].first, lets[i-1].second, result);
+        }
+        return result;
+    }
+
+    void visit(const LetStmt *op) {
+        stmt = combine(op);
+        if (!stmt.defined()) {
+            IRMutator::visit(op);
+        }
+    }
+
+    void visit(const Block *op) {
+        stmt = combine(op);
+        if (!stmt.defined()) {
+            IRMutator::visit(op);
+        }
+    }
+};
+
+}
+
+Stmt combine_checks(Stmt s) {
+    return CombineChecks().mutate(s);
+}
+
+}
+}
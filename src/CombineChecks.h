@@ -0,0 +1,25 @@
+#ifndef HALIDE_COMBINE_CHECKS_H
+#define HALIDE_COMBINE_CHECKS_H
+
+/** \file
+ * Defines the lowering pass that folds runs of argument and buffer
+ * validation asserts into a single branch.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Fold each straight-line run of asserts with side-effect-free
+ * conditions (and the side-effect-free lets interleaved with them)
+ * into one combined predicate. The original asserts only run if the
+ * combined predicate fails, so the error reported is the same, but
+ * the common case takes a single branch. Enabled by
+ * Target::CombineChecks. */
+Stmt combine_checks(Stmt s);
+
+}
+}
+
+#endif
@@ -0,0 +1,479 @@
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "CostReport.h"
+#include "Bounds.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRPrinter.h"
+#include "IRVisitor.h"
+#include "Simplify.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::ostream;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Counts of things, keyed by what they count: operations by type and
+// kind, or bytes by buffer name.
+typedef map<string, Expr> Counts;
+
+struct Cost {
+    Counts ops, loaded, stored;
+};
+
+void accumulate(Counts &counts, const string &key, Expr n) {
+    Expr &c = counts[key];
+    c = simplify(c.defined() ? c + n : n);
+}
+
+Expr sum(const Counts &counts) {
+    Expr s = make_zero(Int(64));
+    for (const auto &it : counts) {
+        s += it.second;
+    }
+    return simplify(s);
+}
+
+class CostModel : public IRVisitor {
+public:
+    struct Loop {
+        string name;
+        ForType for_type;
+        Expr extent;
+        int depth;
+        Cost cost;
+    };
+
+    struct Allocation {
+        string name;
+        Expr bytes, count;
+    };
+
+    Cost total;
+    vector<string> func_order;
+    map<string, Cost> funcs;
+    vector<Loop> loops;
+    vector<Allocation> allocations;
+    Expr peak = make_zero(Int(64));
+
+    void finish() {
+        flush();
+    }
+
+private:
+    using IRVisitor::visit;
+
+    // How many times the code being visited runs.
+    Expr multiplier = make_one(Int(64));
+
+    // Counts for the code being visited, not yet scaled by the
+    // multiplier. Constant within a loop body, so we tally them as
+    // integers and only build symbolic expressions at loop
+    // boundaries.
+    map<string, int64_t> pending_ops, pending_loaded, pending_stored;
+
+    // The values of the integer lets in scope, in terms of the
+    // pipeline's parameters and enclosing loop variables.
+    map<string, Expr> lets;
+
+    // The range of each enclosing loop variable.
+    Scope<Interval> loop_bounds;
+
+    vector<size_t> loop_stack;
+    vector<string> func_stack;
+    Expr live = make_zero(Int(64));
+    bool in_index = false;
+
+    Expr substitute_lets(Expr e) {
+        return simplify(substitute(lets, e));
+    }
+
+    // An upper bound on e over all iterations of the enclosing loops.
+    Expr upper_bound(Expr e) {
+        e = substitute_lets(e);
+        Interval i = bounds_of_expr_in_scope(e, loop_bounds);
+        return simplify(i.has_upper_bound() ? i.max : e);
+    }
+
+    Expr lower_bound(Expr e) {
+        e = substitute_lets(e);
+        Interval i = bounds_of_expr_in_scope(e, loop_bounds);
+        return simplify(i.has_lower_bound() ? i.min : e);
+    }
+
+    void flush_one(map<string, int64_t> &pending, Counts Cost::*field) {
+        for (const auto &it : pending) {
+            Expr n = simplify(multiplier * make_const(Int(64), it.second));
+            accumulate(total.*field, it.first, n);
+            if (!func_stack.empty()) {
+                accumulate(funcs[func_stack.back()].*field, it.first, n);
+            }
+            for (size_t l : loop_stack) {
+                accumulate(loops[l].cost.*field, it.first, n);
+            }
+        }
+        pending.clear();
+    }
+
+    void flush() {
+        flush_one(pending_ops, &Cost::ops);
+        flush_one(pending_loaded, &Cost::loaded);
+        flush_one(pending_stored, &Cost::stored);
+    }
+
+    void count(const char *kind, Type t) {
+        string key;
+        if (in_index) {
+            key = "address arithmetic";
+        } else {
+            std::ostringstream s;
+            s << t.element_of() << " " << kind;
+            key = s.str();
+        }
+        pending_ops[key] += t.lanes();
+    }
+
+    template<typename T>
+    void visit_binary(const T *op, const char *kind) {
+        count(kind, op->type);
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Add *op) {visit_binary(op, "add");}
+    void visit(const Sub *op) {visit_binary(op, "add");}
+    void visit(const Mul *op) {visit_binary(op, "mul");}
+    void visit(const Div *op) {visit_binary(op, "div");}
+    void visit(const Mod *op) {visit_binary(op, "div");}
+    void visit(const Min *op) {visit_binary(op, "min/max");}
+    void visit(const Max *op) {visit_binary(op, "min/max");}
+    void visit(const Select *op) {visit_binary(op, "select");}
+    void visit(const Cast *op) {visit_binary(op, "cast");}
+    void visit(const Not *op) {visit_binary(op, "logical");}
+    void visit(const And *op) {visit_binary(op, "logical");}
+    void visit(const Or *op) {visit_binary(op, "logical");}
+
+    // Comparisons are counted by the type compared.
+    template<typename T>
+    void visit_compare(const T *op) {
+        count("compare", op->a.type());
+        IRVisitor::visit(op);
+    }
+
+    void visit(const EQ *op) {visit_compare(op);}
+    void visit(const NE *op) {visit_compare(op);}
+    void visit(const LT *op) {visit_compare(op);}
+    void visit(const LE *op) {visit_compare(op);}
+    void visit(const GT *op) {visit_compare(op);}
+    void visit(const GE *op) {visit_compare(op);}
+
+    void visit(const Call *op) {
+        if (op->call_type == Call::PureExtern) {
+            count("math", op->type);
+        } else if (op->is_intrinsic(Call::bitwise_and) ||
+                   op->is_intrinsic(Call::bitwise_or) ||
+                   op->is_intrinsic(Call::bitwise_xor) ||
+                   op->is_intrinsic(Call::bitwise_not) ||
+                   op->is_intrinsic(Call::shift_left) ||
+                   op->is_intrinsic(Call::shift_right) ||
+                   op->is_intrinsic(Call::popcount) ||
+                   op->is_intrinsic(Call::count_leading_zeros) ||
+                   op->is_intrinsic(Call::count_trailing_zeros)) {
+            count("bitwise", op->type);
+        } else if (op->is_intrinsic(Call::abs) ||
+                   op->is_intrinsic(Call::absd)) {
+            count("add", op->type);
+        } else if (op->is_intrinsic(Call::lerp)) {
+            count("lerp", op->type);
+        }
+        IRVisitor::visit(op);
+    }
+
+    void visit(const Load *op) {
+        pending_loaded[op->name] += op->type.bytes() * op->type.lanes();
+        bool old_in_index = in_index;
+        in_index = true;
+        op->index.accept(this);
+        in_index = old_in_index;
+    }
+
+    void visit(const Store *op) {
+        pending_stored[op->name] += op->value.type().bytes() * op->value.type().lanes();
+        op->value.accept(this);
+        bool old_in_index = in_index;
+        in_index = true;
+        op->index.accept(this);
+        in_index = old_in_index;
+    }
+
+    void visit(const LetStmt *op) {
+        op->value.accept(this);
+        bool record = op->value.type().is_int() && op->value.type().is_scalar();
+        Expr old;
+        if (record) {
+            auto it = lets.find(op->name);
+            if (it != lets.end()) {
+                old = it->second;
+            }
+            lets[op->name] = substitute_lets(op->value);
+        }
+        op->body.accept(this);
+        if (record) {
+            if (old.defined()) {
+                lets[op->name] = old;
+            } else {
+                lets.erase(op->name);
+            }
+        }
+    }
+
+    void visit(const AssertStmt *) {
+        // Checks run once per call, not once per pixel, and are not
+        // part of the algorithm.
+    }
+
+    void visit(const ProducerConsumer *op) {
+        flush();
+        if (!funcs.count(op->name)) {
+            func_order.push_back(op->name);
+            funcs[op->name];
+        }
+        func_stack.push_back(op->name);
+        op->produce.accept(this);
+        if (op->update.defined()) {
+            op->update.accept(this);
+        }
+        flush();
+        func_stack.pop_back();
+        op->consume.accept(this);
+        flush();
+    }
+
+    void visit(const For *op) {
+        op->min.accept(this);
+        op->extent.accept(this);
+        flush();
+
+        Expr extent = upper_bound(op->extent);
+        Interval range(lower_bound(op->min), upper_bound(op->min + op->extent - 1));
+
+        Loop loop = {op->name, op->for_type, extent, (int)loop_stack.size(), Cost()};
+        loops.push_back(loop);
+        loop_stack.push_back(loops.size() - 1);
+        Expr old_multiplier = multiplier;
+        multiplier = simplify(multiplier * cast(Int(64), extent));
+        loop_bounds.push(op->name, range);
+
+        op->body.accept(this);
+        flush();
+
+        loop_bounds.pop(op->name);
+        multiplier = old_multiplier;
+        loop_stack.pop_back();
+    }
+
+    void visit(const Allocate *op) {
+        Expr bytes = make_const(Int(64), op->type.bytes());
+        for (Expr e : op->extents) {
+            e.accept(this);
+            bytes *= cast(Int(64), upper_bound(e));
+        }
+        bytes = simplify(bytes);
+        allocations.push_back({op->name, bytes, multiplier});
+
+        Expr old_live = live;
+        live = simplify(live + bytes);
+        peak = simplify(max(peak, live));
+        op->body.accept(this);
+        live = old_live;
+    }
+};
+
+class CostReportPrinter {
+    ostream &stream;
+    const map<string, Expr> &estimates;
+
+public:
+    CostReportPrinter(ostream &s, const map<string, Expr> &e) : stream(s), estimates(e) {}
+
+    Expr evaluate(Expr e) {
+        return simplify(substitute(estimates, e));
+    }
+
+    string show(Expr e) {
+        e = evaluate(e);
+        std::ostringstream s;
+        if (const int64_t *i = as_const_int(e)) {
+            // Group the digits in threes, so that a change in
+            // magnitude stands out.
+            string digits = std::to_string(*i);
+            for (int p = (int)digits.size() - 3; p > (*i < 0 ? 1 : 0); p -= 3) {
+                digits.insert(p, ",");
+            }
+            s << digits;
+        } else {
+            s << e;
+        }
+        return s.str();
+    }
+
+    void print_counts(const Counts &counts, const string &indent) {
+        for (const auto &it : counts) {
+            stream << indent << std::left << std::setw(28) << it.first << show(it.second) << "\n";
+        }
+    }
+
+    void print_summary(const Cost &c, const string &indent) {
+        Counts arith = c.ops;
+        Expr address;
+        if (arith.count("address arithmetic")) {
+            address = arith["address arithmetic"];
+            arith.erase("address arithmetic");
+        }
+        Expr ops = sum(arith), loaded = sum(c.loaded), stored = sum(c.stored);
+        stream << indent << "ops: " << show(ops)
+               << ", bytes loaded: " << show(loaded)
+               << ", bytes stored: " << show(stored);
+        Expr total_ops = evaluate(ops), total_bytes = evaluate(loaded + stored);
+        const int64_t *o = as_const_int(total_ops);
+        const int64_t *b = as_const_int(total_bytes);
+        if (o && b && *b > 0) {
+            std::ostringstream intensity;
+            intensity << std::setprecision(3) << (double)*o / *b;
+            stream << ", ops/byte: " << intensity.str();
+        }
+        if (address.defined()) {
+            stream << ", address arithmetic: " << show(address);
+        }
+        stream << "\n";
+    }
+
+    void print(Stmt s) {
+        CostModel model;
+        s.accept(&model);
+        model.finish();
+
+        if (!estimates.empty()) {
+            stream << "Estimates:\n";
+            for (const auto &it : estimates) {
+                stream << "  " << it.first << " = " << it.second << "\n";
+            }
+            stream << "\n";
+        }
+
+        stream << "Total:\n";
+        print_summary(model.total, "  ");
+        print_counts(model.total.ops, "    ");
+        stream << "  Bytes loaded by buffer:\n";
+        print_counts(model.total.loaded, "    ");
+        stream << "  Bytes stored by buffer:\n";
+        print_counts(model.total.stored, "    ");
+        stream << "  Peak memory allocated by the pipeline (per thread): " << show(model.peak) << "\n\n";
+
+        stream << "Funcs:\n";
+        for (const string &f : model.func_order) {
+            stream << "  " << f << ": ";
+            print_summary(model.funcs[f], "");
+            print_counts(model.funcs[f].ops, "    ");
+        }
+        stream << "\n";
+
+        stream << "Loop nests:\n";
+        for (const CostModel::Loop &l : model.loops) {
+            string indent(2 * l.depth + 2, ' ');
+            stream << indent << "for " << l.name << " (extent " << show(l.extent);
+            if (l.for_type != ForType::Serial) {
+                stream << ", " << l.for_type;
+            }
+            stream << "): ";
+            print_summary(l.cost, "");
+        }
+        stream << "\n";
+
+        stream << "Allocations:\n";
+        for (const CostModel::Allocation &a : model.allocations) {
+            stream << "  " << a.name << ": " << show(a.bytes) << " bytes";
+            Expr count = evaluate(a.count);
+            if (!is_one(count)) {
+                stream << ", allocated " << show(count) << " times";
+            }
+            stream << "\n";
+        }
+    }
+};
+
+}  // namespace
+
+void print_cost_report(ostream &stream, Stmt s, const map<string, Expr> &estimates) {
+    stream << "All counts are for one run and are upper bounds: loop extents are\n"
+           << "bounded over all iterations of enclosing loops, and both sides of\n"
+           << "each branch are counted. Ops on vectors count once per lane.\n\n";
+    CostReportPrinter(stream, estimates).print(s);
+}
+
+void print_cost_report(const string &filename, const Module &m, const map<string, Expr> &estimates) {
+    std::ofstream file(filename);
+    for (const LoweredFunc &f : m.functions()) {
+        file << "Cost report for " << f.name << ":\n\n";
+        print_cost_report(file, f.body, estimates);
+        file << "\n";
+    }
+}
+
+void cost_report_test() {
+    // Two loops over an extent n, loading four bytes and storing one
+    // per iteration of the inner loop, with an allocation of n bytes
+    // inside the outer loop.
+    Expr n = Variable::make(Int(32), "n");
+    Expr x = Variable::make(Int(32), "x");
+    Expr y = Variable::make(Int(32), "y");
+    Expr load = Load::make(Int(32), "in", x + y * n, Buffer(), Parameter());
+    Stmt store = Store::make("out", cast<uint8_t>(load * 3 + 1), x + y * n, Parameter());
+    Stmt inner = For::make("x", 0, Variable::make(Int(32), "extent"), ForType::Serial, DeviceAPI::None, store);
+    inner = LetStmt::make("extent", min(n, 100), inner);
+    Stmt alloc = Allocate::make("tmp", UInt(8), {n}, const_true(), inner);
+    Stmt outer = For::make("y", 0, n, ForType::Parallel, DeviceAPI::None, alloc);
+    outer = ProducerConsumer::make("out", outer, Stmt(), Evaluate::make(0));
+
+    std::ostringstream symbolic, numeric;
+    print_cost_report(symbolic, outer);
+    print_cost_report(numeric, outer, {{"n", 10}});
+
+    // With n = 10, each of the 100 iterations does a multiply and an
+    // add on int32 and a cast, and the address arithmetic (a multiply
+    // and an add) is done once each for the load and the store. The
+    // min in the let runs once per outer iteration.
+    const char *expected[] = {
+        "ops: 310, bytes loaded: 400, bytes stored: 100, ops/byte: 0.62, address arithmetic: 400",
+        "int32 min/max               10",
+        "int32 add                   100",
+        "int32 mul                   100",
+        "uint8 cast                  100",
+        "Peak memory allocated by the pipeline (per thread): 10",
+        "for y (extent 10, parallel): ops: 310",
+        "for x (extent 10): ops: 300",
+        "tmp: 10 bytes, allocated 10 times"
+    };
+    for (const char *e : expected) {
+        if (numeric.str().find(e) == string::npos) {
+            internal_error << "Cost report is missing \"" << e << "\":\n" << numeric.str();
+        }
+    }
+    // Without an estimate, the counts remain in terms of n.
+    if (symbolic.str().find("tmp: int64(n) bytes, allocated int64(n) times") == string::npos) {
+        internal_error << "Unexpected symbolic cost report:\n" << symbolic.str();
+    }
+
+    std::cout << "Cost report test passed" << std::endl;
+}
+
+}
+}
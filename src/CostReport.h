@@ -0,0 +1,39 @@
+#ifndef HALIDE_COST_REPORT_H
+#define HALIDE_COST_REPORT_H
+
+/** \file
+ * Defines a static estimate of the arithmetic and memory traffic of
+ * lowered code.
+ */
+
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "Module.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Write a report estimating, for one run of the given lowered Stmt,
+ * the number of arithmetic operations by type, the bytes loaded and
+ * stored by each buffer, and the size of each allocation and the
+ * peak memory live at once. Totals are broken down by Func and by
+ * loop nest. Nothing is run: loop extents and allocation sizes are
+ * bounded symbolically, then evaluated using the given estimates,
+ * which map names appearing in the Stmt (such as "input.extent.0",
+ * or the name of a scalar Param) to values. Counts that depend on
+ * names with no estimate are written as expressions. */
+EXPORT void print_cost_report(std::ostream &stream, Stmt s,
+                              const std::map<std::string, Expr> &estimates = std::map<std::string, Expr>());
+
+/** Write a cost report for each function in a Module to filename. */
+EXPORT void print_cost_report(const std::string &filename, const Module &m,
+                              const std::map<std::string, Expr> &estimates = std::map<std::string, Expr>());
+
+EXPORT void cost_report_test();
+
+}
+}
+
+#endif
@@ -198,6 +198,7 @@ const Specialization &Definition::add_specialization(Expr condition) {
     s.definition.contents->schedule.memoized()         = contents->schedule.memoized();
     s.definition.contents->schedule.touched()          = contents->schedule.touched();
     s.definition.contents->schedule.allow_race_conditions() = contents->schedule.allow_race_conditions();
+    s.definition.contents->schedule.atomic()           = contents->schedule.atomic();
 
     contents->specializations.push_back(s);
     return contents->specializations.back();
@@ -167,6 +167,22 @@ private:
         }
     }
 
+    void visit(const VectorReduce *op) {
+        if (op->type.is_scalar()) {
+            expr = op;
+        } else {
+            // Each lane of the result depends on a contiguous group
+            // of lanes of the value, so we can't deinterleave the
+            // value. Make llvm shuffle the result instead.
+            std::vector<Expr> args;
+            args.push_back(op);
+            for (int i = 0; i < new_lanes; i++) {
+                args.push_back(starting_lane + lane_stride * i);
+            }
+            expr = Call::make(op->type.with_lanes(new_lanes), Call::shuffle_vector, args, Call::PureIntrinsic);
+        }
+    }
+
     void visit(const Load *op) {
         if (op->type.is_scalar()) {
             expr = op;
@@ -148,6 +148,22 @@ private:
         }
     }
 
+    void visit(const VectorReduce *op) {
+        Expr value = mutate(op->value);
+        if (op->type.bits() == 1 && value.type().bits() != 1) {
+            // The value is now a vector of 0 or -1. A bitwise And or
+            // Or of such lanes is the logical reduction.
+            expr = VectorReduce::make(op->op, value, op->type.lanes());
+            if (op->type.is_scalar()) {
+                expr = expr != 0;
+            }
+        } else if (!value.same_as(op->value)) {
+            expr = VectorReduce::make(op->op, value, op->type.lanes());
+        } else {
+            expr = op;
+        }
+    }
+
     template <typename NodeType, typename LetType>
     NodeType visit_let(const LetType *op) {
         Expr value = mutate(op->value);
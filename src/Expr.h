@@ -48,6 +48,7 @@ enum class IRNodeType {
     Load,
     Ramp,
     Broadcast,
+    VectorReduce,
     Call,
     Let,
     LetStmt,
@@ -61,7 +62,8 @@ enum class IRNodeType {
     Realize,
     Block,
     IfThenElse,
-    Evaluate
+    Evaluate,
+    Atomic
 };
 
 /** The abstract base classes for a node in the Halide IR. */
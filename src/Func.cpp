@@ -277,13 +277,18 @@ void Stage::set_dim_type(VarOrRVar var, ForType t) {
             // If it's an rvar and the for type is parallel, we need to
             // validate that this doesn't introduce a race condition.
             if (!dims[i].is_pure() && var.is_rvar && (t == ForType::Vectorized || t == ForType::Parallel)) {
-                user_assert(definition.schedule().allow_race_conditions())
+                // Atomic updates make it safe to run the iterations
+                // of an RVar in parallel or in vector lanes.
+                bool atomic_ok = definition.schedule().atomic();
+                user_assert(atomic_ok || definition.schedule().allow_race_conditions())
                     << "In schedule for " << stage_name
                     << ", marking var " << var.name()
                     << " as parallel or vectorized may introduce a race"
                     << " condition resulting in incorrect output."
                     << " It is possible to override this error using"
-                    << " the allow_race_conditions() method. Use this"
+                    << " the allow_race_conditions() method, or make"
+                    << " the update atomic() if it is associative. Use"
+                    << " allow_race_conditions()"
                     << " with great caution, and only when you are willing"
                     << " to accept non-deterministic output, or you can prove"
                     << " that any race conditions in this code do not change"
@@ -934,6 +939,7 @@ Stage &Stage::purify(VarOrRVar old_var, VarOrRVar new_var) {
             found = true;
             old_name = dims[i].var;
             dims[i].var = new_name;
+            dims[i].dim_type = Dim::Type::PureVar;
         }
     }
 
@@ -1141,6 +1147,39 @@ Stage &Stage::allow_race_conditions() {
     return *this;
 }
 
+Stage &Stage::atomic() {
+    user_assert(!definition.is_init())
+        << "In schedule for " << stage_name
+        << ", atomic() must be called on an update definition\n";
+    user_assert(definition.values().size() == 1)
+        << "In schedule for " << stage_name
+        << ", can't make the update atomic because it is Tuple-valued\n";
+    user_assert(!definition.values()[0].type().is_bool())
+        << "In schedule for " << stage_name
+        << ", can't make the update atomic because it is boolean-valued\n";
+
+    string func_name;
+    {
+        vector<std::string> tmp = split_string(stage_name, ".update(");
+        internal_assert(!tmp.empty() && !tmp[0].empty());
+        func_name = tmp[0];
+    }
+
+    // The update must combine the old value at a site with a new
+    // value using an associative operator, otherwise the order in
+    // which the atomic updates happen would change the result.
+    bool is_assoc;
+    vector<AssociativeOp> ops;
+    std::tie(is_assoc, ops) = prove_associativity(func_name, definition.args(), definition.values());
+    user_assert(is_assoc && !ops.empty() && ops[0].x.second.defined())
+        << "In schedule for " << stage_name
+        << ", can't make the update atomic because it can't be proven"
+        << " to be an associative update of " << func_name << "'s current value\n";
+
+    definition.schedule().atomic() = true;
+    return *this;
+}
+
 Stage &Stage::serial(VarOrRVar var) {
     set_dim_type(var, ForType::Serial);
     return *this;
@@ -2410,6 +2449,20 @@ void Func::compile_to_lowered_stmt(const string &filename,
     pipeline().compile_to_lowered_stmt(filename, args, fmt, target);
 }
 
+void Func::compile_to_cost_report(const string &filename,
+                                  const vector<Argument> &args,
+                                  const std::map<string, Expr> &estimates,
+                                  const Target &target) {
+    pipeline().compile_to_cost_report(filename, args, estimates, target);
+}
+
+void Func::compile_to_profiled_html(const string &filename,
+                                    const vector<Argument> &args,
+                                    const string &profile,
+                                    const Target &target) {
+    pipeline().compile_to_profiled_html(filename, args, profile, target);
+}
+
 void Func::print_loop_nest() {
     pipeline().print_loop_nest();
 }
@@ -2500,6 +2553,12 @@ void Func::infer_input_bounds(Realization dst) {
     pipeline().infer_input_bounds(dst);
 }
 
+void Func::realize_tiled(std::vector<int32_t> sizes, std::vector<int32_t> tile_sizes,
+                         TileReader read, TileWriter write,
+                         TileOrder order, const Target &target) {
+    pipeline().realize_tiled(sizes, tile_sizes, read, write, order, target);
+}
+
 void *Func::compile_jit(const Target &target) {
     return pipeline().compile_jit(target);
 }
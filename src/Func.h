@@ -232,6 +232,23 @@ public:
 
     EXPORT Stage &allow_race_conditions();
 
+    /** Perform the stores of this update definition as atomic
+     * read-modify-write operations, so that it may be parallelized
+     * over RVars even when different iterations write to the same
+     * location (e.g. a histogram or a scatter-add). The update must
+     * be an associative combination of the Func's current value with
+     * a new value, and the Func must not be Tuple-valued. Integer
+     * add, subtract, min, max and bitwise ops lower to atomic
+     * instructions; everything else lowers to a compare-and-swap
+     * loop. Call this before parallelizing or vectorizing over an
+     * RVar. When all the lanes of a vectorized atomic update write
+     * to the same site (e.g. a dot product vectorized over its RDom),
+     * the lanes are combined with a horizontal vector reduction
+     * (pmaddwd, psadbw, vpadd, etc where possible) followed by one
+     * scalar update. Otherwise each lane is updated atomically in
+     * turn. */
+    EXPORT Stage &atomic();
+
     EXPORT Stage &hexagon(VarOrRVar x = Var::outermost());
     // @}
 };
@@ -519,6 +536,15 @@ public:
     EXPORT void infer_input_bounds(Buffer dst);
     // @}
 
+    /** Evaluate this function one tile at a time, streaming any
+     * unbound ImageParams in through read and the completed tiles
+     * out through write. See Pipeline::realize_tiled. */
+    EXPORT void realize_tiled(std::vector<int32_t> sizes,
+                              std::vector<int32_t> tile_sizes,
+                              TileReader read, TileWriter write,
+                              TileOrder order = TileOrder::RowMajor,
+                              const Target &target = Target());
+
     /** Statically compile this function to llvm bitcode, with the
      * given filename (which should probably end in .bc), type
      * signature, and C function name (which defaults to the same name
@@ -592,6 +618,26 @@ public:
                                         StmtOutputFormat fmt = Text,
                                         const Target &target = get_target_from_environment());
 
+    /** Write out a static estimate of the arithmetic, memory traffic
+     * and memory use of the lowered code, broken down by Func and by
+     * loop nest. See Internal::print_cost_report. The estimates map
+     * names in the lowered code, such as "input.extent.0" or the name
+     * of a scalar Param, to values; counts that depend on anything
+     * else are written as expressions. Useful for noticing when a
+     * schedule change increases memory traffic, without running
+     * anything. */
+    EXPORT void compile_to_cost_report(const std::string &filename,
+                                       const std::vector<Argument> &args,
+                                       const std::map<std::string, Expr> &estimates = std::map<std::string, Expr>(),
+                                       const Target &target = get_target_from_environment());
+
+    /** Write out the lowered code as HTML with the results of a
+     * profiled run overlaid. See Pipeline::compile_to_profiled_html. */
+    EXPORT void compile_to_profiled_html(const std::string &filename,
+                                         const std::vector<Argument> &args,
+                                         const std::string &profile,
+                                         const Target &target = get_target_from_environment());
+
     /** Write out the loop nests specified by the schedule for this
      * Function. Helpful for understanding what a schedule is
      * doing. */
@@ -85,6 +85,9 @@ Outputs compute_outputs(const Target &target,
     if (options.emit_stmt_html) {
         output_files.stmt_html_name = base_path + get_extension(".html", options);
     }
+    if (options.emit_cost_report) {
+        output_files.cost_report_name = base_path + get_extension(".cost", options);
+    }
     if (options.emit_static_library) {
         if (is_windows_coff) {
             output_files.static_library_name = base_path + get_extension(".lib", options);
@@ -123,7 +126,7 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
     const char kUsage[] = "gengen [-g GENERATOR_NAME] [-f FUNCTION_NAME] [-o OUTPUT_DIR] [-r RUNTIME_NAME] [-e EMIT_OPTIONS] [-x EXTENSION_OPTIONS] [-n FILE_BASE_NAME] "
                           "target=target-string[,target-string...] [generator_arg=value [...]]\n\n"
                           "  -e  A comma separated list of files to emit. Accepted values are "
-                          "[assembly, bitcode, cpp, h, html, o, static_library, stmt]. If omitted, default value is [static_library, h].\n"
+                          "[assembly, bitcode, cost_report, cpp, h, html, o, static_library, stmt]. If omitted, default value is [static_library, h].\n"
                           "  -x  A comma separated list of file extension pairs to substitute during file naming, "
                           "in the form [.old=.new[,.old2=.new2]]\n";
 
@@ -229,9 +232,11 @@ int generate_filter_main(int argc, char **argv, std::ostream &cerr) {
                 emit_options.emit_h = true;
             } else if (opt == "static_library") {
                 emit_options.emit_static_library = true;
+            } else if (opt == "cost_report") {
+                emit_options.emit_cost_report = true;
             } else if (!opt.empty()) {
                 cerr << "Unrecognized emit option: " << opt
-                     << " not one of [assembly, bitcode, cpp, h, html, o, static_library, stmt], ignoring.\n";
+                     << " not one of [assembly, bitcode, cost_report, cpp, h, html, o, static_library, stmt], ignoring.\n";
             }
         }
     }
@@ -0,0 +1,302 @@
+#include <algorithm>
+
+#include "HoistLoopInvariantDivision.h"
+#include "IREquality.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "IRVisitor.h"
+#include "Scope.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::pair;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Find the depth of the innermost loop that defines a variable used
+// by an expression, and check that the expression is safe to
+// evaluate before that loop, i.e. that it can't fault or read memory
+// the loop might write.
+class FindInvariantDepth : public IRVisitor {
+    const Scope<int> &depths;
+
+    using IRVisitor::visit;
+
+    void visit(const Variable *op) {
+        if (depths.contains(op->name)) {
+            depth = std::max(depth, depths.get(op->name));
+        }
+    }
+
+    void visit(const Load *op) {
+        safe = false;
+    }
+
+    void visit(const Call *op) {
+        if (op->call_type == Call::PureIntrinsic ||
+            op->call_type == Call::PureExtern) {
+            IRVisitor::visit(op);
+        } else {
+            safe = false;
+        }
+    }
+
+    void visit(const Div *op) {
+        if (is_const(op->b)) {
+            IRVisitor::visit(op);
+        } else {
+            safe = false;
+        }
+    }
+
+    void visit(const Mod *op) {
+        if (is_const(op->b)) {
+            IRVisitor::visit(op);
+        } else {
+            safe = false;
+        }
+    }
+
+public:
+    int depth = 0;
+    bool safe = true;
+
+    FindInvariantDepth(const Scope<int> &d) : depths(d) {}
+};
+
+// Make the lets that compute the magic numbers for dividing by d,
+// which has the given (scalar) type. These are the numbers from
+// figure 4.1 of Granlund and Montgomery, "Division by Invariant
+// Integers using Multiplication", for the unsigned divisor |d|:
+// with l = ceil(log2(|d|)),
+//   multiplier = floor(2^N * (2^l - |d|) / |d|) + 1
+//   shift1 = min(l, 1)
+//   shift2 = l - shift1
+// For signed types we also keep the sign of d.
+vector<pair<string, Expr>> make_division_magic(Type t, Expr d, const string &name) {
+    const int bits = t.bits();
+    Type ut = t.with_code(Type::UInt);
+    Type wide = ut.with_bits(bits * 2);
+
+    vector<pair<string, Expr>> lets;
+
+    Expr abs_d = d;
+    if (t.is_int()) {
+        lets.push_back({name + ".sign", select(d < 0, make_const(t, -1), make_zero(t))});
+        Expr sign = cast(ut, Variable::make(t, name + ".sign"));
+        // Done unsigned, so that the most negative divisor works too.
+        abs_d = (cast(ut, d) ^ sign) - sign;
+    }
+    // Division by zero is undefined, but the loop might never run, so
+    // computing the magic numbers must not fault.
+    lets.push_back({name + ".abs", max(abs_d, make_one(ut))});
+    Expr divisor = Variable::make(ut, name + ".abs");
+
+    // l is the number of significant bits in |d| - 1. Count them
+    // with a binary search, because not every backend has a count
+    // leading zeros.
+    string x_name = name + ".x", l_name = name + ".l";
+    lets.push_back({x_name + "0", divisor - 1});
+    lets.push_back({l_name + "0", make_zero(ut)});
+    int step = 0;
+    for (int s = bits / 2; s > 0; s /= 2, step++) {
+        Expr x = Variable::make(ut, x_name + std::to_string(step));
+        Expr l = Variable::make(ut, l_name + std::to_string(step));
+        Expr big = x >= make_const(ut, (uint64_t)1 << s);
+        lets.push_back({l_name + std::to_string(step + 1),
+                        select(big, l + make_const(ut, s), l)});
+        lets.push_back({x_name + std::to_string(step + 1),
+                        select(big, x >> s, x)});
+    }
+    Expr l = (Variable::make(ut, l_name + std::to_string(step)) +
+              Variable::make(ut, x_name + std::to_string(step)));
+    lets.push_back({name + ".log2", l});
+    l = Variable::make(ut, name + ".log2");
+
+    Expr wide_divisor = cast(wide, divisor);
+    Expr numerator = ((make_one(wide) << cast(wide, l)) - wide_divisor) << bits;
+    lets.push_back({name + ".multiplier", cast(ut, numerator / wide_divisor + 1)});
+    lets.push_back({name + ".shift1", min(l, make_one(ut))});
+    lets.push_back({name + ".shift2", l - Variable::make(ut, name + ".shift1")});
+
+    return lets;
+}
+
+// Divide the vector a by the divisor whose magic numbers are in the
+// lets made by make_division_magic, or take the remainder.
+Expr divide_using_magic(Expr a, Expr b, const string &name, bool is_mod) {
+    Type t = a.type();
+    const int bits = t.bits();
+    const int lanes = t.lanes();
+    Type ut = t.with_code(Type::UInt);
+    Type wide = ut.with_bits(bits * 2);
+
+    auto hoisted = [&](Type scalar_type, const string &suffix) {
+        return Broadcast::make(Variable::make(scalar_type, name + suffix), lanes);
+    };
+
+    string n_name = unique_name('n');
+    Expr n = Variable::make(t, n_name);
+
+    // For signed division, rounding to negative infinity is unsigned
+    // division of n, with its bits flipped if it's negative, followed
+    // by flipping the bits of the result back.
+    Expr n_sign, un;
+    if (t.is_int()) {
+        n_sign = select(n < 0, make_const(t, -1), make_zero(t));
+        un = cast(ut, n ^ n_sign);
+    } else {
+        un = n;
+    }
+
+    // Multiply and keep the high half.
+    Expr hi = cast(ut, (cast(wide, un) * cast(wide, hoisted(ut.element_of(), ".multiplier"))) >> bits);
+    Expr q = (hi + ((un - hi) >> hoisted(ut.element_of(), ".shift1"))) >> hoisted(ut.element_of(), ".shift2");
+
+    if (t.is_int()) {
+        q = cast(t, q) ^ n_sign;
+        // Negate the result for negative divisors, to get Euclidean
+        // division.
+        Expr d_sign = hoisted(t.element_of(), ".sign");
+        q = (q ^ d_sign) - d_sign;
+    }
+
+    if (is_mod) {
+        // Wrapping arithmetic gets the right answer even when q * b
+        // alone would overflow.
+        q = cast(t, cast(ut, n) - cast(ut, q) * cast(ut, b));
+    }
+
+    return Let::make(n_name, a, q);
+}
+
+class HoistLoopInvariantDivision : public IRMutator {
+    using IRMutator::visit;
+
+    struct HoistedDivisor {
+        Type type;
+        Expr divisor;
+        string name;
+    };
+
+    // The loops we're in, and the divisors to hoist out of each one.
+    vector<vector<HoistedDivisor>> loops;
+
+    // The depth in loops at which each variable is defined.
+    Scope<int> depths;
+
+    template<typename T>
+    void visit_div_or_mod(const T *op, bool is_mod) {
+        Type t = op->type;
+        const Broadcast *b = op->b.template as<Broadcast>();
+        if (!b || !t.is_vector() ||
+            !(t.is_int() || t.is_uint()) ||
+            !(t.bits() == 8 || t.bits() == 16 || t.bits() == 32) ||
+            is_const(b->value) || loops.empty()) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        FindInvariantDepth invariant(depths);
+        b->value.accept(&invariant);
+        if (!invariant.safe || invariant.depth >= (int)loops.size()) {
+            // The divisor changes in the innermost loop.
+            IRMutator::visit(op);
+            return;
+        }
+
+        // Share the magic numbers between divisions by the same thing.
+        vector<HoistedDivisor> &hoisted = loops[invariant.depth];
+        string name;
+        for (const HoistedDivisor &h : hoisted) {
+            if (h.type == b->value.type() && equal(h.divisor, b->value)) {
+                name = h.name;
+                break;
+            }
+        }
+        if (name.empty()) {
+            name = unique_name("divisor");
+            hoisted.push_back({b->value.type(), b->value, name});
+        }
+
+        expr = divide_using_magic(mutate(op->a), op->b, name, is_mod);
+    }
+
+    void visit(const Div *op) {
+        visit_div_or_mod(op, false);
+    }
+
+    void visit(const Mod *op) {
+        visit_div_or_mod(op, true);
+    }
+
+    void visit(const Let *op) {
+        Expr value = mutate(op->value);
+        depths.push(op->name, (int)loops.size());
+        Expr body = mutate(op->body);
+        depths.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            expr = op;
+        } else {
+            expr = Let::make(op->name, value, body);
+        }
+    }
+
+    void visit(const LetStmt *op) {
+        Expr value = mutate(op->value);
+        depths.push(op->name, (int)loops.size());
+        Stmt body = mutate(op->body);
+        depths.pop(op->name);
+        if (value.same_as(op->value) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = LetStmt::make(op->name, value, body);
+        }
+    }
+
+    void visit(const For *op) {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            // Leave device code to the device backends.
+            stmt = op;
+            return;
+        }
+
+        Expr min = mutate(op->min);
+        Expr extent = mutate(op->extent);
+
+        loops.push_back(vector<HoistedDivisor>());
+        depths.push(op->name, (int)loops.size());
+        Stmt body = mutate(op->body);
+        depths.pop(op->name);
+        vector<HoistedDivisor> hoisted;
+        hoisted.swap(loops.back());
+        loops.pop_back();
+
+        if (min.same_as(op->min) && extent.same_as(op->extent) && body.same_as(op->body)) {
+            stmt = op;
+        } else {
+            stmt = For::make(op->name, min, extent, op->for_type, op->device_api, body);
+        }
+
+        for (size_t i = hoisted.size(); i > 0; i--) {
+            const HoistedDivisor &h = hoisted[i - 1];
+            vector<pair<string, Expr>> lets = make_division_magic(h.type, h.divisor, h.name);
+            for (size_t j = lets.size(); j > 0; j--) {
+                stmt = LetStmt::make(lets[j - 1].first, lets[j - 1].second, stmt);
+            }
+        }
+    }
+};
+
+}  // namespace
+
+Stmt hoist_loop_invariant_division(Stmt s) {
+    return HoistLoopInvariantDivision().mutate(s);
+}
+
+}
+}
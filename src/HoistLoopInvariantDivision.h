@@ -0,0 +1,27 @@
+#ifndef HALIDE_HOIST_LOOP_INVARIANT_DIVISION_H
+#define HALIDE_HOIST_LOOP_INVARIANT_DIVISION_H
+
+/** \file
+ * Defines the lowering pass that rewrites vector division by a
+ * loop-invariant divisor as a multiply and shifts.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Find vector divisions and modulos of 8, 16, or 32-bit integers by
+ * a divisor that is not a constant, but doesn't change within some
+ * enclosing loop (e.g. a Param). Compute the multiply-shift magic
+ * numbers for the divisor once, before the outermost such loop, and
+ * replace the division with a widening multiply, keeping the high
+ * half, and two shifts, all of which vectorize. Constant divisors
+ * are left alone; codegen already does this for them. Done during a
+ * late stage of lowering, after vectorization. */
+Stmt hoist_loop_invariant_division(Stmt s);
+
+}
+}
+
+#endif
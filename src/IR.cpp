@@ -270,6 +270,22 @@ Expr Broadcast::make(Expr value, int lanes) {
     return node;
 }
 
+Expr VectorReduce::make(VectorReduce::Operator op, Expr value, int lanes) {
+    internal_assert(value.defined()) << "VectorReduce of undefined\n";
+    internal_assert(lanes > 0 && value.type().lanes() % lanes == 0)
+        << "VectorReduce of " << value.type().lanes() << " lanes to " << lanes << " lanes\n";
+    internal_assert(!value.type().is_bool() || op == And || op == Or)
+        << "Only And and Or can reduce boolean vectors\n";
+    internal_assert(!value.type().is_float() || (op != And && op != Or))
+        << "Can't do a bitwise reduction of a float vector\n";
+
+    VectorReduce *node = new VectorReduce;
+    node->type = value.type().with_lanes(lanes);
+    node->value = value;
+    node->op = op;
+    return node;
+}
+
 Expr Let::make(std::string name, Expr value, Expr body) {
     internal_assert(value.defined()) << "Let of undefined\n";
     internal_assert(body.defined()) << "Let of undefined\n";
@@ -493,6 +509,15 @@ Stmt Evaluate::make(Expr v) {
     return node;
 }
 
+Stmt Atomic::make(std::string producer_name, Stmt body) {
+    internal_assert(body.defined()) << "Atomic of undefined\n";
+
+    Atomic *node = new Atomic;
+    node->producer_name = producer_name;
+    node->body = body;
+    return node;
+}
+
 Expr Call::make(Type type, std::string name, const std::vector<Expr> &args, CallType call_type,
                 IntrusivePtr<FunctionContents> func, int value_index,
                 Buffer image, Parameter param) {
@@ -562,6 +587,7 @@ template<> void ExprNode<Select>::accept(IRVisitor *v) const { v->visit((const S
 template<> void ExprNode<Load>::accept(IRVisitor *v) const { v->visit((const Load *)this); }
 template<> void ExprNode<Ramp>::accept(IRVisitor *v) const { v->visit((const Ramp *)this); }
 template<> void ExprNode<Broadcast>::accept(IRVisitor *v) const { v->visit((const Broadcast *)this); }
+template<> void ExprNode<VectorReduce>::accept(IRVisitor *v) const { v->visit((const VectorReduce *)this); }
 template<> void ExprNode<Call>::accept(IRVisitor *v) const { v->visit((const Call *)this); }
 template<> void ExprNode<Let>::accept(IRVisitor *v) const { v->visit((const Let *)this); }
 template<> void StmtNode<LetStmt>::accept(IRVisitor *v) const { v->visit((const LetStmt *)this); }
@@ -576,6 +602,7 @@ template<> void StmtNode<Realize>::accept(IRVisitor *v) const { v->visit((const
 template<> void StmtNode<Block>::accept(IRVisitor *v) const { v->visit((const Block *)this); }
 template<> void StmtNode<IfThenElse>::accept(IRVisitor *v) const { v->visit((const IfThenElse *)this); }
 template<> void StmtNode<Evaluate>::accept(IRVisitor *v) const { v->visit((const Evaluate *)this); }
+template<> void StmtNode<Atomic>::accept(IRVisitor *v) const { v->visit((const Atomic *)this); }
 
 Call::ConstString Call::debug_to_file = "debug_to_file";
 Call::ConstString Call::shuffle_vector = "shuffle_vector";
@@ -236,6 +236,31 @@ struct Broadcast : public ExprNode<Broadcast> {
     static const IRNodeType _type_info = IRNodeType::Broadcast;
 };
 
+/** Horizontally reduce a vector to a narrower vector (or a scalar)
+ * using a commutative and associative binary operator. The lanes of
+ * 'value' are divided into as many groups of adjacent lanes as the
+ * result has lanes, and each group is reduced to one lane of the
+ * result. The result has the same element type as 'value'; a
+ * widening reduction is expressed by reducing a widening cast. And
+ * and Or are logical for boolean vectors and bitwise otherwise. */
+struct VectorReduce : public ExprNode<VectorReduce> {
+    enum Operator {
+        Add,
+        Mul,
+        Min,
+        Max,
+        And,
+        Or
+    };
+
+    Expr value;
+    Operator op;
+
+    EXPORT static Expr make(Operator op, Expr value, int lanes);
+
+    static const IRNodeType _type_info = IRNodeType::VectorReduce;
+};
+
 /** A let expression, like you might find in a functional
  * language. Within the expression \ref Let::body, instances of the Var
  * node \ref Let::name refer to \ref Let::value. */
@@ -423,6 +448,20 @@ struct Evaluate : public StmtNode<Evaluate> {
     static const IRNodeType _type_info = IRNodeType::Evaluate;
 };
 
+/** Marks the lowered form of an update definition scheduled with
+ * Stage::atomic. Each store to the buffer 'producer_name' inside the
+ * body is a read-modify-write of a single location, which must be
+ * performed atomically with respect to other threads storing to the
+ * same buffer. */
+struct Atomic : public StmtNode<Atomic> {
+    std::string producer_name;
+    Stmt body;
+
+    EXPORT static Stmt make(std::string producer_name, Stmt body);
+
+    static const IRNodeType _type_info = IRNodeType::Atomic;
+};
+
 /** A function call. This can represent a call to some extern function
  * (like sin), but it's also our multi-dimensional version of a Load,
  * so it can be a load from an input image, or a call to another
@@ -74,6 +74,7 @@ private:
     void visit(const Load *);
     void visit(const Ramp *);
     void visit(const Broadcast *);
+    void visit(const VectorReduce *);
     void visit(const Call *);
     void visit(const Let *);
     void visit(const LetStmt *);
@@ -88,6 +89,7 @@ private:
     void visit(const Block *);
     void visit(const IfThenElse *);
     void visit(const Evaluate *);
+    void visit(const Atomic *);
 };
 
 template<typename T>
@@ -313,6 +315,13 @@ void IRComparer::visit(const Broadcast *op) {
     compare_expr(e->value, op->value);
 }
 
+void IRComparer::visit(const VectorReduce *op) {
+    const VectorReduce *e = expr.as<VectorReduce>();
+    // No need to compare the output lanes because we already compared types
+    compare_scalar(e->op, op->op);
+    compare_expr(e->value, op->value);
+}
+
 void IRComparer::visit(const Call *op) {
     const Call *e = expr.as<Call>();
 
@@ -436,6 +445,13 @@ void IRComparer::visit(const Evaluate *op) {
     compare_expr(s->value, op->value);
 }
 
+void IRComparer::visit(const Atomic *op) {
+    const Atomic *s = stmt.as<Atomic>();
+
+    compare_names(s->producer_name, op->producer_name);
+    compare_stmt(s->body, op->body);
+}
+
 } // namespace
 
 
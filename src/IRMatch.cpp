@@ -219,6 +219,16 @@ public:
         }
     }
 
+    void visit(const VectorReduce *op) {
+        const VectorReduce *e = expr.as<VectorReduce>();
+        if (result && e && types_match(op->type, e->type) && e->op == op->op) {
+            expr = e->value;
+            op->value.accept(this);
+        } else {
+            result = false;
+        }
+    }
+
     void visit(const Call *op) {
         const Call *e = expr.as<Call>();
         if (result && e &&
@@ -116,6 +116,12 @@ void IRMutator::visit(const Broadcast *op) {
     else expr = Broadcast::make(value, op->lanes);
 }
 
+void IRMutator::visit(const VectorReduce *op) {
+    Expr value = mutate(op->value);
+    if (value.same_as(op->value)) expr = op;
+    else expr = VectorReduce::make(op->op, value, op->type.lanes());
+}
+
 void IRMutator::visit(const Call *op) {
     vector<Expr > new_args(op->args.size());
     bool changed = false;
@@ -319,6 +325,15 @@ void IRMutator::visit(const Evaluate *op) {
     }
 }
 
+void IRMutator::visit(const Atomic *op) {
+    Stmt body = mutate(op->body);
+    if (body.same_as(op->body)) {
+        stmt = op;
+    } else {
+        stmt = Atomic::make(op->producer_name, body);
+    }
+}
+
 
 Stmt IRGraphMutator::mutate(Stmt s) {
     auto iter = stmt_replacements.find(s);
@@ -67,6 +67,7 @@ protected:
     EXPORT virtual void visit(const Load *);
     EXPORT virtual void visit(const Ramp *);
     EXPORT virtual void visit(const Broadcast *);
+    EXPORT virtual void visit(const VectorReduce *);
     EXPORT virtual void visit(const Call *);
     EXPORT virtual void visit(const Let *);
     EXPORT virtual void visit(const LetStmt *);
@@ -81,6 +82,7 @@ protected:
     EXPORT virtual void visit(const Block *);
     EXPORT virtual void visit(const IfThenElse *);
     EXPORT virtual void visit(const Evaluate *);
+    EXPORT virtual void visit(const Atomic *);
 };
 
 
@@ -653,6 +653,210 @@ Expr fast_exp(Expr x_full) {
     return result;
 }
 
+// The polynomials used by the functions below were fit with
+// Lawson's algorithm (iteratively reweighted least squares, which
+// converges to the minimax fit) to minimize the maximum relative
+// error over the reduced domain. Each table is ordered from fewest to
+// most terms.
+namespace {
+
+int precision_tier(ApproximationPrecision precision) {
+    switch (precision) {
+    case ApproximationPrecision::Low:
+        return 0;
+    case ApproximationPrecision::Medium:
+        return 1;
+    default:
+        return 2;
+    }
+}
+
+// Evaluate x + x * x^2 * p(x^2), which is more accurate than
+// evaluating the full odd polynomial, because the leading term is
+// exact.
+Expr evaluate_odd_polynomial(Expr x, float *coeff, int n) {
+    Expr x2 = x * x;
+    return x + x * x2 * evaluate_polynomial(x2, coeff, n);
+}
+
+Expr fast_sin_or_cos(Expr x_full, bool is_cos, ApproximationPrecision precision) {
+    Type type = x_full.type();
+    int tier = precision_tier(precision);
+
+    // Reduce to [-pi/4, pi/4], with x_full = x + k * pi/2. pi/2 is
+    // split into three parts, the first two of which have few enough
+    // bits that multiplying them by k is exact.
+    const float pi_over_two_part1 = 1.5703125f;
+    const float pi_over_two_part2 = 4.837512969970703125e-4f;
+    const float pi_over_two_part3 = 7.549789954891882e-8f;
+    Expr k_real = floor(x_full * 0.636619772f + 0.5f);
+    Expr k = cast(Int(32, type.lanes()), k_real);
+    Expr x = x_full - k_real * pi_over_two_part1;
+    x -= k_real * pi_over_two_part2;
+    x -= k_real * pi_over_two_part3;
+
+    // cos(x) = sin(x + pi/2)
+    if (is_cos) {
+        k += 1;
+    }
+
+    // The errors of the degree 5 sine and degree 4 cosine are 2e-6
+    // and 1.5e-5; for the degree 7 sine and degree 6 cosine they are
+    // 4e-9 and 4e-8, which is below float rounding error.
+    float sin_coeff[2][3] = {
+        {0.0081632819f, -0.1666339038f},
+        {-1.9515283167e-4f, 8.3321607616e-3f, -0.1666665461f}};
+    float cos_coeff[2][4] = {
+        {0.0404584521f, -0.4997605570f, 1.0f},
+        {-1.3591853529e-3f, 0.0416557770f, -0.4999988475f, 1.0f}};
+    int sin_poly = (tier == 2) ? 1 : 0;
+    int cos_poly = (tier == 0) ? 0 : 1;
+
+    Expr sin_x = evaluate_odd_polynomial(x, sin_coeff[sin_poly], sin_poly + 2);
+    Expr cos_x = evaluate_polynomial(x * x, cos_coeff[cos_poly], cos_poly + 3);
+
+    // sin(x + k*pi/2) is sin(x), cos(x), -sin(x), or -cos(x),
+    // depending on k mod 4.
+    Expr result = select((k & 1) == 1, cos_x, sin_x);
+    result = select((k & 2) == 2, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+}
+
+Expr fast_sin(Expr x, ApproximationPrecision precision) {
+    user_assert(x.type() == Float(32)) << "fast_sin only works for Float(32)";
+    return fast_sin_or_cos(x, false, precision);
+}
+
+Expr fast_cos(Expr x, ApproximationPrecision precision) {
+    user_assert(x.type() == Float(32)) << "fast_cos only works for Float(32)";
+    return fast_sin_or_cos(x, true, precision);
+}
+
+Expr fast_atan2(Expr y, Expr x, ApproximationPrecision precision) {
+    user_assert(y.type() == Float(32) && x.type() == Float(32))
+        << "fast_atan2 only works for Float(32)";
+    int tier = precision_tier(precision);
+
+    // Reduce to atan(a) for a in [0, 1], and use the symmetries of
+    // atan to get back the full result.
+    Expr abs_x = abs(x), abs_y = abs(y);
+    Expr num = min(abs_x, abs_y), den = max(abs_x, abs_y);
+    Expr a = select(den == 0.0f, 0.0f, num / den);
+
+    float coeff[3][8] = {
+        {0.0248402771f, -0.0940979320f, 0.1868141716f, -0.3321307190f},
+        {8.1063663682e-3f, -0.0377967163f, 0.0848410353f, -0.1354457597f,
+         0.1989787327f, -0.3332849194f},
+        {2.9206930376e-3f, -0.0163679311f, 0.0432118657f, -0.0755221468f,
+         0.1066600481f, -0.1421105534f, 0.1999377284f, -0.3333315274f}};
+    int terms[] = {4, 6, 8};
+
+    Expr result = evaluate_odd_polynomial(a, coeff[tier], terms[tier]);
+    result = select(abs_y > abs_x, 1.570796327f - result, result);
+    result = select(x < 0.0f, 3.141592654f - result, result);
+    result = select(y < 0.0f, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr fast_tanh(Expr x_full, ApproximationPrecision precision) {
+    user_assert(x_full.type() == Float(32)) << "fast_tanh only works for Float(32)";
+    int tier = precision_tier(precision);
+
+    Expr x = abs(x_full);
+
+    // An odd polynomial for small x, where 1 - 2/(exp(2x) + 1) would
+    // lose precision to cancellation.
+    float coeff[3][4] = {
+        {0.1133206831f, -0.3315334351f},
+        {-0.0430996453f, 0.1315235641f, -0.3332451423f},
+        {0.0164375802f, -0.0526718130f, 0.1332072505f, -0.3333294664f}};
+    Expr small = evaluate_odd_polynomial(x, coeff[tier], tier + 2);
+
+    // tanh(x) is one in float for x > 9.1, so clamping x keeps exp
+    // from overflowing.
+    Expr e = 2.0f * min(x, 10.0f);
+    e = (tier == 2) ? Internal::halide_exp(e) : fast_exp(e);
+    Expr large = 1.0f - 2.0f / (e + 1.0f);
+
+    Expr result = select(x < 0.55f, small, large);
+    result = select(x_full < 0.0f, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr fast_erf(Expr x_full, ApproximationPrecision precision) {
+    user_assert(x_full.type() == Float(32)) << "fast_erf only works for Float(32)";
+    int tier = precision_tier(precision);
+
+    Expr x = abs(x_full);
+
+    // x * p(x^2) for x < 1, like the Taylor series.
+    float small_coeff[3][6] = {
+        {-0.0183674614f, 0.1078336675f, -0.3751365414f, 1.1283474151f},
+        {3.4940699727e-3f, -0.0254478101f, 0.1123417429f, -0.3760641423f, 1.1283778878f},
+        {-5.6314222025e-4f, 4.9175514234e-3f, -0.0267113113f, 0.1128018011f,
+         -0.3761232619f, 1.1283791225f}};
+    Expr small = x * evaluate_polynomial(x * x, small_coeff[tier], tier + 4);
+
+    // 1 - p(x)^-16 for larger x, like the approximations in
+    // Abramowitz and Stegun. erf(x) is one in float for x > 3.9, so
+    // clamping x keeps the polynomial in the domain it was fit on.
+    float large_coeff[3][7] = {
+        {0.0186543745f, 0.0157289440f, 0.0981132882f, 0.9900434392f},
+        {3.7981628453e-3f, -3.1239991772e-3f, 0.0614645866f, 0.0563524453f, 1.0040565814f},
+        {1.0972676965e-4f, -2.7426415854e-4f, 2.0154361284e-3f, 5.9513002005e-3f,
+         0.0455789386f, 0.0687867750f, 1.0003792422f}};
+    int large_terms[] = {4, 5, 7};
+    Expr large = evaluate_polynomial(min(x, 4.0f), large_coeff[tier], large_terms[tier]);
+    large = 1.0f - Internal::raise_to_integer_power(large, -16);
+
+    Expr result = select(x < 1.0f, small, large);
+    result = select(x_full < 0.0f, -result, result);
+
+    return common_subexpression_elimination(result);
+}
+
+Expr fast_cbrt(Expr x_full, ApproximationPrecision precision) {
+    user_assert(x_full.type() == Float(32)) << "fast_cbrt only works for Float(32)";
+    int tier = precision_tier(precision);
+
+    Type type = x_full.type();
+    Type int_type = Int(32, type.lanes());
+    Expr x = abs(x_full);
+
+    // Find r = x^(-1/3) instead of the cube root directly, because
+    // Newton's method for it needs no division. Dividing the bits of
+    // x by three approximately divides its log by three, which gives
+    // a first guess good to about four bits.
+    Expr bits = reinterpret(int_type, x);
+    Expr r = reinterpret(type, Internal::make_const(int_type, 0x54a21d2a) - bits / 3);
+
+    // Each step roughly doubles the number of correct bits.
+    Expr third_x = x * (1.0f / 3);
+    int steps = (tier == 0) ? 2 : 3;
+    for (int i = 0; i < steps; i++) {
+        r = r * (4.0f / 3 - third_x * (r * r * r));
+    }
+
+    // x^(1/3) = x * (x^(-1/3))^2
+    Expr result = x * (r * r);
+    if (tier == 2) {
+        // One more Newton step, on the cube root itself, to remove
+        // most of the rounding error of the steps above. r^2 stands in
+        // for 1/result^2.
+        result += (x - result * result * result) * (r * r) * (1.0f / 3);
+    }
+    result = select(x_full < 0.0f, -result, result);
+    // The guess for zero is large enough that r^3 overflows.
+    result = select(x == 0.0f, x_full, result);
+
+    return common_subexpression_elimination(result);
+}
+
 Expr print(const std::vector<Expr> &args) {
     // Insert spaces between each expr.
     std::vector<Expr> print_args(args.size()*2);
@@ -1275,6 +1275,55 @@ inline Expr fast_pow(Expr x, Expr y) {
     return select(x == 0.0f, 0.0f, fast_exp(fast_log(x) * y));
 }
 
+/** Precision tiers for the fast polynomial approximations to
+ * transcendental functions below. Higher tiers use more polynomial
+ * terms (or Newton steps), and so cost a few more multiply-adds per
+ * element. Each function documents its measured worst-case error at
+ * each tier, in units in the last place (ULPs) of the float
+ * result. */
+enum class ApproximationPrecision {
+    Low,    ///< Within 1024 ULPs, i.e. about 14 bits of precision. Plenty for 8-bit output.
+    Medium, ///< Within 32 ULPs, i.e. about 19 bits of precision.
+    High    ///< Within 8 ULPs, and for most functions within 4.
+};
+
+/** Fast approximate cleanly vectorizable sine for Float(32). The
+ * argument is reduced modulo pi/2 using a three-part representation
+ * of pi/2, which stays accurate for |x| up to about 10^4. Within
+ * that range, the worst-case error is 256 ULPs at Low, 32 ULPs at
+ * Medium, and 4 ULPs at High, except near the zeros of sin, where the
+ * absolute error is below 1e-9. Beyond it, the absolute error
+ * grows to about 1e-6 at 10^5. */
+EXPORT Expr fast_sin(Expr x, ApproximationPrecision precision = ApproximationPrecision::Medium);
+
+/** Fast approximate cleanly vectorizable cosine for Float(32). Has
+ * the same accuracy as \ref fast_sin. */
+EXPORT Expr fast_cos(Expr x, ApproximationPrecision precision = ApproximationPrecision::Medium);
+
+/** Fast approximate cleanly vectorizable four-quadrant arctangent of
+ * y/x for Float(32). Returns zero when both arguments are zero, does
+ * not distinguish between positive and negative zero, and returns
+ * nonsense for infinite arguments. The worst-case error is 640 ULPs
+ * at Low, 16 ULPs at Medium, and 4 ULPs at High. */
+EXPORT Expr fast_atan2(Expr y, Expr x, ApproximationPrecision precision = ApproximationPrecision::Medium);
+
+/** Fast approximate cleanly vectorizable hyperbolic tangent for
+ * Float(32). The worst-case error is 1024 ULPs at Low, 32 ULPs at
+ * Medium, and 3 ULPs at High. */
+EXPORT Expr fast_tanh(Expr x, ApproximationPrecision precision = ApproximationPrecision::Medium);
+
+/** Fast approximate cleanly vectorizable error function for
+ * Float(32). The worst-case error is 512 ULPs at Low, 32 ULPs at
+ * Medium, and 8 ULPs at High. */
+EXPORT Expr fast_erf(Expr x, ApproximationPrecision precision = ApproximationPrecision::Medium);
+
+/** Fast approximate cleanly vectorizable cube root for
+ * Float(32). Uses a bit-trick initial guess, refined with Newton's
+ * method. The worst-case error is 400 ULPs at Low, 10 ULPs at Medium,
+ * and 2 ULPs at High. Returns nonsense for denormals, infinities and
+ * NaNs. */
+EXPORT Expr fast_cbrt(Expr x, ApproximationPrecision precision = ApproximationPrecision::Medium);
+
 /** Fast approximate inverse for Float(32). Corresponds to the rcpps
  * instruction on x86, and the vrecpe instruction on ARM. Vectorizes
  * cleanly. */
@@ -46,6 +46,10 @@ EXPORT std::ostream &operator<<(std::ostream &stream, const Stmt &);
  * readable form */
 EXPORT std::ostream &operator<<(std::ostream &stream, const ForType &);
 
+/** Emit a horizontal vector reduction operator in a human-readable
+ * form */
+EXPORT std::ostream &operator<<(std::ostream &stream, const VectorReduce::Operator &);
+
 /** An IRVisitor that emits IR to the given output stream in a human
  * readable form. Can be subclassed if you want to modify the way in
  * which it prints.
@@ -101,6 +105,7 @@ protected:
     void visit(const Load *);
     void visit(const Ramp *);
     void visit(const Broadcast *);
+    void visit(const VectorReduce *);
     void visit(const Call *);
     void visit(const Let *);
     void visit(const LetStmt *);
@@ -115,6 +120,7 @@ protected:
     void visit(const Block *);
     void visit(const IfThenElse *);
     void visit(const Evaluate *);
+    void visit(const Atomic *);
 };
 }
 }
@@ -123,6 +123,10 @@ void IRVisitor::visit(const Broadcast *op) {
     op->value.accept(this);
 }
 
+void IRVisitor::visit(const VectorReduce *op) {
+    op->value.accept(this);
+}
+
 void IRVisitor::visit(const Call *op) {
     for (size_t i = 0; i < op->args.size(); i++) {
         op->args[i].accept(this);
@@ -225,6 +229,10 @@ void IRVisitor::visit(const Evaluate *op) {
     op->value.accept(this);
 }
 
+void IRVisitor::visit(const Atomic *op) {
+    op->body.accept(this);
+}
+
 void IRGraphVisitor::include(const Expr &e) {
     if (visited.count(e.get())) {
         return;
@@ -362,6 +370,10 @@ void IRGraphVisitor::visit(const Broadcast *op) {
     include(op->value);
 }
 
+void IRGraphVisitor::visit(const VectorReduce *op) {
+    include(op->value);
+}
+
 void IRGraphVisitor::visit(const Call *op) {
     for (size_t i = 0; i < op->args.size(); i++) {
         include(op->args[i]);
@@ -449,5 +461,9 @@ void IRGraphVisitor::visit(const Evaluate *op) {
     include(op->value);
 }
 
+void IRGraphVisitor::visit(const Atomic *op) {
+    include(op->body);
+}
+
 }
 }
@@ -48,6 +48,7 @@ public:
     EXPORT virtual void visit(const Load *);
     EXPORT virtual void visit(const Ramp *);
     EXPORT virtual void visit(const Broadcast *);
+    EXPORT virtual void visit(const VectorReduce *);
     EXPORT virtual void visit(const Call *);
     EXPORT virtual void visit(const Let *);
     EXPORT virtual void visit(const LetStmt *);
@@ -62,6 +63,7 @@ public:
     EXPORT virtual void visit(const Block *);
     EXPORT virtual void visit(const IfThenElse *);
     EXPORT virtual void visit(const Evaluate *);
+    EXPORT virtual void visit(const Atomic *);
 };
 
 /** A base class for algorithms that walk recursively over the IR
@@ -112,6 +114,7 @@ public:
     EXPORT virtual void visit(const Load *);
     EXPORT virtual void visit(const Ramp *);
     EXPORT virtual void visit(const Broadcast *);
+    EXPORT virtual void visit(const VectorReduce *);
     EXPORT virtual void visit(const Call *);
     EXPORT virtual void visit(const Let *);
     EXPORT virtual void visit(const LetStmt *);
@@ -126,6 +129,7 @@ public:
     EXPORT virtual void visit(const Block *);
     EXPORT virtual void visit(const IfThenElse *);
     EXPORT virtual void visit(const Evaluate *);
+    EXPORT virtual void visit(const Atomic *);
     // @}
 };
 
@@ -27,12 +27,18 @@ void ImageBase::prepare_for_direct_pixel_access() {
                          buffer.min(1) * stride_1 +
                          buffer.min(2) * stride_2 +
                          buffer.min(3) * stride_3);
+        dims = buffer.dimensions();
+        extra_strides.clear();
+        for (int i = 4; i < dims; i++) {
+            extra_strides.push_back(buffer.stride(i));
+            offset += buffer.min(i) * buffer.stride(i);
+        }
         offset *= elem_size;
         origin = (void *)((uint8_t *)origin - offset);
-        dims = buffer.dimensions();
     } else {
         origin = nullptr;
         stride_0 = stride_1 = stride_2 = stride_3 = 0;
+        extra_strides.clear();
         dims = 0;
     }
 }
@@ -81,6 +87,11 @@ ImageBase::ImageBase(Type t, int x, int y, int z, int w, const std::string &name
     prepare_for_direct_pixel_access();
 }
 
+ImageBase::ImageBase(Type t, const std::vector<int> &sizes, const std::string &name) :
+    buffer(Buffer(t, sizes, nullptr, make_image_name(name, this))) {
+    prepare_for_direct_pixel_access();
+}
+
 ImageBase::ImageBase(Type t, const Buffer &buf) : buffer(buf) {
     if (t != buffer.type()) {
         user_error << "Can't construct Image of type " << t
@@ -149,6 +160,13 @@ void ImageBase::set_min(int m0, int m1, int m2, int m3) {
     prepare_for_direct_pixel_access();
 }
 
+void ImageBase::set_min(const std::vector<int> &mins) {
+    user_assert(defined()) << "set_min of undefined Image\n";
+    buffer.set_min(mins);
+    // Move the origin
+    prepare_for_direct_pixel_access();
+}
+
 int ImageBase::stride(int dim) const {
     user_assert(defined()) << "stride of undefined Image\n";
     user_assert(dim >= 0 && dim < dims)
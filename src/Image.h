@@ -32,6 +32,9 @@ protected:
      */
     int stride_0, stride_1, stride_2, stride_3;
 
+    /** The strides of any dimensions beyond the fourth. */
+    std::vector<int> extra_strides;
+
     /** The dimensionality. */
     int dims;
 
@@ -54,6 +57,10 @@ public:
     /** Allocate an image with the given dimensions. */
     EXPORT ImageBase(Type t, int x, int y = 0, int z = 0, int w = 0, const std::string &name = "");
 
+    /** Allocate an image with the given extents, which may have more
+     * than four dimensions. */
+    EXPORT ImageBase(Type t, const std::vector<int> &sizes, const std::string &name = "");
+
     /** Wrap a buffer in an Image object, so that we can directly
      * access its pixels in a type-safe way. */
     EXPORT ImageBase(Type t, const Buffer &buf);
@@ -95,7 +102,10 @@ public:
     EXPORT int min(int dim) const;
 
     /** Set the min coordinates of a dimension. */
+    // @{
     EXPORT void set_min(int m0, int m1 = 0, int m2 = 0, int m3 = 0);
+    EXPORT void set_min(const std::vector<int> &mins);
+    // @}
 
     /** Get the number of elements in the buffer between two adjacent
      * elements in the given dimension. For example, the stride in
@@ -164,11 +174,28 @@ public:
                             (ptrdiff_t)w*stride_3);
         return (void *)(ptr + offset * elem_size);
     }
+
+    /** Get the address of a particular pixel, given a coordinate in
+     * each dimension. Works for images of any dimensionality. */
+    void *address_of(const std::vector<int> &pos) const {
+        int p[4] = {0, 0, 0, 0};
+        ptrdiff_t offset = 0;
+        for (size_t i = 0; i < pos.size(); i++) {
+            if (i < 4) {
+                p[i] = pos[i];
+            } else {
+                offset += (ptrdiff_t)pos[i] * extra_strides[i - 4];
+            }
+        }
+        return (uint8_t *)address_of(p[0], p[1], p[2], p[3]) + offset * elem_size;
+    }
 };
 
 /** A reference-counted handle on a dense multidimensional array
  * containing scalar values of type T. Can be directly accessed and
- * modified. May have up to four dimensions. Color images are
+ * modified. Images of up to four dimensions may be accessed with a
+ * coordinate per argument, and images of more with a std::vector of
+ * coordinates. Color images are
  * represented as three-dimensional, with the third dimension being
  * the color channel. In general we store color images in
  * color-planes, as opposed to packed RGB, because this tends to
@@ -194,6 +221,9 @@ public:
 
     NO_INLINE Image(int x, const std::string &name) :
         ImageBase(type_of<T>(), x, 0, 0, 0, name) {}
+
+    NO_INLINE Image(const std::vector<int> &sizes, const std::string &name = "") :
+        ImageBase(type_of<T>(), sizes, name) {}
     // @}
 
     /** Wrap a buffer in an Image object, so that we can directly
@@ -240,6 +270,12 @@ public:
         return *((T *)(address_of(x, y, z, w)));
     }
 
+    /** Get the value of the element at the given position, which
+     * may have more than four coordinates. */
+    const T &operator()(const std::vector<int> &pos) const {
+        return *((T *)(address_of(pos)));
+    }
+
     /** Assuming this image is one-dimensional, get a reference to the
      * element at position x */
     T &operator()(int x) {
@@ -264,6 +300,12 @@ public:
         return *((T *)(address_of(x, y, z, w)));
     }
 
+    /** Get a reference to the element at the given position, which
+     * may have more than four coordinates. */
+    T &operator()(const std::vector<int> &pos) {
+        return *((T *)(address_of(pos)));
+    }
+
     /** Get a handle on the Buffer that this image holds */
     operator Buffer() const {
         return buffer;
@@ -6,14 +6,27 @@
 #include "LLVM_Headers.h"
 #include "Error.h"
 
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
 #include <sstream>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 // defines backtrace, which gets the call stack as instruction pointers
 #include <execinfo.h>
 
+#ifndef __APPLE__
+// defines dl_iterate_phdr, which says where the binary was loaded
+#include <link.h>
+#endif
+
 using std::vector;
 using std::pair;
 using std::map;
@@ -37,9 +50,48 @@ void get_program_name(char *name, int32_t size) {
 }
 #endif
 
+#ifndef __APPLE__
+namespace {
+struct LoadBiasQuery {
+    uint64_t addr;
+    int64_t bias;
+    bool found;
+};
+
+int find_load_bias(struct dl_phdr_info *info, size_t, void *data) {
+    LoadBiasQuery *q = (LoadBiasQuery *)data;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr) &ph = info->dlpi_phdr[i];
+        uint64_t begin = info->dlpi_addr + ph.p_vaddr;
+        if (ph.p_type == PT_LOAD && q->addr >= begin && q->addr < begin + ph.p_memsz) {
+            q->bias = info->dlpi_addr;
+            q->found = true;
+            return 1;
+        }
+    }
+    return 0;
+}
+}
+#endif
+
+// Get the offset between the addresses in a binary and the addresses
+// it was loaded at, given a function in it. Returns zero if unknown.
+int64_t guess_load_bias(void (*fn)()) {
+    #ifdef __APPLE__
+    return 0;
+    #else
+    LoadBiasQuery q = {(uint64_t)fn, 0, false};
+    dl_iterate_phdr(find_load_bias, &q);
+    return q.found ? q.bias : 0;
+    #endif
+}
+
 class DebugSections {
 
+    friend void test();
+
     bool calibrated;
+    int64_t pc_adjust;
 
     struct FieldFormat {
         uint64_t name, form;
@@ -158,11 +210,75 @@ class DebugSections {
     };
     vector<TypeInfo> types;
 
+    // The binary and its debug sections, which stay loaded so that
+    // compilation units can be parsed as they are needed.
+#if LLVM_VERSION >= 36
+    llvm::object::OwningBinary<llvm::object::ObjectFile> object_file;
+#else
+    std::unique_ptr<llvm::object::ObjectFile> object_file;
+#endif
+    llvm::StringRef debug_info, debug_abbrev, debug_str, debug_line, debug_ranges;
+    uint8_t address_bytes;
+
+    static const uint64_t no_line_table = (uint64_t)-1;
+
+    // One compilation unit in .debug_info. The tables above are
+    // filled in by parsing it the first time something in it is
+    // looked up, and then moved here. Moving them keeps the type
+    // pointers valid.
+    struct CompilationUnit {
+        // Where the unit starts in .debug_info, and where its line
+        // table starts in .debug_line.
+        uint64_t offset, line_offset;
+
+        bool loaded;
+        // How far the addresses in the tables below have been moved
+        // from the ones in the debug info.
+        int64_t relocation;
+        vector<TypeInfo> types;
+        vector<FunctionInfo> functions;
+        vector<GlobalVariable> global_variables;
+        vector<std::string> source_files;
+        vector<LineInfo> source_lines;
+        CompilationUnit() : offset(0), line_offset(no_line_table), loaded(false), relocation(0) {}
+    };
+    vector<CompilationUnit> units;
+
+    // The code covered by each compilation unit, sorted by address.
+    struct UnitRange {
+        uint64_t pc_begin, pc_end;
+        uint32_t unit;
+        bool operator<(const UnitRange &other) const {
+            return pc_begin < other.pc_begin;
+        }
+    };
+    vector<UnitRange> unit_ranges;
+
+    // The address of every global variable, and the compilation unit
+    // that defines it, sorted by address. Finding these means reading
+    // all of .debug_info, so it's only done the first time a global
+    // is looked up.
+    struct GlobalStart {
+        uint64_t addr;
+        uint32_t unit;
+        bool operator<(const GlobalStart &other) const {
+            return addr < other.addr;
+        }
+    };
+    vector<GlobalStart> global_starts;
+    bool globals_indexed;
+
+    // Where the index above is cached, if anywhere.
+    std::string cache_file;
+
 public:
 
     bool working;
 
-    DebugSections(std::string binary) : calibrated(false), working(false) {
+    DebugSections() : calibrated(false), pc_adjust(0), address_bytes(sizeof(void *)),
+                      globals_indexed(false), working(false) {}
+
+    DebugSections(std::string binary) : DebugSections() {
         #ifdef __APPLE__
         size_t last_slash = binary.rfind('/');
         if (last_slash == std::string::npos ||
@@ -189,76 +305,117 @@ public:
         return 64;
     }
 
+    // Check whether the function at pc_real, which would be at
+    // pc_real - adjust in the debug info, is an offset marker.
+    bool is_offset_marker(uint64_t pc_real, int64_t adjust) {
+        int u = find_unit(pc_real - adjust);
+        if (u < 0) {
+            return false;
+        }
+        const CompilationUnit *unit = load_unit(u);
+        uint64_t pc = pc_real - adjust + unit->relocation;
+        for (const FunctionInfo &f : unit->functions) {
+            if (f.name == "HalideIntrospectionCanary::offset_marker" && f.pc_begin == pc) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void calibrate_pc_offset(void (*fn)()) {
         // Calibrate for the offset between the instruction pointers
         // in the debug info and the instruction pointers in the
         // actual file.
-        bool found = false;
         uint64_t pc_real = (uint64_t)fn;
-        int64_t pc_adjust = 0;
-        for (size_t i = 0; i < functions.size(); i++) {
-            if (functions[i].name == "HalideIntrospectionCanary::offset_marker" &&
-                functions[i].pc_begin) {
 
-                uint64_t pc_debug = functions[i].pc_begin;
-
-                if (calibrated) {
-                    // If we're already calibrated, we should find a function with a matching pc
-                    if (pc_debug == pc_real) {
-                        return;
-                    }
-                } else {
-                    int64_t pc_adj = pc_real - pc_debug;
+        if (calibrated) {
+            // If we're already calibrated, we should find a function with a matching pc
+            if (!is_offset_marker(pc_real, pc_adjust)) {
+                debug(2) << "Failed to find HalideIntrospectionCanary::offset_marker at the expected location\n";
+                working = false;
+            }
+            return;
+        }
 
-                    // Offset must be a multiple of 4096
-                    if (pc_adj & (4095)) {
-                        continue;
-                    }
+        // The dynamic linker knows where it put the binary. Check
+        // that against the marker, so that only the compilation unit
+        // containing it needs to be parsed.
+        bool found = false;
+        int64_t adjust = guess_load_bias(fn);
+        if (is_offset_marker(pc_real, adjust)) {
+            found = true;
+        } else {
+            // Otherwise look through every compilation unit for it.
+            debug(5) << "Searching all compilation units for HalideIntrospectionCanary::offset_marker\n";
+            adjust = 0;
+            for (size_t u = 0; u < units.size(); u++) {
+                const vector<FunctionInfo> &functions = load_unit(u)->functions;
+                for (size_t i = 0; i < functions.size(); i++) {
+                    if (functions[i].name == "HalideIntrospectionCanary::offset_marker" &&
+                        functions[i].pc_begin) {
+
+                        uint64_t pc_debug = functions[i].pc_begin;
+                        int64_t pc_adj = pc_real - pc_debug;
+
+                        // Offset must be a multiple of 4096
+                        if (pc_adj & (4095)) {
+                            continue;
+                        }
 
-                    // If we find multiple matches, pick the one with more trailing zeros
-                    if (!found ||
-                        count_trailing_zeros(pc_adj) > count_trailing_zeros(pc_adjust)) {
-                        pc_adjust = pc_adj;
-                        found = true;
+                        // If we find multiple matches, pick the one with more trailing zeros
+                        if (!found ||
+                            count_trailing_zeros(pc_adj) > count_trailing_zeros(adjust)) {
+                            adjust = pc_adj;
+                            found = true;
+                        }
                     }
                 }
             }
         }
 
         if (!found) {
-            if (!calibrated) {
-                debug(2) << "Failed to find HalideIntrospectionCanary::offset_marker\n";
-            } else {
-                debug(2) << "Failed to find HalideIntrospectionCanary::offset_marker at the expected location\n";
-            }
+            debug(2) << "Failed to find HalideIntrospectionCanary::offset_marker\n";
             working = false;
             return;
         }
 
-        debug(5) << "Program counter adjustment between debug info and actual code: " << pc_adjust << "\n";
+        debug(5) << "Program counter adjustment between debug info and actual code: " << adjust << "\n";
 
-        for (size_t i = 0; i < functions.size(); i++) {
-            FunctionInfo &f = functions[i];
-            f.pc_begin += pc_adjust;
-            f.pc_end += pc_adjust;
+        pc_adjust = adjust;
+        for (CompilationUnit &unit : units) {
+            if (unit.loaded) {
+                relocate(unit, pc_adjust);
+            }
+        }
+
+        calibrated = true;
+    }
+
+    // Move the addresses in a compilation unit's tables so that they
+    // are pc_adjust away from the ones in the debug info.
+    void relocate(CompilationUnit &unit, int64_t adjust) {
+        int64_t delta = adjust - unit.relocation;
+        unit.relocation = adjust;
+        for (size_t i = 0; i < unit.functions.size(); i++) {
+            FunctionInfo &f = unit.functions[i];
+            f.pc_begin += delta;
+            f.pc_end += delta;
             for (size_t j = 0; j < f.variables.size(); j++) {
                 LocalVariable &v = f.variables[j];
                 for (size_t k = 0; k < v.live_ranges.size(); k++) {
-                    v.live_ranges[k].pc_begin += pc_adjust;
-                    v.live_ranges[k].pc_end += pc_adjust;
+                    v.live_ranges[k].pc_begin += delta;
+                    v.live_ranges[k].pc_end += delta;
                 }
             }
         }
 
-        for (size_t i = 0; i < source_lines.size(); i++) {
-            source_lines[i].pc += pc_adjust;
+        for (size_t i = 0; i < unit.source_lines.size(); i++) {
+            unit.source_lines[i].pc += delta;
         }
 
-        for (size_t i = 0; i < global_variables.size(); i++) {
-            global_variables[i].addr += pc_adjust;
+        for (size_t i = 0; i < unit.global_variables.size(); i++) {
+            unit.global_variables[i].addr += delta;
         }
-
-        calibrated = true;
     }
 
     bool type_name_match(const std::string &actual_type, const std::string &query_type) {
@@ -276,15 +433,13 @@ public:
         return false;
     }
 
-    int find_global_variable(const void *global_pointer) {
+    // Find the first global variable in a compilation unit containing the given address.
+    int find_global_variable(const vector<GlobalVariable> &global_variables, uint64_t address) {
         if (global_variables.empty()) {
-            debug(5) << "Considering possible global at " << global_pointer << " but global_variables is empty\n";
             return -1;
         }
-        debug(5) << "Considering possible global at " << global_pointer << "\n";
 
         debug(5) << "Known globals range from " << std::hex << global_variables.front().addr << " to " << global_variables.back().addr << std::dec << "\n";
-        uint64_t address = (uint64_t)(global_pointer);
         size_t hi = global_variables.size();
         size_t lo = 0;
         while (hi > lo + 1) {
@@ -327,10 +482,45 @@ public:
         return (int)idx;
     }
 
+    // Find the first global variable containing the given address,
+    // parsing the compilation unit that defines it. *globals is set
+    // to that unit's global variables.
+    int find_global_variable(const void *global_pointer, const vector<GlobalVariable> **globals) {
+        index_global_variables();
+        debug(5) << "Considering possible global at " << global_pointer << "\n";
+        uint64_t address = (uint64_t)(global_pointer);
+        GlobalStart key = {address - pc_adjust, 0};
+        vector<GlobalStart>::iterator it =
+            std::upper_bound(global_starts.begin(), global_starts.end(), key);
+        if (it == global_starts.begin()) {
+            debug(5) << "No known globals at or below " << global_pointer << "\n";
+            return -1;
+        }
+        it--;
+
+        // Several compilation units may have a global at the same
+        // address (e.g. a static variable in an inline
+        // function). Try each of them.
+        uint64_t start = it->addr;
+        while (it != global_starts.begin() && (it - 1)->addr == start) {
+            it--;
+        }
+        for (; it != global_starts.end() && it->addr == start; it++) {
+            const vector<GlobalVariable> &vars = load_unit(it->unit)->global_variables;
+            int idx = find_global_variable(vars, address);
+            if (idx >= 0) {
+                *globals = &vars;
+                return idx;
+            }
+        }
+        return -1;
+    }
+
     // Get the debug name of a global var from a pointer to it
     std::string get_global_variable_name(const void *global_pointer, const std::string &type_name = "") {
         // Find the index of the first global variable with this address
-        int idx = find_global_variable(global_pointer);
+        const vector<GlobalVariable> *globals = nullptr;
+        int idx = find_global_variable(global_pointer, &globals);
 
         if (idx < 0) {
             // No matching global variable found.
@@ -340,9 +530,10 @@ public:
         uint64_t address = (uint64_t)global_pointer;
 
         // Now test all of them
+        const vector<GlobalVariable> &global_variables = *globals;
         for (; (size_t)idx < global_variables.size() && global_variables[idx].addr <= address; idx++) {
 
-            GlobalVariable &v = global_variables[idx];
+            const GlobalVariable &v = global_variables[idx];
             TypeInfo *elem_type = nullptr;
             if (v.type && v.type->type == TypeInfo::Array && v.type->size) {
                 elem_type = v.type->members[0].type;
@@ -381,12 +572,13 @@ public:
 
     void register_heap_object(const void *obj, size_t size, const void *helper) {
         // helper should be a pointer to a global
-        int idx = find_global_variable(helper);
+        const vector<GlobalVariable> *globals = nullptr;
+        int idx = find_global_variable(helper, &globals);
         if (idx == -1) {
             debug(5) << "Could not find helper object: " << helper << "\n";
             return;
         }
-        const GlobalVariable &ptr = global_variables[idx];
+        const GlobalVariable &ptr = (*globals)[idx];
         debug(5) << "helper object is " << ptr.name << " at " << std::hex << ptr.addr << std::dec;
         if (ptr.type) {
             debug(5) << " with type " << ptr.type->name << "\n";
@@ -562,10 +754,9 @@ public:
         return "";
     }
 
-    // Get the debug name of a stack variable from a pointer to it
-    std::string get_stack_variable_name(const void *stack_pointer, const std::string &type_name = "") {
-
-        // Check it's a plausible stack pointer
+    // Check whether a pointer could be to something on the stack
+    // above this call.
+    bool is_plausible_stack_pointer(const void *stack_pointer) {
         int marker = 0;
         uint64_t marker_addr = (uint64_t)&marker;
         uint64_t top_of_stack;
@@ -578,11 +769,20 @@ public:
             top_of_stack = ((marker_addr >> 30) + 1) << 30;
         }
 
-        if ((uint64_t)stack_pointer > top_of_stack ||
-            (uint64_t)stack_pointer < marker_addr) {
+        return ((uint64_t)stack_pointer <= top_of_stack &&
+                (uint64_t)stack_pointer >= marker_addr);
+    }
+
+    // Get the debug name of a stack variable from a pointer to it
+    std::string get_stack_variable_name(const void *stack_pointer, const std::string &type_name = "") {
+
+        // Check it's a plausible stack pointer
+        if (!is_plausible_stack_pointer(stack_pointer)) {
             return "";
         }
 
+        int marker = 0;
+
         struct frame_info {
             frame_info *frame_pointer;
             void *return_address;
@@ -715,11 +915,6 @@ public:
 
         debug(5) << "Finding source location\n";
 
-        if (!source_lines.size()) {
-            debug(5) << "Bailing out because we have no source lines\n";
-            return "";
-        }
-
         const int max_stack_frames = 256;
 
         // Get the backtrace
@@ -746,7 +941,8 @@ public:
             }
 
             // Binary search into functions
-            FunctionInfo *f = find_containing_function((void *)address);
+            const CompilationUnit *unit = nullptr;
+            FunctionInfo *f = find_containing_function((void *)address, &unit);
 
             // If no debug info for this function, we must still be
             // inside libHalide. Continue searching upwards.
@@ -764,6 +960,12 @@ public:
                 continue;
             }
 
+            const vector<LineInfo> &source_lines = unit->source_lines;
+            if (source_lines.empty()) {
+                debug(5) << "Skipping function because we have no source lines for it\n";
+                continue;
+            }
+
             // Binary search into source_lines
             size_t hi = source_lines.size();
             size_t lo = 0;
@@ -777,7 +979,7 @@ public:
                 }
             }
 
-            const std::string &file = source_files[source_lines[lo].file];
+            const std::string &file = unit->source_files[source_lines[lo].file];
             int line = source_lines[lo].line;
 
             std::ostringstream oss;
@@ -793,76 +995,79 @@ public:
     }
 
     void dump() {
-        // Dump all the types
-        for (size_t i = 0; i < types.size(); i++) {
-            printf("Class %s of size %llu @ %llx: \n",
-                   types[i].name.c_str(),
-                   (unsigned long long)(types[i].size),
-                   (unsigned long long)(types[i].def_loc));
-            for (size_t j = 0; j < types[i].members.size(); j++) {
-                TypeInfo *c = types[i].members[j].type;
-                const char *type_name = "(unknown)";
-                if (c) {
-                    type_name = c->name.c_str();
+        // Only the compilation units parsed so far are dumped.
+        for (const CompilationUnit &unit : units) {
+            if (!unit.loaded) continue;
+            // Dump all the types
+            for (size_t i = 0; i < unit.types.size(); i++) {
+                printf("Class %s of size %llu @ %llx: \n",
+                       unit.types[i].name.c_str(),
+                       (unsigned long long)(unit.types[i].size),
+                       (unsigned long long)(unit.types[i].def_loc));
+                for (size_t j = 0; j < unit.types[i].members.size(); j++) {
+                    TypeInfo *c = unit.types[i].members[j].type;
+                    const char *type_name = "(unknown)";
+                    if (c) {
+                        type_name = c->name.c_str();
+                    }
+                    printf("  Member %s at %d of type %s @ %llx\n",
+                           unit.types[i].members[j].name.c_str(),
+                           unit.types[i].members[j].stack_offset,
+                           type_name,
+                           (long long unsigned)unit.types[i].members[j].type_def_loc);
                 }
-                printf("  Member %s at %d of type %s @ %llx\n",
-                       types[i].members[j].name.c_str(),
-                       types[i].members[j].stack_offset,
-                       type_name,
-                       (long long unsigned)types[i].members[j].type_def_loc);
             }
-        }
 
-        // Dump all the functions and their local variables
-        for (size_t i = 0; i < functions.size(); i++) {
-            const FunctionInfo &f = functions[i];
-            printf("Function %s at %llx - %llx (frame_base %d): \n",
-                   f.name.c_str(),
-                   (unsigned long long)(f.pc_begin),
-                   (unsigned long long)(f.pc_end),
-                   (int)f.frame_base);
-            for (size_t j = 0; j < f.variables.size(); j++) {
-                const LocalVariable &v = f.variables[j];
+            // Dump all the functions and their local variables
+            for (size_t i = 0; i < unit.functions.size(); i++) {
+                const FunctionInfo &f = unit.functions[i];
+                printf("Function %s at %llx - %llx (frame_base %d): \n",
+                       f.name.c_str(),
+                       (unsigned long long)(f.pc_begin),
+                       (unsigned long long)(f.pc_end),
+                       (int)f.frame_base);
+                for (size_t j = 0; j < f.variables.size(); j++) {
+                    const LocalVariable &v = f.variables[j];
+                    TypeInfo *c = v.type;
+                    const char *type_name = "(unknown)";
+                    if (c) {
+                        type_name = c->name.c_str();
+                    }
+                    printf("  Variable %s at %d of type %s @ %llx\n",
+                           v.name.c_str(),
+                           v.stack_offset,
+                           type_name,
+                           (long long unsigned)v.type_def_loc);
+                    for (size_t k = 0; k < v.live_ranges.size(); k++) {
+                        printf("    Live range: %llx - %llx\n",
+                               (unsigned long long)v.live_ranges[k].pc_begin,
+                               (unsigned long long)v.live_ranges[k].pc_end);
+                    }
+                }
+            }
+
+            // Dump the pc -> source file relationship
+            for (size_t i = 0; i < unit.source_lines.size(); i++) {
+                printf("%p -> %s:%d\n",
+                       (void *)(unit.source_lines[i].pc),
+                       unit.source_files[unit.source_lines[i].file].c_str(),
+                       unit.source_lines[i].line);
+            }
+
+            // Dump the global variables
+            for (size_t i = 0; i < unit.global_variables.size(); i++) {
+                const GlobalVariable &v = unit.global_variables[i];
                 TypeInfo *c = v.type;
                 const char *type_name = "(unknown)";
                 if (c) {
                     type_name = c->name.c_str();
                 }
-                printf("  Variable %s at %d of type %s @ %llx\n",
+                printf("  Global variable %s at %llx of type %s\n",
                        v.name.c_str(),
-                       v.stack_offset,
-                       type_name,
-                       (long long unsigned)v.type_def_loc);
-                for (size_t k = 0; k < v.live_ranges.size(); k++) {
-                    printf("    Live range: %llx - %llx\n",
-                           (unsigned long long)v.live_ranges[k].pc_begin,
-                           (unsigned long long)v.live_ranges[k].pc_end);
-                }
-            }
-        }
-
-        // Dump the pc -> source file relationship
-        for (size_t i = 0; i < source_lines.size(); i++) {
-            printf("%p -> %s:%d\n",
-                   (void *)(source_lines[i].pc),
-                   source_files[source_lines[i].file].c_str(),
-                   source_lines[i].line);
-        }
-
-        // Dump the global variables
-        for (size_t i = 0; i < global_variables.size(); i++) {
-            const GlobalVariable &v = global_variables[i];
-            TypeInfo *c = v.type;
-            const char *type_name = "(unknown)";
-            if (c) {
-                type_name = c->name.c_str();
+                       (long long unsigned)v.addr,
+                       type_name);
             }
-            printf("  Global variable %s at %llx of type %s\n",
-                   v.name.c_str(),
-                   (long long unsigned)v.addr,
-                   type_name);
         }
-
     }
 
 private:
@@ -882,7 +1087,8 @@ private:
             return;
         }
 
-        obj = maybe_obj.get().getBinary();
+        object_file = std::move(maybe_obj.get());
+        obj = object_file.getBinary();
 
         #elif LLVM_VERSION >= 36
 
@@ -894,7 +1100,8 @@ private:
             return;
         }
 
-        obj = maybe_obj.get().getBinary();
+        object_file = std::move(maybe_obj.get());
+        obj = object_file.getBinary();
 
         #elif LLVM_VERSION >= 35
 
@@ -906,30 +1113,36 @@ private:
             return;
         }
 
-        obj = maybe_obj.get().get();
+        object_file = std::move(maybe_obj.get());
+        obj = object_file.get();
 
         #else
-        obj = llvm::object::ObjectFile::createObjectFile(binary);
+        object_file.reset(llvm::object::ObjectFile::createObjectFile(binary));
+        obj = object_file.get();
         #endif
 
         if (obj) {
-            working = true;
-            parse_object_file(obj);
-
-            #if LLVM_VERSION < 35
-            // It's not memory-managed in older LLVMs.
-            delete obj;
-            #endif
+            working = find_debug_sections(obj);
+            if (working) {
+                // Only the index of the compilation units is built
+                // up front. The units themselves get parsed when
+                // something in them is looked up.
+                cache_file = get_cache_file(obj);
+                if (cache_file.empty() || !load_cache(cache_file)) {
+                    index_compilation_units();
+                    if (!cache_file.empty()) {
+                        save_cache(cache_file);
+                    }
+                }
+            }
         } else {
             debug(1) << "Could not load object file: " << binary << "\n";
             working = false;
         }
     }
 
-    void parse_object_file(llvm::object::ObjectFile *obj) {
+    bool find_debug_sections(llvm::object::ObjectFile *obj) {
         // Look for the debug_info, debug_abbrev, debug_line, and debug_str sections
-        llvm::StringRef debug_info, debug_abbrev, debug_str, debug_line, debug_ranges;
-
 #ifdef __APPLE__
         std::string prefix = "__";
 #else
@@ -966,28 +1179,186 @@ private:
             debug_line.empty() ||
             debug_ranges.empty()) {
             debug(2) << "Debugging sections not found\n";
-            working = false;
-            return;
+            return false;
         }
 
-        {
-            // Parse the debug_info section to populate the functions and local variables
-            llvm::DataExtractor extractor(debug_info, true, obj->getBytesInAddress());
-            llvm::DataExtractor debug_abbrev_extractor(debug_abbrev, true, obj->getBytesInAddress());
-            parse_debug_info(extractor, debug_abbrev_extractor, debug_str, debug_ranges);
+        address_bytes = obj->getBytesInAddress();
+        return true;
+    }
+
+    // Find the compilation units in .debug_info, and the code and
+    // line table of each. Only the first entry of each unit, which
+    // describes the unit itself, is read.
+    void index_compilation_units() {
+        const unsigned tag_compile_unit = 0x11;
+        const unsigned attr_stmt_list = 0x10;
+        const unsigned attr_low_pc = 0x11;
+        const unsigned attr_high_pc = 0x12;
+        const unsigned attr_ranges = 0x55;
+
+        llvm::DataExtractor e(debug_info, true, address_bytes);
+        uint32_t off = 0;
+        UnitHeader h;
+        while (read_unit_header(e, &off, &h)) {
+            CompilationUnit unit;
+            unit.offset = h.start;
+            uint32_t idx = (uint32_t)units.size();
+
+            parse_debug_abbrev(h.debug_abbrev_offset);
+            uint64_t abbrev_code = e.getULEB128(&off);
+            if (abbrev_code && abbrev_code <= entry_formats.size() &&
+                entry_formats[abbrev_code-1].tag == tag_compile_unit) {
+                const EntryFormat &fmt = entry_formats[abbrev_code-1];
+                uint64_t low_pc = 0, high_pc = 0, ranges = (uint64_t)-1;
+                bool high_pc_is_size = false;
+                for (size_t i = 0; i < fmt.fields.size(); i++) {
+                    uint64_t val;
+                    const uint8_t *payload;
+                    read_attribute(e, h, fmt.fields[i].form, &off, &val, &payload);
+                    unsigned attr = fmt.fields[i].name;
+                    if (attr == attr_low_pc) {
+                        low_pc = val;
+                    } else if (attr == attr_high_pc) {
+                        high_pc = val;
+                        high_pc_is_size = (fmt.fields[i].form != 0x1);
+                    } else if (attr == attr_ranges) {
+                        ranges = val;
+                    } else if (attr == attr_stmt_list) {
+                        unit.line_offset = val;
+                    }
+                }
+
+                if (ranges != (uint64_t)-1) {
+                    parse_debug_ranges(ranges, low_pc, h.address_size, idx);
+                } else if (low_pc && high_pc) {
+                    UnitRange r = {low_pc, high_pc_is_size ? low_pc + high_pc : high_pc, idx};
+                    unit_ranges.push_back(r);
+                }
+            }
+
+            units.push_back(unit);
+            off = h.end;
         }
 
-        {
-            llvm::DataExtractor e(debug_line, true, obj->getBytesInAddress());
-            parse_debug_line(e);
+        std::sort(unit_ranges.begin(), unit_ranges.end());
+        debug(5) << "Indexed " << units.size() << " compilation units\n";
+    }
+
+    // Read a list of address ranges from .debug_ranges covered by a
+    // compilation unit.
+    void parse_debug_ranges(uint32_t off, uint64_t base, uint8_t address_size, uint32_t unit) {
+        llvm::DataExtractor e(debug_ranges, true, address_bytes);
+        const uint64_t max_address = address_size == 4 ? 0xffffffff : (uint64_t)-1;
+        while (e.isValidOffsetForDataOfSize(off, 2 * address_size)) {
+            uint64_t begin = e.getUnsigned(&off, address_size);
+            uint64_t end = e.getUnsigned(&off, address_size);
+            if (!begin && !end) {
+                // End of the list
+                break;
+            } else if (begin == max_address) {
+                // A new base address for the entries that follow
+                base = end;
+            } else if (begin + base && end > begin) {
+                // Ranges at zero belong to code the linker discarded.
+                UnitRange r = {begin + base, end + base, unit};
+                unit_ranges.push_back(r);
+            }
         }
     }
 
-    void parse_debug_ranges(const llvm::DataExtractor &e) {
+    // Find the compilation unit covering an address in the debug
+    // info. Returns -1 if there isn't one.
+    int find_unit(uint64_t pc) {
+        UnitRange key = {pc, pc, 0};
+        vector<UnitRange>::iterator it = std::upper_bound(unit_ranges.begin(), unit_ranges.end(), key);
+        if (it == unit_ranges.begin()) {
+            return -1;
+        }
+        it--;
+        if (pc >= it->pc_end) {
+            return -1;
+        }
+        return (int)it->unit;
+    }
 
+    // Get a compilation unit, parsing it if it hasn't been already.
+    CompilationUnit *load_unit(size_t idx) {
+        CompilationUnit &unit = units[idx];
+        if (!unit.loaded) {
+            debug(5) << "Parsing compilation unit at " << unit.offset << "\n";
+            parse_debug_info(unit.offset);
+            if (unit.line_offset != no_line_table) {
+                parse_debug_line(unit.line_offset);
+            }
+            unit.types.swap(types);
+            unit.functions.swap(functions);
+            unit.global_variables.swap(global_variables);
+            unit.source_files.swap(source_files);
+            unit.source_lines.swap(source_lines);
+            unit.loaded = true;
+            if (calibrated) {
+                relocate(unit, pc_adjust);
+            }
+        }
+        return &unit;
     }
 
-    void parse_debug_abbrev(const llvm::DataExtractor &e, uint32_t off = 0) {
+    // Find the address of every global variable, and the compilation
+    // unit it's in, without parsing anything else about them.
+    void index_global_variables() {
+        if (globals_indexed) {
+            return;
+        }
+        globals_indexed = true;
+
+        const unsigned tag_variable = 0x34;
+        const unsigned attr_location = 0x02;
+
+        llvm::DataExtractor e(debug_info, true, address_bytes);
+        for (size_t u = 0; u < units.size(); u++) {
+            uint32_t off = units[u].offset;
+            UnitHeader h;
+            if (!read_unit_header(e, &off, &h)) {
+                continue;
+            }
+            parse_debug_abbrev(h.debug_abbrev_offset);
+            while (off < h.end) {
+                uint64_t abbrev_code = e.getULEB128(&off);
+                if (abbrev_code == 0) {
+                    continue;
+                }
+                if (abbrev_code > entry_formats.size()) {
+                    break;
+                }
+                const EntryFormat &fmt = entry_formats[abbrev_code-1];
+                for (size_t i = 0; i < fmt.fields.size(); i++) {
+                    uint64_t val;
+                    const uint8_t *payload;
+                    read_attribute(e, h, fmt.fields[i].form, &off, &val, &payload);
+                    // The same test parse_debug_info uses for a global's location
+                    if (fmt.tag == tag_variable &&
+                        fmt.fields[i].name == attr_location &&
+                        payload && payload[0] == 0x03 && val == (sizeof(void *) + 1)) {
+                        const void *addr = *((const void * const *)(payload + 1));
+                        if (addr) {
+                            GlobalStart g = {(uint64_t)addr, (uint32_t)u};
+                            global_starts.push_back(g);
+                        }
+                    }
+                }
+            }
+        }
+
+        std::sort(global_starts.begin(), global_starts.end());
+        debug(5) << "Indexed " << global_starts.size() << " global variables\n";
+
+        if (!cache_file.empty()) {
+            save_cache(cache_file);
+        }
+    }
+
+    void parse_debug_abbrev(uint32_t off) {
+        llvm::DataExtractor e(debug_abbrev, true, address_bytes);
         entry_formats.clear();
         while (1) {
             EntryFormat fmt;
@@ -1014,51 +1385,259 @@ private:
         }
     }
 
-    void parse_debug_info(const llvm::DataExtractor &e,
-                          const llvm::DataExtractor &debug_abbrev,
-                          llvm::StringRef debug_str,
-                          llvm::StringRef debug_ranges) {
-        // Offset into the section
-        uint32_t off = 0;
+    // The header of a compilation unit in .debug_info, which says how
+    // to read the entries that follow it.
+    struct UnitHeader {
+        // Where the header starts, and where the entries start and end.
+        uint64_t start, start_of_entries, end;
+        bool dwarf_64;
+        uint16_t dwarf_version;
+        uint64_t debug_abbrev_offset;
+        uint8_t address_size;
+    };
 
-        llvm::StringRef debug_info = e.getData();
+    // Read the header of the compilation unit at *off, leaving *off
+    // pointing at its first entry. Returns false at the end of the
+    // list, or if the unit doesn't fit in the section.
+    bool read_unit_header(const llvm::DataExtractor &e, uint32_t *off, UnitHeader *h) {
+        h->start = *off;
+        if (!e.isValidOffsetForDataOfSize(*off, 4)) {
+            return false;
+        }
+        uint64_t unit_length = e.getU32(off);
+        if (unit_length == 0xffffffff) {
+            h->dwarf_64 = true;
+            unit_length = e.getU64(off);
+        } else {
+            h->dwarf_64 = false;
+        }
 
-        // A constant to use indicating that we don't know the stack
-        // offset of a variable.
-        const int no_location = 0x80000000;
+        if (!unit_length) {
+            // A zero-length compilation unit indicates the end of
+            // the list.
+            return false;
+        }
 
-        while (1) {
-            uint64_t start_of_unit_header = off;
+        uint64_t start_of_unit = *off;
+        h->end = start_of_unit + unit_length;
+        if (h->end > e.getData().size()) {
+            return false;
+        }
 
-            // Parse compilation unit header
-            bool dwarf_64;
-            uint64_t unit_length = e.getU32(&off);
-            if (unit_length == 0xffffffff) {
-                dwarf_64 = true;
-                unit_length = e.getU64(&off);
+        h->dwarf_version = e.getU16(off);
+        if (h->dwarf_64) {
+            h->debug_abbrev_offset = e.getU64(off);
+        } else {
+            h->debug_abbrev_offset = e.getU32(off);
+        }
+        h->address_size = e.getU8(off);
+        h->start_of_entries = *off;
+        return true;
+    }
+
+    // Read the value of an attribute of the given form at *off, and
+    // advance *off past it.
+    void read_attribute(const llvm::DataExtractor &e, const UnitHeader &h,
+                        uint64_t form, uint32_t *off,
+                        uint64_t *val, const uint8_t **payload) {
+        // A field can either be a constant value:
+        *val = 0;
+        // Or a variable length payload:
+        *payload = nullptr;
+        // If payload is non-null, val indicates the
+        // payload size. If val is zero the payload is a
+        // null-terminated string.
+
+        switch(form) {
+        case 1: // addr (4 or 8 bytes)
+        {
+            if (h.address_size == 4) {
+                *val = e.getU32(off);
             } else {
-                dwarf_64 = false;
+                *val = e.getU64(off);
             }
-
-            if (!unit_length) {
-                // A zero-length compilation unit indicates the end of
-                // the list.
-                break;
+            break;
+        }
+        case 2: // There is no case 2
+        {
+            assert(false && "What's form 2?");
+            break;
+        }
+        case 3: // block2 (2 byte length followed by payload)
+        {
+            *val = e.getU16(off);
+            *payload = (const uint8_t *)(e.getData().data() + *off);
+            *off += *val;
+            break;
+        }
+        case 4: // block4 (4 byte length followed by payload)
+        {
+            *val = e.getU32(off);
+            *payload = (const uint8_t *)(e.getData().data() + *off);
+            *off += *val;
+            break;
+        }
+        case 5: // data2 (2 bytes)
+        {
+            *val = e.getU16(off);
+            break;
+        }
+        case 6: // data4 (4 bytes)
+        {
+            *val = e.getU32(off);
+            break;
+        }
+        case 7: // data8 (8 bytes)
+        {
+            *val = e.getU64(off);
+            break;
+        }
+        case 8: // string (null terminated sequence of bytes)
+        {
+            *val = 0;
+            *payload = (const uint8_t *)(e.getData().data() + *off);
+            while (e.getU8(off));
+            break;
+        }
+        case 9: // block (uleb128 length followed by payload)
+        {
+            *val = e.getULEB128(off);
+            *payload = (const uint8_t *)(e.getData().data() + *off);
+            *off += *val;
+            break;
+        }
+        case 10: // block1 (1 byte length followed by payload)
+        {
+            *val = e.getU8(off);
+            *payload = (const uint8_t *)(e.getData().data() + *off);
+            *off += *val;
+            break;
+        }
+        case 11: // data1 (1 byte)
+        {
+            *val = e.getU8(off);
+            break;
+        }
+        case 12: // flag (1 byte)
+        {
+            *val = e.getU8(off);
+            break;
+        }
+        case 13: // sdata (sleb128 constant)
+        {
+            *val = (uint64_t)e.getSLEB128(off);
+            break;
+        }
+        case 14: // strp (offset into debug_str section. 4 bytes in dwarf 32, 8 in dwarf 64)
+        {
+            uint64_t offset;
+            if (h.dwarf_64) {
+                offset = e.getU64(off);
+            } else {
+                offset = e.getU32(off);
             }
+            *val = 0;
+            *payload = (const uint8_t *)(debug_str.data() + offset);
+            break;
+        }
+        case 15: // udata (uleb128 constant)
+        {
+            *val = e.getULEB128(off);
+            break;
+        }
+        case 16: // ref_addr (offset from beginning of debug_info. 4 bytes in dwarf 32, 8 in dwarf 64)
+        {
+            if ((h.dwarf_version <= 2 && h.address_size == 8) ||
+                (h.dwarf_version > 2 && h.dwarf_64)) {
+                *val = e.getU64(off);
+            } else {
+                *val = e.getU32(off);
+            }
+            break;
+        }
+        case 17: // ref1 (1 byte offset from the first byte of the compilation unit header)
+        {
+            *val = e.getU8(off) + h.start;
+            break;
+        }
+        case 18: // ref2 (2 byte version of the same)
+        {
+            *val = e.getU16(off) + h.start;
+            break;
+        }
+        case 19: // ref4 (4 byte version of the same)
+        {
+            *val = e.getU32(off) + h.start;
+            break;
+        }
+        case 20: // ref8 (8 byte version of the same)
+        {
+            *val = e.getU64(off) + h.start;
+            break;
+        }
+        case 21: // ref_udata (uleb128 version of the same)
+        {
+            *val = e.getULEB128(off) + h.start;
+            break;
+        }
+        case 22: // indirect
+        {
+            assert(false && "Can't handle indirect form");
+            break;
+        }
+        case 23: // sec_offset
+        {
+            if (h.dwarf_64) {
+                *val = e.getU64(off);
+            } else {
+                *val = e.getU32(off);
+            }
+            break;
+        }
+        case 24: // exprloc
+        {
+            // Length
+            *val = e.getULEB128(off);
+            // Payload (contains a DWARF expression to evaluate (ugh))
+            *payload = (const uint8_t *)(e.getData().data() + *off);
+            *off += *val;
+            break;
+        }
+        case 25: // flag_present
+        {
+            *val = 0;
+            // Just the existence of this field is information apparently? There's no data.
+            break;
+        }
+        case 32: // ref_sig8
+        {
+            // 64-bit type signature for a reference in its own type unit
+            *val = e.getU64(off);
+            break;
+        }
+        default:
+            assert(false && "Unknown form");
+            break;
+        }
+    }
 
-            uint64_t start_of_unit = off;
+    // Parse the compilation unit at the given offset in .debug_info to
+    // populate the functions, local and global variables, and types.
+    void parse_debug_info(uint32_t off) {
+        llvm::DataExtractor e(debug_info, true, address_bytes);
 
-            uint16_t dwarf_version = e.getU16(&off);
+        // A constant to use indicating that we don't know the stack
+        // offset of a variable.
+        const int no_location = 0x80000000;
 
-            uint64_t debug_abbrev_offset = 0;
-            if (dwarf_64) {
-                debug_abbrev_offset = e.getU64(&off);
-            } else {
-                debug_abbrev_offset = e.getU32(&off);
+        {
+            // Parse compilation unit header
+            UnitHeader h;
+            if (!read_unit_header(e, &off, &h)) {
+                return;
             }
-            parse_debug_abbrev(debug_abbrev, debug_abbrev_offset);
-
-            uint8_t address_size = e.getU8(&off);
+            parse_debug_abbrev(h.debug_abbrev_offset);
+            uint8_t address_size = h.address_size;
 
             vector<pair<FunctionInfo, int>> func_stack;
             vector<pair<TypeInfo, int>> type_stack;
@@ -1100,254 +1679,78 @@ private:
             const unsigned attr_specification = 0x47;
             const unsigned attr_type = 0x49;
             const unsigned attr_ranges = 0x55;
-
-            while (off - start_of_unit < unit_length) {
-                uint64_t location = off;
-
-                // Grab the next debugging information entry
-                uint64_t abbrev_code = e.getULEB128(&off);
-
-                // A null entry indicates we're popping the stack.
-                if (abbrev_code == 0) {
-                    if (func_stack.size() &&
-                        stack_depth == func_stack.back().second) {
-                        const FunctionInfo &f = func_stack.back().first;
-                        functions.push_back(f);
-                        func_stack.pop_back();
-                    }
-                    if (type_stack.size() &&
-                        stack_depth == type_stack.back().second) {
-                        const TypeInfo &c = type_stack.back().first;
-                        types.push_back(c);
-                        type_stack.pop_back();
-                    }
-                    if (namespace_stack.size() &&
-                        stack_depth == namespace_stack.back().second) {
-                        namespace_stack.pop_back();
-                    }
-                    if (live_range_stack.size() &&
-                        stack_depth == live_range_stack.back().second) {
-                        live_range_stack.pop_back();
-                    }
-                    stack_depth--;
-                    continue;
-                }
-
-                assert(abbrev_code <= entry_formats.size());
-                const EntryFormat &fmt = entry_formats[abbrev_code-1];
-                assert(fmt.code == abbrev_code);
-
-                LocalVariable var;
-                GlobalVariable gvar;
-                FunctionInfo func;
-                TypeInfo type_info;
-                vector<LiveRange> live_ranges;
-                type_info.def_loc = location;
-                func.def_loc = location;
-                var.def_loc = location;
-                gvar.def_loc = location;
-                std::string namespace_name;
-
-                std::string containing_namespace;
-                if (type_stack.size()) {
-                    containing_namespace = type_stack.back().first.name + "::";
-                } else {
-                    for (size_t i = 0; i < namespace_stack.size(); i++) {
-                        containing_namespace += namespace_stack[i].first + "::";
-                    }
-                }
-
-                var.stack_offset = no_location;
-
-                if (fmt.has_children) {
-                    stack_depth++;
-                }
-
-                // Track local vars found for this function
-
-                // Grab the fields
-                for (size_t i = 0; i < fmt.fields.size(); i++) {
-                    unsigned attr = fmt.fields[i].name;
-
-                    // A field can either be a constant value:
-                    uint64_t val = 0;
-                    // Or a variable length payload:
-                    const uint8_t *payload = nullptr;
-                    // If payload is non-null, val indicates the
-                    // payload size. If val is zero the payload is a
-                    // null-terminated string.
-
-                    switch(fmt.fields[i].form) {
-                    case 1: // addr (4 or 8 bytes)
-                    {
-                        if (address_size == 4) {
-                            val = e.getU32(&off);
-                        } else {
-                            val = e.getU64(&off);
-                        }
-                        break;
-                    }
-                    case 2: // There is no case 2
-                    {
-                        assert(false && "What's form 2?");
-                        break;
-                    }
-                    case 3: // block2 (2 byte length followed by payload)
-                    {
-                        val = e.getU16(&off);
-                        payload = (const uint8_t *)(debug_info.data() + off);
-                        off += val;
-                        break;
-                    }
-                    case 4: // block4 (4 byte length followed by payload)
-                    {
-                        val = e.getU32(&off);
-                        payload = (const uint8_t *)(debug_info.data() + off);
-                        off += val;
-                        break;
-                    }
-                    case 5: // data2 (2 bytes)
-                    {
-                        val = e.getU16(&off);
-                        break;
-                    }
-                    case 6: // data4 (4 bytes)
-                    {
-                        val = e.getU32(&off);
-                        break;
-                    }
-                    case 7: // data8 (8 bytes)
-                    {
-                        val = e.getU64(&off);
-                        break;
-                    }
-                    case 8: // string (null terminated sequence of bytes)
-                    {
-                        val = 0;
-                        payload = (const uint8_t *)(debug_info.data() + off);
-                        while (e.getU8(&off));
-                        break;
-                    }
-                    case 9: // block (uleb128 length followed by payload)
-                    {
-                        val = e.getULEB128(&off);
-                        payload = (const uint8_t *)(debug_info.data() + off);
-                        off += val;
-                        break;
-                    }
-                    case 10: // block1 (1 byte length followed by payload)
-                    {
-                        val = e.getU8(&off);
-                        payload = (const uint8_t *)(debug_info.data() + off);
-                        off += val;
-                        break;
-                    }
-                    case 11: // data1 (1 byte)
-                    {
-                        val = e.getU8(&off);
-                        break;
-                    }
-                    case 12: // flag (1 byte)
-                    {
-                        val = e.getU8(&off);
-                        break;
-                    }
-                    case 13: // sdata (sleb128 constant)
-                    {
-                        val = (uint64_t)e.getSLEB128(&off);
-                        break;
-                    }
-                    case 14: // strp (offset into debug_str section. 4 bytes in dwarf 32, 8 in dwarf 64)
-                    {
-                        uint64_t offset;
-                        if (dwarf_64) {
-                            offset = e.getU64(&off);
-                        } else {
-                            offset = e.getU32(&off);
-                        }
-                        val = 0;
-                        payload = (const uint8_t *)(debug_str.data() + offset);
-                        break;
-                    }
-                    case 15: // udata (uleb128 constant)
-                    {
-                        val = e.getULEB128(&off);
-                        break;
-                    }
-                    case 16: // ref_addr (offset from beginning of debug_info. 4 bytes in dwarf 32, 8 in dwarf 64)
-                    {
-                        if ((dwarf_version <= 2 && address_size == 8) ||
-                            (dwarf_version > 2 && dwarf_64)) {
-                            val = e.getU64(&off);
-                        } else {
-                            val = e.getU32(&off);
-                        }
-                        break;
-                    }
-                    case 17: // ref1 (1 byte offset from the first byte of the compilation unit header)
-                    {
-                        val = e.getU8(&off) + start_of_unit_header;
-                        break;
-                    }
-                    case 18: // ref2 (2 byte version of the same)
-                    {
-                        val = e.getU16(&off) + start_of_unit_header;
-                        break;
-                    }
-                    case 19: // ref4 (4 byte version of the same)
-                    {
-                        val = e.getU32(&off) + start_of_unit_header;
-                        break;
-                    }
-                    case 20: // ref8 (8 byte version of the same)
-                    {
-                        val = e.getU64(&off) + start_of_unit_header;
-                        break;
-                    }
-                    case 21: // ref_udata (uleb128 version of the same)
-                    {
-                        val = e.getULEB128(&off) + start_of_unit_header;
-                        break;
-                    }
-                    case 22: // indirect
-                    {
-                        assert(false && "Can't handle indirect form");
-                        break;
-                    }
-                    case 23: // sec_offset
-                    {
-                        if (dwarf_64) {
-                            val = e.getU64(&off);
-                        } else {
-                            val = e.getU32(&off);
-                        }
-                        break;
+
+            while (off < h.end) {
+                uint64_t location = off;
+
+                // Grab the next debugging information entry
+                uint64_t abbrev_code = e.getULEB128(&off);
+
+                // A null entry indicates we're popping the stack.
+                if (abbrev_code == 0) {
+                    if (func_stack.size() &&
+                        stack_depth == func_stack.back().second) {
+                        const FunctionInfo &f = func_stack.back().first;
+                        functions.push_back(f);
+                        func_stack.pop_back();
                     }
-                    case 24: // exprloc
-                    {
-                        // Length
-                        val = e.getULEB128(&off);
-                        // Payload (contains a DWARF expression to evaluate (ugh))
-                        payload = (const uint8_t *)(debug_info.data() + off);
-                        off += val;
-                        break;
+                    if (type_stack.size() &&
+                        stack_depth == type_stack.back().second) {
+                        const TypeInfo &c = type_stack.back().first;
+                        types.push_back(c);
+                        type_stack.pop_back();
                     }
-                    case 25: // flag_present
-                    {
-                        val = 0;
-                        // Just the existence of this field is information apparently? There's no data.
-                        break;
+                    if (namespace_stack.size() &&
+                        stack_depth == namespace_stack.back().second) {
+                        namespace_stack.pop_back();
                     }
-                    case 32: // ref_sig8
-                    {
-                        // 64-bit type signature for a reference in its own type unit
-                        val = e.getU64(&off);
-                        break;
+                    if (live_range_stack.size() &&
+                        stack_depth == live_range_stack.back().second) {
+                        live_range_stack.pop_back();
                     }
-                    default:
-                        assert(false && "Unknown form");
-                        break;
+                    stack_depth--;
+                    continue;
+                }
+
+                assert(abbrev_code <= entry_formats.size());
+                const EntryFormat &fmt = entry_formats[abbrev_code-1];
+                assert(fmt.code == abbrev_code);
+
+                LocalVariable var;
+                GlobalVariable gvar;
+                FunctionInfo func;
+                TypeInfo type_info;
+                vector<LiveRange> live_ranges;
+                type_info.def_loc = location;
+                func.def_loc = location;
+                var.def_loc = location;
+                gvar.def_loc = location;
+                std::string namespace_name;
+
+                std::string containing_namespace;
+                if (type_stack.size()) {
+                    containing_namespace = type_stack.back().first.name + "::";
+                } else {
+                    for (size_t i = 0; i < namespace_stack.size(); i++) {
+                        containing_namespace += namespace_stack[i].first + "::";
                     }
+                }
+
+                var.stack_offset = no_location;
+
+                if (fmt.has_children) {
+                    stack_depth++;
+                }
+
+                // Track local vars found for this function
+
+                // Grab the fields
+                for (size_t i = 0; i < fmt.fields.size(); i++) {
+                    unsigned attr = fmt.fields[i].name;
+
+                    uint64_t val;
+                    const uint8_t *payload;
+                    read_attribute(e, h, fmt.fields[i].form, &off, &val, &payload);
 
                     if (fmt.tag == tag_function) {
                         if (attr == attr_name) {
@@ -1689,32 +2092,7 @@ private:
             }
         }
 
-        // Hook up the type pointers
-        {
-            std::map<uint64_t, TypeInfo *> type_map;
-            for (size_t i = 0; i < types.size(); i++) {
-                type_map[types[i].def_loc] = &types[i];
-            }
-
-            for (size_t i = 0; i < functions.size(); i++) {
-                for (size_t j = 0; j < functions[i].variables.size(); j++) {
-                    functions[i].variables[j].type =
-                        type_map[functions[i].variables[j].type_def_loc];
-                }
-            }
-
-            for (size_t i = 0; i < global_variables.size(); i++) {
-                global_variables[i].type =
-                    type_map[global_variables[i].type_def_loc];
-            }
-
-            for (size_t i = 0; i < types.size(); i++) {
-                for (size_t j = 0; j < types[i].members.size(); j++) {
-                    types[i].members[j].type =
-                        type_map[types[i].members[j].type_def_loc];
-                }
-            }
-        }
+        link_types();
 
         for (size_t i = 0; i < types.size(); i++) {
             // Set the names of the pointer types
@@ -1882,17 +2260,20 @@ private:
         std::sort(global_variables.begin(), global_variables.end());
     }
 
-    void parse_debug_line(const llvm::DataExtractor &e) {
-        uint32_t off = 0;
+    // Parse the line table at the given offset in .debug_line to
+    // populate the source files and lines.
+    void parse_debug_line(uint32_t off) {
+        llvm::DataExtractor e(debug_line, true, address_bytes);
 
-        // For every compilation unit
-        while (1) {
+        {
             // Parse the header
+            if (!e.isValidOffsetForDataOfSize(off, 4)) {
+                return;
+            }
             uint32_t unit_length = e.getU32(&off);
 
-            if (unit_length == 0) {
-                // No more units
-                break;
+            if (unit_length == 0 || off + unit_length > debug_line.size()) {
+                return;
             }
 
             uint32_t unit_end = off + unit_length;
@@ -2137,9 +2518,260 @@ private:
 
 
 
-    FunctionInfo *find_containing_function(void *addr) {
+    // Hook up the type pointers
+    void link_types() {
+        std::map<uint64_t, TypeInfo *> type_map;
+        for (size_t i = 0; i < types.size(); i++) {
+            type_map[types[i].def_loc] = &types[i];
+        }
+
+        for (size_t i = 0; i < functions.size(); i++) {
+            for (size_t j = 0; j < functions[i].variables.size(); j++) {
+                functions[i].variables[j].type =
+                    type_map[functions[i].variables[j].type_def_loc];
+            }
+        }
+
+        for (size_t i = 0; i < global_variables.size(); i++) {
+            global_variables[i].type =
+                type_map[global_variables[i].type_def_loc];
+        }
+
+        for (size_t i = 0; i < types.size(); i++) {
+            for (size_t j = 0; j < types[i].members.size(); j++) {
+                types[i].members[j].type =
+                    type_map[types[i].members[j].type_def_loc];
+            }
+        }
+    }
+
+    // Get the GNU build-id of an ELF object file as a hex string, or
+    // the empty string if it doesn't have one.
+    std::string get_build_id(llvm::object::ObjectFile *obj) {
+        llvm::StringRef note;
+#if LLVM_VERSION > 34
+        for (llvm::object::section_iterator iter = obj->section_begin();
+             iter != obj->section_end(); ++iter) {
+#else
+        llvm::error_code err;
+        for (llvm::object::section_iterator iter = obj->begin_sections();
+             iter != obj->end_sections(); iter.increment(err)) {
+#endif
+            llvm::StringRef name;
+            iter->getName(name);
+            if (name == ".note.gnu.build-id") {
+                iter->getContents(note);
+            }
+        }
+
+        // The note is a 12-byte header (the name size, the
+        // descriptor size, and the type), the name "GNU" padded to 4
+        // bytes, and then the build-id itself.
+        if (note.size() < 16) {
+            return "";
+        }
+        llvm::DataExtractor e(note, obj->isLittleEndian(), obj->getBytesInAddress());
+        uint32_t off = 0;
+        uint32_t name_size = e.getU32(&off);
+        uint32_t desc_size = e.getU32(&off);
+        uint32_t desc_start = 12 + ((name_size + 3) & ~3);
+        if (desc_size == 0 || desc_start + desc_size > note.size()) {
+            return "";
+        }
+
+        std::ostringstream oss;
+        oss << std::hex;
+        for (uint32_t i = 0; i < desc_size; i++) {
+            oss << std::setw(2) << std::setfill('0') << (int)(uint8_t)note[desc_start + i];
+        }
+        return oss.str();
+    }
+
+    // Get the file in which to cache the parsed debug info for an
+    // object file, or the empty string if it can't be cached.
+    std::string get_cache_file(llvm::object::ObjectFile *obj) {
+        std::string build_id = get_build_id(obj);
+        if (build_id.empty()) {
+            return "";
+        }
+
+        std::string dir;
+        if (const char *xdg = getenv("XDG_CACHE_HOME")) {
+            dir = xdg;
+        } else if (const char *home = getenv("HOME")) {
+            dir = std::string(home) + "/.cache";
+        } else {
+            return "";
+        }
+        mkdir(dir.c_str(), 0755);
+        dir += "/halide";
+        mkdir(dir.c_str(), 0755);
+        return dir + "/introspection-" + build_id;
+    }
+
+    // Reads or writes the cache, depending on the mode the file was
+    // opened in. Any failure (including a truncated or corrupt file)
+    // clears ok.
+    class CacheFile {
+        FILE *f;
+        bool reading;
+        uint64_t file_size;
+
+    public:
+        bool ok;
+
+        CacheFile(const std::string &path, bool r) :
+            f(fopen(path.c_str(), r ? "rb" : "wb")), reading(r), file_size(0), ok(f != nullptr) {
+            if (ok && reading) {
+                fseek(f, 0, SEEK_END);
+                file_size = ftell(f);
+                fseek(f, 0, SEEK_SET);
+            }
+        }
+
+        ~CacheFile() {
+            close();
+        }
+
+        bool close() {
+            if (f) {
+                ok = (fclose(f) == 0) && ok;
+                f = nullptr;
+            }
+            return ok;
+        }
+
+        template<typename T>
+        void pod(T &x) {
+            if (!ok) return;
+            ok = reading ? fread(&x, sizeof(x), 1, f) == 1 : fwrite(&x, sizeof(x), 1, f) == 1;
+        }
+
+        // Read or write a count of things that follow, each of which
+        // takes at least min_size bytes in the file. When reading,
+        // check that that many could fit in the rest of the file, so
+        // that a corrupt count can't make us allocate lots of memory.
+        size_t count(size_t n, size_t min_size) {
+            uint64_t c = n;
+            pod(c);
+            if (ok && reading) {
+                long pos = ftell(f);
+                uint64_t remaining = (pos < 0 || (uint64_t)pos > file_size) ? 0 : file_size - pos;
+                if (c > remaining / min_size) {
+                    ok = false;
+                }
+            }
+            return ok ? (size_t)c : 0;
+        }
+
+        void str(std::string &s) {
+            size_t size = count(s.size(), 1);
+            if (!ok || size == 0) return;
+            if (reading) {
+                s.resize(size);
+                ok = fread(&s[0], 1, size, f) == size;
+            } else {
+                ok = fwrite(s.data(), 1, size, f) == size;
+            }
+        }
+
+        template<typename T, typename Fn>
+        void vec(vector<T> &v, size_t min_elem_size, Fn elem) {
+            size_t size = count(v.size(), min_elem_size);
+            if (reading) {
+                v.resize(size);
+            }
+            for (size_t i = 0; ok && i < size; i++) {
+                elem(v[i]);
+            }
+        }
+    };
+
+    // Read or write the index of the compilation units and global
+    // variables. The compilation units themselves are cheap enough
+    // to parse as they are needed.
+    bool serialize(CacheFile &c) {
+        std::string magic = "Halide introspection index 2";
+        std::string m = magic;
+        c.str(m);
+        if (m != magic) {
+            return false;
+        }
+
+        c.vec(units, 2 * sizeof(uint64_t), [&](CompilationUnit &u) {
+                c.pod(u.offset);
+                c.pod(u.line_offset);
+            });
+
+        c.vec(unit_ranges, 2 * sizeof(uint64_t) + sizeof(uint32_t), [&](UnitRange &r) {
+                c.pod(r.pc_begin);
+                c.pod(r.pc_end);
+                c.pod(r.unit);
+            });
+
+        uint8_t indexed = globals_indexed;
+        c.pod(indexed);
+        globals_indexed = (indexed != 0);
+        c.vec(global_starts, sizeof(uint64_t) + sizeof(uint32_t), [&](GlobalStart &g) {
+                c.pod(g.addr);
+                c.pod(g.unit);
+            });
+
+        return c.ok;
+    }
+
+    bool load_cache(const std::string &path) {
+        CacheFile c(path, true);
+        if (!c.ok) {
+            return false;
+        }
+        bool ok = serialize(c);
+        for (size_t i = 0; ok && i < unit_ranges.size(); i++) {
+            ok = unit_ranges[i].unit < units.size();
+        }
+        for (size_t i = 0; ok && i < global_starts.size(); i++) {
+            ok = global_starts[i].unit < units.size();
+        }
+        if (!ok) {
+            debug(1) << "Ignoring bad introspection cache: " << path << "\n";
+            units.clear();
+            unit_ranges.clear();
+            global_starts.clear();
+            globals_indexed = false;
+            return false;
+        }
+        debug(5) << "Loaded debug info index from " << path << "\n";
+        return true;
+    }
+
+    void save_cache(const std::string &path) {
+        // Write to a temporary file and move it into place, so that
+        // concurrent processes never see a partial cache.
+        std::string tmp = path + ".tmp." + std::to_string(getpid());
+        CacheFile c(tmp, false);
+        if (serialize(c) && c.close()) {
+            rename(tmp.c_str(), path.c_str());
+        } else {
+            debug(1) << "Failed to write introspection cache: " << path << "\n";
+            unlink(tmp.c_str());
+        }
+    }
+
+    // Find the function containing an address, parsing the
+    // compilation unit it's in. If unit is non-null it's set to that
+    // compilation unit.
+    FunctionInfo *find_containing_function(void *addr, const CompilationUnit **unit = nullptr) {
         uint64_t address = (uint64_t)addr;
         debug(5) << "Searching for function containing address " << addr << "\n";
+        int u = find_unit(address - pc_adjust);
+        if (u < 0) {
+            return nullptr;
+        }
+        CompilationUnit *containing_unit = load_unit(u);
+        if (unit) {
+            *unit = containing_unit;
+        }
+        vector<FunctionInfo> &functions = containing_unit->functions;
         size_t hi = functions.size();
         size_t lo = 0;
         while (hi > lo) {
@@ -2202,43 +2834,107 @@ private:
     }
 };
 
-namespace {
-DebugSections *debug_sections = nullptr;
-}
+const uint64_t DebugSections::no_line_table;
 
-std::string get_variable_name(const void *var, const std::string &expected_type) {
-    if (!debug_sections) return "";
-    if (!debug_sections->working) return "";
-    std::string name = debug_sections->get_stack_variable_name(var, expected_type);
-    if (name.empty()) {
-        // Maybe it's a member of a heap object.
-        name = debug_sections->get_heap_member_name(var, expected_type);
+void test() {
+    // Round-trip an index through the cache.
+    DebugSections a;
+    a.units.resize(3);
+    for (size_t i = 0; i < a.units.size(); i++) {
+        a.units[i].offset = 100 * i;
+        a.units[i].line_offset = (i == 1) ? DebugSections::no_line_table : 50 * i;
     }
-    if (name.empty()) {
-        // Maybe it's a global
-        name = debug_sections->get_global_variable_name(var, expected_type);
+    a.unit_ranges = {{0x1000, 0x2000, 0}, {0x2000, 0x2800, 2}, {0x3000, 0x3100, 1}};
+    a.globals_indexed = true;
+    a.global_starts = {{0x8000, 1}, {0x8010, 2}, {0x8010, 0}};
+
+    TemporaryFile cache("introspection", ".cache");
+    a.save_cache(cache.pathname());
+
+    DebugSections b;
+    internal_assert(b.load_cache(cache.pathname())) << "Failed to load introspection cache\n";
+    internal_assert(b.units.size() == a.units.size() &&
+                    b.unit_ranges.size() == a.unit_ranges.size() &&
+                    b.global_starts.size() == a.global_starts.size() &&
+                    b.globals_indexed);
+    for (size_t i = 0; i < a.units.size(); i++) {
+        internal_assert(b.units[i].offset == a.units[i].offset &&
+                        b.units[i].line_offset == a.units[i].line_offset &&
+                        !b.units[i].loaded);
+    }
+    for (size_t i = 0; i < a.unit_ranges.size(); i++) {
+        internal_assert(b.unit_ranges[i].pc_begin == a.unit_ranges[i].pc_begin &&
+                        b.unit_ranges[i].pc_end == a.unit_ranges[i].pc_end &&
+                        b.unit_ranges[i].unit == a.unit_ranges[i].unit);
+    }
+    for (size_t i = 0; i < a.global_starts.size(); i++) {
+        internal_assert(b.global_starts[i].addr == a.global_starts[i].addr &&
+                        b.global_starts[i].unit == a.global_starts[i].unit);
+    }
+    internal_assert(b.find_unit(0x1800) == 0 &&
+                    b.find_unit(0x2000) == 2 &&
+                    b.find_unit(0x2900) == -1 &&
+                    b.find_unit(0x30ff) == 1 &&
+                    b.find_unit(0x800) == -1);
+
+    // Read the file back in.
+    vector<char> bytes;
+    {
+        FILE *f = fopen(cache.pathname().c_str(), "rb");
+        internal_assert(f);
+        char buf[256];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+            bytes.insert(bytes.end(), buf, buf + n);
+        }
+        fclose(f);
     }
 
-    return name;
-}
+    auto write_and_load = [&](const vector<char> &contents) {
+        FILE *f = fopen(cache.pathname().c_str(), "wb");
+        internal_assert(f);
+        if (!contents.empty()) {
+            fwrite(&contents[0], 1, contents.size(), f);
+        }
+        fclose(f);
+        DebugSections c;
+        bool loaded = c.load_cache(cache.pathname());
+        // A cache that fails to load leaves nothing behind.
+        internal_assert(loaded || (c.units.empty() &&
+                                   c.unit_ranges.empty() &&
+                                   c.global_starts.empty() &&
+                                   !c.globals_indexed));
+        return loaded;
+    };
 
-std::string get_source_location() {
-    if (!debug_sections) return "";
-    if (!debug_sections->working) return "";
-    return debug_sections->get_source_location();
-}
+    internal_assert(write_and_load(bytes));
 
-void register_heap_object(const void *obj, size_t size, const void *helper) {
-    if (!debug_sections) return;
-    if (!debug_sections->working) return;
-    if (!helper) return;
-    debug_sections->register_heap_object(obj, size, helper);
-}
+    // A truncated cache is ignored.
+    for (size_t size : {(size_t)0, (size_t)4, bytes.size() / 2, bytes.size() - 1}) {
+        internal_assert(!write_and_load(vector<char>(bytes.begin(), bytes.begin() + size)))
+            << "Loaded an introspection cache truncated to " << size << " bytes\n";
+    }
 
-void deregister_heap_object(const void *obj, size_t size) {
-    if (!debug_sections) return;
-    if (!debug_sections->working) return;
-    debug_sections->deregister_heap_object(obj, size);
+    // So is a cache with the wrong magic string.
+    vector<char> corrupt = bytes;
+    corrupt[sizeof(uint64_t)] ^= 1;
+    internal_assert(!write_and_load(corrupt));
+
+    // A corrupt count is caught before anything is allocated for it.
+    // The count of units follows the magic string.
+    size_t units_count_offset = sizeof(uint64_t) + sizeof("Halide introspection index 2") - 1;
+    corrupt = bytes;
+    uint64_t huge_count = 0x00ffffffffffffffULL;
+    memcpy(&corrupt[units_count_offset], &huge_count, sizeof(huge_count));
+    internal_assert(!write_and_load(corrupt));
+
+    // A unit index that's out of range is ignored too. The last byte
+    // of the file is the high byte of the last global's unit.
+    corrupt = bytes;
+    corrupt.back() = 0x7f;
+    internal_assert(!write_and_load(corrupt));
+
+    std::cout << "Introspection test passed\n";
 }
 
 bool saves_frame_pointer(void *fn) {
@@ -2247,40 +2943,45 @@ bool saves_frame_pointer(void *fn) {
     return ptr[0] == 0x55; // push %rbp
 }
 
+namespace {
+DebugSections *debug_sections = nullptr;
 
-void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string &)),
-                           bool (*test_a)(const void *, const std::string &),
-                           void (*calib)()) {
-    #ifdef __ARM__
-    return;
-    #else
+// The compilation units that have asked for introspection, but have
+// not yet been tested.
+struct PendingTest {
+    bool (*test)(bool (*)(const void *, const std::string &));
+    bool (*test_a)(const void *, const std::string &);
+    void (*calib)();
+};
 
-    // Skip entirely on arm or 32-bit
-    if (sizeof(void *) == 4) {
-        return;
-    }
+// These get used during static initialization, so they're constructed
+// on first use.
+vector<PendingTest> &pending_tests() {
+    static vector<PendingTest> tests;
+    return tests;
+}
 
-    debug(5) << "Testing compilation unit with offset_marker at " << reinterpret_bits<void *>(calib) << "\n";
+std::recursive_mutex &loading_lock() {
+    static std::recursive_mutex lock;
+    return lock;
+}
 
-    if (!debug_sections) {
-        char path[2048];
-        get_program_name(path, sizeof(path));
-        debug_sections = new DebugSections(path);
-    }
+void run_test(const PendingTest &t) {
+    debug(5) << "Testing compilation unit with offset_marker at " << reinterpret_bits<void *>(t.calib) << "\n";
 
     if (!saves_frame_pointer(reinterpret_bits<void *>(&test_compilation_unit)) ||
-        !saves_frame_pointer(reinterpret_bits<void *>(test))) {
+        !saves_frame_pointer(reinterpret_bits<void *>(t.test))) {
         // Make sure libHalide and the test compilation unit both save the frame pointer
         debug_sections->working = false;
         debug(5) << "Failed because frame pointer not saved\n";
     } else if (debug_sections->working) {
-        debug_sections->calibrate_pc_offset(calib);
+        debug_sections->calibrate_pc_offset(t.calib);
         if (!debug_sections->working) {
             debug(5) << "Failed because offset calibration failed\n";
             return;
         }
 
-        debug_sections->working = (*test)(test_a);
+        debug_sections->working = (*t.test)(t.test_a);
         if (!debug_sections->working) {
             debug(5) << "Failed because test routine failed\n";
             return;
@@ -2290,6 +2991,111 @@ void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string
     }
 
     //debug_sections->dump();
+}
+
+// Get the debug info, loading it and running any pending tests
+// first. Returns null if introspection isn't working.
+DebugSections *get_debug_sections() {
+    std::lock_guard<std::recursive_mutex> lock(loading_lock());
+
+    // This is checked the first time something is introspected, rather
+    // than at static initialization, so that programs can set it too.
+    static bool disabled = [] {
+        size_t defined = 0;
+        std::string disable = get_env_variable("HL_DISABLE_INTROSPECTION", defined);
+        return defined && disable != "0";
+    }();
+    if (disabled) {
+        return nullptr;
+    }
+
+    if (!pending_tests().empty()) {
+        if (!debug_sections) {
+            char path[2048];
+            get_program_name(path, sizeof(path));
+            debug_sections = new DebugSections(path);
+        }
+
+        // The tests call back in here, so take them off the list
+        // before running them.
+        vector<PendingTest> tests;
+        tests.swap(pending_tests());
+        for (const PendingTest &t : tests) {
+            run_test(t);
+        }
+    }
+
+    if (debug_sections && debug_sections->working) {
+        return debug_sections;
+    } else {
+        return nullptr;
+    }
+}
+}
+
+// The units of debug info are parsed lazily, and the heap objects
+// change, so each lookup holds the loading lock throughout.
+
+std::string get_variable_name(const void *var, const std::string &expected_type) {
+    std::lock_guard<std::recursive_mutex> lock(loading_lock());
+    DebugSections *sections = get_debug_sections();
+    if (!sections) return "";
+    std::string name = sections->get_stack_variable_name(var, expected_type);
+    if (name.empty()) {
+        // Maybe it's a member of a heap object.
+        name = sections->get_heap_member_name(var, expected_type);
+    }
+    if (name.empty() && !sections->is_plausible_stack_pointer(var)) {
+        // Maybe it's a global. Looking for globals means finding all
+        // of them in the debug info, so don't bother for unnamed
+        // things on the stack.
+        name = sections->get_global_variable_name(var, expected_type);
+    }
+
+    return name;
+}
+
+std::string get_source_location() {
+    std::lock_guard<std::recursive_mutex> lock(loading_lock());
+    DebugSections *sections = get_debug_sections();
+    if (!sections) return "";
+    return sections->get_source_location();
+}
+
+void register_heap_object(const void *obj, size_t size, const void *helper) {
+    if (!helper) return;
+    std::lock_guard<std::recursive_mutex> lock(loading_lock());
+    DebugSections *sections = get_debug_sections();
+    if (!sections) return;
+    sections->register_heap_object(obj, size, helper);
+}
+
+void deregister_heap_object(const void *obj, size_t size) {
+    // Nothing can have been registered if the debug info was never
+    // loaded, so don't load it just to find that out.
+    std::lock_guard<std::recursive_mutex> lock(loading_lock());
+    if (!debug_sections || !debug_sections->working) return;
+    debug_sections->deregister_heap_object(obj, size);
+}
+
+void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string &)),
+                           bool (*test_a)(const void *, const std::string &),
+                           void (*calib)()) {
+    #ifdef __ARM__
+    return;
+    #else
+
+    // Skip entirely on arm or 32-bit
+    if (sizeof(void *) == 4) {
+        return;
+    }
+
+    // This runs during static initialization of every compilation
+    // unit that includes Halide.h, so just note the test down. The
+    // debug info gets loaded and the tests run the first time
+    // something is introspected.
+    std::lock_guard<std::recursive_mutex> lock(loading_lock());
+    pending_tests().push_back({test, test_a, calib});
 
     #endif
 }
@@ -2323,6 +3129,9 @@ void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string
                            void (*calib)()) {
 }
 
+void test() {
+}
+
 }
 }
 }
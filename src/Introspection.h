@@ -12,6 +12,13 @@
  * Defines methods for introspecting in C++. Relies on DWARF debugging
  * metadata, so the compilation unit that uses this must be compiled
  * with -g.
+ *
+ * The debug info is loaded the first time something is
+ * introspected. Only an index of the compilation units is built up
+ * front; each unit is parsed the first time something in it is looked
+ * up. The index is cached in ~/.cache/halide (or
+ * $XDG_CACHE_HOME/halide), keyed by the build-id of the
+ * binary. Setting HL_DISABLE_INTROSPECTION=1 turns it off entirely.
  */
 
 namespace Halide {
@@ -48,10 +55,14 @@ EXPORT std::string get_source_location();
 
 // This gets called automatically by anyone who includes Halide.h by
 // the code below. It tests if this functionality works for the given
-// compilation unit, and disables it if not.
+// compilation unit, and disables it if not. The test is deferred
+// until the debug info is first needed.
 EXPORT void test_compilation_unit(bool (*test)(bool (*)(const void *, const std::string &)),
                                   bool (*test_a)(const void *, const std::string &),
                                   void (*calib)());
+
+/** Test the on-disk cache of the debug info index. */
+EXPORT void test();
 }
 
 }
@@ -10,6 +10,7 @@
 #include "AllocationBoundsInference.h"
 #include "Bounds.h"
 #include "BoundsInference.h"
+#include "CombineChecks.h"
 #include "CSE.h"
 #include "Debug.h"
 #include "DebugToFile.h"
@@ -20,6 +21,7 @@
 #include "Function.h"
 #include "FuseGPUThreadLoops.h"
 #include "HexagonOffload.h"
+#include "HoistLoopInvariantDivision.h"
 #include "InjectHostDevBufferCopies.h"
 #include "InjectImageIntrinsics.h"
 #include "InjectOpenGLIntrinsics.h"
@@ -29,6 +31,7 @@
 #include "IRPrinter.h"
 #include "LoopCarry.h"
 #include "Memoization.h"
+#include "MemoryPlanning.h"
 #include "PartitionLoops.h"
 #include "Profiling.h"
 #include "Qualify.h"
@@ -40,6 +43,7 @@
 #include "SelectGPUAPI.h"
 #include "SkipStages.h"
 #include "SlidingWindow.h"
+#include "SpecializeDenseStrides.h"
 #include "Simplify.h"
 #include "SimplifySpecializations.h"
 #include "StorageFlattening.h"
@@ -63,7 +67,15 @@ using std::string;
 using std::vector;
 using std::map;
 
-Stmt lower(vector<Function> outputs, const string &pipeline_name, const Target &t, const vector<IRMutator *> &custom_passes) {
+Stmt lower(vector<Function> outputs, const string &pipeline_name, const Target &t, const vector<IRMutator *> &custom_passes,
+           vector<std::pair<string, Stmt>> *pass_log) {
+
+    auto log_pass = [&](const string &pass, Stmt result) {
+        debug(2) << "Lowering after " << pass << ":\n" << result << "\n\n";
+        if (pass_log) {
+            pass_log->push_back({pass, result});
+        }
+    };
 
     // Compute an environment
     map<string, Function> env;
@@ -89,95 +101,110 @@ Stmt lower(vector<Function> outputs, const string &pipeline_name, const Target &
 
     debug(1) << "Creating initial loop nests...\n";
     Stmt s = schedule_functions(outputs, order, env, t, any_memoized);
-    debug(2) << "Lowering after creating initial loop nests:\n" << s << '\n';
+    log_pass("creating initial loop nests", s);
 
     if (any_memoized) {
         debug(1) << "Injecting memoization...\n";
         s = inject_memoization(s, env, pipeline_name, outputs);
-        debug(2) << "Lowering after injecting memoization:\n" << s << '\n';
+        log_pass("injecting memoization", s);
     } else {
         debug(1) << "Skipping injecting memoization...\n";
     }
 
     debug(1) << "Injecting tracing...\n";
     s = inject_tracing(s, pipeline_name, env, outputs);
-    debug(2) << "Lowering after injecting tracing:\n" << s << '\n';
+    log_pass("injecting tracing", s);
 
     debug(1) << "Adding checks for parameters\n";
     s = add_parameter_checks(s, t);
-    debug(2) << "Lowering after injecting parameter checks:\n" << s << '\n';
+    log_pass("injecting parameter checks", s);
 
     // Compute the maximum and minimum possible value of each
     // function. Used in later bounds inference passes.
     debug(1) << "Computing bounds of each function's value\n";
     FuncValueBounds func_bounds = compute_function_value_bounds(order, env);
 
+    // The passes below ask for the bounds of the same expressions
+    // over the same scopes many times over, both directly and via
+    // boxes_required and friends: add_image_checks, bounds_inference,
+    // sliding_window, allocation_bounds_inference, storage_folding,
+    // and the simplifier. While bounds_cache is alive, those queries
+    // are memoized, including the ones that use func_bounds, and the
+    // results are shared between the passes.
+    BoundsCache bounds_cache(func_bounds);
+
     // The checks will be in terms of the symbols defined by bounds
     // inference.
     debug(1) << "Adding checks for images\n";
     s = add_image_checks(s, outputs, t, order, env, func_bounds);
-    debug(2) << "Lowering after injecting image checks:\n" << s << '\n';
+    log_pass("injecting image checks", s);
 
     // This pass injects nested definitions of variable names, so we
     // can't simplify statements from here until we fix them up. (We
     // can still simplify Exprs).
     debug(1) << "Performing computation bounds inference...\n";
     s = bounds_inference(s, outputs, order, env, func_bounds);
-    debug(2) << "Lowering after computation bounds inference:\n" << s << '\n';
+    log_pass("computation bounds inference", s);
 
     debug(1) << "Performing sliding window optimization...\n";
     s = sliding_window(s, env);
-    debug(2) << "Lowering after sliding window:\n" << s << '\n';
+    log_pass("sliding window", s);
 
     debug(1) << "Performing allocation bounds inference...\n";
     s = allocation_bounds_inference(s, env, func_bounds);
-    debug(2) << "Lowering after allocation bounds inference:\n" << s << '\n';
+    log_pass("allocation bounds inference", s);
 
     debug(1) << "Removing code that depends on undef values...\n";
     s = remove_undef(s);
-    debug(2) << "Lowering after removing code that depends on undef values:\n" << s << "\n\n";
+    log_pass("removing code that depends on undef values", s);
 
     // This uniquifies the variable names, so we're good to simplify
     // after this point. This lets later passes assume syntactic
     // equivalence means semantic equivalence.
     debug(1) << "Uniquifying variable names...\n";
     s = uniquify_variable_names(s);
-    debug(2) << "Lowering after uniquifying variable names:\n" << s << "\n\n";
+    log_pass("uniquifying variable names", s);
 
     debug(1) << "Performing storage folding optimization...\n";
     s = storage_folding(s, env);
-    debug(2) << "Lowering after storage folding:\n" << s << '\n';
+    log_pass("storage folding", s);
 
     debug(1) << "Injecting debug_to_file calls...\n";
     s = debug_to_file(s, outputs, env);
-    debug(2) << "Lowering after injecting debug_to_file calls:\n" << s << '\n';
+    log_pass("injecting debug_to_file calls", s);
 
     debug(1) << "Simplifying...\n"; // without removing dead lets, because storage flattening needs the strides
     s = simplify(s, false);
-    debug(2) << "Lowering after first simplification:\n" << s << "\n\n";
+    log_pass("first simplification", s);
 
     debug(1) << "Dynamically skipping stages...\n";
     s = skip_stages(s, order);
-    debug(2) << "Lowering after dynamically skipping stages:\n" << s << "\n\n";
+    log_pass("dynamically skipping stages", s);
 
     if (t.has_feature(Target::OpenGL) || t.has_feature(Target::Renderscript)) {
         debug(1) << "Injecting image intrinsics...\n";
         s = inject_image_intrinsics(s, env);
-        debug(2) << "Lowering after image intrinsics:\n" << s << "\n\n";
+        log_pass("image intrinsics", s);
     }
 
     debug(1) << "Performing storage flattening...\n";
     s = storage_flattening(s, outputs, env, t);
-    debug(2) << "Lowering after storage flattening:\n" << s << "\n\n";
+    log_pass("storage flattening", s);
 
     if (any_memoized) {
         debug(1) << "Rewriting memoized allocations...\n";
         s = rewrite_memoized_allocations(s, env);
-        debug(2) << "Lowering after rewriting memoized allocations:\n" << s << "\n\n";
+        log_pass("rewriting memoized allocations", s);
     } else {
         debug(1) << "Skipping rewriting memoized allocations...\n";
     }
 
+    if (t.has_feature(Target::DenseStrides)) {
+        debug(1) << "Specializing on dense strides...\n";
+        s = specialize_dense_strides(s);
+        log_pass("specializing on dense strides", s);
+    }
+
     if (t.has_gpu_feature() ||
         t.has_feature(Target::OpenGLCompute) ||
         t.has_feature(Target::OpenGL) ||
@@ -185,17 +212,17 @@ Stmt lower(vector<Function> outputs, const string &pipeline_name, const Target &
         (t.arch != Target::Hexagon && (t.features_any_of({Target::HVX_64, Target::HVX_128})))) {
         debug(1) << "Selecting a GPU API for GPU loops...\n";
         s = select_gpu_api(s, t);
-        debug(2) << "Lowering after selecting a GPU API:\n" << s << "\n\n";
+        log_pass("selecting a GPU API", s);
 
         debug(1) << "Injecting host <-> dev buffer copies...\n";
         s = inject_host_dev_buffer_copies(s, t);
-        debug(2) << "Lowering after injecting host <-> dev buffer copies:\n" << s << "\n\n";
+        log_pass("injecting host <-> dev buffer copies", s);
     }
 
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Injecting OpenGL texture intrinsics...\n";
         s = inject_opengl_intrinsics(s);
-        debug(2) << "Lowering after OpenGL intrinsics:\n" << s << "\n\n";
+        log_pass("OpenGL intrinsics", s);
     }
 
     if (t.has_gpu_feature() ||
@@ -203,47 +230,57 @@ Stmt lower(vector<Function> outputs, const string &pipeline_name, const Target &
         t.has_feature(Target::Renderscript)) {
         debug(1) << "Injecting per-block gpu synchronization...\n";
         s = fuse_gpu_thread_loops(s);
-        debug(2) << "Lowering after injecting per-block gpu synchronization:\n" << s << "\n\n";
+        log_pass("injecting per-block gpu synchronization", s);
     }
 
     debug(1) << "Simplifying...\n";
     s = simplify(s);
     s = unify_duplicate_lets(s);
     s = remove_trivial_for_loops(s);
-    debug(2) << "Lowering after second simplifcation:\n" << s << "\n\n";
+    log_pass("second simplifcation", s);
 
     debug(1) << "Unrolling...\n";
     s = unroll_loops(s);
     s = simplify(s);
-    debug(2) << "Lowering after unrolling:\n" << s << "\n\n";
+    log_pass("unrolling", s);
 
     debug(1) << "Vectorizing...\n";
     s = vectorize_loops(s);
     s = simplify(s);
-    debug(2) << "Lowering after vectorizing:\n" << s << "\n\n";
+    log_pass("vectorizing", s);
 
     debug(1) << "Detecting vector interleavings...\n";
     s = rewrite_interleavings(s);
     s = simplify(s);
-    debug(2) << "Lowering after rewriting vector interleavings:\n" << s << "\n\n";
+    log_pass("rewriting vector interleavings", s);
 
     debug(1) << "Partitioning loops to simplify boundary conditions...\n";
     s = partition_loops(s);
     s = simplify(s);
-    debug(2) << "Lowering after partitioning loops:\n" << s << "\n\n";
+    log_pass("partitioning loops", s);
 
     debug(1) << "Trimming loops to the region over which they do something...\n";
     s = trim_no_ops(s);
-    debug(2) << "Lowering after loop trimming:\n" << s << "\n\n";
+    log_pass("loop trimming", s);
+
+    debug(1) << "Hoisting magic numbers for loop-invariant division...\n";
+    s = hoist_loop_invariant_division(s);
+    log_pass("hoisting loop-invariant division", s);
 
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
-    debug(2) << "Lowering after injecting early frees:\n" << s << "\n\n";
+    log_pass("injecting early frees", s);
+
+    if (t.has_feature(Target::PlanMemory)) {
+        debug(1) << "Planning memory...\n";
+        s = plan_memory(s, t);
+        log_pass("planning memory", s);
+    }
 
     if (t.has_feature(Target::Profile)) {
         debug(1) << "Injecting profiling...\n";
         s = inject_profiling(s, pipeline_name);
-        debug(2) << "Lowering after injecting profiling:\n" << s << '\n';
+        log_pass("injecting profiling", s);
     }
 
     debug(1) << "Simplifying...\n";
@@ -252,27 +289,39 @@ Stmt lower(vector<Function> outputs, const string &pipeline_name, const Target &
     if (t.has_feature(Target::OpenGL)) {
         debug(1) << "Detecting varying attributes...\n";
         s = find_linear_expressions(s);
-        debug(2) << "Lowering after detecting varying attributes:\n" << s << "\n\n";
+        log_pass("detecting varying attributes", s);
 
         debug(1) << "Moving varying attribute expressions out of the shader...\n";
         s = setup_gpu_vertex_buffer(s);
-        debug(2) << "Lowering after removing varying attributes:\n" << s << "\n\n";
+        log_pass("removing varying attributes", s);
+    }
+
+    if (t.has_feature(Target::CombineChecks)) {
+        debug(1) << "Combining validation checks...\n";
+        s = combine_checks(s);
+        log_pass("combining validation checks", s);
     }
 
     s = remove_dead_allocations(s);
     s = remove_trivial_for_loops(s);
     s = simplify(s);
     debug(1) << "Lowering after final simplification:\n" << s << "\n\n";
+    if (pass_log) {
+        pass_log->push_back({"final simplification", s});
+    }
 
     debug(1) << "Splitting off Hexagon offload...\n";
     s = inject_hexagon_rpc(s, t);
-    debug(2) << "Lowering after splitting off Hexagon offload:\n" << s << '\n';
+    log_pass("splitting off Hexagon offload", s);
 
     if (!custom_passes.empty()) {
         for (size_t i = 0; i < custom_passes.size(); i++) {
             debug(1) << "Running custom lowering pass " << i << "...\n";
             s = custom_passes[i]->mutate(s);
             debug(1) << "Lowering after custom pass " << i << ":\n" << s << "\n\n";
+            if (pass_log) {
+                pass_log->push_back({"custom pass " + std::to_string(i), s});
+            }
         }
     }
 
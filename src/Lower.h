@@ -17,9 +17,12 @@ class IRMutator;
 
 /** Given a halide function with a schedule, create a statement that
  * evaluates it. Automatically pulls in all the functions f depends
- * on. Some stages of lowering may be target-specific. */
+ * on. Some stages of lowering may be target-specific. If pass_log is
+ * non-null, the name of each lowering pass and the Stmt after it are
+ * appended to it. */
 EXPORT Stmt lower(std::vector<Function> outputs, const std::string &pipeline_name, const Target &t,
-                  const std::vector<IRMutator *> &custom_passes = std::vector<IRMutator *>());
+                  const std::vector<IRMutator *> &custom_passes = std::vector<IRMutator *>(),
+                  std::vector<std::pair<std::string, Stmt>> *pass_log = nullptr);
 
 void lower_test();
 
@@ -0,0 +1,287 @@
+#include <map>
+
+#include "MemoryPlanning.h"
+#include "CodeGen_Internal.h"
+#include "Debug.h"
+#include "ExprUsesVar.h"
+#include "IRMutator.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Simplify.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Check that an expression can be evaluated at the top of a group of
+// allocations, before the buffers in it are produced: it must not
+// read memory or call into the runtime.
+class CanHoist : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Call *op) {
+        if (!op->is_pure()) {
+            result = false;
+        } else {
+            IRVisitor::visit(op);
+        }
+    }
+
+    void visit(const Load *op) {
+        result = false;
+    }
+
+public:
+    bool result = true;
+};
+
+bool can_hoist(Expr e) {
+    CanHoist check;
+    e.accept(&check);
+    return check.result;
+}
+
+// Rewrite an expression in terms of the variables in scope at the top
+// of the group, by substituting in the lets defined within it. The
+// result is undefined if one of those lets can't be hoisted.
+class LiftLets : public IRMutator {
+    const Scope<Expr> &lets;
+
+    using IRMutator::visit;
+
+    void visit(const Variable *op) {
+        if (lets.contains(op->name)) {
+            Expr value = lets.get(op->name);
+            if (value.defined()) {
+                expr = mutate(value);
+            } else {
+                failed = true;
+                expr = op;
+            }
+        } else {
+            expr = op;
+        }
+    }
+
+public:
+    bool failed = false;
+    LiftLets(const Scope<Expr> &l) : lets(l) {}
+};
+
+struct Lifetime {
+    // The size in bytes, in terms of the variables in scope at the
+    // top of the group.
+    Expr size;
+    // The times of the allocation and of the free.
+    int start, end;
+};
+
+// Find the lifetimes of the heap allocations nested inside an
+// allocation, in execution order. Allocations inside loops (and
+// inside the loops' bodies) are left alone.
+class FindLifetimes : public IRVisitor {
+    Scope<Expr> lets;
+    int time = 0;
+
+    using IRVisitor::visit;
+
+    void visit(const For *op) {
+        time++;
+    }
+
+    void visit(const LetStmt *op) {
+        lets.push(op->name, can_hoist(op->value) ? op->value : Expr());
+        op->body.accept(this);
+        lets.pop(op->name);
+    }
+
+    // Get the size of an allocation that should go in the arena, or
+    // an undefined Expr if it should be left alone.
+    Expr arena_size(const Allocate *op) {
+        if (op->new_expr.defined() || !op->free_function.empty() || op->extents.empty()) {
+            return Expr();
+        }
+
+        // Small constant-sized allocations go on the stack.
+        int32_t constant_size = Allocate::constant_allocation_size(op->extents, op->name);
+        if (constant_size > 0 && can_allocation_fit_on_stack(constant_size * op->type.bytes())) {
+            return Expr();
+        }
+
+        // Buffers that get wrapped in a buffer_t (for extern stages,
+        // or device copies) manage their own host memory.
+        if (stmt_uses_var(op->body, op->name + ".buffer")) {
+            return Expr();
+        }
+
+        // Include the padding that codegen adds for loads past the
+        // end, and round up to keep every slot aligned.
+        Expr size = make_const(Int(64), op->type.bytes());
+        for (Expr e : op->extents) {
+            size *= cast<int64_t>(e);
+        }
+        size += op->type.bytes();
+        size = ((size + 63) / 64) * 64;
+        size = select(op->condition, size, make_zero(Int(64)));
+
+        LiftLets lift(lets);
+        size = lift.mutate(size);
+        if (lift.failed) {
+            return Expr();
+        }
+        return simplify(size);
+    }
+
+    void visit(const Allocate *op) {
+        time++;
+        Expr size = arena_size(op);
+        if (size.defined()) {
+            lifetimes[op->name] = {size, time, -1};
+            order.push_back(op->name);
+        }
+        op->body.accept(this);
+
+        // If there was no early free, it lives until the end of the
+        // Allocate node.
+        time++;
+        end_lifetime(op->name);
+    }
+
+    void visit(const Free *op) {
+        time++;
+        end_lifetime(op->name);
+    }
+
+    void end_lifetime(const string &name) {
+        auto it = lifetimes.find(name);
+        if (it != lifetimes.end() && it->second.end < 0) {
+            it->second.end = time;
+        }
+    }
+
+public:
+    map<string, Lifetime> lifetimes;
+    // The allocations in the order they start.
+    vector<string> order;
+};
+
+// Point the allocations at their offsets within the arena.
+class PlaceInArena : public IRMutator {
+    const string &arena;
+    const map<string, Expr> &offsets;
+
+    using IRMutator::visit;
+
+    void visit(const Allocate *op) {
+        auto it = offsets.find(op->name);
+        if (it == offsets.end()) {
+            IRMutator::visit(op);
+            return;
+        }
+        Expr ptr = Call::make(Handle(), Call::address_of,
+                              {Load::make(UInt(8), arena, it->second, Buffer(), Parameter())},
+                              Call::Intrinsic);
+        stmt = Allocate::make(op->name, op->type, op->extents, op->condition, mutate(op->body),
+                              ptr, "halide_device_host_nop_free");
+    }
+
+public:
+    PlaceInArena(const string &a, const map<string, Expr> &o) : arena(a), offsets(o) {}
+};
+
+class PlanMemory : public IRMutator {
+    const Target &target;
+
+    using IRMutator::visit;
+
+    void visit(const For *op) {
+        stmt = op;
+    }
+
+    void visit(const Allocate *op) {
+        FindLifetimes lifetimes;
+        Stmt(op).accept(&lifetimes);
+        if (lifetimes.order.size() < 2) {
+            IRMutator::visit(op);
+            return;
+        }
+
+        // Assign the allocations to slots in order of their
+        // allocation times, reusing a slot if its last occupant has
+        // been freed. This uses the minimum number of slots, which is
+        // the maximum number of allocations live at once.
+        vector<Expr> slot_size;
+        vector<int> slot_free_at;
+        map<string, int> slot_of;
+        for (const string &name : lifetimes.order) {
+            const Lifetime &l = lifetimes.lifetimes[name];
+            size_t slot = 0;
+            while (slot < slot_size.size() && slot_free_at[slot] > l.start) {
+                slot++;
+            }
+            if (slot == slot_size.size()) {
+                slot_size.push_back(l.size);
+                slot_free_at.push_back(l.end);
+            } else {
+                slot_size[slot] = max(slot_size[slot], l.size);
+                slot_free_at[slot] = l.end;
+            }
+            slot_of[name] = (int)slot;
+            debug(3) << "Placing " << name << " in slot " << slot << " of the arena\n";
+        }
+
+        string arena = unique_name("memory_arena");
+        vector<Expr> offset_vars;
+        vector<std::pair<string, Expr>> lets;
+        Expr total = make_zero(Int(64));
+        for (size_t i = 0; i < slot_size.size(); i++) {
+            string offset_name = arena + ".offset." + std::to_string(i);
+            lets.push_back({offset_name, cast<int32_t>(total)});
+            offset_vars.push_back(Variable::make(Int(32), offset_name));
+            string size_name = arena + ".size." + std::to_string(i);
+            lets.push_back({size_name, simplify(slot_size[i])});
+            total += Variable::make(Int(64), size_name);
+        }
+
+        map<string, Expr> offsets;
+        for (const auto &p : slot_of) {
+            offsets[p.first] = offset_vars[p.second];
+        }
+        Stmt body = PlaceInArena(arena, offsets).mutate(op);
+        body = Block::make(body, Free::make(arena));
+        body = Allocate::make(arena, UInt(8), {cast<int32_t>(total)}, const_true(), body);
+
+        // The individual allocations were checked for overflow, but
+        // the sum of them might not fit.
+        Expr max_size = make_const(Int(64), target.maximum_buffer_size());
+        Expr error = Call::make(Int(32), "halide_error_buffer_allocation_too_large",
+                                {arena, total, max_size}, Call::Extern);
+        body = Block::make(AssertStmt::make(total <= max_size, error), body);
+
+        for (size_t i = lets.size(); i > 0; i--) {
+            body = LetStmt::make(lets[i-1].first, lets[i-1].second, body);
+        }
+        stmt = body;
+    }
+
+public:
+    PlanMemory(const Target &t) : target(t) {}
+};
+
+}
+
+Stmt plan_memory(Stmt s, const Target &t) {
+    // Offsets into the arena are 32-bit.
+    if (t.has_feature(Target::LargeBuffers)) {
+        return s;
+    }
+    return PlanMemory(t).mutate(s);
+}
+
+}
+}
@@ -5,6 +5,7 @@
 
 #include "CodeGen_C.h"
 #include "CodeGen_Internal.h"
+#include "CostReport.h"
 #include "Debug.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
@@ -46,6 +47,7 @@ Outputs add_suffixes(const Outputs &in, const std::string &suffix) {
     if (!in.c_source_name.empty()) out.c_source_name = add_suffix(in.c_source_name, suffix);
     if (!in.stmt_name.empty()) out.stmt_name = add_suffix(in.stmt_name, suffix);
     if (!in.stmt_html_name.empty()) out.stmt_html_name = add_suffix(in.stmt_html_name, suffix);
+    if (!in.cost_report_name.empty()) out.cost_report_name = add_suffix(in.cost_report_name, suffix);
     return out;
 }
 
@@ -212,6 +214,10 @@ void Module::compile(const Outputs &output_files) const {
         debug(1) << "Module.compile(): stmt_html_name " << output_files.stmt_html_name << "\n";
         Internal::print_to_html(output_files.stmt_html_name, *this);
     }
+    if (!output_files.cost_report_name.empty()) {
+        debug(1) << "Module.compile(): cost_report_name " << output_files.cost_report_name << "\n";
+        Internal::print_cost_report(output_files.cost_report_name, *this);
+    }
 }
 
 Outputs compile_standalone_runtime(const Outputs &output_files, Target t) {
@@ -45,11 +45,13 @@ public:
     void visit(const Load *);
     void visit(const Ramp *);
     void visit(const Broadcast *);
+    void visit(const VectorReduce *);
     void visit(const Call *);
     void visit(const Let *);
     void visit(const LetStmt *);
     void visit(const AssertStmt *);
     void visit(const ProducerConsumer *);
+    void visit(const Atomic *);
     void visit(const For *);
     void visit(const Store *);
     void visit(const Provide *);
@@ -368,6 +370,12 @@ void ComputeModulusRemainder::visit(const Broadcast *) {
     internal_assert(false) << "modulus_remainder of vector\n";
 }
 
+void ComputeModulusRemainder::visit(const VectorReduce *op) {
+    internal_assert(op->type.is_scalar()) << "modulus_remainder of vector\n";
+    modulus = 1;
+    remainder = 0;
+}
+
 void ComputeModulusRemainder::visit(const Call *) {
     modulus = 1;
     remainder = 0;
@@ -400,6 +408,10 @@ void ComputeModulusRemainder::visit(const ProducerConsumer *) {
     internal_assert(false) << "modulus_remainder of statement\n";
 }
 
+void ComputeModulusRemainder::visit(const Atomic *) {
+    internal_assert(false) << "modulus_remainder of statement\n";
+}
+
 void ComputeModulusRemainder::visit(const For *) {
     internal_assert(false) << "modulus_remainder of statement\n";
 }
@@ -286,6 +286,10 @@ class MonotonicVisitor : public IRVisitor {
         internal_error << "Monotonic of vector\n";
     }
 
+    void visit(const VectorReduce *op) {
+        internal_error << "Monotonic of vector\n";
+    }
+
     void visit(const Call *op) {
         // Some functions are known to be monotonic
         if (op->is_intrinsic(Call::likely) ||
@@ -331,6 +335,10 @@ class MonotonicVisitor : public IRVisitor {
         internal_error << "Monotonic of statement\n";
     }
 
+    void visit(const Atomic *op) {
+        internal_error << "Monotonic of statement\n";
+    }
+
     void visit(const For *op) {
         internal_error << "Monotonic of statement\n";
     }
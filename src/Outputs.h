@@ -50,6 +50,10 @@ struct Outputs {
      * output is desired. */
     std::string static_library_name;
 
+    /** The name of the emitted cost report. Empty if no cost report
+     * output is desired. */
+    std::string cost_report_name;
+
     /** Make a new Outputs struct that emits everything this one does
      * and also an object file with the given name. */
     Outputs object(const std::string &object_name) {
@@ -121,6 +125,14 @@ struct Outputs {
         updated.static_library_name = static_library_name;
         return updated;
     }
+
+    /** Make a new Outputs struct that emits everything this one does
+     * and also a cost report with the given name. */
+    Outputs cost_report(const std::string &cost_report_name) {
+        Outputs updated = *this;
+        updated.cost_report_name = cost_report_name;
+        return updated;
+    }
 };
 
 }
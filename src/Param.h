@@ -152,6 +152,11 @@ public:
         param.set_default(value);
     }
 
+    /** Get at the internal parameter object representing this Param. */
+    const Internal::Parameter &parameter() const {
+        return param;
+    }
+
     /** You can use this parameter as an expression in a halide
      * function definition */
     operator Expr() const {
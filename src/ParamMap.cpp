@@ -0,0 +1,48 @@
+#include "ParamMap.h"
+
+namespace Halide {
+
+using Internal::Parameter;
+
+Parameter &ParamMap::replacement_for(const Parameter &p) {
+    user_assert(p.defined()) << "Can't set an undefined Param in a ParamMap\n";
+    for (Mapping &m : mappings) {
+        if (m.original.same_as(p)) {
+            return m.replacement;
+        }
+    }
+    // The replacement only holds a value, so it stays out of the
+    // ObjectInstanceRegistry.
+    Mapping m = {p, Parameter(p.type(), p.is_buffer(), p.dimensions(), p.name(),
+                              p.is_explicit_name(), /*register_instance*/ false)};
+    mappings.push_back(m);
+    return mappings.back().replacement;
+}
+
+void ParamMap::set(const ImageParam &p, Buffer b) {
+    user_assert(p.defined()) << "Can't set an undefined ImageParam in a ParamMap\n";
+    if (b.defined()) {
+        user_assert(b.type() == p.type())
+            << "Can't bind ImageParam " << p.name()
+            << " of type " << p.type()
+            << " to Buffer " << b.name()
+            << " of type " << b.type() << "\n";
+    }
+    replacement_for(p.parameter()).set_buffer(b);
+}
+
+const Parameter &ParamMap::map(const Parameter &p) const {
+    for (const Mapping &m : mappings) {
+        if (m.original.same_as(p)) {
+            return m.replacement;
+        }
+    }
+    return p;
+}
+
+const ParamMap &ParamMap::empty_map() {
+    static ParamMap empty;
+    return empty;
+}
+
+}
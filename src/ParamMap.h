@@ -0,0 +1,72 @@
+#ifndef HALIDE_PARAM_MAP_H
+#define HALIDE_PARAM_MAP_H
+
+/** \file
+ * Defines a collection of parameter values to pass to a single call
+ * of a jit-compiled pipeline.
+ */
+
+#include <vector>
+
+#include "ImageParam.h"
+#include "Param.h"
+
+namespace Halide {
+
+/** A set of values for the Params and ImageParams of a pipeline, to
+ * use for one call to Pipeline::realize instead of the values set on
+ * the Params themselves. Params and ImageParams not in the map use
+ * their own values as usual.
+ *
+ * Param::set and ImageParam::set change state shared by every user of
+ * the Param, so two threads can't run the same pipeline with
+ * different inputs that way. Give each thread its own ParamMap
+ * instead:
+ \code
+ ParamMap params;
+ params.set(gain, 2.0f);
+ params.set(input, my_input_image);
+ pipeline.realize(my_output_image, params);
+ \endcode
+ */
+class ParamMap {
+    struct Mapping {
+        Internal::Parameter original, replacement;
+    };
+    std::vector<Mapping> mappings;
+
+    /** Find or make the replacement for a Parameter. */
+    EXPORT Internal::Parameter &replacement_for(const Internal::Parameter &p);
+
+public:
+    ParamMap() {}
+
+    /** Set the value to use for a Param. */
+    template<typename T>
+    void set(const Param<T> &p, T val) {
+        Internal::Parameter &r = replacement_for(p.parameter());
+        r.set_scalar<T>(val);
+    }
+
+    /** Set the buffer to use for an ImageParam. */
+    EXPORT void set(const ImageParam &p, Buffer b);
+
+    /** Get the Parameter holding the value to use for p: either the
+     * one set in this map, or p itself. The address of the scalar
+     * value of the result is stable for the lifetime of the map (or
+     * of p), and is only read, so many threads may call a pipeline
+     * with the same map at once. */
+    EXPORT const Internal::Parameter &map(const Internal::Parameter &p) const;
+
+    /** The number of Params and ImageParams set in this map. */
+    size_t size() const {
+        return mappings.size();
+    }
+
+    /** A map that sets nothing. */
+    EXPORT static const ParamMap &empty_map();
+};
+
+}
+
+#endif
@@ -1,14 +1,18 @@
 #include <algorithm>
+#include <mutex>
 
 #include "Pipeline.h"
 #include "Argument.h"
+#include "CostReport.h"
 #include "Func.h"
 #include "IRVisitor.h"
 #include "LLVM_Headers.h"
 #include "LLVM_Output.h"
 #include "Lower.h"
 #include "Outputs.h"
+#include "ParamMap.h"
 #include "PrintLoopNest.h"
+#include "StmtToHtml.h"
 
 using namespace Halide::Internal;
 
@@ -73,6 +77,11 @@ struct PipelineContents {
     JITModule jit_module;
     Target jit_target;
 
+    // Held while checking for and making the cached jit-compiled
+    // code, so that threads realizing the same Pipeline at once
+    // compile it only once.
+    std::mutex jit_mutex;
+
     /** Clear all cached state */
     void invalidate_cache() {
         module = Module("", Target());
@@ -251,6 +260,26 @@ void Pipeline::compile_to_lowered_stmt(const string &filename,
     m.compile(outputs);
 }
 
+void Pipeline::compile_to_cost_report(const string &filename,
+                                      const vector<Argument> &args,
+                                      const std::map<string, Expr> &estimates,
+                                      const Target &target) {
+    Module m = compile_to_module(args, "", target);
+    print_cost_report(output_name(filename, m, ".cost"), m, estimates);
+}
+
+void Pipeline::compile_to_profiled_html(const string &filename,
+                                        const vector<Argument> &args,
+                                        const string &profile,
+                                        const Target &target) {
+    // Record the Stmt after each lowering pass as the Module is
+    // compiled.
+    vector<std::pair<string, Stmt>> passes;
+    Module m = build_module(args, "", target, LoweredFunc::External, &passes);
+
+    print_to_html(output_name(filename, m, ".html"), m, parse_profiler_report(profile), passes);
+}
+
 void Pipeline::compile_to_static_library(const string &filename_prefix,
                                          const vector<Argument> &args,
                                          const Target &target) {
@@ -533,6 +562,14 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
                                    const string &fn_name,
                                    const Target &target,
                                    const Internal::LoweredFunc::LinkageType linkage_type) {
+    return build_module(args, fn_name, target, linkage_type, nullptr);
+}
+
+Module Pipeline::build_module(const vector<Argument> &args,
+                              const string &fn_name,
+                              const Target &target,
+                              const Internal::LoweredFunc::LinkageType linkage_type,
+                              vector<std::pair<string, Stmt>> *pass_log) {
     user_assert(defined()) << "Can't compile undefined Pipeline\n";
     string new_fn_name(fn_name);
     if (new_fn_name.empty()) {
@@ -555,7 +592,8 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
     Stmt private_body;
 
     const Module &old_module = contents->module;
-    if (!old_module.functions().empty() &&
+    if (!pass_log &&
+        !old_module.functions().empty() &&
         old_module.target() == target) {
         internal_assert(old_module.functions().size() == 2);
         // We can avoid relowering and just reuse the private body
@@ -569,7 +607,7 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
             custom_passes.push_back(p.pass);
         }
 
-        private_body = lower(contents->outputs, fn_name, target, custom_passes);
+        private_body = lower(contents->outputs, fn_name, target, custom_passes, pass_log);
     }
 
     std::vector<std::string> namespaces;
@@ -578,6 +616,11 @@ Module Pipeline::compile_to_module(const vector<Argument> &args,
 
     // Get all the arguments/global images referenced in this function.
     vector<Argument> public_args = build_public_args(args, target);
+    for (const Argument &arg : public_args) {
+        user_assert(!arg.is_buffer() || arg.dimensions <= HALIDE_BUFFER_MAX_DIMENSIONS)
+            << "Buffer argument " << arg.name << " has " << (int)arg.dimensions
+            << " dimensions. At most " << HALIDE_BUFFER_MAX_DIMENSIONS << " are supported.\n";
+    }
 
     vector<Buffer> global_images = validate_arguments(public_args, private_body);
 
@@ -641,6 +684,8 @@ void *Pipeline::compile_jit(const Target &target_arg) {
 
     debug(2) << "jit-compiling for: " << target_arg.to_string() << "\n";
 
+    std::lock_guard<std::mutex> lock(contents->jit_mutex);
+
     // If we're re-jitting for the same target, we can just keep the
     // old jit module.
     if (contents->jit_target == target &&
@@ -764,6 +809,10 @@ void Pipeline::realize(Buffer b, const Target &target) {
     realize(Realization({b}), target);
 }
 
+void Pipeline::realize(Buffer b, const ParamMap &params, const Target &target) {
+    realize(Realization({b}), params, target);
+}
+
 Realization Pipeline::realize(vector<int32_t> sizes,
                               const Target &target) {
     user_assert(defined()) << "Pipeline is undefined\n";
@@ -854,10 +903,12 @@ struct ErrorBuffer {
 struct JITFuncCallContext {
     ErrorBuffer error_buffer;
     JITUserContext jit_context;
-    Parameter &user_context_param;
+    Parameter *user_context_param;
     bool custom_error_handler;
 
-    JITFuncCallContext(const JITHandlers &handlers, Parameter &user_context_param)
+    // If user_context_param is null, the caller passes &jit_context
+    // to the jitted function itself.
+    JITFuncCallContext(const JITHandlers &handlers, Parameter *user_context_param)
         : user_context_param(user_context_param) {
         void *user_context = nullptr;
         JITHandlers local_handlers = handlers;
@@ -869,7 +920,9 @@ struct JITFuncCallContext {
             custom_error_handler = true;
         }
         JITSharedRuntime::init_jit_user_context(jit_context, user_context, local_handlers);
-        user_context_param.set_scalar(&jit_context);
+        if (user_context_param) {
+            user_context_param->set_scalar(&jit_context);
+        }
 
         debug(2) << "custom_print: " << (void *)jit_context.handlers.custom_print << '\n'
                  << "custom_malloc: " << (void *)jit_context.handlers.custom_malloc << '\n'
@@ -896,30 +949,22 @@ struct JITFuncCallContext {
 
     void finalize(int exit_status) {
         report_if_error(exit_status);
-        user_context_param.set_scalar((void *)nullptr); // Don't leave param hanging with pointer to stack.
+        if (user_context_param) {
+            user_context_param->set_scalar((void *)nullptr); // Don't leave param hanging with pointer to stack.
+        }
     }
 };
 
-}  // namespace
-
-// Make a vector of void *'s to pass to the jit call using the
-// currently bound value for all of the params and image
-// params. Unbound image params produce null values.
-vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const Target &target) {
-    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
-
-    compile_jit(target);
-
-    JITModule &compiled_module = contents->jit_module;
-    internal_assert(compiled_module.argv_function());
-
+// Check that dst has the right number, types, and dimensionalities
+// of buffers to hold the outputs of a pipeline.
+void validate_output_buffers(const vector<Function> &outputs, const Realization &dst) {
     struct OutputBufferType {
         Function func;
         Type type;
         int dims;
     };
     vector<OutputBufferType> output_buffer_types;
-    for (Function f : contents->outputs) {
+    for (Function f : outputs) {
         for (Type t : f.output_types()) {
             OutputBufferType obt = {f, t, f.dimensions()};
             output_buffer_types.push_back(obt);
@@ -951,16 +996,33 @@ vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const
             << ", but Func \"" << func.name()
             << "\" has type " << type << ".\n";
     }
+}
+
+}  // namespace
+
+// Make a vector of void *'s to pass to the jit call using the value
+// in params, or else the currently bound value, for all of the params
+// and image params. Unbound image params produce null values.
+vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const Target &target,
+                                                          const ParamMap &params) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+
+    compile_jit(target);
+
+    JITModule &compiled_module = contents->jit_module;
+    internal_assert(compiled_module.argv_function());
+
+    validate_output_buffers(contents->outputs, dst);
 
     // Come up with the void * arguments to pass to the argv function
     const vector<InferredArgument> &input_args = contents->inferred_args;
     vector<const void *> arg_values;
 
     // First the inputs
-    for (InferredArgument arg : input_args) {
+    for (const InferredArgument &arg : input_args) {
         if (arg.param.defined() && arg.param.is_buffer()) {
             // ImageParam arg
-            Buffer buf = arg.param.get_buffer();
+            Buffer buf = params.map(arg.param).get_buffer();
             if (buf.defined()) {
                 arg_values.push_back(buf.raw_buffer());
             } else {
@@ -969,7 +1031,7 @@ vector<const void *> Pipeline::prepare_jit_call_arguments(Realization dst, const
             }
             debug(1) << "JIT input ImageParam argument ";
         } else if (arg.param.defined()) {
-            arg_values.push_back(arg.param.get_scalar_address());
+            arg_values.push_back(params.map(arg.param).get_scalar_address());
             debug(1) << "JIT input scalar argument ";
         } else {
             debug(1) << "JIT input Image argument ";
@@ -1041,14 +1103,11 @@ Pipeline::make_externs_jit_module(const Target &target,
     return result;
 }
 
-void Pipeline::realize(Realization dst, const Target &t) {
+Target Pipeline::jit_target_for(const Target &t) const {
     Target target = t;
-    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
-
-    debug(2) << "Realizing Pipeline for " << target.to_string() << "\n";
-
     // If target is unspecified...
     if (target.os == Target::OSUnknown) {
+        std::lock_guard<std::mutex> lock(contents->jit_mutex);
         // If we've already jit-compiled for a specific target, use that.
         if (contents->jit_module.compiled()) {
             target = contents->jit_target;
@@ -1057,18 +1116,35 @@ void Pipeline::realize(Realization dst, const Target &t) {
             target = get_jit_target_from_environment();
         }
     }
+    return target;
+}
+
+void Pipeline::realize(Realization dst, const Target &t) {
+    realize(dst, ParamMap::empty_map(), t);
+}
+
+void Pipeline::realize(Realization dst, const ParamMap &params, const Target &t) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+    debug(2) << "Realizing Pipeline for " << t.to_string() << "\n";
 
+    Target target = jit_target_for(t);
+
+    vector<const void *> args = prepare_jit_call_arguments(dst, target, params);
+
+    size_t user_context_index = args.size();
     for (size_t i = 0; i < contents->inferred_args.size(); i++) {
         const InferredArgument &arg = contents->inferred_args[i];
         const void *arg_value = args[i];
-        if (arg.param.defined()) {
+        if (arg.param.same_as(contents->user_context_arg.param)) {
+            user_context_index = i;
+        } else if (arg.param.defined()) {
             user_assert(arg_value != nullptr)
                 << "Can't realize a pipeline because ImageParam "
                 << arg.param.name() << " is not bound to a Buffer\n";
         }
     }
+    internal_assert(user_context_index < args.size());
 
     // We need to make a context for calling the jitted function to
     // carry the the set of custom handlers. Here's how handlers get
@@ -1090,9 +1166,13 @@ void Pipeline::realize(Realization dst, const Target &t) {
     // Those global handlers use the user_context passed in to call
     // the right handler for this particular pipeline run. The
     // user_context is just a pointer to a JITUserContext, which is a
-    // member of the JITFuncCallContext which we will declare now:
+    // member of the JITFuncCallContext which we will declare now. It
+    // is passed by pointer in args rather than through the
+    // user_context Parameter, so that concurrent calls don't share it:
 
-    JITFuncCallContext jit_context(jit_handlers(), contents->user_context_arg.param);
+    JITFuncCallContext jit_context(contents->jit_handlers, nullptr);
+    void *user_context = &jit_context.jit_context;
+    args[user_context_index] = &user_context;
 
     // The handlers in the jit_context default to the default handlers
     // in the runtime of the shared module (e.g. halide_print_impl,
@@ -1142,7 +1222,7 @@ void Pipeline::realize(Realization dst, const Target &t) {
         JITModule::Symbol reset_sym =
             contents->jit_module.find_symbol_by_name("halide_profiler_reset");
         if (report_sym.address && reset_sym.address) {
-            void *uc = jit_context.user_context_param.get_scalar<void *>();
+            void *uc = &jit_context.jit_context;
             void (*report_fn_ptr)(void *) = (void (*)(void *))(report_sym.address);
             report_fn_ptr(uc);
 
@@ -1154,17 +1234,160 @@ void Pipeline::realize(Realization dst, const Target &t) {
     jit_context.finalize(exit_status);
 }
 
-void Pipeline::infer_input_bounds(Realization dst) {
+struct PreparedRealizationContents {
+    mutable RefCount ref_count;
 
-    Target target = get_jit_target_from_environment();
+    // The compiled code, and the arguments it was compiled for. These
+    // also keep the Params, ImageParams and embedded Buffers alive.
+    JITModule jit_module;
+    vector<InferredArgument> inputs;
+    JITHandlers handlers;
+
+    // The argv array, as packed by prepare_jit_call_arguments.
+    vector<const void *> args;
+
+    // The indices in args of the ImageParams, which are looked up on
+    // each run, and of the user context, which is made on each run.
+    vector<size_t> image_param_indices;
+    size_t user_context_index;
+
+    // The default outputs, and what is required of any others.
+    vector<Function> output_funcs;
+    vector<Buffer> outputs;
+};
+
+namespace Internal {
+template<>
+EXPORT RefCount &ref_count<PreparedRealizationContents>(const PreparedRealizationContents *p) {
+    return p->ref_count;
+}
+
+template<>
+EXPORT void destroy<PreparedRealizationContents>(const PreparedRealizationContents *p) {
+    delete p;
+}
+}
+
+PreparedRealization Pipeline::prepare_realize(Buffer dst, const Target &target) {
+    return prepare_realize(Realization({dst}), target);
+}
+
+PreparedRealization Pipeline::prepare_realize(Realization dst, const Target &t) {
+    user_assert(defined()) << "Can't prepare an undefined Pipeline\n";
+
+    Target target = jit_target_for(t);
+    vector<const void *> args = prepare_jit_call_arguments(dst, target, ParamMap::empty_map());
+
+    IntrusivePtr<PreparedRealizationContents> c = new PreparedRealizationContents;
+    c->jit_module = contents->jit_module;
+    c->inputs = contents->inferred_args;
+    c->handlers = contents->jit_handlers;
+    c->args = args;
+    c->user_context_index = args.size();
+    for (size_t i = 0; i < c->inputs.size(); i++) {
+        const Parameter &param = c->inputs[i].param;
+        if (param.same_as(contents->user_context_arg.param)) {
+            c->user_context_index = i;
+        } else if (param.defined() && param.is_buffer()) {
+            c->image_param_indices.push_back(i);
+        }
+    }
+    internal_assert(c->user_context_index < args.size());
+    c->output_funcs = contents->outputs;
+    c->outputs = dst.as_vector();
+
+    return PreparedRealization(c);
+}
+
+PreparedRealization::PreparedRealization() {}
+
+PreparedRealization::PreparedRealization(IntrusivePtr<PreparedRealizationContents> c) : contents(c) {}
+
+bool PreparedRealization::defined() const {
+    return contents.defined();
+}
+
+namespace {
+
+void run_prepared(const PreparedRealizationContents &c, const vector<Buffer> &dst) {
+    // Patch a copy of the packed arguments, so that several threads
+    // can run at once. Small pipelines fit on the stack.
+    const size_t num_args = c.args.size();
+    const void *stack_args[32];
+    vector<const void *> heap_args;
+    const void **args = stack_args;
+    if (num_args > sizeof(stack_args) / sizeof(stack_args[0])) {
+        heap_args.resize(num_args);
+        args = &heap_args[0];
+    }
+    memcpy(args, &c.args[0], num_args * sizeof(const void *));
+
+    for (size_t i : c.image_param_indices) {
+        const Parameter &param = c.inputs[i].param;
+        Buffer buf = param.get_buffer();
+        user_assert(buf.defined())
+            << "Can't run a prepared realization because ImageParam "
+            << param.name() << " is not bound to a Buffer\n";
+        args[i] = buf.raw_buffer();
+    }
+
+    const size_t first_output = num_args - dst.size();
+    for (size_t i = 0; i < dst.size(); i++) {
+        args[first_output + i] = dst[i].raw_buffer();
+    }
+
+    JITFuncCallContext jit_context(c.handlers, nullptr);
+    void *user_context = &jit_context.jit_context;
+    args[c.user_context_index] = &user_context;
+
+    int exit_status = c.jit_module.argv_function()(args);
+    jit_context.finalize(exit_status);
+}
+
+}  // namespace
 
-    vector<const void *> args = prepare_jit_call_arguments(dst, target);
+void PreparedRealization::run() {
+    user_assert(defined()) << "Can't run an undefined PreparedRealization\n";
+    run_prepared(*contents, contents->outputs);
+}
+
+void PreparedRealization::run(Buffer dst) {
+    run(Realization({dst}));
+}
+
+void PreparedRealization::run(Realization dst) {
+    user_assert(defined()) << "Can't run an undefined PreparedRealization\n";
+    const PreparedRealizationContents &c = *contents;
+    const vector<Buffer> &bufs = dst.as_vector();
+
+    // Only do the full check (and build the error message) if the
+    // outputs don't match the ones we were prepared with.
+    bool matches = bufs.size() == c.outputs.size();
+    for (size_t i = 0; matches && i < bufs.size(); i++) {
+        matches = (bufs[i].defined() &&
+                   bufs[i].type() == c.outputs[i].type() &&
+                   bufs[i].dimensions() == c.outputs[i].dimensions());
+    }
+    if (!matches) {
+        for (const Buffer &buf : bufs) {
+            user_assert(buf.defined()) << "Can't realize into an undefined Buffer\n";
+        }
+        validate_output_buffers(c.output_funcs, dst);
+    }
+
+    run_prepared(c, bufs);
+}
+
+std::map<size_t, Buffer> Pipeline::query_input_bounds(Realization dst, const Target &target) {
+    vector<const void *> args = prepare_jit_call_arguments(dst, target, ParamMap::empty_map());
 
     struct TrackedBuffer {
-        // The query buffer.
-        buffer_t query;
+        // The query buffer, and its dimensions beyond the fourth.
+        halide_nd_buffer_t query;
+        vector<halide_dimension_t> query_dims;
         // A backup copy of it to test if it changed.
         buffer_t orig;
+        vector<halide_dimension_t> orig_dims;
     };
     vector<TrackedBuffer> tracked_buffers(args.size());
 
@@ -1172,25 +1395,36 @@ void Pipeline::infer_input_bounds(Realization dst) {
     for (size_t i = 0; i < args.size(); i++) {
         if (args[i] == nullptr) {
             query_indices.push_back(i);
-            memset(&tracked_buffers[i], 0, sizeof(TrackedBuffer));
-            args[i] = &tracked_buffers[i].query;
+            TrackedBuffer &tb = tracked_buffers[i];
+            memset(&tb.query, 0, sizeof(tb.query));
+            memset(&tb.orig, 0, sizeof(tb.orig));
+            int dims = contents->inferred_args[i].param.dimensions();
+            if (dims > 4) {
+                tb.query_dims.resize(dims - 4, halide_dimension_t());
+                tb.query.buf.extra_dimensions = (uint8_t)(dims - 4);
+                tb.query.extra_dim = &tb.query_dims[0];
+            }
+            args[i] = &tb.query.buf;
         }
     }
 
+    std::map<size_t, Buffer> result;
+
     // No need to query if all the inputs are bound already.
     if (query_indices.empty()) {
         debug(1) << "All inputs are bound. No need for bounds inference\n";
-        return;
+        return result;
     }
 
-    JITFuncCallContext jit_context(jit_handlers(), contents->user_context_arg.param);
+    JITFuncCallContext jit_context(jit_handlers(), &contents->user_context_arg.param);
 
     int iter = 0;
     const int max_iters = 16;
     for (iter = 0; iter < max_iters; iter++) {
         // Make a copy of the buffers that might be mutated
         for (TrackedBuffer &tb : tracked_buffers) {
-            tb.orig = tb.query;
+            tb.orig = tb.query.buf;
+            tb.orig_dims = tb.query_dims;
         }
 
         Internal::debug(2) << "Calling jitted function\n";
@@ -1201,9 +1435,15 @@ void Pipeline::infer_input_bounds(Realization dst) {
 
         // Check if there were any changed
         for (TrackedBuffer &tb : tracked_buffers) {
-            if (memcmp(&tb.query, &tb.orig, sizeof(buffer_t))) {
+            if (memcmp(&tb.query.buf, &tb.orig, sizeof(buffer_t))) {
                 changed = true;
             }
+            for (size_t d = 0; d < tb.query_dims.size(); d++) {
+                const halide_dimension_t &a = tb.query_dims[d], &b = tb.orig_dims[d];
+                if (a.min != b.min || a.extent != b.extent || a.stride != b.stride) {
+                    changed = true;
+                }
+            }
         }
         if (!changed) {
             break;
@@ -1219,11 +1459,24 @@ void Pipeline::infer_input_bounds(Realization dst) {
 
     debug(1) << "Bounds inference converged after " << iter << " iterations\n";
 
-    // Now allocate the resulting buffers
     for (size_t i : query_indices) {
-        InferredArgument ia = contents->inferred_args[i];
+        result[i] = Buffer(contents->inferred_args[i].param.type(), &tracked_buffers[i].query.buf);
+    }
+    return result;
+}
+
+void Pipeline::infer_input_bounds(Realization dst) {
+
+    Target target = get_jit_target_from_environment();
+
+    std::map<size_t, Buffer> query = query_input_bounds(dst, target);
+
+    // Now allocate the resulting buffers
+    for (const auto &q : query) {
+        InferredArgument ia = contents->inferred_args[q.first];
         internal_assert(!ia.param.get_buffer().defined());
-        buffer_t buf = tracked_buffers[i].query;
+        const Buffer &inferred = q.second;
+        const buffer_t &buf = *inferred.raw_buffer();
 
         Internal::debug(1) << "Inferred bounds for " << ia.param.name() << ": ("
                            << buf.min[0] << ","
@@ -1237,23 +1490,27 @@ void Pipeline::infer_input_bounds(Realization dst) {
 
         // Figure out how much memory to allocate for this buffer
         size_t min_idx = 0, max_idx = 0;
-        for (int d = 0; d < 4; d++) {
-            if (buf.stride[d] > 0) {
-                min_idx += buf.min[d] * buf.stride[d];
-                max_idx += (buf.min[d] + buf.extent[d] - 1) * buf.stride[d];
+        int dims = std::max(4, inferred.dimensions());
+        for (int d = 0; d < dims; d++) {
+            halide_dimension_t dim = halide_buffer_dim(&buf, d);
+            if (dim.stride > 0) {
+                min_idx += dim.min * dim.stride;
+                max_idx += (dim.min + dim.extent - 1) * dim.stride;
             } else {
-                max_idx += buf.min[d] * buf.stride[d];
-                min_idx += (buf.min[d] + buf.extent[d] - 1) * buf.stride[d];
+                max_idx += dim.min * dim.stride;
+                min_idx += (dim.min + dim.extent - 1) * dim.stride;
             }
         }
         size_t total_size = (max_idx - min_idx);
         while (total_size & 0x1f) total_size++;
 
         // Allocate enough memory with the right dimensionality.
-        Buffer buffer(ia.param.type(), total_size,
-                      buf.extent[1] > 0 ? 1 : 0,
-                      buf.extent[2] > 0 ? 1 : 0,
-                      buf.extent[3] > 0 ? 1 : 0);
+        vector<int32_t> sizes(dims, 0);
+        sizes[0] = (int32_t)total_size;
+        for (int d = 1; d < dims; d++) {
+            sizes[d] = halide_buffer_dim(&buf, d).extent > 0 ? 1 : 0;
+        }
+        Buffer buffer(ia.param.type(), sizes);
 
         // Rewrite the buffer fields to match the ones returned
         for (int d = 0; d < 4; d++) {
@@ -1261,6 +1518,9 @@ void Pipeline::infer_input_bounds(Realization dst) {
             buffer.raw_buffer()->stride[d] = buf.stride[d];
             buffer.raw_buffer()->extent[d] = buf.extent[d];
         }
+        for (int d = 4; d < dims; d++) {
+            ((halide_nd_buffer_t *)buffer.raw_buffer())->extra_dim[d - 4] = halide_buffer_dim(&buf, d);
+        }
         ia.param.set_buffer(buffer);
     }
 }
@@ -1281,6 +1541,228 @@ void Pipeline::infer_input_bounds(Buffer dst) {
     infer_input_bounds(Realization({dst}));
 }
 
+namespace {
+
+// A box in up to four dimensions.
+struct Region {
+    int dims;
+    int min[4], extent[4];
+};
+
+Region region_of(const buffer_t &b, int dims) {
+    Region r;
+    r.dims = dims;
+    for (int d = 0; d < 4; d++) {
+        r.min[d] = d < dims ? b.min[d] : 0;
+        r.extent[d] = d < dims ? b.extent[d] : 0;
+    }
+    return r;
+}
+
+// Returns false if the regions don't intersect.
+bool intersect(const Region &a, const Region &b, Region &result) {
+    result = a;
+    for (int d = 0; d < a.dims; d++) {
+        int lo = std::max(a.min[d], b.min[d]);
+        int hi = std::min(a.min[d] + a.extent[d], b.min[d] + b.extent[d]);
+        if (hi <= lo) {
+            return false;
+        }
+        result.min[d] = lo;
+        result.extent[d] = hi - lo;
+    }
+    return true;
+}
+
+// Cut the part of a region outside of a region it contains into
+// disjoint boxes.
+vector<Region> subtract(Region a, const Region &b) {
+    vector<Region> result;
+    for (int d = 0; d < a.dims; d++) {
+        int b_max = b.min[d] + b.extent[d];
+        int a_max = a.min[d] + a.extent[d];
+        if (a.min[d] < b.min[d]) {
+            Region slab = a;
+            slab.extent[d] = b.min[d] - a.min[d];
+            result.push_back(slab);
+        }
+        if (a_max > b_max) {
+            Region slab = a;
+            slab.min[d] = b_max;
+            slab.extent[d] = a_max - b_max;
+            result.push_back(slab);
+        }
+        a.min[d] = b.min[d];
+        a.extent[d] = b.extent[d];
+    }
+    return result;
+}
+
+size_t offset_of(const buffer_t &b, const int *coords, int dims) {
+    int64_t offset = 0;
+    for (int d = 0; d < dims; d++) {
+        offset += (int64_t)(coords[d] - b.min[d]) * b.stride[d];
+    }
+    return (size_t)offset * b.elem_size;
+}
+
+// Make a Buffer that aliases a region within another.
+Buffer crop(const Buffer &b, const Region &r) {
+    buffer_t view = *b.raw_buffer();
+    view.host += offset_of(view, r.min, r.dims);
+    for (int d = 0; d < r.dims; d++) {
+        view.min[d] = r.min[d];
+        view.extent[d] = r.extent[d];
+    }
+    return Buffer(b.type(), &view, b.name());
+}
+
+// Copy a region contained in both of two dense buffers of the same type.
+void copy_region(const Buffer &src, const Buffer &dst, const Region &r) {
+    const buffer_t &s = *src.raw_buffer(), &d = *dst.raw_buffer();
+    internal_assert(r.dims == 0 || (s.stride[0] == 1 && d.stride[0] == 1));
+    size_t row_bytes = (r.dims > 0 ? r.extent[0] : 1) * s.elem_size;
+    int c[4] = {r.min[0], r.min[1], r.min[2], r.min[3]};
+    for (c[3] = r.min[3]; c[3] < r.min[3] + std::max(1, r.extent[3]); c[3]++) {
+        for (c[2] = r.min[2]; c[2] < r.min[2] + std::max(1, r.extent[2]); c[2]++) {
+            for (c[1] = r.min[1]; c[1] < r.min[1] + std::max(1, r.extent[1]); c[1]++) {
+                memcpy(d.host + offset_of(d, c, r.dims), s.host + offset_of(s, c, r.dims), row_bytes);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void Pipeline::realize_tiled(vector<int32_t> sizes, vector<int32_t> tile_sizes,
+                             TileReader read, TileWriter write,
+                             TileOrder order, const Target &t) {
+    user_assert(defined()) << "Can't realize an undefined Pipeline\n";
+    user_assert(sizes.size() <= 4 && tile_sizes.size() <= sizes.size())
+        << "Can't realize_tiled a " << sizes.size() << "-dimensional output with "
+        << tile_sizes.size() << " tile sizes\n";
+    user_assert(write != nullptr) << "realize_tiled requires a TileWriter\n";
+
+    Target target = jit_target_for(t);
+    compile_jit(target);
+
+    // The unbound ImageParams are streamed.
+    vector<size_t> streamed;
+    for (size_t i = 0; i < contents->inferred_args.size(); i++) {
+        const InferredArgument &arg = contents->inferred_args[i];
+        if (arg.param.defined() && arg.param.is_buffer() && !arg.param.get_buffer().defined()) {
+            user_assert(arg.param.dimensions() <= 4)
+                << "realize_tiled can't stream the " << arg.param.dimensions()
+                << "-dimensional ImageParam " << arg.param.name()
+                << ". Streamed inputs may have at most four dimensions.\n";
+            streamed.push_back(i);
+        }
+    }
+    user_assert(streamed.empty() || read != nullptr)
+        << "realize_tiled requires a TileReader to stream the unbound ImageParam "
+        << contents->inferred_args[streamed[0]].param.name() << "\n";
+
+    vector<int> num_tiles(tile_sizes.size());
+    int total_tiles = 1;
+    for (size_t d = 0; d < tile_sizes.size(); d++) {
+        user_assert(tile_sizes[d] > 0) << "Tile sizes passed to realize_tiled must be positive\n";
+        num_tiles[d] = (sizes[d] + tile_sizes[d] - 1) / tile_sizes[d];
+        total_tiles *= num_tiles[d];
+    }
+
+    // The input buffers for the previous tile, to copy the overlap
+    // with the next one from.
+    std::map<size_t, Buffer> previous_inputs;
+    Realization tile(vector<Buffer>{Buffer()});
+
+    for (int k = 0; k < total_tiles; k++) {
+        // Find the coordinates of the k'th tile in the chosen order.
+        vector<int> idx(tile_sizes.size());
+        int rest = k;
+        if (order == TileOrder::ColumnMajor) {
+            for (int d = (int)tile_sizes.size() - 1; d >= 0; d--) {
+                idx[d] = rest % num_tiles[d];
+                rest /= num_tiles[d];
+            }
+        } else {
+            for (size_t d = 0; d < tile_sizes.size(); d++) {
+                idx[d] = rest % num_tiles[d];
+                rest /= num_tiles[d];
+            }
+            if (order == TileOrder::Serpentine && (k / num_tiles[0]) % 2 == 1) {
+                idx[0] = num_tiles[0] - 1 - idx[0];
+            }
+        }
+
+        vector<int32_t> tile_min(4, 0), tile_extent = sizes;
+        for (size_t d = 0; d < tile_sizes.size(); d++) {
+            tile_min[d] = idx[d] * tile_sizes[d];
+            tile_extent[d] = std::min(tile_sizes[d], sizes[d] - tile_min[d]);
+        }
+
+        // Only reallocate the output tile if its size changed.
+        bool same_size = tile[0].defined();
+        for (size_t d = 0; d < sizes.size() && same_size; d++) {
+            same_size = tile[0].extent(d) == tile_extent[d];
+        }
+        if (!same_size) {
+            vector<Buffer> bufs;
+            for (Function f : contents->outputs) {
+                for (Type type : f.output_types()) {
+                    bufs.push_back(Buffer(type, tile_extent));
+                }
+            }
+            tile = Realization(bufs);
+        }
+        for (Buffer b : tile.as_vector()) {
+            b.set_min(tile_min[0], tile_min[1], tile_min[2], tile_min[3]);
+        }
+
+        if (!streamed.empty()) {
+            for (size_t i : streamed) {
+                contents->inferred_args[i].param.set_buffer(Buffer());
+            }
+            std::map<size_t, Buffer> query = query_input_bounds(tile, target);
+
+            for (size_t i : streamed) {
+                Parameter &param = contents->inferred_args[i].param;
+                Region required = region_of(*query[i].raw_buffer(), param.dimensions());
+                Buffer input(param.type(),
+                             vector<int32_t>(required.extent, required.extent + required.dims),
+                             nullptr, param.name());
+                input.set_min(required.min[0], required.min[1], required.min[2], required.min[3]);
+
+                // Copy over what the last tile also needed, and read
+                // the rest.
+                Region overlap;
+                auto prev = previous_inputs.find(i);
+                if (prev != previous_inputs.end() &&
+                    intersect(required, region_of(*prev->second.raw_buffer(), required.dims), overlap)) {
+                    copy_region(prev->second, input, overlap);
+                    for (const Region &r : subtract(required, overlap)) {
+                        read(param.name(), crop(input, r));
+                    }
+                } else {
+                    read(param.name(), input);
+                }
+
+                param.set_buffer(input);
+                previous_inputs[i] = input;
+            }
+        }
+
+        realize(tile, target);
+        for (Buffer b : tile.as_vector()) {
+            b.copy_to_host();
+        }
+        write(tile);
+    }
+
+    for (size_t i : streamed) {
+        contents->inferred_args[i].param.set_buffer(Buffer());
+    }
+}
+
 void Pipeline::invalidate_cache() {
     if (defined()) {
         contents->invalidate_cache();
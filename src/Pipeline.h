@@ -7,6 +7,8 @@
  * pipeline.
  */
 
+#include <functional>
+#include <map>
 #include <vector>
 
 #include "Buffer.h"
@@ -22,12 +24,38 @@ namespace Halide {
 struct Argument;
 class Func;
 struct Outputs;
+class ParamMap;
 struct PipelineContents;
+struct PreparedRealizationContents;
+class PreparedRealization;
 
 namespace Internal {
 class IRMutator;
 }  // namespace Internal
 
+/** The order in which Pipeline::realize_tiled visits output tiles. */
+enum class TileOrder {
+    /** Along the first dimension, then the second, and so on. */
+    RowMajor,
+    /** Along the last tiled dimension, then the one before, and so on. */
+    ColumnMajor,
+    /** Like RowMajor, but reversing direction along the first
+     * dimension after each row, so that consecutive tiles are always
+     * adjacent. */
+    Serpentine
+};
+
+/** Called by Pipeline::realize_tiled to fill in a region of the
+ * input image with the given name. The Buffer's mins and extents
+ * give the region, and it is only valid for the duration of the
+ * call. */
+typedef std::function<void(const std::string &input, Buffer region)> TileReader;
+
+/** Called by Pipeline::realize_tiled with each completed output tile,
+ * with its mins set to its position in the output. The Buffers are
+ * reused for the next tile once this returns. */
+typedef std::function<void(Realization tile)> TileWriter;
+
 /**
  * Used to determine if the output printed to file should be as a normal string
  * or as an HTML file which can be opened in a browerser and manipulated via JS and CSS.*/
@@ -60,7 +88,9 @@ class Pipeline {
 
     std::vector<Argument> infer_arguments(Internal::Stmt body);
     std::vector<Buffer> validate_arguments(const std::vector<Argument> &args, Internal::Stmt body);
-    std::vector<const void *> prepare_jit_call_arguments(Realization dst, const Target &target);
+    std::vector<const void *> prepare_jit_call_arguments(Realization dst, const Target &target,
+                                                         const ParamMap &params);
+    std::map<size_t, Buffer> query_input_bounds(Realization dst, const Target &target);
 
     static std::vector<Internal::JITModule> make_externs_jit_module(const Target &target,
                                                                     std::map<std::string, JITExtern> &externs_in_out);
@@ -155,6 +185,33 @@ public:
                                         StmtOutputFormat fmt = Text,
                                         const Target &target = get_target_from_environment());
 
+    /** Write out a static estimate of the arithmetic, memory traffic
+     * and memory use of the lowered code, broken down by Func and by
+     * loop nest. See Internal::print_cost_report. The estimates map
+     * names in the lowered code, such as "input.extent.0" or the name
+     * of a scalar Param, to values; counts that depend on anything
+     * else are written as expressions. Useful for noticing when a
+     * schedule change increases memory traffic, without running
+     * anything. */
+    EXPORT void compile_to_cost_report(const std::string &filename,
+                                       const std::vector<Argument> &args,
+                                       const std::map<std::string, Expr> &estimates = std::map<std::string, Expr>(),
+                                       const Target &target = get_target_from_environment());
+
+    /** Write out the lowered code as HTML, like
+     * compile_to_lowered_stmt, with the results of a profiled run
+     * overlaid: each produce node is annotated with its Func's time
+     * and memory use, and each loop with the time spent in the Funcs
+     * computed within it, with hot regions shaded red. The IR after
+     * each lowering pass is appended in collapsed sections. The
+     * profile is the text printed by the runtime profiler at the end
+     * of a run with the Profile target feature (which can be captured
+     * with set_custom_print). */
+    EXPORT void compile_to_profiled_html(const std::string &filename,
+                                         const std::vector<Argument> &args,
+                                         const std::string &profile,
+                                         const Target &target = get_target_from_environment());
+
     /** Write out the loop nests specified by the schedule for this
      * Pipeline's Funcs. Helpful for understanding what a schedule is
      * doing. */
@@ -198,7 +255,9 @@ public:
      * wish to avoid including the time taken to compile a pipeline,
      * then you can call this ahead of time. Returns the raw function
      * pointer to the compiled pipeline. Default is to use the Target
-     * returned from Halide::get_jit_target_from_environment()
+     * returned from Halide::get_jit_target_from_environment(). Safe
+     * to call from several threads at once; the first call compiles
+     * and the others wait for it.
      */
      EXPORT void *compile_jit(const Target &target = get_jit_target_from_environment());
 
@@ -371,6 +430,35 @@ public:
     }
     // @}
 
+    /** Evaluate this function into existing allocated buffers, using
+     * the values in the given ParamMap for the Params and ImageParams
+     * it sets. This touches no state shared with other calls, so once
+     * the pipeline is jit-compiled, many threads may realize it at
+     * once, each with its own ParamMap and outputs, as long as
+     * nothing reschedules it, changes its handlers, or calls
+     * Param::set or ImageParam::set on a Param that some ParamMap
+     * doesn't override. */
+    // @{
+    EXPORT void realize(Realization dst, const ParamMap &params, const Target &target = Target());
+    EXPORT void realize(Buffer dst, const ParamMap &params, const Target &target = Target());
+
+    template<typename T>
+    NO_INLINE void realize(Image<T> dst, const ParamMap &params, const Target &target = Target()) {
+        // Images are expected to exist on-host.
+        realize(Buffer(dst), params, target);
+        dst.copy_to_host();
+    }
+    // @}
+
+    /** Jit-compile this pipeline (if needed) and bind it to the
+     * given output buffers, returning an object that calls it with
+     * much less overhead per call than realize. See
+     * PreparedRealization. */
+    // @{
+    EXPORT PreparedRealization prepare_realize(Realization dst, const Target &target = Target());
+    EXPORT PreparedRealization prepare_realize(Buffer dst, const Target &target = Target());
+    // @}
+
     /** For a given size of output, or a given set of output buffers,
      * determine the bounds required of all unbound ImageParams
      * referenced. Communicates the result by allocating new buffers
@@ -382,6 +470,25 @@ public:
     EXPORT void infer_input_bounds(Buffer dst);
     // @}
 
+    /** Evaluate an output of the given size one tile at a time, so
+     * that neither the output nor the inputs need to fit in memory.
+     * Any ImageParams that are unbound are streamed: for each tile,
+     * the region of each such input it requires is found with a
+     * bounds query, and filled in by calling read. The part of that
+     * region that was also required by the previous tile is copied
+     * over rather than read again, so visiting the tiles in an order
+     * where consecutive tiles are adjacent (e.g. TileOrder::Serpentine)
+     * reads each input pixel close to once. Each completed tile is
+     * passed to write. The tile sizes apply to the first dimensions of
+     * the output; any remaining dimensions are not tiled. Tiles at the
+     * far edges are smaller if the sizes don't divide evenly. The
+     * streamed ImageParams are left unbound. */
+    EXPORT void realize_tiled(std::vector<int32_t> sizes,
+                              std::vector<int32_t> tile_sizes,
+                              TileReader read, TileWriter write,
+                              TileOrder order = TileOrder::RowMajor,
+                              const Target &target = Target());
+
     /** Infer the arguments to the Pipeline, sorted into a canonical order:
      * all buffers (sorted alphabetically by name), followed by all non-buffers
      * (sorted alphabetically by name).
@@ -402,8 +509,62 @@ public:
 
 private:
     std::string generate_function_name() const;
+
+    /** The implementation of compile_to_module. If pass_log is
+     * non-null, the pipeline is always lowered (rather than reusing
+     * the previous Module), and the Stmt after each lowering pass is
+     * appended to it. */
+    Module build_module(const std::vector<Argument> &args,
+                        const std::string &fn_name,
+                        const Target &target,
+                        const Internal::LoweredFunc::LinkageType linkage_type,
+                        std::vector<std::pair<std::string, Internal::Stmt>> *pass_log);
     std::vector<Argument> build_public_args(const std::vector<Argument> &args, const Target &target) const;
+    Target jit_target_for(const Target &target) const;
+
+};
+
+/** A call to a jit-compiled Pipeline with its arguments packed ahead
+ * of time, made by Pipeline::prepare_realize. Use it to call a small
+ * pipeline many times, e.g. once per tile of a video frame, when the
+ * checks and setup done by each call to Pipeline::realize would cost
+ * more than the computation.
+ *
+ * Params are read through their storage, so Param::set between runs
+ * takes effect with no further work, and the buffer bound to each
+ * ImageParam is looked up again on each run. Everything else is fixed
+ * when the call is prepared: the compiled code, the custom handlers,
+ * and the output buffers (unless new ones are passed to run). If the
+ * Pipeline is rescheduled or recompiled, prepare it again. Profiling
+ * reports are not printed.
+ *
+ * run may be called from several threads at once, as long as they
+ * write to different output buffers and nothing sets a Param or binds
+ * an ImageParam in the meantime. */
+class PreparedRealization {
+    Internal::IntrusivePtr<PreparedRealizationContents> contents;
+
+    friend class Pipeline;
+    PreparedRealization(Internal::IntrusivePtr<PreparedRealizationContents> c);
 
+public:
+    /** Make an undefined PreparedRealization object. */
+    EXPORT PreparedRealization();
+
+    /** Run the pipeline into the output buffers it was prepared
+     * with. */
+    EXPORT void run();
+
+    /** Run the pipeline into the given output buffers instead, which
+     * must have the same types and dimensionalities as the ones it
+     * was prepared with. */
+    // @{
+    EXPORT void run(Realization dst);
+    EXPORT void run(Buffer dst);
+    // @}
+
+    /** Check if this object was made by Pipeline::prepare_realize. */
+    EXPORT bool defined() const;
 };
 
 namespace {
@@ -113,6 +113,13 @@ private:
 
         bool on_stack;
         Expr size = compute_allocation_size(new_extents, condition, op->type, op->name, on_stack);
+
+        // Allocations that point into another one (e.g. a memory
+        // arena) don't use any memory of their own.
+        const Call *new_call = op->new_expr.as<Call>();
+        if (new_call && new_call->is_intrinsic(Call::address_of)) {
+            size = make_zero(UInt(64));
+        }
         internal_assert(size.type() == UInt(64));
         func_alloc_sizes.push(op->name, {on_stack, size});
 
@@ -145,6 +145,13 @@ private:
         else expr = Broadcast::make(value, op->lanes);
     }
 
+    void visit(const VectorReduce *op) {
+        Expr value = mutate(op->value);
+        if (!expr.defined()) return;
+        if (value.same_as(op->value)) expr = op;
+        else expr = VectorReduce::make(op->op, value, op->type.lanes());
+    }
+
     void visit(const Call *op) {
         if (op->is_intrinsic(Call::undef)) {
             expr = Expr();
@@ -0,0 +1,263 @@
+#include "Scan.h"
+#include "Associativity.h"
+#include "IROperator.h"
+#include "RDom.h"
+
+namespace Halide {
+
+using std::string;
+using std::vector;
+
+namespace {
+
+// The common implementation of the scans. If starts is non-null, the
+// scan is segmented.
+Func blocked_scan(const Func &source, const Func *starts, int dim, Expr first, Expr extent,
+                  std::function<Expr(Expr, Expr)> op, int block_size, int vector_width,
+                  const string &name) {
+    user_assert(source.defined())
+        << "Can't scan undefined Func " << source.name() << "\n";
+    user_assert(source.outputs() == 1)
+        << "Can't scan Func " << source.name() << " because it is Tuple-valued\n";
+    user_assert(dim >= 0 && dim < source.dimensions())
+        << "Can't scan along dimension " << dim << " of Func " << source.name()
+        << ", which has " << source.dimensions() << " dimensions\n";
+    user_assert(first.defined() && extent.defined())
+        << "Scan of Func " << source.name() << " must have a defined min and extent\n";
+    user_assert(vector_width >= 1)
+        << "Vector width for the scan of Func " << source.name() << " must be positive\n";
+    user_assert(block_size > 1)
+        << "Block size for the scan of Func " << source.name() << " must be greater than one\n";
+    if (starts) {
+        user_assert(starts->defined() && starts->outputs() == 1 &&
+                    starts->dimensions() == source.dimensions())
+            << "The segment starts for the scan of Func " << source.name()
+            << " must be a single-valued Func with the same dimensionality\n";
+    }
+
+    const vector<Var> args = source.args();
+    const Type t = source.output_types()[0];
+    Var b(name + "_block"), i(name + "_index");
+
+    // The blocks are stored with the index within the block in place
+    // of the scanned dimension, and the block number next to it. When
+    // scanning along the innermost dimension, the block number goes
+    // first, so that the scan within the blocks can be vectorized
+    // across blocks.
+    auto block_args = [&](Expr index, Expr block) {
+        vector<Expr> result(args.begin(), args.end());
+        result[dim] = index;
+        result.insert(result.begin() + (dim == 0 ? 0 : dim + 1), block);
+        return result;
+    };
+    vector<Var> block_vars(args);
+    block_vars[dim] = i;
+    block_vars.insert(block_vars.begin() + (dim == 0 ? 0 : dim + 1), b);
+
+    // The block totals are stored with the block number in place of
+    // the scanned dimension.
+    auto carry_args = [&](Expr block) {
+        vector<Expr> result(args.begin(), args.end());
+        result[dim] = block;
+        return result;
+    };
+    vector<Var> carry_vars(args);
+    carry_vars[dim] = b;
+
+    // Positions past the end of the last block read the last element,
+    // which doesn't affect the results within the range.
+    auto clamped_args = [&](Expr pos) {
+        vector<Expr> result(args.begin(), args.end());
+        result[dim] = clamp(first + pos, first, first + extent - 1);
+        return result;
+    };
+    Expr num_blocks = (extent + block_size - 1) / block_size;
+
+    // If rfactor can prove the operator associative, reduce each block
+    // to its total with an rfactor of the reduction over the whole
+    // range, scan the totals, and then scan each block starting from
+    // the total of the blocks before it. Otherwise (e.g. for segmented
+    // scans, whose operator is a Tuple of a flag and a value), scan
+    // each block independently and fix up the elements afterwards.
+    Func block_total;
+    RDom rt(0, block_size, 0, num_blocks, name + "_rt");
+    if (!starts) {
+        vector<Var> others(args);
+        others.erase(others.begin() + dim);
+        Func total(name + "_total");
+        total(others) = undef(t);
+        total(others) = op(total(others), source(clamped_args(rt.y * block_size + rt.x)));
+        bool associative =
+            Internal::prove_associativity(total.name(), total.update_args(),
+                                          total.update_values().as_vector()).first;
+        if (associative) {
+            // The result has the other dimensions in order, followed
+            // by the block number. The total of the last block
+            // includes the padding, but isn't used.
+            block_total = total.update().rfactor(rt.y, b);
+        }
+    }
+    auto block_total_args = [&](Expr block) {
+        vector<Expr> result(args.begin(), args.end());
+        result.erase(result.begin() + dim);
+        result.push_back(block);
+        return result;
+    };
+
+    // Scan the block totals. carry(b) is the scan through the end of
+    // block b. With the rfactor, this doesn't depend on the scan
+    // within the blocks, which starts from it, so it's defined first.
+    Func carry(name + "_carry");
+    RDom rb(1, max(num_blocks - 1, 0), name + "_rb");
+    if (block_total.defined()) {
+        carry(carry_vars) = block_total(block_total_args(b));
+        carry(carry_args(rb)) = op(carry(carry_args(rb - 1)), carry(carry_args(rb)));
+    }
+
+    // Scan within each block. For a segmented scan, the blocks also
+    // track whether there has been a segment start in the block so
+    // far.
+    Func blocks(name + "_blocks");
+    RDom r(1, block_size - 1, name + "_r");
+    vector<Expr> prev = block_args(r - 1, b), cur = block_args(r, b);
+    auto block_value = [&](const vector<Expr> &site) -> Expr {
+        return starts ? blocks(site)[1] : blocks(site);
+    };
+    Expr value = source(clamped_args(b * block_size + i));
+    if (block_total.defined()) {
+        // Start each block from the total of the ones before it.
+        Expr before = carry(carry_args(max(b - 1, 0)));
+        blocks(block_vars) = select(i == 0 && b > 0, op(before, value), value);
+        blocks(cur) = op(blocks(prev), blocks(cur));
+    } else if (starts) {
+        Expr is_start = (*starts)(clamped_args(b * block_size + i)) != Internal::make_zero(starts->output_types()[0]);
+        blocks(block_vars) = Tuple(is_start, value);
+        blocks(cur) = Tuple(blocks(prev)[0] || blocks(cur)[0],
+                            select(blocks(cur)[0], blocks(cur)[1], op(blocks(prev)[1], blocks(cur)[1])));
+    } else {
+        blocks(block_vars) = value;
+        blocks(cur) = op(blocks(prev), blocks(cur));
+    }
+
+    if (!block_total.defined()) {
+        carry(carry_vars) = block_value(block_args(block_size - 1, b));
+        Expr this_total = carry(carry_args(rb)), prev_total = carry(carry_args(rb - 1));
+        if (starts) {
+            Expr restarted = blocks(block_args(block_size - 1, rb))[0];
+            carry(carry_args(rb)) = select(restarted, this_total, op(prev_total, this_total));
+        } else {
+            carry(carry_args(rb)) = op(prev_total, this_total);
+        }
+    }
+
+    // Combine each element with the total of the blocks before it, if
+    // the blocks didn't already start from it.
+    Expr pos = args[dim] - first;
+    Expr block = pos / block_size, index = pos % block_size;
+    Expr in_block = block_value(block_args(index, block));
+    Func result(name);
+    if (block_total.defined()) {
+        result(args) = in_block;
+    } else {
+        Expr before = carry(carry_args(max(block - 1, 0)));
+        Expr no_carry = block == 0;
+        if (starts) {
+            no_carry = no_carry || blocks(block_args(index, block))[0];
+        }
+        result(args) = select(no_carry, in_block, op(before, in_block));
+    }
+
+    // The reductions and scans within the blocks are independent, so
+    // run them in parallel, and vectorize them if asked to. Only the
+    // scan of the block totals is serial, and it's vectorized along
+    // the innermost dimension if that isn't the one being scanned.
+    blocks.compute_at(result, Var::outermost());
+    carry.compute_at(result, Var::outermost());
+    if (block_total.defined()) {
+        block_total.compute_at(result, Var::outermost());
+    }
+    if (dim == 0) {
+        blocks.update().reorder(b, r.x);
+        if (block_total.defined()) {
+            block_total.update().reorder(b, rt.x);
+        }
+        if (args.size() == 1) {
+            // There's no other dimension to parallelize over, so
+            // split the blocks into groups, and process the groups in
+            // parallel, vectorizing within each group.
+            Var group(name + "_block_group");
+            const int group_size = vector_width * 8;
+            blocks.split(b, group, b, group_size).reorder(b, i, group).parallel(group);
+            blocks.update().split(b, group, b, group_size).reorder(b, r.x, group).parallel(group);
+            if (block_total.defined()) {
+                block_total.split(b, group, b, group_size).parallel(group);
+                block_total.update().split(b, group, b, group_size).reorder(b, rt.x, group).parallel(group);
+            }
+        }
+        if (vector_width > 1) {
+            blocks.vectorize(b, vector_width);
+            blocks.update().vectorize(b, vector_width);
+            if (block_total.defined()) {
+                block_total.vectorize(b, vector_width);
+                block_total.update().vectorize(b, vector_width);
+            }
+        }
+        if (args.size() > 1) {
+            blocks.update().parallel(args.back());
+            carry.update().parallel(args.back());
+            if (block_total.defined()) {
+                block_total.update().parallel(args.back());
+            }
+        }
+    } else {
+        blocks.update().reorder(args[0], r.x).parallel(b);
+        carry.update().reorder(args[0], rb.x);
+        if (block_total.defined()) {
+            block_total.update().reorder(args[0], rt.x).parallel(b);
+        }
+        if (vector_width > 1) {
+            blocks.vectorize(args[0], vector_width);
+            blocks.update().vectorize(args[0], vector_width);
+            carry.vectorize(args[0], vector_width);
+            carry.update().vectorize(args[0], vector_width);
+            if (block_total.defined()) {
+                block_total.vectorize(args[0], vector_width);
+                block_total.update().vectorize(args[0], vector_width);
+            }
+        }
+        if (dim != (int)args.size() - 1) {
+            carry.update().parallel(args.back());
+        }
+    }
+
+    return result;
+}
+
+Expr add(Expr a, Expr b) {
+    return a + b;
+}
+
+}
+
+Func scan(const Func &source, int dim, Expr min, Expr extent,
+          std::function<Expr(Expr, Expr)> op, int block_size, int vector_width, const string &name) {
+    return blocked_scan(source, nullptr, dim, min, extent, op, block_size, vector_width, name);
+}
+
+Func prefix_sum(const Func &source, int dim, Expr min, Expr extent,
+                int block_size, int vector_width, const string &name) {
+    return blocked_scan(source, nullptr, dim, min, extent, add, block_size, vector_width, name);
+}
+
+Func segmented_scan(const Func &source, const Func &starts, int dim, Expr min, Expr extent,
+                    std::function<Expr(Expr, Expr)> op, int block_size, int vector_width,
+                    const string &name) {
+    return blocked_scan(source, &starts, dim, min, extent, op, block_size, vector_width, name);
+}
+
+Func segmented_prefix_sum(const Func &source, const Func &starts, int dim, Expr min, Expr extent,
+                          int block_size, int vector_width, const string &name) {
+    return blocked_scan(source, &starts, dim, min, extent, add, block_size, vector_width, name);
+}
+
+}
@@ -0,0 +1,73 @@
+#ifndef HALIDE_SCAN_H
+#define HALIDE_SCAN_H
+
+/** \file
+ * Defines parallel prefix scans (cumulative sums and the like) along
+ * one dimension of a Func.
+ */
+
+#include <functional>
+#include <string>
+
+#include "Func.h"
+
+namespace Halide {
+
+/** Compute an inclusive scan of a Func along one of its dimensions:
+ * the result at coordinate x of dimension 'dim' combines the source
+ * at coordinates min through x using the associative operator
+ * 'op'. Other dimensions are left alone. For example, an integral
+ * image is a prefix sum along x followed by a prefix sum along y:
+ *
+ \code
+ Func integral = prefix_sum(prefix_sum(in, 0, 0, w), 1, 0, h);
+ \endcode
+ *
+ * Rather than one long serial update, the scan is done in blocks of
+ * 'block_size' elements. If rfactor can prove 'op' associative (as it
+ * can for sums, products, mins and maxes), each block is reduced to
+ * its total with Stage::rfactor, the totals are scanned, and then each
+ * block is scanned starting from the total of the blocks before
+ * it. Otherwise each block is scanned independently, and then each
+ * element is fixed up by combining it with the scanned total of the
+ * preceding blocks. Either way, the work on each block runs in
+ * parallel, leaving only the scan of the block totals serial. If
+ * 'vector_width' is greater than one, the work on the blocks is also
+ * vectorized by that factor (across blocks when scanning along the
+ * innermost dimension, and along the innermost dimension
+ * otherwise). Pass the natural vector width of the target for the
+ * source type, e.g. target.natural_vector_size(type).
+ *
+ * The returned Func is pure, so it can be scheduled like any other:
+ * the intermediate stages are computed at its outermost loop level,
+ * so it may be computed at any level of a consumer, but must not be
+ * inlined. The result is only meaningful within [min, min + extent)
+ * along 'dim', and the source is only evaluated within that range. */
+// @{
+EXPORT Func scan(const Func &source, int dim, Expr min, Expr extent,
+                 std::function<Expr(Expr, Expr)> op,
+                 int block_size = 256, int vector_width = 1,
+                 const std::string &name = "scan");
+EXPORT Func prefix_sum(const Func &source, int dim, Expr min, Expr extent,
+                       int block_size = 256, int vector_width = 1,
+                       const std::string &name = "prefix_sum");
+// @}
+
+/** Segmented variants of \ref scan and \ref prefix_sum. The Func
+ * 'starts' must have the same dimensionality as the source, and the
+ * scan restarts wherever it is true (or non-zero): the result at x is
+ * the combination of the source from the last start at or before x
+ * (or from min, if there is none) through x. */
+// @{
+EXPORT Func segmented_scan(const Func &source, const Func &starts, int dim, Expr min, Expr extent,
+                           std::function<Expr(Expr, Expr)> op,
+                           int block_size = 256, int vector_width = 1,
+                           const std::string &name = "segmented_scan");
+EXPORT Func segmented_prefix_sum(const Func &source, const Func &starts, int dim, Expr min, Expr extent,
+                                 int block_size = 256, int vector_width = 1,
+                                 const std::string &name = "segmented_prefix_sum");
+// @}
+
+}
+
+#endif
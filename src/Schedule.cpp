@@ -26,8 +26,9 @@ struct ScheduleContents {
     bool memoized;
     bool touched;
     bool allow_race_conditions;
+    bool atomic;
 
-    ScheduleContents() : memoized(false), touched(false), allow_race_conditions(false) {};
+    ScheduleContents() : memoized(false), touched(false), allow_race_conditions(false), atomic(false) {};
 
     // Pass an IRMutator through to all Exprs referenced in the ScheduleContents
     void mutate(IRMutator *mutator) {
@@ -83,6 +84,7 @@ Schedule Schedule::deep_copy(
     copy.contents->memoized = contents->memoized;
     copy.contents->touched = contents->touched;
     copy.contents->allow_race_conditions = contents->allow_race_conditions;
+    copy.contents->atomic = contents->atomic;
 
     // Deep-copy wrapper functions. If function has already been deep-copied before,
     // i.e. it's in the 'copied_map', use the deep-copied version from the map instead
@@ -201,6 +203,14 @@ bool Schedule::allow_race_conditions() const {
     return contents->allow_race_conditions;
 }
 
+bool &Schedule::atomic() {
+    return contents->atomic;
+}
+
+bool Schedule::atomic() const {
+    return contents->atomic;
+}
+
 void Schedule::accept(IRVisitor *visitor) const {
     for (const ReductionVariable &r : rvars()) {
         if (r.min.defined()) {
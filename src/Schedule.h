@@ -279,6 +279,13 @@ public:
     bool &allow_race_conditions();
     // @}
 
+    /** Should the stores of this (update) stage be performed as
+     * atomic read-modify-write operations? See \ref Stage::atomic */
+    // @{
+    bool atomic() const;
+    bool &atomic();
+    // @}
+
     /** Pass an IRVisitor through to all Exprs referenced in the
      * Schedule. */
     void accept(IRVisitor *) const;
@@ -73,6 +73,15 @@ Stmt build_provide_loop_nest_helper(string func_name,
     // Make the (multi-dimensional multi-valued) store node.
     Stmt stmt = Provide::make(func_name, values, site);
 
+    if (s.atomic()) {
+        // The read-modify-write of each site must be atomic. If it
+        // gets vectorized, vectorize_loops reduces the lanes that
+        // update the same site horizontally before the atomic
+        // update.
+        internal_assert(is_update && values.size() == 1);
+        stmt = Atomic::make(func_name, stmt);
+    }
+
     // The dimensions for which we have a known static size.
     map<string, Expr> known_size_dims;
     // First hunt through the bounds for them.
@@ -3173,6 +3173,31 @@ private:
         }
     }
 
+    void visit(const VectorReduce *op) {
+        Expr value = mutate(op->value);
+        int lanes = op->type.lanes();
+        int factor = value.type().lanes() / lanes;
+        const Broadcast *b = value.as<Broadcast>();
+
+        if (factor == 1) {
+            expr = value;
+        } else if (b && op->op != VectorReduce::Mul) {
+            // Reducing a broadcast
+            Expr result = b->value;
+            if (op->op == VectorReduce::Add) {
+                result = mutate(result * make_const(result.type(), factor));
+            }
+            if (lanes > 1) {
+                result = Broadcast::make(result, lanes);
+            }
+            expr = result;
+        } else if (value.same_as(op->value)) {
+            expr = op;
+        } else {
+            expr = VectorReduce::make(op->op, value, lanes);
+        }
+    }
+
     void visit(const IfThenElse *op) {
         Expr condition = mutate(op->condition);
 
@@ -0,0 +1,129 @@
+#include "SpecializeDenseStrides.h"
+#include "Debug.h"
+#include "IRVisitor.h"
+#include "IROperator.h"
+#include "Scope.h"
+#include "Substitute.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+
+namespace {
+
+// Find the buffers accessed by a statement whose sizes are free
+// variables, i.e. the inputs and outputs of the pipeline, along with
+// all the free variables used.
+class FindExternalBuffers : public IRVisitor {
+    Scope<int> defined;
+
+    using IRVisitor::visit;
+
+    void visit(const LetStmt *op) {
+        op->value.accept(this);
+        defined.push(op->name, 0);
+        op->body.accept(this);
+        defined.pop(op->name);
+    }
+
+    void visit(const Let *op) {
+        op->value.accept(this);
+        defined.push(op->name, 0);
+        op->body.accept(this);
+        defined.pop(op->name);
+    }
+
+    void visit(const For *op) {
+        op->min.accept(this);
+        op->extent.accept(this);
+        defined.push(op->name, 0);
+        op->body.accept(this);
+        defined.pop(op->name);
+    }
+
+    void visit(const Variable *op) {
+        if (!defined.contains(op->name)) {
+            free_vars.insert(op->name);
+        }
+    }
+
+    void record(const string &name) {
+        // Internal allocations, and buffers with a user-specified
+        // stride, have their strides defined by a let.
+        string stride = name + ".stride.0";
+        if (!defined.contains(stride) && !defined.contains(stride + ".constrained")) {
+            buffers.insert(name);
+        }
+    }
+
+    void visit(const Load *op) {
+        IRVisitor::visit(op);
+        record(op->name);
+    }
+
+    void visit(const Store *op) {
+        IRVisitor::visit(op);
+        record(op->name);
+    }
+
+public:
+    set<string> buffers;
+    set<string> free_vars;
+};
+
+Stmt specialize(Stmt s) {
+    FindExternalBuffers finder;
+    s.accept(&finder);
+
+    Expr condition;
+    map<string, Expr> replacements;
+
+    for (const string &name : finder.buffers) {
+        string stride_0 = name + ".stride.0";
+        if (!finder.free_vars.count(stride_0)) {
+            continue;
+        }
+
+        Expr dense = Variable::make(Int(32), stride_0) == 1;
+        condition = condition.defined() ? condition && dense : dense;
+        replacements[stride_0] = 1;
+    }
+
+    if (!condition.defined()) {
+        debug(3) << "No external buffers with a symbolic innermost stride\n";
+        return s;
+    }
+
+    debug(3) << "Specializing on dense strides: " << condition << "\n";
+
+    // The fallback is the unmodified statement, so there are only
+    // ever two copies of the body, however many buffers there are.
+    Stmt dense = substitute(replacements, s);
+    return IfThenElse::make(condition, dense, s);
+}
+
+}  // namespace
+
+Stmt specialize_dense_strides(Stmt s) {
+    // Walk past the lets, the asserts, and the bounds query early
+    // return at the top of the pipeline, so that they are not
+    // duplicated.
+    if (const LetStmt *op = s.as<LetStmt>()) {
+        return LetStmt::make(op->name, op->value, specialize_dense_strides(op->body));
+    } else if (const Block *op = s.as<Block>()) {
+        if (op->first.as<AssertStmt>() && op->rest.defined()) {
+            return Block::make(op->first, specialize_dense_strides(op->rest));
+        }
+    } else if (const IfThenElse *op = s.as<IfThenElse>()) {
+        if (!op->else_case.defined()) {
+            return IfThenElse::make(op->condition, specialize_dense_strides(op->then_case));
+        }
+    }
+    return specialize(s);
+}
+
+}
+}
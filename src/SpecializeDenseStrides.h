@@ -0,0 +1,26 @@
+#ifndef HALIDE_SPECIALIZE_DENSE_STRIDES_H
+#define HALIDE_SPECIALIZE_DENSE_STRIDES_H
+
+/** \file
+ * Defines the lowering pass that specializes a pipeline on its input
+ * and output buffers being dense in their innermost dimension.
+ */
+
+#include "IR.h"
+
+namespace Halide {
+namespace Internal {
+
+/** Specialize a flattened pipeline body on the innermost stride of
+ * every input and output buffer being one, so that accesses along
+ * the innermost dimension become dense vector loads and stores. The
+ * generic code is kept as the fallback, so the body is cloned at most
+ * once regardless of the number of buffers. Buffers with a
+ * user-specified stride constraint are left alone. Enabled by
+ * Target::DenseStrides. */
+Stmt specialize_dense_strides(Stmt s);
+
+}
+}
+
+#endif
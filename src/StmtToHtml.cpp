@@ -3,16 +3,20 @@
 #include "IROperator.h"
 #include "Scope.h"
 
+#include <algorithm>
 #include <iterator>
 #include <iostream>
 #include <fstream>
+#include <set>
 #include <sstream>
 #include <stdio.h>
 
 namespace Halide {
 namespace Internal {
 
+using std::map;
 using std::string;
+using std::vector;
 
 namespace {
 template <typename T>
@@ -22,6 +26,60 @@ std::string to_string(T value) {
     return os.str() ;
 }
 
+string escape_html(const string &x) {
+    string result;
+    for (char c : x) {
+        switch (c) {
+        case '<': result += "&lt;"; break;
+        case '>': result += "&gt;"; break;
+        case '&': result += "&amp;"; break;
+        default: result += c;
+        }
+    }
+    return result;
+}
+
+// The profiler attributes time to the Func whose produce node is
+// running, keyed by the Func name. Loops are named
+// <func>.s<stage>.<var>, and the buffers of Tuple-valued Funcs
+// <func>.<index>, so strip those suffixes, and leave any other name
+// alone.
+string profiled_name(const string &name) {
+    for (size_t dot = name.find(".s"); dot != string::npos; dot = name.find(".s", dot + 1)) {
+        size_t end = dot + 2;
+        while (end < name.size() && isdigit(name[end])) {
+            end++;
+        }
+        if (end > dot + 2 && end < name.size() && name[end] == '.') {
+            return name.substr(0, dot);
+        }
+    }
+    size_t dot = name.rfind('.');
+    if (dot != string::npos && dot + 1 < name.size() &&
+        std::all_of(name.begin() + dot + 1, name.end(), ::isdigit)) {
+        return name.substr(0, dot);
+    }
+    return name;
+}
+
+// Find the Funcs with produce nodes or loops in a Stmt.
+class FuncsComputed : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const ProducerConsumer *op) {
+        names.insert(profiled_name(op->name));
+        IRVisitor::visit(op);
+    }
+
+    void visit(const For *op) {
+        names.insert(profiled_name(op->name));
+        IRVisitor::visit(op);
+    }
+
+public:
+    std::set<string> names;
+};
+
 class StmtToHtml : public IRVisitor {
 
     static const std::string css, js;
@@ -37,7 +95,7 @@ private:
     // All spans and divs will have an id of the form "x-y", where x
     // is shared among all spans/divs in the same context, and y is unique.
     std::vector<int> context_stack;
-    string open_tag(const string &tag, const string &cls, int id = -1) {
+    string open_tag(const string &tag, const string &cls, int id = -1, bool hidden = false) {
         std::stringstream s;
         s << "<" << tag << " class='" << cls << "' id='";
         if (id == -1) {
@@ -46,7 +104,11 @@ private:
         } else {
             s << id;
         }
-        s << "'>";
+        s << "'";
+        if (hidden) {
+            s << " style='display:none;'";
+        }
+        s << ">";
         context_stack.push_back(unique_id());
         return s.str();
     }
@@ -78,8 +140,8 @@ private:
         return span("Matched", body);
     }
 
-    string open_div(const string &cls, int id = -1) {
-        return open_tag("div", cls, id) + "\n";
+    string open_div(const string &cls, int id = -1, bool hidden = false) {
+        return open_tag("div", cls, id, hidden) + "\n";
     }
     string close_div() {
         return close_tag("div") + "\n";
@@ -123,16 +185,68 @@ private:
         stream << matched(r);
     }
 
-    string open_expand_button(int id) {
+    string open_expand_button(int id, bool collapsed = false) {
         std::stringstream button;
         button << "<a class=ExpandButton onclick='return toggle(" << id << ");' href=_blank>"
                << "<div style='position:relative; width:0; height:0;'>"
-               << "<div class=ShowHide style='display:none;' id=" << id << "-show" << "><i class='fa fa-plus-square-o'></i></div>"
-               << "<div class=ShowHide id=" << id << "-hide" << "><i class='fa fa-minus-square-o'></i></div>"
+               << "<div class=ShowHide" << (collapsed ? "" : " style='display:none;'")
+               << " id=" << id << "-show" << "><i class='fa fa-plus-square-o'></i></div>"
+               << "<div class=ShowHide" << (collapsed ? " style='display:none;'" : "")
+               << " id=" << id << "-hide" << "><i class='fa fa-minus-square-o'></i></div>"
                << "</div>";
         return button.str();
     }
 
+    // The profile to overlay, if any.
+    map<string, FuncProfile> profile;
+
+    // Sum the profiles of the given Funcs. Returns false if none of
+    // them were profiled.
+    bool total_profile(const std::set<string> &funcs, FuncProfile &total) {
+        bool found = false;
+        for (const string &f : funcs) {
+            auto it = profile.find(f);
+            if (it != profile.end()) {
+                found = true;
+                total.time += it->second.time;
+                total.percent += it->second.percent;
+                total.memory_peak += it->second.memory_peak;
+                total.num_allocs += it->second.num_allocs;
+                total.stack_peak = std::max(total.stack_peak, it->second.stack_peak);
+            }
+        }
+        return found;
+    }
+
+    // Shade a region by its share of the total time, from white
+    // through to red.
+    string open_heat(const FuncProfile &p) {
+        int lightness = 100 - (int)(std::min(p.percent, 100.0) * 0.45);
+        std::stringstream s;
+        s << "<div class=Heat style='background-color: hsl(0, 100%, " << lightness << "%);'>";
+        return s.str();
+    }
+    string close_heat() {
+        return "</div>";
+    }
+
+    string profile_annotation(const FuncProfile &p, bool show_time, bool show_memory) {
+        std::stringstream s;
+        s << "<span class=Profile>";
+        if (show_time) {
+            s << p.time << "ms (" << p.percent << "%)";
+        }
+        if (show_memory && p.num_allocs) {
+            s << (show_time ? ", " : "") << "peak heap: " << p.memory_peak
+              << " bytes in " << p.num_allocs << " allocations";
+        }
+        if (show_memory && p.stack_peak) {
+            s << ((show_time || p.num_allocs) ? ", " : "") << "peak stack: " << p.stack_peak << " bytes";
+        }
+        s << "</span>";
+        return s.str();
+    }
+
     string close_expand_button() {
         return "</a>";
     }
@@ -277,6 +391,16 @@ private:
         stream << matched(")");
         stream << close_span();
     }
+    void visit(const VectorReduce *op) {
+        stream << open_span("VectorReduce");
+        stream << open_span("Matched");
+        stream << open_span("Type") << op->type << close_span();
+        stream << symbol("vector_reduce") << "(" << op->op << ", ";
+        stream << close_span();
+        print(op->value);
+        stream << matched(")");
+        stream << close_span();
+    }
     void visit(const Call *op) {
         stream << open_span("Call");
         if (op->is_intrinsic(Call::extract_buffer_host)) {
@@ -347,6 +471,11 @@ private:
     }
     void visit(const ProducerConsumer *op) {
         scope.push(op->name, unique_id());
+        FuncProfile p;
+        bool profiled = total_profile({profiled_name(op->name)}, p);
+        if (profiled) {
+            stream << open_heat(p);
+        }
         stream << open_div("Produce");
         int produce_id = unique_id();
         stream << open_span("Matched");
@@ -355,6 +484,9 @@ private:
         stream << var(op->name);
         stream << close_expand_button() << " {";
         stream << close_span();;
+        if (profiled) {
+            stream << profile_annotation(p, true, true);
+        }
         stream << open_div("ProduceBody Indent", produce_id);
         print(op->produce);
         stream << close_div();
@@ -376,11 +508,54 @@ private:
             stream << matched("}");
             stream << close_div();
         }
-        print(op->consume);
+        if (profiled) {
+            stream << close_heat();
+        }
+
+        // The time spent consuming a Func belongs to its consumers,
+        // so the consume side is annotated with the Funcs computed
+        // within it, like a loop.
+        FuncProfile consume_profile;
+        bool consume_profiled = false;
+        if (!profile.empty()) {
+            FuncsComputed funcs;
+            op->consume.accept(&funcs);
+            consume_profiled = total_profile(funcs.names, consume_profile);
+        }
+        if (consume_profiled) {
+            stream << open_heat(consume_profile);
+            stream << open_div("Consume");
+            int consume_id = unique_id();
+            stream << open_span("Matched");
+            stream << open_expand_button(consume_id);
+            stream << keyword("consume") << " ";
+            stream << var(op->name);
+            stream << close_expand_button() << " {";
+            stream << close_span();
+            stream << profile_annotation(consume_profile, true, false);
+            stream << open_div("ConsumeBody Indent", consume_id);
+            print(op->consume);
+            stream << close_div();
+            stream << matched("}");
+            stream << close_div();
+            stream << close_heat();
+        } else {
+            print(op->consume);
+        }
         scope.pop(op->name);
     }
     void visit(const For *op) {
         scope.push(op->name, unique_id());
+        FuncProfile p;
+        bool profiled = false;
+        if (!profile.empty()) {
+            FuncsComputed funcs;
+            op->accept(&funcs);
+            profiled = total_profile(funcs.names, p);
+        }
+        if (profiled) {
+            stream << open_heat(p);
+        }
         stream << open_div("For");
 
         int id = unique_id();
@@ -403,12 +578,18 @@ private:
         stream << matched(")");
         stream << close_expand_button();
         stream << " " << matched("{");
+        if (profiled) {
+            stream << profile_annotation(p, true, false);
+        }
         stream << open_div("ForBody Indent", id);
         print(op->body);
         stream << close_div();
         stream << matched("}");
 
         stream << close_div();
+        if (profiled) {
+            stream << close_heat();
+        }
         scope.pop(op->name);
     }
     void visit(const Store *op) {
@@ -471,6 +652,10 @@ private:
             stream << keyword("custom_delete") << "{ " << op->free_function << "(); ";
             stream << matched("}");
         }
+        FuncProfile p;
+        if (total_profile({profiled_name(op->name)}, p)) {
+            stream << profile_annotation(p, false, true);
+        }
 
         stream << open_div("AllocateBody");
         print(op->body);
@@ -580,6 +765,22 @@ private:
         stream << close_div();
     }
 
+    void visit(const Atomic *op) {
+        stream << open_div("Atomic");
+        int id = unique_id();
+        stream << open_expand_button(id);
+        stream << open_span("Matched");
+        stream << keyword("atomic") << " (" << var(op->producer_name) << ")";
+        stream << close_span();
+        stream << close_expand_button();
+        stream << " " << matched("{");
+        stream << open_div("AtomicBody Indent", id);
+        print(op->body);
+        stream << close_div();
+        stream << matched("}");
+        stream << close_div();
+    }
+
 public:
     void print(Expr ir) {
         ir.accept(this);
@@ -623,7 +824,47 @@ public:
         stream << close_div();
     }
 
-    StmtToHtml(string filename) : id_count(0), context_stack(1, 0) {
+    // List the profiled Funcs, hottest first.
+    void print_profile_summary() {
+        vector<std::pair<string, FuncProfile>> funcs(profile.begin(), profile.end());
+        std::stable_sort(funcs.begin(), funcs.end(),
+                         [](const std::pair<string, FuncProfile> &a, const std::pair<string, FuncProfile> &b) {
+                             return a.second.percent > b.second.percent;
+                         });
+        stream << open_div("ProfileSummary");
+        for (const auto &f : funcs) {
+            stream << open_heat(f.second);
+            stream << open_div("WrapLine");
+            stream << keyword("profile") << " " << var(f.first) << ": "
+                   << profile_annotation(f.second, true, true);
+            stream << close_div();
+            stream << close_heat();
+        }
+        stream << close_div();
+    }
+
+    // Print the Stmt after each lowering pass, each in its own
+    // collapsed block. The profile is only overlaid on the final
+    // Stmt.
+    void print_passes(const vector<std::pair<string, Stmt>> &passes) {
+        profile.clear();
+        stream << open_div("Passes");
+        for (const auto &pass : passes) {
+            stream << open_div("Pass");
+            int id = unique_id();
+            stream << open_expand_button(id, true);
+            stream << keyword("after") << " " << span("Comment", escape_html(pass.first));
+            stream << close_expand_button();
+            stream << open_div("PassBody Indent", id, true);
+            print(pass.second);
+            stream << close_div();
+            stream << close_div();
+        }
+        stream << close_div();
+    }
+
+    StmtToHtml(string filename, const map<string, FuncProfile> &profile = map<string, FuncProfile>())
+        : id_count(0), context_stack(1, 0), profile(profile) {
         stream.open(filename.c_str());
         stream << "<head>";
         stream << "<style type='text/css'>" << css << "</style>\n";
@@ -662,6 +903,7 @@ span.Type { color: #445588; font-weight: bold; }\n \
 span.StringImm { color: #d14; }\n \
 span.IntImm { color: #099; }\n \
 span.FloatImm { color: #099; }\n \
+span.Profile { color: #666; font-style: italic; margin-left: 1em; }\n \
 b.Highlight { font-weight: bold; background-color: #DDD; }\n \
 span.Highlight { font-weight: bold; background-color: #FF0; }\n \
 ";
@@ -690,13 +932,64 @@ void print_to_html(string filename, Stmt s) {
 }
 
 void print_to_html(string filename, const Module &m) {
-    StmtToHtml sth(filename);
+    print_to_html(filename, m, map<string, FuncProfile>());
+}
+
+void print_to_html(string filename, const Module &m,
+                   const map<string, FuncProfile> &profile,
+                   const vector<std::pair<string, Stmt>> &passes) {
+    StmtToHtml sth(filename, profile);
+    if (!profile.empty()) {
+        sth.print_profile_summary();
+    }
     for (const auto &b : m.buffers()) {
         sth.print(b);
     }
     for (const auto &f : m.functions()) {
         sth.print(f);
     }
+    if (!passes.empty()) {
+        sth.print_passes(passes);
+    }
+}
+
+map<string, FuncProfile> parse_profiler_report(const string &report) {
+    // Each Func gets a line of the form:
+    //   name:   1.23ms   (45%)   threads: 3.5   peak: 1024   num: 3   avg: 341 stack: 64
+    // Pipeline-level lines are not indented by two spaces.
+    map<string, FuncProfile> result;
+    std::istringstream lines(report);
+    string line;
+    while (std::getline(lines, line)) {
+        if (line.size() < 3 || line[0] != ' ' || line[1] != ' ' || line[2] == ' ') {
+            continue;
+        }
+        size_t colon = line.find(": ");
+        if (colon == string::npos) {
+            continue;
+        }
+        string name = line.substr(2, colon - 2);
+        std::istringstream fields(line.substr(colon + 1));
+        FuncProfile p;
+        string ms, percent;
+        if (!(fields >> p.time >> ms >> percent) || ms != "ms" ||
+            percent.size() < 3 || percent[0] != '(') {
+            continue;
+        }
+        p.percent = atof(percent.c_str() + 1);
+        string key;
+        while (fields >> key) {
+            if (key == "peak:") {
+                fields >> p.memory_peak;
+            } else if (key == "num:") {
+                fields >> p.num_allocs;
+            } else if (key == "stack:") {
+                fields >> p.stack_peak;
+            }
+        }
+        result[name] = p;
+    }
+    return result;
 }
 
 }
@@ -5,11 +5,31 @@
  * Defines a function to dump an HTML-formatted stmt to a file.
  */
 
+#include <map>
+
 #include "Module.h"
 
 namespace Halide {
 namespace Internal {
 
+/** The statistics the runtime profiler reports for one Func. */
+struct FuncProfile {
+    /** Average time per run in milliseconds, and the percentage of
+     * the pipeline's total time spent in the Func. */
+    double time, percent;
+    /** Peak heap usage and peak stack usage in bytes, and the number
+     * of heap allocations. */
+    uint64_t memory_peak, num_allocs, stack_peak;
+
+    FuncProfile() : time(0), percent(0), memory_peak(0), num_allocs(0), stack_peak(0) {}
+};
+
+/** Parse the per-Func lines of the text printed by
+ * halide_profiler_report. Stats for a Func that appears in several
+ * pipelines are taken from the last one. Only the profiler's report is
+ * understood; statistics gathered from a trace of a run are not. */
+EXPORT std::map<std::string, FuncProfile> parse_profiler_report(const std::string &report);
+
 /**
  * Dump an HTML-formatted print of a Stmt to filename.
  */
@@ -18,6 +38,18 @@ EXPORT void print_to_html(std::string filename, Stmt s);
 /** Dump an HTML-formatted print of a Module to filename. */
 EXPORT void print_to_html(std::string filename, const Module &m);
 
+/** Dump an HTML-formatted print of a Module to filename, with the
+ * given profile overlaid. Each produce node is annotated with the
+ * time and memory use of its Func. Each loop, and the consume side of
+ * each produce node, is annotated with the time spent in the Funcs
+ * computed within it. Hot regions are shaded red. Each
+ * Stmt in passes (see the pass_log argument to lower) is appended in a
+ * collapsed section. */
+EXPORT void print_to_html(std::string filename, const Module &m,
+                          const std::map<std::string, FuncProfile> &profile,
+                          const std::vector<std::pair<std::string, Stmt>> &passes =
+                          std::vector<std::pair<std::string, Stmt>>());
+
 }}
 
 #endif
@@ -249,6 +249,9 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"hvx_64", Target::HVX_64},
     {"hvx_128", Target::HVX_128},
     {"hvx_v62", Target::HVX_v62},
+    {"dense_strides", Target::DenseStrides},
+    {"combine_checks", Target::CombineChecks},
+    {"plan_memory", Target::PlanMemory},
 };
 
 bool lookup_feature(const std::string &tok, Target::Feature &result) {
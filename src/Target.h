@@ -74,6 +74,9 @@ struct Target {
         HVX_64 = halide_target_feature_hvx_64,
         HVX_128 = halide_target_feature_hvx_128,
         HVX_v62 = halide_target_feature_hvx_v62,
+        DenseStrides = halide_target_feature_dense_strides,
+        CombineChecks = halide_target_feature_combine_checks,
+        PlanMemory = halide_target_feature_plan_memory,
         FeatureEnd = halide_target_feature_end
     };
     Target() : os(OSUnknown), arch(ArchUnknown), bits(0) {}
@@ -28,6 +28,10 @@ class VectorizeLoops : public IRMutator {
         bool scalarized;
         int scalar_lane;
 
+        // Whether there's a parallel loop around the atomic updates
+        // we encounter. If not, they don't need to stay atomic.
+        bool in_parallel_loop;
+
         Expr widen(Expr e, int lanes) {
             if (e.type().lanes() == lanes) {
                 return e;
@@ -410,6 +414,102 @@ class VectorizeLoops : public IRMutator {
             }
         }
 
+        void visit(const Atomic *op) {
+            if (scalarized) {
+                IRMutator::visit(op);
+                return;
+            }
+
+            // If every lane updates the same site, we can combine the
+            // new values of the lanes with a horizontal reduction, and
+            // then do a single scalar read-modify-write. The update
+            // is known to be associative, so the order in which the
+            // lanes get combined doesn't matter.
+            const Store *store = op->body.as<Store>();
+            Expr index;
+            if (store && !vectorized_allocations.contains(store->name)) {
+                index = mutate(store->index);
+            }
+            if (index.defined() && index.type().is_scalar()) {
+                auto is_self_load = [&](Expr e) {
+                    const Load *load = e.as<Load>();
+                    return load && load->name == store->name && equal(load->index, store->index);
+                };
+
+                Expr a, b;
+                VectorReduce::Operator reduce_op = VectorReduce::Add;
+                bool commutative = true;
+                const Call *call = store->value.as<Call>();
+                if (const Add *add = store->value.as<Add>()) {
+                    a = add->a;
+                    b = add->b;
+                } else if (const Sub *sub = store->value.as<Sub>()) {
+                    // x - a - b - ... is x - (a + b + ...)
+                    a = sub->a;
+                    b = sub->b;
+                    commutative = false;
+                } else if (const Mul *mul = store->value.as<Mul>()) {
+                    a = mul->a;
+                    b = mul->b;
+                    reduce_op = VectorReduce::Mul;
+                } else if (const Min *min = store->value.as<Min>()) {
+                    a = min->a;
+                    b = min->b;
+                    reduce_op = VectorReduce::Min;
+                } else if (const Max *max = store->value.as<Max>()) {
+                    a = max->a;
+                    b = max->b;
+                    reduce_op = VectorReduce::Max;
+                } else if (call && call->is_intrinsic(Call::bitwise_and)) {
+                    a = call->args[0];
+                    b = call->args[1];
+                    reduce_op = VectorReduce::And;
+                } else if (call && call->is_intrinsic(Call::bitwise_or)) {
+                    a = call->args[0];
+                    b = call->args[1];
+                    reduce_op = VectorReduce::Or;
+                }
+                if (commutative && b.defined() && is_self_load(b)) {
+                    std::swap(a, b);
+                }
+
+                if (a.defined() && is_self_load(a)) {
+                    Expr rest = mutate(b);
+                    Expr self = mutate(a);
+                    if (rest.type().is_vector() && self.type().is_scalar()) {
+                        rest = VectorReduce::make(reduce_op, rest, 1);
+                        Expr value;
+                        switch (reduce_op) {
+                        case VectorReduce::Add:
+                            value = commutative ? Add::make(self, rest) : Sub::make(self, rest);
+                            break;
+                        case VectorReduce::Mul:
+                            value = Mul::make(self, rest);
+                            break;
+                        case VectorReduce::Min:
+                            value = Min::make(self, rest);
+                            break;
+                        case VectorReduce::Max:
+                            value = Max::make(self, rest);
+                            break;
+                        case VectorReduce::And:
+                        case VectorReduce::Or:
+                            value = Call::make(call->type, call->name, {self, rest}, call->call_type);
+                            break;
+                        }
+                        stmt = Store::make(store->name, value, index, store->param);
+                        if (in_parallel_loop) {
+                            stmt = Atomic::make(op->producer_name, stmt);
+                        }
+                        return;
+                    }
+                }
+            }
+
+            // Otherwise do one atomic update per lane.
+            stmt = scalarize(op);
+        }
+
         void visit(const AssertStmt *op) {
             if (op->condition.type().lanes() > 1) {
                 stmt = scalarize(op);
@@ -505,7 +605,10 @@ class VectorizeLoops : public IRMutator {
                 return;
             }
 
+            bool old_in_parallel_loop = in_parallel_loop;
+            in_parallel_loop = in_parallel_loop || for_type == ForType::Parallel;
             Stmt body = mutate(op->body);
+            in_parallel_loop = old_in_parallel_loop;
 
             if (min.same_as(op->min) &&
                 extent.same_as(op->extent) &&
@@ -577,17 +680,25 @@ class VectorizeLoops : public IRMutator {
 
                 // Hide all the vectors in scope with a scalar version
                 // in the appropriate lane.
+                vector<std::pair<string, Expr>> lane_lets;
                 for (Scope<Expr>::iterator iter = scope.begin(); iter != scope.end(); ++iter) {
                     string name = iter.name() + ".lane." + std::to_string(i);
                     Expr lane = extract_lane(iter.value(), i);
                     new_stmt = substitute(iter.name(), Variable::make(lane.type(), name), new_stmt);
-                    new_stmt = LetStmt::make(name, lane, new_stmt);
+                    lane_lets.push_back({name, lane});
                 }
 
                 // Should only serve to rewrite access to internal allocations:
                 // foo[x] -> foo[x * lanes + i]
                 new_stmt = mutate(new_stmt);
 
+                // The lanes of the vectors in scope are already in
+                // terms of the replacement, so define them outside of
+                // the mutation above.
+                for (const auto &let : lane_lets) {
+                    new_stmt = LetStmt::make(let.first, let.second, new_stmt);
+                }
+
                 if (i == 0) {
                     result = new_stmt;
                 } else {
@@ -651,14 +762,17 @@ class VectorizeLoops : public IRMutator {
         }
 
     public:
-        VectorSubs(string v, Expr r) : var(v), replacement(r),
-                                       scalarized(false), scalar_lane(0) {
+        VectorSubs(string v, Expr r, bool in_parallel_loop) :
+            var(v), replacement(r), scalarized(false), scalar_lane(0),
+            in_parallel_loop(in_parallel_loop) {
 
             std::ostringstream oss;
             widening_suffix = ".x" + std::to_string(replacement.type().lanes());
         }
     };
 
+    bool in_parallel_loop = false;
+
     using IRMutator::visit;
 
     void visit(const For *for_loop) {
@@ -674,13 +788,16 @@ class VectorizeLoops : public IRMutator {
             // Replace the var with a ramp within the body
             Expr for_var = Variable::make(Int(32), for_loop->name);
             Expr replacement = Ramp::make(for_var, 1, extent->value);
-            Stmt body = VectorSubs(for_loop->name, replacement).mutate(for_loop->body);
+            Stmt body = VectorSubs(for_loop->name, replacement, in_parallel_loop).mutate(for_loop->body);
 
             // The for loop becomes a simple let statement
             stmt = LetStmt::make(for_loop->name, for_loop->min, body);
 
         } else {
+            bool old_in_parallel_loop = in_parallel_loop;
+            in_parallel_loop = in_parallel_loop || for_loop->for_type == ForType::Parallel;
             IRMutator::visit(for_loop);
+            in_parallel_loop = old_in_parallel_loop;
         }
     }
 
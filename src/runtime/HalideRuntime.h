@@ -560,6 +560,10 @@ enum halide_error_code_t {
      * too small to store all the values of a producer needed by the
      * consumer. */
     halide_error_code_fold_factor_too_small = -26,
+
+    /** A buffer with the wrong number of dimensions was passed to a
+     * buffer argument of more than four dimensions. */
+    halide_error_code_bad_dimensions = -27,
 };
 
 /** Halide calls the functions below on various error conditions. The
@@ -617,6 +621,8 @@ extern int halide_error_bad_fold(void *user_context, const char *func_name, cons
                                  const char *loop_name);
 extern int halide_error_fold_factor_too_small(void *user_context, const char *func_name, const char *var_name,
                                               int fold_factor, const char *loop_name, int required_extent);
+extern int halide_error_bad_dimensions(void *user_context, const char *buffer_name,
+                                       int dimensions_given, int correct_dimensions);
 
 // @}
 
@@ -675,7 +681,13 @@ typedef enum halide_target_feature_t {
     halide_target_feature_hvx_128 = 34, ///< Enable HVX 128 byte mode.
     halide_target_feature_hvx_v62 = 35, ///< Enable Hexagon v62 architecture.
 
-    halide_target_feature_end = 36 ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
+    halide_target_feature_dense_strides = 36, ///< Specialize the pipeline on input and output buffers having an innermost stride of one.
+
+    halide_target_feature_combine_checks = 37, ///< Fold the argument and buffer validation asserts into a single branch on the common path.
+
+    halide_target_feature_plan_memory = 38, ///< Pack the heap allocations made outside of loops into one arena, reusing the space of freed allocations. The effect on peak memory use has only been measured by test/correctness/memory_planning.cpp, not on the apps.
+
+    halide_target_feature_end = 39 ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
 /** This function is called internally by Halide in some situations to determine
@@ -766,12 +778,72 @@ typedef struct buffer_t {
     device side. */
     HALIDE_ATTRIBUTE_ALIGN(1) bool dev_dirty;
 
+    /** The number of dimensions beyond the four described above, at
+     * most HALIDE_BUFFER_MAX_DIMENSIONS - 4. If this is nonzero (and
+     * extent[3] is nonzero), this buffer_t is the first member of a
+     * halide_nd_buffer_t, which describes the rest. Zero-initialize
+     * buffer_t structs (e.g. buffer_t b = {0}) so that this is zero
+     * for ordinary buffers. Pipelines reject a buffer argument of four
+     * or fewer dimensions with four non-zero extents and a non-zero
+     * extra_dimensions. */
+    HALIDE_ATTRIBUTE_ALIGN(1) uint8_t extra_dimensions;
+
     // Some compilers will add extra padding at the end to ensure
     // the size is a multiple of 8; we'll do that explicitly so that
     // there is no ambiguity.
-    HALIDE_ATTRIBUTE_ALIGN(1) uint8_t _padding[10 - sizeof(void *)];
+    HALIDE_ATTRIBUTE_ALIGN(1) uint8_t _padding[9 - sizeof(void *)];
 } buffer_t;
 
+/** The most dimensions a buffer may have, including the four in
+ * buffer_t itself. */
+#define HALIDE_BUFFER_MAX_DIMENSIONS 16
+
+/** One dimension of a buffer, laid out as in the min, extent and
+ * stride fields of buffer_t. */
+typedef struct halide_dimension_t {
+    int32_t min, extent, stride;
+} halide_dimension_t;
+
+/** A buffer with more than four dimensions. The first four are
+ * described by buf as usual, and the remaining
+ * buf.extra_dimensions are described by the array extra_dim. Pass
+ * &buf wherever a buffer_t * is expected: Halide pipelines with
+ * buffer arguments of more than four dimensions expect one of these,
+ * and the runtime's device and cache functions accept one
+ * anywhere. Code that only understands buffer_t will see the first
+ * four dimensions. */
+typedef struct halide_nd_buffer_t {
+    buffer_t buf;
+    halide_dimension_t *extra_dim;
+} halide_nd_buffer_t;
+
+/** Get the number of dimensions of a buffer_t, including any beyond
+ * the fourth. Returns -1 if extra_dimensions is out of range, which
+ * usually means that the buffer_t wasn't zero-initialized. */
+static inline int halide_buffer_dimensions(const buffer_t *buf) {
+    int d = 0;
+    while (d < 4 && buf->extent[d]) {
+        d++;
+    }
+    if (d < 4) {
+        return d;
+    }
+    if (buf->extra_dimensions > HALIDE_BUFFER_MAX_DIMENSIONS - 4) {
+        return -1;
+    }
+    return d + buf->extra_dimensions;
+}
+
+/** Get a dimension of a buffer_t, which may be one beyond the fourth
+ * if the buffer is part of a halide_nd_buffer_t. */
+static inline halide_dimension_t halide_buffer_dim(const buffer_t *buf, int i) {
+    if (i < 4) {
+        halide_dimension_t d = {buf->min[i], buf->extent[i], buf->stride[i]};
+        return d;
+    }
+    return ((const halide_nd_buffer_t *)buf)->extra_dim[i - 4];
+}
+
 #endif
 
 /** halide_scalar_value_t is a simple union able to represent all the well-known
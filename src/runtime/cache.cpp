@@ -72,9 +72,29 @@ WEAK bool bounds_equal(const buffer_t &buf1, const buffer_t &buf2) {
             return false;
         }
     }
+    int dims = halide_buffer_dimensions(&buf1);
+    if (dims != halide_buffer_dimensions(&buf2)) {
+        return false;
+    }
+    for (int i = 4; i < dims; i++) {
+        halide_dimension_t d1 = halide_buffer_dim(&buf1, i);
+        halide_dimension_t d2 = halide_buffer_dim(&buf2, i);
+        if (d1.min != d2.min ||
+            d1.extent != d2.extent ||
+            d1.stride != d2.stride) {
+            return false;
+        }
+    }
     return true;
 }
 
+// The number of dimensions a buffer has beyond the four stored in
+// the buffer_t itself.
+WEAK int extra_dims(const buffer_t &buf) {
+    int dims = halide_buffer_dimensions(&buf);
+    return dims > 4 ? dims - 4 : 0;
+}
+
 // Each host block has extra space to store a header just before the contents.
 // 16 is chosen to keep that alignment.
 // The header holds the cache key hash and pointer to the hash entry.
@@ -92,9 +112,12 @@ struct CacheEntry {
     uint32_t hash;
     uint32_t in_use_count; // 0 if none returned from halide_cache_lookup
     uint32_t tuple_count;
-    buffer_t computed_bounds;
-    buffer_t buf[1];
-    // ADDITIONAL buffer_t STRUCTS HERE
+    // Dimensions beyond the fourth of computed_bounds and the tuple
+    // buffers, which their extra_dim fields point into.
+    halide_dimension_t *extra_dim_storage;
+    halide_nd_buffer_t computed_bounds;
+    halide_nd_buffer_t buf[1];
+    // ADDITIONAL halide_nd_buffer_t STRUCTS HERE
 
     bool init(const uint8_t *cache_key, size_t cache_key_size,
               uint32_t key_hash, const buffer_t &computed_buf,
@@ -123,25 +146,53 @@ WEAK bool CacheEntry::init(const uint8_t *cache_key, size_t cache_key_size,
     hash = key_hash;
     in_use_count = 0;
     tuple_count = tuples;
+    extra_dim_storage = NULL;
+
+    int total_extra_dims = extra_dims(computed_buf);
+    for (uint32_t i = 0; i < tuple_count; i++) {
+        total_extra_dims += extra_dims(*tuple_buffers[i]);
+    }
+    if (total_extra_dims > 0) {
+        extra_dim_storage = (halide_dimension_t *)halide_malloc(NULL, sizeof(halide_dimension_t) * total_extra_dims);
+        if (extra_dim_storage == NULL) {
+            return false;
+        }
+    }
 
     key = (uint8_t *)halide_malloc(NULL, key_size);
     if (key == NULL) {
+        if (extra_dim_storage != NULL) {
+            halide_free(NULL, extra_dim_storage);
+        }
         return false;
     }
-    computed_bounds = computed_buf;
-    computed_bounds.host = NULL;
-    computed_bounds.dev = 0;
+
+    halide_dimension_t *next_dim = extra_dim_storage;
+    computed_bounds.buf = computed_buf;
+    computed_bounds.buf.host = NULL;
+    computed_bounds.buf.dev = 0;
+    computed_bounds.extra_dim = next_dim;
+    for (int d = 0; d < extra_dims(computed_buf); d++) {
+        *next_dim++ = halide_buffer_dim(&computed_buf, d + 4);
+    }
     for (size_t i = 0; i < key_size; i++) {
         key[i] = cache_key[i];
     }
     for (uint32_t i = 0; i < tuple_count; i++) {
-        buffer(i) = *tuple_buffers[i];
+        buf[i].buf = *tuple_buffers[i];
+        buf[i].extra_dim = next_dim;
+        for (int d = 0; d < extra_dims(*tuple_buffers[i]); d++) {
+            *next_dim++ = halide_buffer_dim(tuple_buffers[i], d + 4);
+        }
     }
     return true;
 }
 
 WEAK void CacheEntry::destroy() {
     halide_free(NULL, key);
+    if (extra_dim_storage != NULL) {
+        halide_free(NULL, extra_dim_storage);
+    }
     for (uint32_t i = 0; i < tuple_count; i++) {
         halide_device_free(NULL, &buffer(i));
         halide_free(NULL, get_pointer_to_header(buffer(i).host));
@@ -149,8 +200,8 @@ WEAK void CacheEntry::destroy() {
 }
 
 WEAK buffer_t &CacheEntry::buffer(int32_t i) {
-    buffer_t *buf_ptr = &buf[0];
-    return buf_ptr[i];
+    halide_nd_buffer_t *buf_ptr = &buf[0];
+    return buf_ptr[i].buf;
 }
 
 WEAK uint32_t djb_hash(const uint8_t *key, size_t key_size)  {
@@ -318,7 +369,7 @@ WEAK int halide_memoization_cache_lookup(void *user_context, const uint8_t *cach
     while (entry != NULL) {
         if (entry->hash == h && entry->key_size == (size_t)size &&
             keys_equal(entry->key, cache_key, size) &&
-            bounds_equal(entry->computed_bounds, *computed_bounds) &&
+            bounds_equal(entry->computed_bounds.buf, *computed_bounds) &&
             entry->tuple_count == (uint32_t)tuple_count) {
 
             bool all_bounds_equal = true;
@@ -415,7 +466,7 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
     while (entry != NULL) {
         if (entry->hash == h && entry->key_size == (size_t)size &&
             keys_equal(entry->key, cache_key, size) &&
-            bounds_equal(entry->computed_bounds, *computed_bounds) &&
+            bounds_equal(entry->computed_bounds.buf, *computed_bounds) &&
             entry->tuple_count == (uint32_t)tuple_count) {
 
             bool all_bounds_equal = true;
@@ -453,7 +504,7 @@ WEAK int halide_memoization_cache_store(void *user_context, const uint8_t *cache
     current_cache_size += added_size;
     prune_cache();
 
-    void *entry_storage = halide_malloc(NULL, sizeof(CacheEntry) + sizeof(buffer_t) * (tuple_count - 1));
+    void *entry_storage = halide_malloc(NULL, sizeof(CacheEntry) + sizeof(halide_nd_buffer_t) * (tuple_count - 1));
     if (entry_storage == NULL) {
         current_cache_size -= added_size;
 
@@ -13,14 +13,20 @@ namespace Halide { namespace Runtime { namespace Internal {
 // allocation).
 WEAK size_t buf_size(const buffer_t *buf) {
     size_t size = buf->elem_size;
-    for (size_t i = 0; i < sizeof(buf->stride) / sizeof(buf->stride[0]); i++) {
+    int dims = halide_buffer_dimensions(buf);
+    halide_assert(NULL, dims >= 0);
+    if (dims < 4) {
+        dims = 4;
+    }
+    for (int i = 0; i < dims; i++) {
+        halide_dimension_t dim = halide_buffer_dim(buf, i);
         size_t positive_stride;
-        if (buf->stride[i] < 0) {
-            positive_stride = (size_t)-buf->stride[i];
+        if (dim.stride < 0) {
+            positive_stride = (size_t)-dim.stride;
         } else {
-            positive_stride = (size_t)buf->stride[i];
+            positive_stride = (size_t)dim.stride;
         }
-        size_t total_dim_size = buf->elem_size * buf->extent[i] * positive_stride;
+        size_t total_dim_size = buf->elem_size * dim.extent * positive_stride;
         if (total_dim_size > size) {
             size = total_dim_size;
         }
@@ -46,10 +52,14 @@ WEAK size_t buf_size(const buffer_t *buf) {
 // device_copy struct. It describes a 4D array of copies to
 // perform. Initially it describes copying over a single pixel at a
 // time. We then try to discover contiguous groups of copies that can
-// be coalesced into a single larger copy.
+// be coalesced into a single larger copy. Buffers of more than four
+// dimensions (see halide_nd_buffer_t) can leave more than four
+// dimensions of copies; backends that issue each copy themselves
+// loop over the first four within a loop over outer_count() outer
+// copies.
 
 // The struct that describes a host <-> dev copy to perform.
-#define MAX_COPY_DIMS 4
+#define MAX_COPY_DIMS HALIDE_BUFFER_MAX_DIMENSIONS
 struct device_copy {
     uint64_t src, dst;
     // The multidimensional array of contiguous copy tasks that need to be done.
@@ -59,22 +69,46 @@ struct device_copy {
     // How many contiguous bytes to copy per task
     uint64_t chunk_size;
 
+    // The number of copy tasks in the dimensions beyond the fourth.
+    inline uint64_t outer_count() const {
+        uint64_t n = 1;
+        for (int i = 4; i < MAX_COPY_DIMS; i++) {
+            n *= extent[i];
+        }
+        return n;
+    }
+
+    // The offset in bytes of the given task in the dimensions beyond
+    // the fourth.
+    inline uint64_t outer_offset(uint64_t i) const {
+        uint64_t off = 0;
+        for (int d = 4; d < MAX_COPY_DIMS; d++) {
+            off += (i % extent[d]) * stride_bytes[d];
+            i /= extent[d];
+        }
+        return off;
+    }
+
     inline void copy_memory(void *user_context) const {
         // If this is a zero copy buffer, these pointers will be the same.
         if (src != dst) {
-            // TODO: Is this 32-bit or 64-bit? Leaving signed for now
-            // in case negative strides.
-            for (int w = 0; w < (int)extent[3]; w++) {
-                for (int z = 0; z < (int)extent[2]; z++) {
-                    for (int y = 0; y < (int)extent[1]; y++) {
-                        for (int x = 0; x < (int)extent[0]; x++) {
-                            uint64_t off = (x * stride_bytes[0] +
-                                            y * stride_bytes[1] +
-                                            z * stride_bytes[2] +
-                                            w * stride_bytes[3]);
-                            const void *from = (void *)(src + off);
-                            void *to = (void *)(dst + off);
-                            memcpy(to, from, chunk_size);
+            for (uint64_t o = 0; o < outer_count(); o++) {
+                uint64_t outer = outer_offset(o);
+                // TODO: Is this 32-bit or 64-bit? Leaving signed for now
+                // in case negative strides.
+                for (int w = 0; w < (int)extent[3]; w++) {
+                    for (int z = 0; z < (int)extent[2]; z++) {
+                        for (int y = 0; y < (int)extent[1]; y++) {
+                            for (int x = 0; x < (int)extent[0]; x++) {
+                                uint64_t off = (outer +
+                                                x * stride_bytes[0] +
+                                                y * stride_bytes[1] +
+                                                z * stride_bytes[2] +
+                                                w * stride_bytes[3]);
+                                const void *from = (void *)(src + off);
+                                void *to = (void *)(dst + off);
+                                memcpy(to, from, chunk_size);
+                            }
                         }
                     }
                 }
@@ -106,9 +140,12 @@ WEAK device_copy make_host_to_device_copy(const buffer_t *buf) {
     // Now expand it to copy all the pixels (one at a time) by taking
     // the extents and strides from the buffer_t. Dimensions are added
     // to the copy by inserting it s.t. the stride is in ascending order.
-    for (int i = 0; i < 4 && buf->extent[i]; i++) {
+    int dims = halide_buffer_dimensions(buf);
+    halide_assert(NULL, dims >= 0 && dims <= MAX_COPY_DIMS);
+    for (int i = 0; i < dims; i++) {
+        halide_dimension_t dim = halide_buffer_dim(buf, i);
         // TODO: deal with negative strides.
-        uint64_t stride_bytes = buf->stride[i] * buf->elem_size;
+        uint64_t stride_bytes = dim.stride * buf->elem_size;
         // Insert the dimension sorted into the buffer copy.
         int insert;
         for (insert = 0; insert < i; insert++) {
@@ -123,7 +160,7 @@ WEAK device_copy make_host_to_device_copy(const buffer_t *buf) {
             c.stride_bytes[j] = c.stride_bytes[j - 1];
         }
         // If the stride is 0, only copy it once.
-        c.extent[insert] = stride_bytes != 0 ? buf->extent[i] : 1;
+        c.extent[insert] = stride_bytes != 0 ? dim.extent : 1;
         c.stride_bytes[insert] = stride_bytes;
     };
 
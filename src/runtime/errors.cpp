@@ -193,5 +193,18 @@ WEAK int halide_error_fold_factor_too_small(void *user_context, const char *func
     return halide_error_code_fold_factor_too_small;
 }
 
+WEAK int halide_error_bad_dimensions(void *user_context, const char *buffer_name,
+                                     int dimensions_given, int correct_dimensions) {
+    // A buffer_t that claims extra dimensions where none were expected
+    // usually just wasn't zero-initialized.
+    const char *hint = correct_dimensions <= 4 ?
+        " Make sure the buffer_t is zero-initialized." : "";
+    error(user_context)
+        << buffer_name << " has " << dimensions_given
+        << " dimensions, but a buffer with " << correct_dimensions
+        << " dimensions was expected." << hint;
+    return halide_error_code_bad_dimensions;
+}
+
 
 }  // extern "C"
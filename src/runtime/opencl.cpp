@@ -783,59 +783,63 @@ WEAK int halide_opencl_copy_to_device(void *user_context, buffer_t* buf) {
 
     // TODO: Is this 32-bit or 64-bit? Leaving signed for now
     // in case negative strides.
-    for (int w = 0; w < (int)c.extent[3]; w++) {
-        for (int z = 0; z < (int)c.extent[2]; z++) {
+    for (uint64_t o = 0; o < c.outer_count(); o++) {
+        uint64_t outer = c.outer_offset(o);
+        for (int w = 0; w < (int)c.extent[3]; w++) {
+            for (int z = 0; z < (int)c.extent[2]; z++) {
 #ifdef ENABLE_OPENCL_11
-            // OpenCL 1.1 supports stride-aware memory transfers up to 3D, so we
-            // can deal with the 2 innermost strides with OpenCL.
-            uint64_t off = z * c.stride_bytes[2] + w * c.stride_bytes[3];
-
-            size_t offset[3] = { off, 0, 0 };
-            size_t region[3] = { c.chunk_size, c.extent[0], c.extent[1] };
-
-            debug(user_context)
-                << "    clEnqueueWriteBufferRect ((" << z << ", " << w << "), "
-                << "(" << (void *)c.src << " -> " << c.dst << ") + " << off << ", "
-                << (int)region[0] << "x" << (int)region[1] << "x" << (int)region[2] << " bytes, "
-                << c.stride_bytes[0] << "x" << c.stride_bytes[1] << ")\n";
-
-            cl_int err = clEnqueueWriteBufferRect(ctx.cmd_queue, (cl_mem)c.dst, CL_FALSE,
-                                                  offset, offset, region,
-                                                  c.stride_bytes[0], c.stride_bytes[1],
-                                                  c.stride_bytes[0], c.stride_bytes[1],
-                                                  (void *)c.src,
-                                                  0, NULL, NULL);
-
-            if (err != CL_SUCCESS) {
-                error(user_context) << "CL: clEnqueueWriteBufferRect failed: "
-                                    << get_opencl_error_name(err);
-                return err;
-            }
+                // OpenCL 1.1 supports stride-aware memory transfers up to 3D, so we
+                // can deal with the 2 innermost strides with OpenCL.
+                uint64_t off = outer + z * c.stride_bytes[2] + w * c.stride_bytes[3];
+
+                size_t offset[3] = { off, 0, 0 };
+                size_t region[3] = { c.chunk_size, c.extent[0], c.extent[1] };
+
+                debug(user_context)
+                    << "    clEnqueueWriteBufferRect ((" << z << ", " << w << "), "
+                    << "(" << (void *)c.src << " -> " << c.dst << ") + " << off << ", "
+                    << (int)region[0] << "x" << (int)region[1] << "x" << (int)region[2] << " bytes, "
+                    << c.stride_bytes[0] << "x" << c.stride_bytes[1] << ")\n";
+
+                cl_int err = clEnqueueWriteBufferRect(ctx.cmd_queue, (cl_mem)c.dst, CL_FALSE,
+                                                      offset, offset, region,
+                                                      c.stride_bytes[0], c.stride_bytes[1],
+                                                      c.stride_bytes[0], c.stride_bytes[1],
+                                                      (void *)c.src,
+                                                      0, NULL, NULL);
+
+                if (err != CL_SUCCESS) {
+                    error(user_context) << "CL: clEnqueueWriteBufferRect failed: "
+                                        << get_opencl_error_name(err);
+                    return err;
+                }
 #else
-            for (int y = 0; y < (int)c.extent[1]; y++) {
-                for (int x = 0; x < (int)c.extent[0]; x++) {
-                    uint64_t off = (x * c.stride_bytes[0] +
-                                    y * c.stride_bytes[1] +
-                                    z * c.stride_bytes[2] +
-                                    w * c.stride_bytes[3]);
-                    void *src = (void *)(c.src + off);
-                    void *dst = (void *)(c.dst + off);
-                    uint64_t size = c.chunk_size;
-
-                    debug(user_context)
-                        << "    clEnqueueWriteBuffer  ((" << x << ", " << y << ", " << z << ", " << w << "), "
-                        << size << " bytes, " << src << " -> " << (void *)dst << ")\n";
-
-                    cl_int err = clEnqueueWriteBuffer(ctx.cmd_queue, (cl_mem)c.dst,
-                                                      CL_FALSE, off, size, src, 0, NULL, NULL);
-                    if (err != CL_SUCCESS) {
-                        error(user_context) << "CL: clEnqueueWriteBuffer failed: "
-                                            << get_opencl_error_name(err);
-                        return err;
+                for (int y = 0; y < (int)c.extent[1]; y++) {
+                    for (int x = 0; x < (int)c.extent[0]; x++) {
+                        uint64_t off = (outer +
+                                        x * c.stride_bytes[0] +
+                                        y * c.stride_bytes[1] +
+                                        z * c.stride_bytes[2] +
+                                        w * c.stride_bytes[3]);
+                        void *src = (void *)(c.src + off);
+                        void *dst = (void *)(c.dst + off);
+                        uint64_t size = c.chunk_size;
+
+                        debug(user_context)
+                            << "    clEnqueueWriteBuffer  ((" << x << ", " << y << ", " << z << ", " << w << "), "
+                            << size << " bytes, " << src << " -> " << (void *)dst << ")\n";
+
+                        cl_int err = clEnqueueWriteBuffer(ctx.cmd_queue, (cl_mem)c.dst,
+                                                          CL_FALSE, off, size, src, 0, NULL, NULL);
+                        if (err != CL_SUCCESS) {
+                            error(user_context) << "CL: clEnqueueWriteBuffer failed: "
+                                                << get_opencl_error_name(err);
+                            return err;
+                        }
                     }
                 }
-            }
 #endif
+            }
         }
     }
     // The writes above are all non-blocking, so empty the command
@@ -875,59 +879,63 @@ WEAK int halide_opencl_copy_to_host(void *user_context, buffer_t* buf) {
 
     // TODO: Is this 32-bit or 64-bit? Leaving signed for now
     // in case negative strides.
-    for (int w = 0; w < (int)c.extent[3]; w++) {
-        for (int z = 0; z < (int)c.extent[2]; z++) {
+    for (uint64_t o = 0; o < c.outer_count(); o++) {
+        uint64_t outer = c.outer_offset(o);
+        for (int w = 0; w < (int)c.extent[3]; w++) {
+            for (int z = 0; z < (int)c.extent[2]; z++) {
 #ifdef ENABLE_OPENCL_11
-            // OpenCL 1.1 supports stride-aware memory transfers up to 3D, so we
-            // can deal with the 2 innermost strides with OpenCL.
-            uint64_t off = z * c.stride_bytes[2] + w * c.stride_bytes[3];
-
-            size_t offset[3] = { off, 0, 0 };
-            size_t region[3] = { c.chunk_size, c.extent[0], c.extent[1] };
-
-            debug(user_context)
-                << "    clEnqueueReadBufferRect ((" << z << ", " << w << "), "
-                << "(" << (void *)c.src << " -> " << (void *)c.dst << ") + " << off << ", "
-                << (int)region[0] << "x" << (int)region[1] << "x" << (int)region[2] << " bytes, "
-                << c.stride_bytes[0] << "x" << c.stride_bytes[1] << ")\n";
-
-            cl_int err = clEnqueueReadBufferRect(ctx.cmd_queue, (cl_mem)c.src, CL_FALSE,
-                                                 offset, offset, region,
-                                                 c.stride_bytes[0], c.stride_bytes[1],
-                                                 c.stride_bytes[0], c.stride_bytes[1],
-                                                 (void *)c.dst,
-                                                 0, NULL, NULL);
-
-            if (err != CL_SUCCESS) {
-                error(user_context) << "CL: clEnqueueReadBufferRect failed: "
-                                    << get_opencl_error_name(err);
-                return err;
-            }
+                // OpenCL 1.1 supports stride-aware memory transfers up to 3D, so we
+                // can deal with the 2 innermost strides with OpenCL.
+                uint64_t off = outer + z * c.stride_bytes[2] + w * c.stride_bytes[3];
+
+                size_t offset[3] = { off, 0, 0 };
+                size_t region[3] = { c.chunk_size, c.extent[0], c.extent[1] };
+
+                debug(user_context)
+                    << "    clEnqueueReadBufferRect ((" << z << ", " << w << "), "
+                    << "(" << (void *)c.src << " -> " << (void *)c.dst << ") + " << off << ", "
+                    << (int)region[0] << "x" << (int)region[1] << "x" << (int)region[2] << " bytes, "
+                    << c.stride_bytes[0] << "x" << c.stride_bytes[1] << ")\n";
+
+                cl_int err = clEnqueueReadBufferRect(ctx.cmd_queue, (cl_mem)c.src, CL_FALSE,
+                                                     offset, offset, region,
+                                                     c.stride_bytes[0], c.stride_bytes[1],
+                                                     c.stride_bytes[0], c.stride_bytes[1],
+                                                     (void *)c.dst,
+                                                     0, NULL, NULL);
+
+                if (err != CL_SUCCESS) {
+                    error(user_context) << "CL: clEnqueueReadBufferRect failed: "
+                                        << get_opencl_error_name(err);
+                    return err;
+                }
 #else
-            for (int y = 0; y < (int)c.extent[1]; y++) {
-                for (int x = 0; x < (int)c.extent[0]; x++) {
-                    uint64_t off = (x * c.stride_bytes[0] +
-                                    y * c.stride_bytes[1] +
-                                    z * c.stride_bytes[2] +
-                                    w * c.stride_bytes[3]);
-                    void *src = (void *)(c.src + off);
-                    void *dst = (void *)(c.dst + off);
-                    uint64_t size = c.chunk_size;
-
-                    debug(user_context)
-                        << "    clEnqueueReadBuffer  ((" << x << ", " << y << ", " << z << ", " << w << "), "
-                        << size << " bytes, " << src << " -> " << dst << ")\n";
-
-                    cl_int err = clEnqueueReadBuffer(ctx.cmd_queue, (cl_mem)c.src,
-                                                     CL_FALSE, off, size, dst, 0, NULL, NULL);
-                    if (err != CL_SUCCESS) {
-                        error(user_context) << "CL: clEnqueueReadBuffer failed: "
-                                            << get_opencl_error_name(err);
-                        return err;
+                for (int y = 0; y < (int)c.extent[1]; y++) {
+                    for (int x = 0; x < (int)c.extent[0]; x++) {
+                        uint64_t off = (outer +
+                                        x * c.stride_bytes[0] +
+                                        y * c.stride_bytes[1] +
+                                        z * c.stride_bytes[2] +
+                                        w * c.stride_bytes[3]);
+                        void *src = (void *)(c.src + off);
+                        void *dst = (void *)(c.dst + off);
+                        uint64_t size = c.chunk_size;
+
+                        debug(user_context)
+                            << "    clEnqueueReadBuffer  ((" << x << ", " << y << ", " << z << ", " << w << "), "
+                            << size << " bytes, " << src << " -> " << dst << ")\n";
+
+                        cl_int err = clEnqueueReadBuffer(ctx.cmd_queue, (cl_mem)c.src,
+                                                         CL_FALSE, off, size, dst, 0, NULL, NULL);
+                        if (err != CL_SUCCESS) {
+                            error(user_context) << "CL: clEnqueueReadBuffer failed: "
+                                                << get_opencl_error_name(err);
+                            return err;
+                        }
                     }
                 }
-            }
 #endif
+            }
         }
     }
     // The writes above are all non-blocking, so empty the command
@@ -48,6 +48,7 @@ extern "C" __attribute__((used)) void *halide_runtime_api_functions[] = {
     (void *)&halide_enumerate_registered_filters,
     (void *)&halide_error,
     (void *)&halide_error_access_out_of_bounds,
+    (void *)&halide_error_bad_dimensions,
     (void *)&halide_error_bad_elem_size,
     (void *)&halide_error_bad_fold,
     (void *)&halide_error_bounds_inference_call_failed,
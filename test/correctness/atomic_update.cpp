@@ -0,0 +1,92 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <algorithm>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int W = 256, H = 256;
+
+    Image<uint8_t> in(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            in(x, y) = rand() & 0xff;
+        }
+    }
+
+    // Compute the references serially.
+    int32_t ref_hist[256];
+    float ref_weighted[256];
+    int16_t ref_max[16];
+    for (int i = 0; i < 256; i++) {
+        ref_hist[i] = 0;
+        ref_weighted[i] = 0.0f;
+    }
+    for (int i = 0; i < 16; i++) {
+        ref_max[i] = -1;
+    }
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            ref_hist[in(x, y)] += 1;
+            // Small integers, so float addition is exact in any order.
+            ref_weighted[in(x, y)] += (float)(x & 7);
+            ref_max[in(x, y) & 15] = std::max(ref_max[in(x, y) & 15], (int16_t)(y + x));
+        }
+    }
+
+    Var x;
+    RDom r(in);
+
+    {
+        // A histogram. This lowers to an atomic add.
+        Func hist;
+        hist(x) = 0;
+        hist(cast<int>(in(r.x, r.y))) += 1;
+        hist.update().atomic().parallel(r.y);
+
+        Image<int32_t> result = hist.realize(256);
+        for (int i = 0; i < 256; i++) {
+            if (result(i) != ref_hist[i]) {
+                printf("hist(%d) = %d instead of %d\n", i, result(i), ref_hist[i]);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // A floating point histogram. This lowers to a compare-and-swap loop.
+        Func weighted;
+        weighted(x) = 0.0f;
+        weighted(cast<int>(in(r.x, r.y))) += cast<float>(r.x & 7);
+        weighted.update().atomic().parallel(r.y);
+
+        Image<float> result = weighted.realize(256);
+        for (int i = 0; i < 256; i++) {
+            if (result(i) != ref_weighted[i]) {
+                printf("weighted(%d) = %f instead of %f\n", i, result(i), ref_weighted[i]);
+                return -1;
+            }
+        }
+    }
+
+    {
+        // A scattered max over a narrow type.
+        Func m;
+        m(x) = cast<int16_t>(-1);
+        Expr site = cast<int>(in(r.x, r.y) & 15);
+        m(site) = max(m(site), cast<int16_t>(r.x + r.y));
+        RVar ryo, ryi;
+        m.update().atomic().split(r.y, ryo, ryi, 16).parallel(ryo);
+
+        Image<int16_t> result = m.realize(16);
+        for (int i = 0; i < 16; i++) {
+            if (result(i) != ref_max[i]) {
+                printf("m(%d) = %d instead of %d\n", i, result(i), ref_max[i]);
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
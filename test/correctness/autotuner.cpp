@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <string>
+#include "Halide.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    ImageParam input(Int(32), 2);
+    Func blur_x("blur_x"), blur_y("blur_y");
+    Var x("x"), y("y"), yi("yi");
+
+    blur_x(x, y) = input(x, y) + input(x+1, y) + input(x+2, y);
+    blur_y(x, y) = blur_x(x, y) + blur_x(x, y+1) + blur_x(x, y+2);
+
+    Image<int> in(131, 67);
+    for (int y = 0; y < in.height(); y++) {
+        for (int x = 0; x < in.width(); x++) {
+            in(x, y) = (x * 17 + y * 31) % 101;
+        }
+    }
+    input.set(in);
+    Image<int> out(in.width() - 2, in.height() - 2);
+
+    auto check = [&](Image<int> out) {
+        for (int y = 0; y < out.height(); y++) {
+            for (int x = 0; x < out.width(); x++) {
+                int correct = 0;
+                for (int dy = 0; dy < 3; dy++) {
+                    for (int dx = 0; dx < 3; dx++) {
+                        correct += in(x + dx, y + dy);
+                    }
+                }
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), correct);
+                    return false;
+                }
+            }
+        }
+        return true;
+    };
+
+    int schedules_applied = 0;
+    Autotuner tuner(blur_y, [&](const AutotuneConfig &c) {
+        schedules_applied++;
+        blur_y.split(y, y, yi, c["rows"]).parallel(y).vectorize(x, c["vec"]);
+        if (c["blur_x"] == 1) {
+            blur_x.compute_at(blur_y, y).vectorize(x, c["vec"]);
+        } else if (c["blur_x"] == 2) {
+            blur_x.store_at(blur_y, y).compute_at(blur_y, yi).vectorize(x, c["vec"]);
+        }
+    });
+    tuner.add_knob("rows", {4, 16})
+        .add_knob("vec", {4, 8})
+        .add_choice("blur_x", {"inline", "strip", "sliding"});
+
+    AutotuneOptions options;
+    options.samples = 1;
+    options.min_sample_time = 0;
+
+    // A grid search over a space smaller than the budget should visit
+    // every configuration exactly once.
+    options.strategy = AutotuneStrategy::Grid;
+    options.max_candidates = 100;
+    AutotuneResult r = tuner.tune(out, options);
+    if (r.candidates.size() != 12) {
+        printf("Grid search tried %d configurations instead of 12\n", (int)r.candidates.size());
+        return -1;
+    }
+
+    // The pipeline is left with the best schedule.
+    Image<int> result = Pipeline(blur_y).realize(out.width(), out.height());
+    if (!check(result)) {
+        return -1;
+    }
+
+    for (AutotuneStrategy strategy : {AutotuneStrategy::Random, AutotuneStrategy::Evolutionary}) {
+        options.strategy = strategy;
+        options.max_candidates = 8;
+        options.population = 3;
+        r = tuner.tune(out, options);
+        if (r.candidates.empty() || r.candidates.size() > 8) {
+            printf("Tried %d configurations with a budget of 8\n", (int)r.candidates.size());
+            return -1;
+        }
+        // The timings of schedules seen by the grid search are reused.
+        for (const AutotuneCandidate &c : r.candidates) {
+            if (c.compile_time != 0) {
+                printf("Recompiled %s\n", tuner.describe(c.config).c_str());
+                return -1;
+            }
+        }
+    }
+
+    // Timings are only reused for the same problem, so a smaller
+    // output, or an input of a different size, times the schedules
+    // again.
+    {
+        options.strategy = AutotuneStrategy::Grid;
+        options.max_candidates = 12;
+        Image<int> small_out(out.width() / 2, out.height() / 2);
+        r = tuner.tune(small_out, options);
+        for (const AutotuneCandidate &c : r.candidates) {
+            if (c.compile_time == 0) {
+                printf("Reused the timing of %s for a different output size\n", tuner.describe(c.config).c_str());
+                return -1;
+            }
+        }
+
+        Image<int> other_in(in.width() + 10, in.height());
+        input.set(other_in);
+        r = tuner.tune(out, options);
+        input.set(in);
+        for (const AutotuneCandidate &c : r.candidates) {
+            if (c.compile_time == 0) {
+                printf("Reused the timing of %s for a different input size\n", tuner.describe(c.config).c_str());
+                return -1;
+            }
+        }
+    }
+
+    // Applying a configuration starts from the original schedule, so
+    // the result doesn't depend on what was applied before.
+    AutotuneConfig c;
+    c.set("rows", 16);
+    c.set("vec", 4);
+    c.set("blur_x", 2);
+    std::string source = tuner.schedule_source(c);
+    c.set("blur_x", 0);
+    tuner.apply(c);
+    c.set("blur_x", 2);
+    if (tuner.schedule_source(c) != source) {
+        printf("Schedule source changed:\n%s\n", tuner.schedule_source(c).c_str());
+        return -1;
+    }
+    if (source.find(".compute_at(blur_y, yi)") == std::string::npos ||
+        source.find(".split(y, y, yi, 16)") == std::string::npos) {
+        printf("Unexpected schedule source:\n%s\n", source.c_str());
+        return -1;
+    }
+    if (schedules_applied < 12) {
+        printf("Schedule function called only %d times\n", schedules_applied);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -140,6 +140,38 @@ void check_mirror_interior(const Image<T> &input, Func f,
     }
 }
 
+// Check that padded_copy(f) matches f, both when the copy is computed
+// at root and when it's computed per tile of a consumer.
+template <typename T>
+void check_padded_copy(Func f,
+                       int test_min_x, int test_extent_x, int test_min_y, int test_extent_y,
+                       int vector_width) {
+    Image<T> correct(test_extent_x, test_extent_y);
+    correct.set_min(test_min_x, test_min_y);
+    lambda(x, y, f(x, y)).realize(correct);
+
+    for (int tiled = 0; tiled < 2; tiled++) {
+        Func padded = padded_copy(f, vector_width);
+        Func consumer;
+        consumer(x, y) = padded(x, y);
+        if (tiled) {
+            Var xi, yi;
+            consumer.tile(x, y, xi, yi, 16, 8);
+            padded.compute_at(consumer, x);
+        }
+
+        Image<T> result(test_extent_x, test_extent_y);
+        result.set_min(test_min_x, test_min_y);
+        consumer.realize(result);
+
+        for (int32_t y = test_min_y; y < test_min_y + test_extent_y; y++) {
+            for (int32_t x = test_min_x; x < test_min_x + test_extent_x; x++) {
+                assert(result(x, y) == correct(x, y));
+            }
+        }
+    }
+}
+
 int main(int argc, char **argv) {
 
     const int W = 32;
@@ -345,6 +377,21 @@ int main(int argc, char **argv) {
         }
     }
 
+    // padded_copy:
+    std::cout << "padded_copy\n";
+    {
+        const int32_t test_min = -25;
+        const int32_t test_extent = 100;
+
+        for (int vector_width : {1, 16}) {
+            check_padded_copy<uint8_t>(repeat_edge(input), test_min, test_extent, test_min, test_extent, vector_width);
+            check_padded_copy<uint8_t>(constant_exterior(input, (uint8_t)42), test_min, test_extent, test_min, test_extent, vector_width);
+            check_padded_copy<uint8_t>(repeat_image(input), test_min, test_extent, test_min, test_extent, vector_width);
+            check_padded_copy<uint8_t>(mirror_image(input), test_min, test_extent, test_min, test_extent, vector_width);
+            check_padded_copy<uint8_t>(mirror_interior(input), test_min, test_extent, test_min, test_extent, vector_width);
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -21,10 +21,16 @@ int main(int argc, char **argv) {
     CHECK(elem_size, 60, 64);
     CHECK(host_dirty, 64, 68);
     CHECK(dev_dirty, 65, 69);
-    CHECK(_padding, 66, 70);
+    CHECK(extra_dimensions, 66, 70);
+    CHECK(_padding, 67, 71);
 
     static_assert(sizeof(buffer_t) == 72, "size is wrong");
 
+    // The pointer to the dimensions beyond the fourth directly
+    // follows the buffer_t, which is where the compiled code
+    // expects to find it.
+    static_assert(offsetof(halide_nd_buffer_t, extra_dim) == sizeof(buffer_t), "extra_dim is in the wrong place");
+
     // Ensure alignment is at least that of a pointer.
     static_assert(ALIGN_OF(buffer_t) >= ALIGN_OF(uint8_t*), "align is wrong");
 
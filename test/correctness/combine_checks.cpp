@@ -0,0 +1,148 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <string>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// With Target::CombineChecks, the validation asserts should be folded
+// into a combined check, but report exactly the same errors.
+
+std::string error_message;
+void my_error_handler(void *user_context, const char *msg) {
+    error_message = msg;
+}
+
+// Count the asserts guarded by a combined check.
+int guarded_asserts = 0;
+class CountGuardedAsserts : public IRMutator {
+    using IRMutator::visit;
+
+    void visit(const IfThenElse *op) {
+        Stmt s = op->then_case;
+        while (const Block *b = s.as<Block>()) {
+            if (b->first.as<AssertStmt>()) {
+                guarded_asserts++;
+            }
+            s = b->rest;
+        }
+        IRMutator::visit(op);
+    }
+};
+
+int main(int argc, char **argv) {
+    ImageParam input(Int(32), 2, "input");
+    Param<int> k("k", 1, 0, 10);
+    input.set_min(0, 0);
+
+    Var x, y;
+    Func f[2];
+    for (int i = 0; i < 2; i++) {
+        f[i](x, y) = input(x, y) * k + input(x + 1, y);
+        f[i].set_error_handler(my_error_handler);
+    }
+    f[1].add_custom_lowering_pass(new CountGuardedAsserts);
+
+    Target t[2];
+    t[0] = get_jit_target_from_environment();
+    t[1] = t[0].with_feature(Target::CombineChecks);
+    f[0].compile_jit(t[0]);
+    f[1].compile_jit(t[1]);
+
+    if (guarded_asserts < 2) {
+        printf("Expected the asserts to be combined, but only %d are guarded\n", guarded_asserts);
+        return -1;
+    }
+
+    Image<int> good(33, 16), small(10, 10), shifted(33, 16);
+    for (int y = 0; y < 16; y++) {
+        for (int x = 0; x < 33; x++) {
+            good(x, y) = x + y;
+        }
+    }
+    shifted.set_min(1, 0);
+
+    struct Case {
+        const char *name;
+        Image<int> in;
+        int k;
+        bool should_fail;
+    } cases[] = {
+        {"valid", good, 3, false},
+        {"param too large", good, 20, true},
+        {"input too small", small, 3, true},
+        {"input shifted", shifted, 3, true},
+    };
+
+    for (const Case &c : cases) {
+        std::string messages[2];
+        for (int i = 0; i < 2; i++) {
+            input.set(c.in);
+            k.set(c.k);
+            error_message.clear();
+            Image<int> out(32, 16);
+            f[i].realize(out, t[i]);
+            messages[i] = error_message;
+
+            if (!c.should_fail) {
+                for (int y = 0; y < 16; y++) {
+                    for (int x = 0; x < 32; x++) {
+                        int correct = good(x, y) * c.k + good(x + 1, y);
+                        if (out(x, y) != correct) {
+                            printf("%s: out(%d, %d) = %d instead of %d\n",
+                                   c.name, x, y, out(x, y), correct);
+                            return -1;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (messages[0].empty() != !c.should_fail) {
+            printf("%s: unexpected result: \"%s\"\n", c.name, messages[0].c_str());
+            return -1;
+        }
+
+        if (messages[0] != messages[1]) {
+            printf("%s: combined checks reported:\n%s\ninstead of:\n%s\n",
+                   c.name, messages[1].c_str(), messages[0].c_str());
+            return -1;
+        }
+    }
+
+    {
+        // The bounds of g depend on a division by d, which is only
+        // safe once the check on d's range has passed. Combining the
+        // checks mustn't evaluate the division first.
+        Param<int> d("d", 1, 1, 10);
+        Func g[2];
+        for (int i = 0; i < 2; i++) {
+            g[i](x, y) = input(x / d, y);
+            g[i].set_error_handler(my_error_handler);
+            g[i].compile_jit(t[i]);
+        }
+
+        std::string messages[2];
+        for (int i = 0; i < 2; i++) {
+            input.set(good);
+            d.set(0);
+            error_message.clear();
+            Image<int> out(32, 16);
+            g[i].realize(out, t[i]);
+            messages[i] = error_message;
+        }
+
+        if (messages[0].empty()) {
+            printf("Dividing by zero wasn't caught by the check on d\n");
+            return -1;
+        }
+        if (messages[0] != messages[1]) {
+            printf("divisor check: combined checks reported:\n%s\ninstead of:\n%s\n",
+                   messages[1].c_str(), messages[0].c_str());
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
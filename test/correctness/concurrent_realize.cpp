@@ -0,0 +1,101 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    ImageParam input(Int(32), 2);
+    Param<int> offset;
+    Var x, y;
+
+    Func blur;
+    blur(x, y) = input(x, y) + input(x + 1, y) + offset;
+
+    Func out;
+    out(x, y) = blur(x, y) * 2 + blur(x, y + 1);
+    blur.compute_at(out, y).vectorize(x, 4);
+    out.parallel(y);
+
+    // Deliberately not compiled up front, so that the threads race to
+    // compile it too.
+    Pipeline p(out);
+
+    // A value left bound on the Params themselves, which the
+    // ParamMaps must override.
+    Image<int> unused(1, 1);
+    input.set(unused);
+    offset.set(-1000);
+
+    const int num_threads = 8;
+    const int iterations = 50;
+    const int W = 67, H = 33;
+    std::atomic<int> failures(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.push_back(std::thread([&, t]() {
+            Image<int> in(W + 1, H + 1), result(W, H);
+            ParamMap params;
+            params.set(input, in);
+            for (int i = 0; i < iterations; i++) {
+                int k = t * iterations + i;
+                for (int yy = 0; yy < in.height(); yy++) {
+                    for (int xx = 0; xx < in.width(); xx++) {
+                        in(xx, yy) = xx * k + yy;
+                    }
+                }
+                params.set(offset, k);
+
+                p.realize(result, params);
+
+                for (int yy = 0; yy < H; yy++) {
+                    for (int xx = 0; xx < W; xx++) {
+                        int b0 = in(xx, yy) + in(xx + 1, yy) + k;
+                        int b1 = in(xx, yy + 1) + in(xx + 1, yy + 1) + k;
+                        int correct = b0 * 2 + b1;
+                        if (result(xx, yy) != correct) {
+                            if (failures++ == 0) {
+                                printf("Thread %d, iteration %d: result(%d, %d) = %d instead of %d\n",
+                                       t, i, xx, yy, result(xx, yy), correct);
+                            }
+                            return;
+                        }
+                    }
+                }
+            }
+        }));
+    }
+
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    if (failures) {
+        return -1;
+    }
+
+    // The Params' own values are untouched, and still used when no
+    // ParamMap is given.
+    if (offset.get() != -1000 || input.get().raw_buffer() != unused.raw_buffer()) {
+        printf("Realizing with a ParamMap changed the Params\n");
+        return -1;
+    }
+    Image<int> in(W + 1, H + 1);
+    for (int yy = 0; yy < in.height(); yy++) {
+        for (int xx = 0; xx < in.width(); xx++) {
+            in(xx, yy) = 1;
+        }
+    }
+    input.set(in);
+    offset.set(0);
+    Image<int> result = p.realize(W, H);
+    if (result(3, 4) != 6) {
+        printf("result(3, 4) = %d instead of 6\n", result(3, 4));
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
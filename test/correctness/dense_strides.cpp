@@ -0,0 +1,84 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Count the dense and strided vector loads from a buffer.
+int dense_loads = 0, strided_loads = 0;
+class CountVectorLoads : public IRMutator {
+    using IRMutator::visit;
+
+    void visit(const Load *op) {
+        IRMutator::visit(op);
+        if (op->name == "input" && op->type.is_vector()) {
+            const Ramp *r = op->index.as<Ramp>();
+            if (r && is_one(r->stride)) {
+                dense_loads++;
+            } else {
+                strided_loads++;
+            }
+        }
+    }
+};
+
+int main(int argc, char **argv) {
+    const int W = 64, H = 16;
+
+    // An input with no constraint on its innermost stride.
+    ImageParam input(Float(32), 2, "input");
+    input.set_stride(0, Expr());
+
+    Var x, y;
+    Func f;
+    f(x, y) = input(x, y) * 2 + input(x + 1, y);
+    f.vectorize(x, 8);
+    f.add_custom_lowering_pass(new CountVectorLoads);
+
+    Target t = get_jit_target_from_environment().with_feature(Target::DenseStrides);
+    f.compile_jit(t);
+
+    if (dense_loads == 0 || strided_loads == 0) {
+        printf("Expected both a dense and a strided version of the loads: %d dense, %d strided\n",
+               dense_loads, strided_loads);
+        return -1;
+    }
+
+    // Run it on both a dense and an interleaved input.
+    Image<float> storage(2 * (W + 1), H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < 2 * (W + 1); x++) {
+            storage(x, y) = (float)(rand() & 0xff);
+        }
+    }
+
+    buffer_t strided_buf = *storage.raw_buffer();
+    strided_buf.extent[0] = W + 1;
+    strided_buf.stride[0] = 2;
+    Image<float> strided(Buffer(Float(32), &strided_buf));
+
+    Image<float> dense(W + 1, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W + 1; x++) {
+            dense(x, y) = storage(2 * x, y);
+        }
+    }
+
+    for (int i = 0; i < 2; i++) {
+        input.set(i == 0 ? dense : strided);
+        Image<float> out = f.realize(W, H, t);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                float correct = dense(x, y) * 2 + dense(x + 1, y);
+                if (out(x, y) != correct) {
+                    printf("out(%d, %d) = %f instead of %f (%s input)\n",
+                           x, y, out(x, y), correct, i == 0 ? "dense" : "strided");
+                    return -1;
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
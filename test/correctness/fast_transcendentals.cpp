@@ -0,0 +1,137 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include <functional>
+
+using namespace Halide;
+
+// Check the fast transcendental approximations against the double
+// precision versions from libm, at each precision tier, and check that
+// the worst-case errors are within what IROperator.h documents.
+
+const int N = 1 << 16;
+
+double ulp_of(double x) {
+    int e;
+    frexp(x, &e);
+    // Don't let the ulp drop below that of the smallest normal float.
+    return ldexp(1.0, std::max(e, -125) - 24);
+}
+
+double frand(double lo, double hi) {
+    return lo + (hi - lo) * (rand() / (double)RAND_MAX);
+}
+
+struct Test {
+    const char *name;
+    std::function<Expr(Expr, Expr, ApproximationPrecision)> fast;
+    std::function<double(double, double)> reference;
+    std::function<void(float &, float &)> make_input;
+    // Below this magnitude of the result, measure the error in ULPs
+    // of this magnitude instead, i.e. bound the absolute error. This
+    // is for the zeros of sin and cos.
+    double absolute_below;
+    double max_ulps[3];
+};
+
+bool test(const Test &t) {
+    Image<float> a(N), b(N);
+    for (int i = 0; i < N; i++) {
+        t.make_input(a(i), b(i));
+    }
+
+    const ApproximationPrecision tiers[] = {ApproximationPrecision::Low,
+                                            ApproximationPrecision::Medium,
+                                            ApproximationPrecision::High};
+    for (int tier = 0; tier < 3; tier++) {
+        Func f;
+        Var x;
+        f(x) = t.fast(a(x), b(x), tiers[tier]);
+        f.vectorize(x, 8);
+        Image<float> out = f.realize(N);
+
+        double worst = 0;
+        for (int i = 0; i < N; i++) {
+            double correct = t.reference(a(i), b(i));
+            double err = fabs(out(i) - correct);
+            double ulps = err / ulp_of(std::max(fabs(correct), t.absolute_below));
+            if (!(ulps <= t.max_ulps[tier])) {
+                printf("%s at tier %d: f(%.9g, %.9g) = %.9g instead of %.9g (%g ULPs)\n",
+                       t.name, tier, a(i), b(i), out(i), correct, ulps);
+                return false;
+            }
+            worst = std::max(worst, ulps);
+        }
+        printf("%s at tier %d: worst error %g ULPs\n", t.name, tier, worst);
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::vector<Test> tests = {
+        {"fast_sin",
+         [](Expr x, Expr y, ApproximationPrecision p) { return fast_sin(x, p); },
+         [](double x, double y) { return sin(x); },
+         [](float &x, float &y) { x = (float)frand(-1e4, 1e4); },
+         1e-2, {256, 32, 4}},
+        {"fast_cos",
+         [](Expr x, Expr y, ApproximationPrecision p) { return fast_cos(x, p); },
+         [](double x, double y) { return cos(x); },
+         [](float &x, float &y) { x = (float)frand(-1e4, 1e4); },
+         1e-2, {256, 32, 4}},
+        {"fast_sin near zeros",
+         [](Expr x, Expr y, ApproximationPrecision p) { return fast_sin(x, p); },
+         [](double x, double y) { return sin(x); },
+         [](float &x, float &y) { x = (float)(floor(frand(-100, 100)) * 3.14159265358979 + frand(-1e-3, 1e-3)); },
+         1e-2, {256, 32, 4}},
+        {"fast_atan2",
+         [](Expr y, Expr x, ApproximationPrecision p) { return fast_atan2(y, x, p); },
+         [](double y, double x) { return atan2(y, x); },
+         [](float &y, float &x) {
+             y = (float)(frand(-1, 1) * pow(10, frand(-3, 3)));
+             x = (float)(frand(-1, 1) * pow(10, frand(-3, 3)));
+         },
+         0, {640, 16, 4}},
+        {"fast_tanh",
+         [](Expr x, Expr y, ApproximationPrecision p) { return fast_tanh(x, p); },
+         [](double x, double y) { return tanh(x); },
+         [](float &x, float &y) { x = (float)(frand(-1, 1) * pow(10, frand(-4, 1.2))); },
+         0, {1024, 32, 3}},
+        {"fast_erf",
+         [](Expr x, Expr y, ApproximationPrecision p) { return fast_erf(x, p); },
+         [](double x, double y) { return erf(x); },
+         [](float &x, float &y) { x = (float)(frand(-1, 1) * pow(10, frand(-4, 0.7))); },
+         0, {512, 32, 8}},
+        {"fast_cbrt",
+         [](Expr x, Expr y, ApproximationPrecision p) { return fast_cbrt(x, p); },
+         [](double x, double y) { return cbrt(x); },
+         [](float &x, float &y) { x = (float)((rand() & 1 ? -1 : 1) * pow(10, frand(-37.9, 38.5))); },
+         0, {400, 10, 2}},
+    };
+
+    for (const Test &t : tests) {
+        if (!test(t)) {
+            return -1;
+        }
+    }
+
+    // Exact cases.
+    Func g;
+    Var x;
+    g(x) = Tuple(fast_sin(0.0f), fast_cos(0.0f), fast_atan2(0.0f, 0.0f),
+                 fast_tanh(0.0f), fast_erf(0.0f), fast_cbrt(0.0f));
+    Realization r = g.realize(1);
+    const float correct[] = {0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 6; i++) {
+        Image<float> out = r[i];
+        if (out(0) != correct[i]) {
+            printf("Output %d at zero is %f instead of %f\n", i, out(0), correct[i]);
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    if (!get_jit_target_from_environment().has_gpu_feature()) {
+        printf("Not running test because no gpu target enabled\n");
+        return 0;
+    }
+
+    // A five-dimensional input, copied to the device, and a
+    // five-dimensional output, copied back.
+    std::vector<int> sizes = {16, 8, 3, 2, 4};
+    Image<int> in(sizes);
+    std::vector<int> pos(5);
+    for (pos[4] = 0; pos[4] < sizes[4]; pos[4]++) {
+        for (pos[3] = 0; pos[3] < sizes[3]; pos[3]++) {
+            for (pos[2] = 0; pos[2] < sizes[2]; pos[2]++) {
+                for (pos[1] = 0; pos[1] < sizes[1]; pos[1]++) {
+                    for (pos[0] = 0; pos[0] < sizes[0]; pos[0]++) {
+                        in(pos) = pos[0] + 10 * pos[1] + 100 * pos[2] +
+                            1000 * pos[3] + 10000 * pos[4];
+                    }
+                }
+            }
+        }
+    }
+
+    ImageParam param(Int(32), 5);
+    param.set(in);
+
+    std::vector<Var> v(5);
+    std::vector<Expr> ve(v.begin(), v.end());
+    Func f;
+    f(v) = param(ve) * 2 + v[4];
+    f.gpu_tile(v[0], v[1], 8, 8);
+
+    Image<int> out(sizes);
+    f.realize(out);
+    out.copy_to_host();
+
+    for (pos[4] = 0; pos[4] < sizes[4]; pos[4]++) {
+        for (pos[3] = 0; pos[3] < sizes[3]; pos[3]++) {
+            for (pos[2] = 0; pos[2] < sizes[2]; pos[2]++) {
+                for (pos[1] = 0; pos[1] < sizes[1]; pos[1]++) {
+                    for (pos[0] = 0; pos[0] < sizes[0]; pos[0]++) {
+                        int correct = in(pos) * 2 + pos[4];
+                        if (out(pos) != correct) {
+                            printf("out(%d, %d, %d, %d, %d) = %d instead of %d\n",
+                                   pos[0], pos[1], pos[2], pos[3], pos[4], out(pos), correct);
+                            return -1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
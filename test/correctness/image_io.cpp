@@ -0,0 +1,135 @@
+#define HALIDE_NOPNG
+#include "../../tools/halide_image.h"
+#include "../../tools/halide_image_io.h"
+#include <stdio.h>
+
+using namespace Halide::Tools;
+
+template<typename T>
+bool check_equal(const Image<T> &a, const Image<T> &b, const char *what) {
+    if (a.dimensions() != b.dimensions()) {
+        printf("%s: dimensions %d instead of %d\n", what, b.dimensions(), a.dimensions());
+        return false;
+    }
+    for (int i = 0; i < a.dimensions(); i++) {
+        if (a.min(i) != b.min(i) || a.extent(i) != b.extent(i)) {
+            printf("%s: dimension %d is [%d, %d] instead of [%d, %d]\n", what, i,
+                   b.min(i), b.extent(i), a.min(i), a.extent(i));
+            return false;
+        }
+    }
+    for (int c = 0; c < a.channels(); c++) {
+        for (int y = 0; y < a.height(); y++) {
+            for (int x = 0; x < a.width(); x++) {
+                int xi = x + a.min(0);
+                int yi = a.dimensions() > 1 ? y + a.min(1) : 0;
+                int ci = a.dimensions() > 2 ? c + a.min(2) : 0;
+                if (a(xi, yi, ci) != b(xi, yi, ci)) {
+                    printf("%s: pixel (%d, %d, %d) differs\n", what, xi, yi, ci);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template<typename T>
+Image<T> make_image(int w, int h, int c, bool interleaved = false) {
+    Image<T> im(w, h, c > 1 ? c : 0, 0, interleaved);
+    for (int ci = 0; ci < c; ci++) {
+        for (int y = 0; y < h; y++) {
+            for (int x = 0; x < w; x++) {
+                im(x, y, ci) = (T)(x * 3 + y * 7 + ci * 11 + 1);
+            }
+        }
+    }
+    return im;
+}
+
+// Save an image, then check that both load() and load_mapped() give
+// back the same pixels.
+template<typename T>
+bool round_trip(Image<T> &im, const std::string &filename) {
+    if (!save(im, filename)) {
+        printf("Could not save %s\n", filename.c_str());
+        return false;
+    }
+
+    Image<T> loaded;
+    if (!load(filename, &loaded)) {
+        printf("Could not load %s\n", filename.c_str());
+        return false;
+    }
+    if (!check_equal(im, loaded, filename.c_str())) return false;
+
+    MappedImage mapped;
+    if (!load_mapped(filename, &mapped)) {
+        printf("Could not map %s\n", filename.c_str());
+        return false;
+    }
+    halide_type_t t = Internal::raw_type<T>();
+    if (mapped.type().code != t.code || mapped.type().bits != t.bits) {
+        printf("%s: mapped with the wrong type\n", filename.c_str());
+        return false;
+    }
+    Image<T> wrapped = mapped.image<Image<T>>();
+    if (!check_equal(im, wrapped, (filename + " (mapped)").c_str())) return false;
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string dir = "/tmp/";
+#ifdef _WIN32
+    dir = "";
+#endif
+
+    // PGM and PPM hold 8- and 16-bit samples. Mapping a 16-bit file
+    // byte-swaps it in place on little-endian machines.
+    {
+        Image<uint8_t> im = make_image<uint8_t>(37, 19, 1);
+        if (!round_trip(im, dir + "halide_image_io_8.pgm")) return -1;
+    }
+    {
+        Image<uint16_t> im = make_image<uint16_t>(37, 19, 1);
+        if (!round_trip(im, dir + "halide_image_io_16.pgm")) return -1;
+    }
+    {
+        // PPM files are interleaved, so load them into interleaved
+        // images to compare against the mapping.
+        Image<uint16_t> im = make_image<uint16_t>(23, 17, 3, true);
+        if (!round_trip(im, dir + "halide_image_io_16.ppm")) return -1;
+    }
+
+    // .hraw files keep the type, mins and dimensionality.
+    {
+        Image<float> im = make_image<float>(31, 13, 5);
+        im.set_min(-3, 4, 1);
+        if (!round_trip(im, dir + "halide_image_io_float.hraw")) return -1;
+    }
+    {
+        // A strided source image is packed densely when saved.
+        Image<int16_t> im = make_image<int16_t>(29, 11, 3, true);
+        if (!round_trip(im, dir + "halide_image_io_strided.hraw")) return -1;
+    }
+    {
+        Image<uint32_t> im(101);
+        for (int x = 0; x < 101; x++) {
+            im(x) = x * 12345;
+        }
+        if (!round_trip(im, dir + "halide_image_io_1d.hraw")) return -1;
+    }
+
+    // Loading a file as the wrong type must fail rather than reinterpret the pixels.
+    {
+        Image<uint8_t> wrong;
+        if (load_raw(dir + "halide_image_io_float.hraw", &wrong)) {
+            printf("Loaded a float .hraw file as uint8\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
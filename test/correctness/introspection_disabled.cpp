@@ -0,0 +1,29 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+#ifndef _WIN32
+    // The environment variable is read the first time introspection
+    // is needed, so setting it here still turns it off.
+    setenv("HL_DISABLE_INTROSPECTION", "1", 1);
+
+    Func f;
+    std::string name = Internal::Introspection::get_variable_name(&f, "Halide::Func");
+    if (!name.empty()) {
+        printf("Introspection found name %s despite being disabled\n", name.c_str());
+        return -1;
+    }
+
+    std::string loc = Internal::Introspection::get_source_location();
+    if (!loc.empty()) {
+        printf("Introspection found source location %s despite being disabled\n", loc.c_str());
+        return -1;
+    }
+#endif
+
+    printf("Success!\n");
+    return 0;
+}
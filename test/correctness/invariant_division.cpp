@@ -0,0 +1,103 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace Halide;
+
+// Vector division by a divisor that is constant in the vectorized
+// loop but not a compile-time constant is done with multiplies and
+// shifts, using numbers computed outside the loop. Check it against
+// Euclidean division done in 64 bits.
+
+template<typename T>
+bool test(int lanes) {
+    const int bits = sizeof(T) * 8;
+    const bool is_signed = (T)(-1) < (T)0;
+    const int64_t min_val = is_signed ? -((int64_t)1 << (bits - 1)) : 0;
+    const int64_t max_val = is_signed ? ((int64_t)1 << (bits - 1)) - 1 : ((int64_t)1 << bits) - 1;
+
+    const int W = 256, H = 4;
+    Image<T> input(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            input(x, y) = (T)(rand() ^ (rand() << 16));
+        }
+    }
+    // Make sure the extremes are in there.
+    input(0, 0) = (T)min_val;
+    input(1, 0) = (T)max_val;
+    input(2, 0) = (T)(min_val + 1);
+    input(3, 0) = 0;
+
+    // Some divisors vary with y, so that the magic numbers are
+    // computed at different loop levels.
+    Param<T> p;
+    Var x, y;
+    Func f;
+    Expr d = select(y % 2 == 0, p, p ^ cast<T>(y * 16));
+    f(x, y) = Tuple(input(x, y) / d, input(x, y) % d);
+    f.vectorize(x, lanes);
+
+    std::vector<int64_t> divisors = {1, 2, 3, 5, 7, 10, 127, 255, 1000, 65535, 65537,
+                                     max_val, max_val - 1, max_val / 2, max_val / 2 + 1};
+    if (is_signed) {
+        std::vector<int64_t> negative = {-1, -2, -3, -7, -128, -1000, min_val, min_val + 1};
+        divisors.insert(divisors.end(), negative.begin(), negative.end());
+    }
+    for (int i = 0; i < 20; i++) {
+        divisors.push_back((T)(rand() ^ (rand() << 16)));
+    }
+
+    for (int64_t divisor : divisors) {
+        bool nonzero = divisor != 0;
+        for (int yy = 1; yy < H; yy += 2) {
+            nonzero = nonzero && (T)(divisor ^ (yy * 16)) != 0;
+        }
+        if (divisor < min_val || divisor > max_val || !nonzero) {
+            continue;
+        }
+        p.set((T)divisor);
+        Realization r = f.realize(W, H);
+        Image<T> q = r[0], m = r[1];
+        for (int yy = 0; yy < H; yy++) {
+            int64_t b = (yy % 2 == 0) ? divisor : (int64_t)(T)(divisor ^ (yy * 16));
+            for (int xx = 0; xx < W; xx++) {
+                int64_t a = input(xx, yy);
+                if (is_signed && a == min_val && b == -1) continue;
+                int64_t correct_q = a / b, correct_m = a % b;
+                if (correct_m < 0) {
+                    correct_m += (b > 0) ? b : -b;
+                    correct_q += (b > 0) ? -1 : 1;
+                }
+                if (q(xx, yy) != (T)correct_q || m(xx, yy) != (T)correct_m) {
+                    printf("%s%d x %d: %lld / %lld = %lld, %lld instead of %lld, %lld\n",
+                           is_signed ? "int" : "uint", bits, lanes,
+                           (long long)a, (long long)b,
+                           (long long)q(xx, yy), (long long)m(xx, yy),
+                           (long long)correct_q, (long long)correct_m);
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool success = true;
+    success = success && test<int8_t>(16);
+    success = success && test<uint8_t>(16);
+    success = success && test<int16_t>(8);
+    success = success && test<uint16_t>(8);
+    success = success && test<int32_t>(4);
+    success = success && test<uint32_t>(4);
+    success = success && test<int32_t>(8);
+    success = success && test<uint32_t>(8);
+
+    if (!success) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
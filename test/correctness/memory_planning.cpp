@@ -0,0 +1,97 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+// With Target::PlanMemory, the compute_root intermediates of a
+// pipeline should be placed in a single allocation, in which those
+// with lifetimes that don't overlap share storage, without changing
+// the output.
+
+int mallocs = 0, frees = 0;
+size_t bytes_allocated = 0;
+
+void *my_malloc(void *user_context, size_t x) {
+    mallocs++;
+    bytes_allocated += x;
+    void *orig = malloc(x+32);
+    void *ptr = (void *)((((size_t)orig + 32) >> 5) << 5);
+    ((void **)ptr)[-1] = orig;
+    return ptr;
+}
+
+void my_free(void *user_context, void *ptr) {
+    frees++;
+    free(((void**)ptr)[-1]);
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(Float(32), 2, "input");
+    Var x, y;
+
+    // A chain of stages in which g's storage can be reused by k once
+    // h has consumed it.
+    Func out[2];
+    for (int i = 0; i < 2; i++) {
+        Func f, g, h, k;
+        f(x, y) = input(x, y) + 1;
+        g(x, y) = f(x - 1, y) + f(x + 1, y);
+        h(x, y) = g(x, y - 1) * g(x, y + 1);
+        k(x, y) = h(x - 1, y) - h(x + 1, y);
+        out[i](x, y) = k(x, y) + f(x, y);
+
+        f.compute_root();
+        g.compute_root().parallel(y);
+        h.compute_root();
+        k.compute_root().vectorize(x, 4);
+        out[i].set_custom_allocator(my_malloc, my_free);
+    }
+
+    const int W = 300, H = 200;
+    Image<float> in(W + 4, H + 2);
+    in.set_min(-2, -1);
+    for (int y = -1; y < H + 1; y++) {
+        for (int x = -2; x < W + 2; x++) {
+            in(x, y) = (float)((x * 17 + y * 31) % 101);
+        }
+    }
+    input.set(in);
+
+    Target t = get_jit_target_from_environment();
+    Image<float> correct = out[0].realize(W, H, t);
+    int separate_mallocs = mallocs;
+    size_t separate_bytes = bytes_allocated;
+
+    mallocs = frees = 0;
+    bytes_allocated = 0;
+    Image<float> planned = out[1].realize(W, H, t.with_feature(Target::PlanMemory));
+
+    if (mallocs != 1 || frees != 1) {
+        printf("Expected a single allocation with Target::PlanMemory, "
+               "but there were %d mallocs and %d frees (%d without it)\n",
+               mallocs, frees, separate_mallocs);
+        return -1;
+    }
+
+    // Each slot of the arena is at least as large as the allocation
+    // it replaces, so the arena can only be smaller than the separate
+    // allocations put together if g and k share a slot.
+    if (bytes_allocated >= separate_bytes) {
+        printf("The arena is %d bytes, but the separate allocations "
+               "only took %d bytes\n", (int)bytes_allocated, (int)separate_bytes);
+        return -1;
+    }
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (planned(x, y) != correct(x, y)) {
+                printf("planned(%d, %d) = %f instead of %f\n",
+                       x, y, planned(x, y), correct(x, y));
+                return -1;
+            }
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include "Halide.h"
+#include "../../tools/halide_image.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+// An extern stage over five-dimensional buffers. Dimensions past the
+// fourth live in the halide_nd_buffer_t the buffer_t belongs to.
+extern "C" DLLEXPORT int triple(buffer_t *in, buffer_t *out) {
+    int dims = halide_buffer_dimensions(out);
+    if (dims != 5 || halide_buffer_dimensions(in) != 5) {
+        printf("Extern stage expected five-dimensional buffers\n");
+        return -1;
+    }
+    if (!in->host) {
+        // Bounds query: we need the same region of the input.
+        for (int i = 0; i < 4; i++) {
+            in->min[i] = out->min[i];
+            in->extent[i] = out->extent[i];
+        }
+        halide_dimension_t *in_dim = ((halide_nd_buffer_t *)in)->extra_dim;
+        in_dim[0].min = halide_buffer_dim(out, 4).min;
+        in_dim[0].extent = halide_buffer_dim(out, 4).extent;
+        return 0;
+    }
+    int size = 1;
+    for (int i = 0; i < dims; i++) {
+        size *= halide_buffer_dim(out, i).extent;
+    }
+    for (int i = 0; i < size; i++) {
+        // Walk both buffers in storage order of out.
+        int in_idx = 0, out_idx = 0, rem = i;
+        for (int d = 0; d < dims; d++) {
+            halide_dimension_t od = halide_buffer_dim(out, d);
+            halide_dimension_t id = halide_buffer_dim(in, d);
+            int c = od.min + rem % od.extent;
+            rem /= od.extent;
+            out_idx += (c - od.min) * od.stride;
+            in_idx += (c - id.min) * id.stride;
+        }
+        ((int *)out->host)[out_idx] = 3 * ((int *)in->host)[in_idx];
+    }
+    return 0;
+}
+
+// Step to the next position in a buffer of the given extents. Returns
+// false after the last one.
+bool next_position(std::vector<int> &pos, const std::vector<int> &sizes) {
+    for (size_t i = 0; i < pos.size(); i++) {
+        if (++pos[i] < sizes[i]) {
+            return true;
+        }
+        pos[i] = 0;
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    // A six-dimensional input image.
+    std::vector<int> sizes = {5, 4, 3, 2, 3, 4};
+    Image<int> in(sizes);
+    std::vector<int> pos(6);
+    for (pos[5] = 0; pos[5] < sizes[5]; pos[5]++) {
+        for (pos[4] = 0; pos[4] < sizes[4]; pos[4]++) {
+            for (pos[3] = 0; pos[3] < sizes[3]; pos[3]++) {
+                for (pos[2] = 0; pos[2] < sizes[2]; pos[2]++) {
+                    for (pos[1] = 0; pos[1] < sizes[1]; pos[1]++) {
+                        for (pos[0] = 0; pos[0] < sizes[0]; pos[0]++) {
+                            in(pos) = pos[0] + 10 * pos[1] + 100 * pos[2] +
+                                1000 * pos[3] + 10000 * pos[4] + 100000 * pos[5];
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (in.dimensions() != 6 || in.extent(5) != 4 || in.stride(5) != 5 * 4 * 3 * 2 * 3) {
+        printf("Image has the wrong shape\n");
+        return -1;
+    }
+
+    ImageParam param(Int(32), 6);
+    param.set(in);
+
+    std::vector<Var> v(6);
+    std::vector<Expr> ve(v.begin(), v.end());
+
+    // Slice off the last dimension and hand the remaining five to an
+    // extern stage.
+    Func sliced;
+    std::vector<Var> v5(v.begin(), v.begin() + 5);
+    std::vector<Expr> args(v.begin(), v.begin() + 5);
+    args.push_back(1);
+    sliced(v5) = param(args);
+    sliced.compute_root();
+
+    Func tripled;
+    std::vector<ExternFuncArgument> extern_args = {sliced};
+    tripled.define_extern("triple", extern_args, Int(32), 5);
+    tripled.compute_root();
+
+    Func out;
+    std::vector<Expr> inner(ve.begin(), ve.begin() + 5);
+    out(v) = param(ve) + tripled(inner) + v[5];
+
+    Realization r = out.realize(std::vector<int32_t>(sizes.begin(), sizes.end()));
+    Image<int> result = r[0];
+    if (result.dimensions() != 6) {
+        printf("Output has %d dimensions instead of 6\n", result.dimensions());
+        return -1;
+    }
+
+    for (pos[5] = 0; pos[5] < sizes[5]; pos[5]++) {
+        for (pos[4] = 0; pos[4] < sizes[4]; pos[4]++) {
+            for (pos[3] = 0; pos[3] < sizes[3]; pos[3]++) {
+                for (pos[2] = 0; pos[2] < sizes[2]; pos[2]++) {
+                    for (pos[1] = 0; pos[1] < sizes[1]; pos[1]++) {
+                        for (pos[0] = 0; pos[0] < sizes[0]; pos[0]++) {
+                            std::vector<int> slice = pos;
+                            slice[5] = 1;
+                            int correct = in(pos) + 3 * in(slice) + pos[5];
+                            if (result(pos) != correct) {
+                                printf("result(%d, %d, %d, %d, %d, %d) = %d instead of %d\n",
+                                       pos[0], pos[1], pos[2], pos[3], pos[4], pos[5],
+                                       result(pos), correct);
+                                return -1;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // tools/halide_image.h can allocate and index images of more than
+    // four dimensions too.
+    Halide::Tools::Image<int> tools_in(sizes);
+    if (tools_in.dimensions() != 6 || tools_in.extent(5) != 4 || tools_in.stride(5) != in.stride(5)) {
+        printf("Tools::Image has the wrong shape\n");
+        return -1;
+    }
+    pos.assign(6, 0);
+    do {
+        tools_in(pos) = in(pos);
+    } while (next_position(pos, sizes));
+
+    // Run the pipeline on it, and read the output back through a
+    // Tools::Image wrapping it.
+    param.set(Image<int>((buffer_t *)tools_in));
+    Image<int> result2 = out.realize(std::vector<int32_t>(sizes.begin(), sizes.end()))[0];
+    const Halide::Tools::Image<int> tools_out(result2.raw_buffer());
+    if (tools_out.dimensions() != 6) {
+        printf("Tools::Image wrapping the output has %d dimensions instead of 6\n",
+               tools_out.dimensions());
+        return -1;
+    }
+    pos.assign(6, 0);
+    do {
+        if (tools_out(pos) != result(pos)) {
+            printf("tools_out(%d, %d, %d, %d, %d, %d) = %d instead of %d\n",
+                   pos[0], pos[1], pos[2], pos[3], pos[4], pos[5],
+                   tools_out(pos), result(pos));
+            return -1;
+        }
+    } while (next_position(pos, sizes));
+
+    printf("Success!\n");
+    return 0;
+}
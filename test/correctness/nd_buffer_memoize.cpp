@@ -0,0 +1,110 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+#ifdef _WIN32
+#define DLLEXPORT __declspec(dllexport)
+#else
+#define DLLEXPORT
+#endif
+
+int call_count = 0;
+
+// A five-dimensional extern stage that counts how often it runs.
+extern "C" DLLEXPORT int count_calls_5d(int32_t val, buffer_t *out) {
+    if (!out->host) {
+        return 0;
+    }
+    if (halide_buffer_dimensions(out) != 5) {
+        printf("Extern stage expected a five-dimensional buffer\n");
+        return -1;
+    }
+    call_count++;
+    int size = 1;
+    for (int i = 0; i < 5; i++) {
+        size *= halide_buffer_dim(out, i).extent;
+    }
+    for (int i = 0; i < size; i++) {
+        int idx = 0, coord_sum = 0, rem = i;
+        for (int d = 0; d < 5; d++) {
+            halide_dimension_t dim = halide_buffer_dim(out, d);
+            int c = dim.min + rem % dim.extent;
+            rem /= dim.extent;
+            idx += (c - dim.min) * dim.stride;
+            coord_sum += c;
+        }
+        ((int *)out->host)[idx] = val + coord_sum;
+    }
+    return 0;
+}
+
+int check(const Image<int> &im, int val) {
+    std::vector<int> pos(5);
+    for (pos[4] = 0; pos[4] < im.extent(4); pos[4]++) {
+        for (pos[3] = 0; pos[3] < im.extent(3); pos[3]++) {
+            for (pos[2] = 0; pos[2] < im.extent(2); pos[2]++) {
+                for (pos[1] = 0; pos[1] < im.extent(1); pos[1]++) {
+                    for (pos[0] = 0; pos[0] < im.extent(0); pos[0]++) {
+                        int correct = val + 2 * (pos[0] + pos[1] + pos[2] + pos[3] + pos[4]);
+                        if (im(pos) != correct) {
+                            printf("im(%d, %d, %d, %d, %d) = %d instead of %d\n",
+                                   pos[0], pos[1], pos[2], pos[3], pos[4], im(pos), correct);
+                            return -1;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    Param<int32_t> val;
+    std::vector<Var> v(5);
+    std::vector<Expr> ve(v.begin(), v.end());
+
+    Func f;
+    std::vector<ExternFuncArgument> extern_args = {val};
+    f.define_extern("count_calls_5d", extern_args, Int(32), 5);
+    f.compute_root().memoize();
+
+    Func g;
+    g(v) = f(ve) + v[0] + v[1] + v[2] + v[3] + v[4];
+
+    val.set(7);
+    Image<int> out1 = g.realize(std::vector<int32_t>{3, 4, 2, 2, 5});
+    Image<int> out2 = g.realize(std::vector<int32_t>{3, 4, 2, 2, 5});
+    if (check(out1, 7) || check(out2, 7)) {
+        return -1;
+    }
+    if (call_count != 1) {
+        printf("Extern stage ran %d times instead of once\n", call_count);
+        return -1;
+    }
+
+    // A region that only differs past the fourth dimension must not
+    // hit the cache.
+    Image<int> out3 = g.realize(std::vector<int32_t>{3, 4, 2, 2, 6});
+    if (check(out3, 7)) {
+        return -1;
+    }
+    if (call_count != 2) {
+        printf("Extern stage ran %d times instead of twice\n", call_count);
+        return -1;
+    }
+
+    // The first region should still be cached.
+    Image<int> out4 = g.realize(std::vector<int32_t>{3, 4, 2, 2, 5});
+    if (check(out4, 7)) {
+        return -1;
+    }
+    if (call_count != 2) {
+        printf("Extern stage ran %d times instead of twice\n", call_count);
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <algorithm>
+
+using namespace Halide;
+
+// Check the blocked parallel scans against the obvious serial
+// versions, including extents that aren't a multiple of the block
+// size.
+
+const int W = 1000, H = 37;
+
+template<typename T>
+bool check(const char *name, Image<T> result, Image<T> correct) {
+    for (int y = correct.top(); y <= correct.bottom(); y++) {
+        for (int x = correct.left(); x <= correct.right(); x++) {
+            if (result(x, y) != correct(x, y)) {
+                printf("%s(%d, %d) = %d instead of %d\n", name, x, y,
+                       (int)result(x, y), (int)correct(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Image<int> in(W, H);
+    Image<bool> starts(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            in(x, y) = (rand() % 201) - 100;
+            starts(x, y) = (rand() % 50) == 0;
+        }
+    }
+
+    Var x, y;
+    Func f, s;
+    f(x, y) = in(x, y);
+    s(x, y) = starts(x, y);
+
+    {
+        // A prefix sum along x, and along y.
+        Func serial_x, serial_y;
+        RDom rx(1, W - 1), ry(1, H - 1);
+        serial_x(x, y) = in(x, y);
+        serial_x(rx, y) += serial_x(rx - 1, y);
+        serial_y(x, y) = in(x, y);
+        serial_y(x, ry) += serial_y(x, ry - 1);
+
+        Image<int> correct_x = serial_x.realize(W, H), correct_y = serial_y.realize(W, H);
+
+        // Both unvectorized and vectorized.
+        for (int vector_width : {1, 8}) {
+            Func sum_x = prefix_sum(f, 0, 0, W, 64, vector_width);
+            Func sum_y = prefix_sum(f, 1, 0, H, 8, vector_width);
+
+            if (!check("sum_x", Image<int>(sum_x.realize(W, H)), correct_x)) return -1;
+            if (!check("sum_y", Image<int>(sum_y.realize(W, H)), correct_y)) return -1;
+        }
+    }
+
+    {
+        // One-dimensional scans, where the groups of blocks are what
+        // run in parallel. The segmented one can't use rfactor.
+        const int N = 100003;
+        Image<int> in_1d(N);
+        Image<bool> starts_1d(N);
+        for (int i = 0; i < N; i++) {
+            in_1d(i) = (rand() % 201) - 100;
+            starts_1d(i) = (rand() % 1000) == 0;
+        }
+        Func f_1d, s_1d;
+        f_1d(x) = in_1d(x);
+        s_1d(x) = starts_1d(x);
+
+        Image<int> correct(N), correct_segmented(N);
+        int acc = 0, acc_segmented = 0;
+        for (int i = 0; i < N; i++) {
+            acc += in_1d(i);
+            acc_segmented = (starts_1d(i) ? 0 : acc_segmented) + in_1d(i);
+            correct(i) = acc;
+            correct_segmented(i) = acc_segmented;
+        }
+
+        for (int vector_width : {1, 8}) {
+            Func sum = prefix_sum(f_1d, 0, 0, N, 64, vector_width);
+            Func segmented = segmented_prefix_sum(f_1d, s_1d, 0, 0, N, 64, vector_width);
+            if (!check("1-D sum", Image<int>(sum.realize(N)), correct)) return -1;
+            if (!check("1-D segmented sum", Image<int>(segmented.realize(N)), correct_segmented)) return -1;
+        }
+    }
+
+    {
+        // A running max along x, computed per row of a consumer.
+        Func serial;
+        RDom rx(1, W - 1);
+        serial(x, y) = in(x, y);
+        serial(rx, y) = max(serial(rx, y), serial(rx - 1, y));
+
+        Func running_max = scan(f, 0, 0, W, [](Expr a, Expr b) { return max(a, b); }, 100);
+        Func out;
+        out(x, y) = running_max(x, y) * 2;
+        running_max.compute_at(out, y);
+        out.parallel(y);
+
+        Image<int> correct = serial.realize(W, H);
+        Image<int> result = out.realize(W, H);
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                correct(x, y) *= 2;
+            }
+        }
+        if (!check("running max", result, correct)) return -1;
+    }
+
+    {
+        // A segmented sum along x.
+        Func serial;
+        RDom rx(1, W - 1);
+        serial(x, y) = in(x, y);
+        serial(rx, y) = select(starts(rx, y), serial(rx, y), serial(rx, y) + serial(rx - 1, y));
+
+        Func sum = segmented_prefix_sum(f, s, 0, 0, W, 64, 4);
+        if (!check("segmented sum", Image<int>(sum.realize(W, H)), Image<int>(serial.realize(W, H)))) return -1;
+    }
+
+    {
+        // A segmented sum along y over a sub-range with a non-zero min.
+        Image<int> correct(W, H - 5);
+        correct.set_min(0, 5);
+        for (int x = 0; x < W; x++) {
+            int acc = 0;
+            for (int y = 5; y < H; y++) {
+                acc = (starts(x, y) ? 0 : acc) + in(x, y);
+                correct(x, y) = acc;
+            }
+        }
+
+        Func sum = segmented_prefix_sum(f, s, 1, 5, H - 5, 4);
+        Image<int> result(W, H - 5);
+        result.set_min(0, 5);
+        sum.realize(result);
+        if (!check("segmented sum along y", result, correct)) return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+
+uint16_t input_value(int x, int y) {
+    return (uint16_t)((x * 7 + y * 13) & 0xff);
+}
+
+int main(int argc, char **argv) {
+    ImageParam input(UInt(16), 2, "input");
+    Var x("x"), y("y");
+
+    Func blur("blur");
+    blur(x, y) = (input(x - 1, y - 1) + input(x, y - 1) + input(x + 1, y - 1) +
+                  input(x - 1, y) + input(x, y) + input(x + 1, y) +
+                  input(x - 1, y + 1) + input(x, y + 1) + input(x + 1, y + 1));
+    blur.vectorize(x, 8).parallel(y);
+
+    // The whole input and output would take about 48MB, but no
+    // buffer handed to the callbacks may exceed this budget.
+    const int width = 4000, height = 3000, tile = 256;
+    const size_t budget = 256 * 1024;
+
+    for (TileOrder order : {TileOrder::RowMajor, TileOrder::ColumnMajor, TileOrder::Serpentine}) {
+        size_t pixels_read = 0, pixels_written = 0;
+        bool ok = true;
+
+        auto read = [&](const std::string &name, Buffer region) {
+            if (name != input.name()) {
+                printf("Asked to read unknown input %s\n", name.c_str());
+                ok = false;
+                return;
+            }
+            if ((size_t)region.extent(0) * region.extent(1) * 2 > budget) {
+                printf("Input region %dx%d exceeds the memory budget\n", region.extent(0), region.extent(1));
+                ok = false;
+                return;
+            }
+            Image<uint16_t> im(region);
+            for (int j = im.min(1); j < im.min(1) + im.extent(1); j++) {
+                for (int i = im.min(0); i < im.min(0) + im.extent(0); i++) {
+                    im(i, j) = input_value(i, j);
+                }
+            }
+            pixels_read += im.extent(0) * im.extent(1);
+        };
+
+        auto write = [&](Realization r) {
+            Image<uint16_t> out(r[0]);
+            if ((size_t)out.extent(0) * out.extent(1) * 2 > budget) {
+                printf("Output tile exceeds the memory budget\n");
+                ok = false;
+            }
+            for (int j = out.min(1); ok && j < out.min(1) + out.extent(1); j++) {
+                for (int i = out.min(0); i < out.min(0) + out.extent(0); i++) {
+                    uint16_t correct = 0;
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            correct += input_value(i + dx, j + dy);
+                        }
+                    }
+                    if (out(i, j) != correct) {
+                        printf("blur(%d, %d) = %d instead of %d\n", i, j, out(i, j), correct);
+                        ok = false;
+                        break;
+                    }
+                }
+            }
+            pixels_written += out.extent(0) * out.extent(1);
+        };
+
+        blur.realize_tiled({width, height}, {tile, tile}, read, write, order);
+
+        if (!ok) {
+            return -1;
+        }
+        if (pixels_written != (size_t)width * height) {
+            printf("Wrote %d pixels instead of %d\n", (int)pixels_written, width * height);
+            return -1;
+        }
+
+        // The overlap with the previous tile is never read twice. In
+        // serpentine order the previous tile is always adjacent, so
+        // only the halo shared with the tile on the other side is
+        // read again.
+        size_t input_pixels = (size_t)(width + 2) * (height + 2);
+        if (order == TileOrder::Serpentine && pixels_read > input_pixels * 1.02) {
+            printf("Read %d input pixels for an input of %d\n", (int)pixels_read, (int)input_pixels);
+            return -1;
+        }
+        if (pixels_read < input_pixels) {
+            printf("Read only %d input pixels for an input of %d\n", (int)pixels_read, (int)input_pixels);
+            return -1;
+        }
+    }
+
+    // The input is left unbound.
+    if (input.get().defined()) {
+        printf("Input was left bound\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
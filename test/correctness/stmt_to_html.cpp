@@ -1,5 +1,7 @@
 #include "Halide.h"
 #include <stdio.h>
+#include <fstream>
+#include <iterator>
 #ifndef _MSC_VER
 #include <unistd.h>
 #endif
@@ -52,6 +54,36 @@ int main() {
     assert(access(result_file_2, F_OK) == 0 && "Output file not created.");
     #endif
 
+    // Check overlaying a profile. The report is in the format printed
+    // by the runtime profiler.
+    const char *result_file_4 = "stmt_to_html_dump_4.html";
+    Func producer("producer"), consumer("consumer");
+    producer(x, y) = x * y;
+    consumer(x, y) = producer(x, y) + producer(x, y + 1);
+    producer.compute_at(consumer, y);
+    std::string report =
+        "consumer\n"
+        " total time: 100.000000 ms  samples: 100  runs: 10  time/run: 10.000000 ms\n"
+        " heap allocations: 20  peak heap usage: 4096 bytes\n"
+        "  producer:              7.500ms   (75%)   peak: 4096       num: 20        avg: 2048\n"
+        "  consumer:              2.500ms   (25%)  \n";
+    consumer.compile_to_profiled_html(result_file_4, {}, report);
+
+    std::ifstream html(result_file_4);
+    std::string contents((std::istreambuf_iterator<char>(html)), std::istreambuf_iterator<char>());
+    const char *expected[] = {
+        "7.5ms (75%), peak heap: 4096 bytes in 20 allocations",
+        "10ms (100%)",
+        "class=Heat",
+        "storage flattening"
+    };
+    for (const char *e : expected) {
+        if (contents.find(e) == std::string::npos) {
+            printf("Profiled HTML is missing \"%s\"\n", e);
+            return -1;
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
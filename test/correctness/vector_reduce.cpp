@@ -0,0 +1,136 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+
+using namespace Halide;
+
+// Vectorizing an atomic update over an RVar reduces the vector lanes
+// horizontally. Check that we get the same answers as the serial
+// updates.
+
+const int N = 1024;
+
+template<typename T>
+bool check(const char *name, Image<T> result, Image<T> correct) {
+    for (int i = 0; i < correct.width(); i++) {
+        if (result(i) != correct(i)) {
+            printf("%s(%d) = %f instead of %f\n", name, i, (double)result(i), (double)correct(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    Image<int16_t> a(N), b(N);
+    Image<uint8_t> bytes(N, 16);
+    Image<float> f(N);
+    for (int i = 0; i < N; i++) {
+        a(i) = (int16_t)(rand() - RAND_MAX / 2);
+        b(i) = (int16_t)(rand() - RAND_MAX / 2);
+        f(i) = (rand() & 0xfff) / 4096.0f;
+        for (int y = 0; y < 16; y++) {
+            bytes(i, y) = (uint8_t)rand();
+        }
+    }
+
+    Var x;
+    RDom r(0, N);
+
+    {
+        // A dot product of 16-bit vectors. This uses pmaddwd on x86.
+        Func serial, vec;
+        serial() = 0;
+        serial() += cast<int>(a(r)) * cast<int>(b(r));
+        vec() = 0;
+        vec() += cast<int>(a(r)) * cast<int>(b(r));
+        vec.update().atomic().vectorize(r, 16);
+
+        Image<int> correct = serial.realize(), result = vec.realize();
+        if (!check("dot", result, correct)) return -1;
+    }
+
+    {
+        // Sums of each row of bytes. This uses psadbw on x86.
+        Func serial, vec;
+        Var y;
+        serial(y) = 0;
+        serial(y) += cast<int>(bytes(r, y));
+        vec(y) = 0;
+        vec(y) += cast<int>(bytes(r, y));
+        vec.update().atomic().vectorize(r, 32).parallel(y);
+
+        Image<int> correct = serial.realize(16), result = vec.realize(16);
+        if (!check("row sums", result, correct)) return -1;
+    }
+
+    {
+        // A subtraction with an odd vector width, over an extent that
+        // it divides.
+        RDom r3(0, N - N % 3);
+        Func serial, vec;
+        serial() = cast<uint16_t>(1000);
+        serial() -= cast<uint16_t>(bytes(r3, 0));
+        vec() = cast<uint16_t>(1000);
+        vec() -= cast<uint16_t>(bytes(r3, 0));
+        RVar ro, ri;
+        vec.update().atomic().split(r3, ro, ri, 3).vectorize(ri);
+
+        Image<uint16_t> correct = serial.realize(), result = vec.realize();
+        if (!check("difference", result, correct)) return -1;
+    }
+
+    {
+        // Min and max.
+        Func mn, mx, mn_serial, mx_serial;
+        mn_serial() = cast<int16_t>(32767);
+        mn_serial() = min(mn_serial(), a(r));
+        mx_serial() = cast<int16_t>(-32768);
+        mx_serial() = max(mx_serial(), a(r));
+        mn() = cast<int16_t>(32767);
+        mn() = min(mn(), a(r));
+        mx() = cast<int16_t>(-32768);
+        mx() = max(mx(), a(r));
+        mn.update().atomic().vectorize(r, 8);
+        mx.update().atomic().vectorize(r, 16);
+
+        if (!check("min", Image<int16_t>(mn.realize()), Image<int16_t>(mn_serial.realize()))) return -1;
+        if (!check("max", Image<int16_t>(mx.realize()), Image<int16_t>(mx_serial.realize()))) return -1;
+    }
+
+    {
+        // A floating-point sum. The lanes get added in a different
+        // order, so allow for rounding error.
+        Func serial, vec;
+        serial() = 0.0f;
+        serial() += f(r);
+        vec() = 0.0f;
+        vec() += f(r);
+        vec.update().atomic().vectorize(r, 8);
+
+        Image<float> correct = serial.realize(), result = vec.realize();
+        if (fabs(result(0) - correct(0)) > 1e-3f * fabs(correct(0))) {
+            printf("float sum = %f instead of %f\n", result(0), correct(0));
+            return -1;
+        }
+    }
+
+    {
+        // A histogram. The lanes may update different sites, so each
+        // lane gets its own atomic update.
+        Func serial, vec;
+        serial(x) = 0;
+        serial(cast<int>(bytes(r, 0))) += 1;
+        vec(x) = 0;
+        vec(cast<int>(bytes(r, 0))) += 1;
+        RVar ro, ri;
+        vec.update().atomic().split(r, ro, ri, 64).parallel(ro).vectorize(ri, 8);
+
+        Image<int> correct = serial.realize(256), result = vec.realize(256);
+        if (!check("hist", result, correct)) return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -16,6 +16,8 @@
 #include "Reduction.h"
 #include "Interval.h"
 #include "Associativity.h"
+#include "CostReport.h"
+#include "Introspection.h"
 
 using namespace Halide;
 using namespace Halide::Internal;
@@ -37,6 +39,8 @@ int main(int argc, const char **argv) {
     split_predicate_test();
     interval_test();
     associativity_test();
+    cost_report_test();
+    Introspection::test();
 
     return 0;
 }
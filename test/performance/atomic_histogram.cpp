@@ -0,0 +1,66 @@
+#include "Halide.h"
+#include <cstdio>
+#include "benchmark.h"
+
+using namespace Halide;
+
+#define W 4096
+#define H 4096
+
+int main(int argc, char **argv) {
+    Image<uint8_t> in(W, H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            in(x, y) = rand() & 0xff;
+        }
+    }
+
+    Var x, u;
+    RDom r(in);
+
+    // Serial
+    Func serial;
+    serial(x) = 0;
+    serial(cast<int>(in(r.x, r.y))) += 1;
+
+    // Parallel using rfactor: one partial histogram per row
+    Func rfactored;
+    rfactored(x) = 0;
+    rfactored(cast<int>(in(r.x, r.y))) += 1;
+    Func intm = rfactored.update().rfactor(r.y, u);
+    intm.compute_root().update().parallel(u);
+
+    // Parallel using atomics: one shared histogram
+    Func atomic;
+    atomic(x) = 0;
+    atomic(cast<int>(in(r.x, r.y))) += 1;
+    RVar ryo, ryi;
+    atomic.update().atomic().split(r.y, ryo, ryi, 16).parallel(ryo);
+
+    Image<int> serial_out = serial.realize(256);
+    Image<int> rfactor_out = rfactored.realize(256);
+    Image<int> atomic_out = atomic.realize(256);
+
+    double serial_time = benchmark("atomic_histogram: serial", [&]() { serial.realize(serial_out); });
+    double rfactor_time = benchmark("atomic_histogram: rfactor", [&]() { rfactored.realize(rfactor_out); });
+    double atomic_time = benchmark("atomic_histogram: atomic", [&]() { atomic.realize(atomic_out); });
+
+    for (int i = 0; i < 256; i++) {
+        if (rfactor_out(i) != serial_out(i) || atomic_out(i) != serial_out(i)) {
+            printf("Mismatch in bucket %d: serial %d, rfactor %d, atomic %d\n",
+                   i, serial_out(i), rfactor_out(i), atomic_out(i));
+            return -1;
+        }
+    }
+
+    printf("Times (ms): serial %f, rfactor %f, atomic %f\n",
+           serial_time * 1e3, rfactor_time * 1e3, atomic_time * 1e3);
+
+    if (atomic_time > serial_time) {
+        fprintf(stderr, "WARNING: atomic histogram should be faster than serial\n");
+        return 0;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -53,7 +53,7 @@ Image<uint16_t> test_transpose(int mode) {
 
     output.realize(result);
 
-    double t = benchmark(1, 10, [&]() {
+    double t = benchmark("block_transpose: dummy func, " + algorithm, [&]() {
         output.realize(result);
     });
 
@@ -103,7 +103,7 @@ Image<uint16_t> test_transpose_wrap(int mode) {
 
     output.realize(result);
 
-    double t = benchmark(1, 10, [&]() {
+    double t = benchmark("block_transpose: wrapper, " + algorithm, [&]() {
         output.realize(result);
     });
 
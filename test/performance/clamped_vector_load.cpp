@@ -11,7 +11,7 @@ Image<uint16_t> output;
 #define MIN 1
 #define MAX 1020
 
-double test(Func f, bool test_correctness = true) {
+double test(Func f, const char *name, bool test_correctness = true) {
     f.compile_to_assembly(f.name() + ".s", {input}, f.name());
     f.compile_jit();
     f.realize(output);
@@ -31,7 +31,7 @@ double test(Func f, bool test_correctness = true) {
         }
     }
 
-    return benchmark(1, 10, [&]() { f.realize(output); });
+    return benchmark(std::string("clamped_vector_load: ") + name, [&]() { f.realize(output); });
 }
 
 int main(int argc, char **argv) {
@@ -59,7 +59,7 @@ int main(int argc, char **argv) {
 
         f.vectorize(x, 8);
 
-        t_ref = test(f, false);
+        t_ref = test(f, "unclamped", false);
     }
 
     {
@@ -73,7 +73,7 @@ int main(int argc, char **argv) {
         f.vectorize(x, 8);
         f.compile_to_lowered_stmt("debug_clamped_vector_load.stmt", f.infer_arguments());
 
-        t_clamped = test(f);
+        t_clamped = test(f, "clamped");
     }
 
     {
@@ -87,7 +87,7 @@ int main(int argc, char **argv) {
         f.vectorize(x, 8);
         g.compute_at(f, x);
 
-        t_scalar = test(f);
+        t_scalar = test(f, "scalar");
     }
 
     {
@@ -101,7 +101,7 @@ int main(int argc, char **argv) {
         f.vectorize(x, 8);
         g.compute_at(f, y);
 
-        t_pad = test(f);
+        t_pad = test(f, "padded");
     }
 
     // This constraint is pretty lax, because the op is so trivial
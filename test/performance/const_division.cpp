@@ -57,14 +57,17 @@ bool test(int w) {
     g.compile_jit();
     h.compile_jit();
 
+    std::string name = (std::string("const_division: ") + (is_signed ? "" : "u") +
+                        "int" + std::to_string(bits) + "_t x " + std::to_string(w));
+
     Image<T> correct = g.realize(input.width(), num_vals);
-    double t_correct = benchmark(1, 30, [&]() { g.realize(correct); });
+    double t_correct = benchmark(name + ", divide", [&]() { g.realize(correct); });
 
     Image<T> fast = f.realize(input.width(), num_vals);
-    double t_fast = benchmark(1, 30, [&]() { f.realize(fast); });
+    double t_fast = benchmark(name + ", constant divisor", [&]() { f.realize(fast); });
 
     Image<T> fast_dynamic = h.realize(input.width(), num_vals);
-    double t_fast_dynamic = benchmark(1, 30, [&]() { h.realize(fast_dynamic); });
+    double t_fast_dynamic = benchmark(name + ", fast_integer_divide", [&]() { h.realize(fast_dynamic); });
 
     printf("compile-time-constant divisor path is %1.3f x faster \n", t_correct / t_fast);
     printf("fast_integer_divide path is           %1.3f x faster \n", t_fast_dynamic / t_fast);
@@ -0,0 +1,91 @@
+#include "Halide.h"
+#include <cstdio>
+#include <cmath>
+#include <algorithm>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Compare the throughput of the fast polynomial approximations to
+// transcendental functions with the libm versions, which are called
+// one element at a time.
+
+Var x, y;
+
+// The input to each function: a smooth ramp over the given range.
+Expr input(float lo, float hi) {
+    return lo + (hi - lo) * ((x + y * 1024) / (1024.0f * 256.0f));
+}
+
+struct Comparison {
+    const char *name;
+    Expr slow, fast;
+    // Whether the slow version calls libm one element at a time, so
+    // that the fast one should beat it.
+    bool slow_is_scalar;
+};
+
+int main(int argc, char **argv) {
+    Expr a = input(-10.0f, 10.0f), b = input(0.01f, 5.0f);
+    std::vector<Comparison> comparisons = {
+        {"sin", sin(a), fast_sin(a), true},
+        {"cos", cos(a), fast_cos(a), true},
+        {"atan2", atan2(a, b), fast_atan2(a, b), true},
+        {"tanh", tanh(a), fast_tanh(a), true},
+        // pow and erf are already vectorizable, using exp and log, and
+        // a polynomial, respectively.
+        {"cbrt", pow(b, 1.0f / 3), fast_cbrt(b), false},
+        {"erf", erf(a), fast_erf(a), false},
+    };
+
+    // All profiling runs are done into the same buffer, to avoid
+    // cache weirdness.
+    Image<float> timing_scratch(1024, 256);
+    const int timing_N = timing_scratch.width() * timing_scratch.height();
+
+    bool success = true;
+    for (const Comparison &c : comparisons) {
+        Func slow, fast;
+        slow(x, y) = c.slow;
+        fast(x, y) = c.fast;
+        slow.vectorize(x, 8);
+        fast.vectorize(x, 8);
+        slow.compile_jit();
+        fast.compile_jit();
+
+        std::string name = std::string("fast_transcendentals: ") + c.name;
+        double t_slow = benchmark(name, [&]() { slow.realize(timing_scratch); });
+        double t_fast = benchmark(name + ", fast", [&]() { fast.realize(timing_scratch); });
+
+        Image<float> slow_out = slow.realize(1024, 256);
+        Image<float> fast_out = fast.realize(1024, 256);
+        double max_err = 0;
+        for (int yy = 0; yy < 256; yy++) {
+            for (int xx = 0; xx < 1024; xx++) {
+                max_err = std::max(max_err, (double)std::abs(slow_out(xx, yy) - fast_out(xx, yy)));
+            }
+        }
+
+        printf("%s: %f ns per pixel\n"
+               "fast_%s: %f ns per pixel (%1.3f x faster, max abs error = %g)\n",
+               c.name, 1e9 * t_slow / timing_N,
+               c.name, 1e9 * t_fast / timing_N, t_slow / t_fast, max_err);
+
+        if (max_err > 1e-5) {
+            printf("Error for fast_%s too large\n", c.name);
+            success = false;
+        }
+
+        if (c.slow_is_scalar && t_slow < t_fast) {
+            printf("%s is faster than fast_%s\n", c.name, c.name);
+            success = false;
+        }
+    }
+
+    if (!success) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
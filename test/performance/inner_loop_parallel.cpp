@@ -26,7 +26,8 @@ int main(int argc, char **argv) {
         // Start the thread pool without giving any hints as to the
         // number of tasks we'll be using.
         f.realize(t, 1);
-        double min_time = benchmark(3, 1, [&]() { return f.realize(2, 1000000); });
+        double min_time = benchmark("inner_loop_parallel: " + std::to_string(t) + " threads",
+                                    [&]() { return f.realize(2, 1000000); });
 
         printf("%d: %f ms\n", t, min_time * 1e3);
         if (t == 2) {
@@ -48,8 +48,6 @@ int main(int argc, char **argv) {
 
     matrix_mul.compile_jit();
 
-    const int iterations = 50;
-
     Image<float> mat_A(matrix_size, matrix_size);
     Image<float> mat_B(matrix_size, matrix_size);
     Image<float> output(matrix_size, matrix_size);
@@ -67,7 +65,7 @@ int main(int argc, char **argv) {
 
     matrix_mul.realize(output);
 
-    double t = benchmark(1, iterations, [&]() {
+    double t = benchmark("matrix_multiplication", [&]() {
         matrix_mul.realize(output);
     });
 
@@ -35,7 +35,10 @@ double test_copy(Image<uint8_t> src, Image<uint8_t> dst) {
 
     f.realize(dst);
 
-    return benchmark(5, 10, [&]() { return f.realize(dst); });
+    std::string name = (std::string("packed_planar_fusion: ") +
+                        (src.stride(0) == 1 ? "planar" : "packed") + " to " +
+                        (dst.stride(0) == 1 ? "planar" : "packed"));
+    return benchmark(name, [&]() { return f.realize(dst); });
 }
 
 Image<uint8_t> make_packed(uint8_t *host, int W, int H) {
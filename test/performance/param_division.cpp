@@ -0,0 +1,101 @@
+#include "Halide.h"
+#include <cstdio>
+#include <cstdint>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Compare vector division by a Param, which is done with multiplies
+// and shifts by numbers computed once outside the loop, with division
+// by a compile-time constant (see const_division.cpp) and with the
+// same division done one element at a time.
+template<typename T>
+bool test(int w) {
+    Func f, g, h;
+    Var x, y;
+
+    size_t bits = sizeof(T)*8;
+    bool is_signed = (T)(-1) < (T)(0);
+
+    printf("Testing %sint%d_t x %d\n",
+           is_signed ? "" : "u",
+           (int)bits, w);
+
+    Image<T> input(w * 1024, 64);
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            uint32_t bits = rand() ^ (rand() << 16);
+            input(x, y) = (T)bits;
+        }
+    }
+
+    const T divisor = 7;
+    Param<T> p;
+    p.set(divisor);
+
+    // Vectorized division by a Param
+    f(x, y) = input(x, y) / p;
+    f.vectorize(x, w);
+
+    // Vectorized division by a constant
+    g(x, y) = input(x, y) / cast<T>((int)divisor);
+    g.vectorize(x, w);
+
+    // Scalar division by a Param
+    h(x, y) = input(x, y) / p;
+
+    f.compile_jit();
+    g.compile_jit();
+    h.compile_jit();
+
+    std::string name = (std::string("param_division: ") + (is_signed ? "" : "u") +
+                        "int" + std::to_string(bits) + "_t x " + std::to_string(w));
+
+    Image<T> param_out = f.realize(input.width(), input.height());
+    double t_param = benchmark(name + ", param divisor", [&]() { f.realize(param_out); });
+
+    Image<T> const_out = g.realize(input.width(), input.height());
+    double t_const = benchmark(name + ", constant divisor", [&]() { g.realize(const_out); });
+
+    Image<T> scalar_out = h.realize(input.width(), input.height());
+    double t_scalar = benchmark(name + ", scalar", [&]() { h.realize(scalar_out); });
+
+    printf("param divisor path is %1.3f x faster than scalar division\n", t_scalar / t_param);
+    printf("constant divisor path is %1.3f x faster than the param divisor path\n", t_param / t_const);
+
+    for (int y = 0; y < input.height(); y++) {
+        for (int x = 0; x < input.width(); x++) {
+            if (param_out(x, y) != const_out(x, y) ||
+                param_out(x, y) != scalar_out(x, y)) {
+                printf("param_out(%d, %d) = %lld instead of %lld (%lld/%d)\n",
+                       x, y,
+                       (long long int)param_out(x, y),
+                       (long long int)const_out(x, y),
+                       (long long int)input(x, y),
+                       (int)divisor);
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    bool success = true;
+    success = success && test<int32_t>(4);
+    success = success && test<int16_t>(8);
+    success = success && test<int8_t>(16);
+    success = success && test<uint32_t>(4);
+    success = success && test<uint16_t>(8);
+    success = success && test<uint8_t>(16);
+    success = success && test<int32_t>(8);
+    success = success && test<uint32_t>(8);
+
+    if (success) {
+        printf("Success!\n");
+        return 0;
+    } else {
+        return -1;
+    }
+}
@@ -0,0 +1,71 @@
+#include "Halide.h"
+#include <cstdio>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Measure how long it takes to lower a deep pyramid pipeline, which
+// stresses bounds inference. Each level is a downsample, an upsample
+// and a difference, giving three stages per level.
+
+Var x, y;
+
+Func downsample(Func f) {
+    Func down;
+    down(x, y) = (f(2*x - 1, y) + 2 * f(2*x, y) + f(2*x + 1, y) +
+                  f(2*x, y - 1) + f(2*x, y + 1)) / 6;
+    return down;
+}
+
+Func upsample(Func f) {
+    Func up;
+    up(x, y) = 0.25f * f(x/2 - 1 + 2*(x % 2), y/2) + 0.75f * f(x/2, y/2);
+    return up;
+}
+
+int main(int argc, char **argv) {
+    const int levels = 8;
+
+    ImageParam input(Float(32), 2);
+
+    Func clamped = BoundaryConditions::repeat_edge(input);
+
+    Func gaussian[levels];
+    Func laplacian[levels];
+    gaussian[0](x, y) = clamped(x, y);
+    for (int j = 1; j < levels; j++) {
+        gaussian[j] = downsample(gaussian[j-1]);
+    }
+    laplacian[levels-1](x, y) = gaussian[levels-1](x, y);
+    for (int j = levels - 2; j >= 0; j--) {
+        Func up = upsample(gaussian[j+1]);
+        laplacian[j](x, y) = gaussian[j](x, y) - up(x, y);
+        up.compute_at(laplacian[j], y);
+    }
+
+    // Collapse the pyramid again.
+    Func collapsed[levels];
+    collapsed[levels-1](x, y) = laplacian[levels-1](x, y);
+    for (int j = levels - 2; j >= 0; j--) {
+        collapsed[j](x, y) = upsample(collapsed[j+1])(x, y) + laplacian[j](x, y);
+    }
+
+    for (int j = 0; j < levels; j++) {
+        gaussian[j].compute_root().vectorize(x, 8);
+        laplacian[j].compute_root().vectorize(x, 8);
+        if (j > 0) {
+            collapsed[j].compute_root().vectorize(x, 8);
+        }
+    }
+    collapsed[0].parallel(y).vectorize(x, 8);
+
+    Target t = get_jit_target_from_environment();
+    double t_lower = benchmark("pyramid_compile_time", [&]() {
+        collapsed[0].compile_to_module({input}, "pyramid", t);
+    });
+
+    printf("Lowering a pyramid pipeline with %d levels took %f ms\n", levels, t_lower * 1e3);
+
+    printf("Success!\n");
+    return 0;
+}
@@ -23,9 +23,6 @@ void test_deinterleave() {
     dst.reorder(c, x, y).unroll(c);
     dst.vectorize(x, 16);
 
-    // Run test many times to avoid timing jitter
-    const int iterations = 20;
-
     // Allocate two 16 megapixel, 3 channel, 8-bit images -- input and output
     const int32_t buffer_side_length = (1 << 12);
     const int32_t buffer_size = buffer_side_length * buffer_side_length;
@@ -77,7 +74,7 @@ void test_deinterleave() {
     // Warm up caches, etc.
     dst.realize(dst_image);
 
-    double t1 = benchmark(1, iterations, [&]() {
+    double t1 = benchmark("rgb_interleaved: interleaved to planar", [&]() {
         dst.realize(dst_image);
     });
 
@@ -104,7 +101,7 @@ void test_deinterleave() {
 
     memset(dst_storage, 0, buffer_size);
 
-    double t2 = benchmark(1, iterations, [&]() {
+    double t2 = benchmark("rgb_interleaved: interleaved to semi-planar", [&]() {
         dst.realize(dst_image);
     });
 
@@ -145,9 +142,6 @@ void test_interleave(bool fast) {
         dst.reorder(c, x, y).vectorize(x, 16);
     }
 
-    // Run test many times to avoid timing jitter
-    const int iterations = 20;
-
     // Allocate two 16 megapixel, 3 channel, 8-bit images -- input and output
     const int32_t buffer_side_length = (1 << 12);
     const int32_t buffer_size = buffer_side_length * buffer_side_length;
@@ -204,7 +198,7 @@ void test_interleave(bool fast) {
     // Warm up caches, etc.
     dst.realize(dst_image);
 
-    double t = benchmark(1, iterations, [&]() {
+    double t = benchmark(std::string("rgb_interleaved: planar to interleaved") + (fast ? ", fast" : ""), [&]() {
         dst.realize(dst_image);
     });
 
@@ -156,7 +156,7 @@ int main(int argc, char **argv) {
     printf("Running...\n");
     Image<int> bitonic_sorted(N);
     f.realize(bitonic_sorted);
-    double t_bitonic = benchmark(1, 10, [&]() {
+    double t_bitonic = benchmark("sort: bitonic", [&]() {
         f.realize(bitonic_sorted);
     });
 
@@ -167,7 +167,7 @@ int main(int argc, char **argv) {
     printf("Running...\n");
     Image<int> merge_sorted(N);
     f.realize(merge_sorted);
-    double t_merge = benchmark(1, 10, [&]() {
+    double t_merge = benchmark("sort: merge", [&]() {
         f.realize(merge_sorted);
     });
 
@@ -176,6 +176,7 @@ int main(int argc, char **argv) {
         correct(i) = data(i);
     }
     printf("std::sort...\n");
+    // This sorts in place, so only the first run is meaningful.
     double t_std = benchmark(1, 1, [&]() {
         std::sort(&correct(0), &correct(N));
     });
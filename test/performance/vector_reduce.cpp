@@ -0,0 +1,126 @@
+#include "Halide.h"
+#include <cstdio>
+#include "benchmark.h"
+
+using namespace Halide;
+
+// Compare reductions vectorized over the RDom, which reduce the
+// vector lanes horizontally (pmaddwd, psadbw, vpadd, etc), with the
+// ways of writing them that were available before.
+//
+// The float dot product and matrix-vector product baselines use the
+// schedules of the sdot and transposed sgemv generators in
+// apps/linear_algebra: a vector of partial sums per lane, summed
+// across the lanes at the end. They are reproduced here rather than
+// run through the app, whose benchmarks need BLAS and Eigen.
+
+const int N = 1 << 14;
+const int rows = 256;
+const int vec_size = 8;
+
+struct Comparison {
+    const char *name;
+    const char *baseline_name;
+    Func baseline, vec;
+    int extent;
+};
+
+int main(int argc, char **argv) {
+    Image<int16_t> a(N), b(N);
+    Image<float> fa(N), fb(N), mat(N, rows), vec_in(N);
+    Image<uint8_t> bytes(N + 64);
+    for (int i = 0; i < N; i++) {
+        a(i) = (int16_t)(rand() & 0xfff);
+        b(i) = (int16_t)(rand() & 0xfff);
+        fa(i) = (rand() & 0xff) / 256.0f;
+        fb(i) = (rand() & 0xff) / 256.0f;
+        vec_in(i) = (rand() & 0xff) / 256.0f;
+        for (int y = 0; y < rows; y++) {
+            mat(i, y) = (rand() & 0xff) / 256.0f;
+        }
+    }
+    for (int i = 0; i < N + 64; i++) {
+        bytes(i) = (uint8_t)rand();
+    }
+
+    Var x, lane;
+    RDom r(0, N), w(0, 64), k(0, N / vec_size), lanes(0, vec_size);
+
+    std::vector<Comparison> comparisons;
+
+    {
+        // A dot product of 16-bit vectors, against the serial sum.
+        Func serial, vec;
+        serial() = 0;
+        serial() += cast<int>(a(r)) * cast<int>(b(r));
+        vec() = 0;
+        vec() += cast<int>(a(r)) * cast<int>(b(r));
+        vec.update().atomic().vectorize(r, 16);
+        comparisons.push_back({"int16 dot", "serial", serial, vec, 1});
+    }
+
+    {
+        // A float dot product, against the sdot schedule.
+        Func partial, app, vec;
+        partial(lane) = 0.0f;
+        partial(lane) += fa(k * vec_size + lane) * fb(k * vec_size + lane);
+        app() = sum(partial(lanes));
+        partial.compute_root().vectorize(lane);
+        partial.update().vectorize(lane);
+
+        vec() = 0.0f;
+        vec() += fa(r) * fb(r);
+        vec.update().atomic().vectorize(r, vec_size);
+        comparisons.push_back({"float dot", "sdot schedule", app, vec, 1});
+    }
+
+    {
+        // A matrix-vector product summing along the rows of the
+        // matrix, against the transposed sgemv schedule.
+        Func partial, app, vec;
+        partial(lane, x) = 0.0f;
+        partial(lane, x) += mat(k * vec_size + lane, x) * vec_in(k * vec_size + lane);
+        app(x) = sum(partial(lanes, x));
+        partial.compute_at(app, x).vectorize(lane);
+        partial.update().vectorize(lane);
+
+        vec(x) = 0.0f;
+        vec(x) += mat(r, x) * vec_in(r);
+        vec.update().atomic().vectorize(r, vec_size);
+        comparisons.push_back({"gemv", "sgemv schedule", app, vec, rows});
+    }
+
+    {
+        // A box filter sum over a 64-wide window of bytes, against the
+        // serial sum.
+        Func serial, vec;
+        serial(x) = cast<uint16_t>(0);
+        serial(x) += cast<uint16_t>(bytes(x + w));
+        vec(x) = cast<uint16_t>(0);
+        vec(x) += cast<uint16_t>(bytes(x + w));
+        vec.update().atomic().vectorize(w, 32);
+        comparisons.push_back({"box sum", "serial", serial, vec, N});
+    }
+
+    for (Comparison &c : comparisons) {
+        c.baseline.compile_jit();
+        c.vec.compile_jit();
+
+        Realization baseline_out = c.baseline.realize(c.extent);
+        Realization vec_out = c.vec.realize(c.extent);
+
+        std::string name = std::string("vector_reduce: ") + c.name;
+        double t_baseline = benchmark(name + ", " + c.baseline_name, [&]() { c.baseline.realize(baseline_out); });
+        double t_vec = benchmark(name + ", vectorized", [&]() { c.vec.realize(vec_out); });
+
+        printf("%s: %s %f ms, vectorized %f ms (%1.3f x faster)\n",
+               c.name, c.baseline_name, t_baseline * 1e3, t_vec * 1e3, t_baseline / t_vec);
+
+        if (t_vec > t_baseline) {
+            fprintf(stderr, "WARNING: vectorized %s should be faster than the %s\n", c.name, c.baseline_name);
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
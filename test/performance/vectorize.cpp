@@ -52,10 +52,11 @@ bool test(int vec_width) {
     Image<A> outputg = g.realize(W, H);
     Image<A> outputf = f.realize(W, H);
 
-    double t_g = benchmark(1, 10, [&]() {
+    std::string name = std::string("vectorize: ") + string_of_type<A>() + " x " + std::to_string(vec_width);
+    double t_g = benchmark(name + ", scalar", [&]() {
         g.realize(outputg);
     });
-    double t_f = benchmark(1, 10, [&]() {
+    double t_f = benchmark(name + ", vectorized", [&]() {
         f.realize(outputf);
     });
 
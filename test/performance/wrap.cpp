@@ -129,17 +129,17 @@ int main(int argc, char **argv) {
     Buffer buf2(out2);
     Buffer buf3(out3);
 
-    double shared_time = benchmark(5, 5, [&]() {
+    double shared_time = benchmark("wrap: shared", [&]() {
             use_shared.realize(buf1);
             buf1.device_sync();
         });
 
-    double l1_time = benchmark(5, 5, [&]() {
+    double l1_time = benchmark("wrap: l1", [&]() {
             use_l1.realize(buf2);
             buf2.device_sync();
         });
 
-    double wrap_time = benchmark(5, 5, [&]() {
+    double wrap_time = benchmark("wrap: wrap for shared", [&]() {
             use_wrap_for_shared.realize(buf3);
             buf3.device_sync();
         });
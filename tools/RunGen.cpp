@@ -0,0 +1,472 @@
+// A generic benchmarking driver for AOT-compiled filters. Link this
+// against one or more static libraries produced by a Generator with
+// the register_metadata target feature (and a runtime), e.g.
+//
+//    g++ -std=c++11 RunGen.cpp -I <halide>/include -Wl,--whole-archive my_filter.a -Wl,--no-whole-archive runtime.a -lpthread -ldl -lpng -lz
+//
+// (the whole-archive flags stop the linker from discarding the filter,
+// which nothing references directly). The resulting tool finds the
+// filters via halide_enumerate_registered_filters, builds their
+// arguments from the command line and the filter metadata, and times
+// repeated calls. Results are printed to stdout as JSON.
+//
+// Run it with --help for the list of flags.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "HalideRuntime.h"
+#include "halide_image.h"
+#include "halide_image_io.h"
+
+namespace {
+
+using std::map;
+using std::string;
+using std::vector;
+
+const char *usage =
+    "Usage: %s [flags] [argument=value ...]\n"
+    "\n"
+    "Flags:\n"
+    "  --help                  Print this message and exit.\n"
+    "  --list                  Describe the linked-in filters and exit.\n"
+    "  --filter=NAME           The filter to run. Required if more than one\n"
+    "                          filter is linked in.\n"
+    "  --warmup=N              Untimed calls before timing starts (default 1).\n"
+    "  --samples=N             Number of timed samples (default 10).\n"
+    "  --iterations=N          Calls per timed sample (default 1).\n"
+    "  --output_extents=[x,y,...]\n"
+    "                          Extents of any output not given explicitly.\n"
+    "                          Defaults to the extents of the first input buffer.\n"
+    "\n"
+    "Arguments:\n"
+    "  scalar=VALUE            Sets a scalar argument. Scalars not given use\n"
+    "                          their default value from the metadata, or zero.\n"
+    "  input=[x,y,...]         Synthesizes an input buffer with the given extents,\n"
+    "                          filled with pseudo-random values.\n"
+    "  input=FILE              Loads an input buffer from a png, pgm or ppm file.\n"
+    "  output=[x,y,...]        Sets the extents of an output buffer.\n";
+
+void fail(const char *fmt, const char *arg = "") {
+    fprintf(stderr, "Error: ");
+    fprintf(stderr, fmt, arg);
+    fprintf(stderr, "\n");
+    exit(-1);
+}
+
+struct Filter {
+    const halide_filter_metadata_t *metadata;
+    int (*argv_func)(void **args);
+};
+
+int enumerate_func(void *enumerate_context,
+                   const halide_filter_metadata_t *metadata,
+                   int (*argv_func)(void **args)) {
+    vector<Filter> &filters = *reinterpret_cast<vector<Filter> *>(enumerate_context);
+    filters.push_back({metadata, argv_func});
+    return 0;
+}
+
+string type_to_string(const halide_type_t &t) {
+    const char *code = "?";
+    switch (t.code) {
+    case halide_type_int: code = "int"; break;
+    case halide_type_uint: code = t.bits == 1 ? "bool" : "uint"; break;
+    case halide_type_float: code = "float"; break;
+    case halide_type_handle: code = "handle"; break;
+    }
+    if (t.code == halide_type_handle || (t.code == halide_type_uint && t.bits == 1)) {
+        return code;
+    }
+    return code + std::to_string(t.bits);
+}
+
+// Parse a list of extents of the form [x,y,...]. Returns false if the
+// string isn't one.
+bool parse_extents(const string &s, vector<int> *extents) {
+    if (s.size() < 2 || s.front() != '[' || s.back() != ']') {
+        return false;
+    }
+    extents->clear();
+    string list = s.substr(1, s.size() - 2);
+    size_t start = 0;
+    while (start < list.size()) {
+        size_t end = list.find(',', start);
+        if (end == string::npos) {
+            end = list.size();
+        }
+        char *parse_end = nullptr;
+        string item = list.substr(start, end - start);
+        long e = strtol(item.c_str(), &parse_end, 10);
+        if (item.empty() || *parse_end != 0 || e <= 0) {
+            return false;
+        }
+        extents->push_back((int)e);
+        start = end + 1;
+    }
+    return !extents->empty() && extents->size() <= 4;
+}
+
+// Parse a scalar of the given type into a halide_scalar_value_t.
+bool parse_scalar(const string &s, const halide_type_t &t, halide_scalar_value_t *v) {
+    memset(v, 0, sizeof(*v));
+    const char *str = s.c_str();
+    char *end = nullptr;
+    if (t.code == halide_type_handle) {
+        // Only null handles can be given on the command line.
+        v->u.handle = nullptr;
+        return s == "0" || s == "null" || s == "nullptr";
+    } else if (t.code == halide_type_uint && t.bits == 1) {
+        if (s == "true" || s == "1") {
+            v->u.b = true;
+        } else if (s == "false" || s == "0") {
+            v->u.b = false;
+        } else {
+            return false;
+        }
+        return true;
+    } else if (t.code == halide_type_float) {
+        double d = strtod(str, &end);
+        if (t.bits == 32) {
+            v->u.f32 = (float)d;
+        } else {
+            v->u.f64 = d;
+        }
+    } else if (t.code == halide_type_int) {
+        long long i = strtoll(str, &end, 0);
+        switch (t.bits) {
+        case 8: v->u.i8 = (int8_t)i; break;
+        case 16: v->u.i16 = (int16_t)i; break;
+        case 32: v->u.i32 = (int32_t)i; break;
+        default: v->u.i64 = (int64_t)i; break;
+        }
+    } else {
+        unsigned long long u = strtoull(str, &end, 0);
+        switch (t.bits) {
+        case 8: v->u.u8 = (uint8_t)u; break;
+        case 16: v->u.u16 = (uint16_t)u; break;
+        case 32: v->u.u32 = (uint32_t)u; break;
+        default: v->u.u64 = (uint64_t)u; break;
+        }
+    }
+    return !s.empty() && *end == 0;
+}
+
+// A dense planar buffer, aligned like the buffers in halide_image.h.
+class Buffer {
+    std::unique_ptr<uint8_t[]> alloc;
+
+public:
+    buffer_t buf;
+
+    Buffer(const vector<int> &extents, int elem_size) {
+        memset(&buf, 0, sizeof(buf));
+        size_t size = elem_size;
+        for (size_t i = 0; i < extents.size(); i++) {
+            buf.extent[i] = extents[i];
+            buf.stride[i] = (int32_t)(size / elem_size);
+            size *= extents[i];
+        }
+        buf.elem_size = elem_size;
+        const size_t alignment = 128;
+        alloc.reset(new uint8_t[size + alignment - 1]);
+        buf.host = (uint8_t *)(((uintptr_t)alloc.get() + alignment - 1) & ~(alignment - 1));
+    }
+
+    ~Buffer() {
+        if (buf.dev) {
+            halide_device_free(nullptr, &buf);
+        }
+    }
+
+    size_t size_in_bytes() const {
+        size_t size = buf.elem_size;
+        for (int i = 0; i < 4 && buf.extent[i]; i++) {
+            size *= buf.extent[i];
+        }
+        return size;
+    }
+
+    // Fill with pseudo-random values that are valid for the type:
+    // floats are in [0, 1], and bools are zero or one.
+    void fill_random(const halide_type_t &t, uint32_t seed) {
+        size_t n = size_in_bytes() / buf.elem_size;
+        uint32_t state = seed * 2654435761u + 1;
+        for (size_t i = 0; i < n; i++) {
+            state = state * 1664525u + 1013904223u;
+            uint32_t r = state >> 8;
+            uint8_t *dst = buf.host + i * buf.elem_size;
+            if (t.code == halide_type_float && t.bits == 32) {
+                float f = r / (float)(1 << 24);
+                memcpy(dst, &f, sizeof(f));
+            } else if (t.code == halide_type_float && t.bits == 64) {
+                double d = r / (double)(1 << 24);
+                memcpy(dst, &d, sizeof(d));
+            } else if (t.bits == 1) {
+                *dst = r & 1;
+            } else {
+                uint64_t bits = ((uint64_t)r << 32) | (state ^ r);
+                memcpy(dst, &bits, buf.elem_size);
+            }
+        }
+        buf.host_dirty = true;
+    }
+};
+
+template<typename T>
+std::unique_ptr<Buffer> load_buffer(const string &filename) {
+    Halide::Tools::Image<T> im;
+    if (!Halide::Tools::load(filename, &im)) {
+        fail("Could not load %s", filename.c_str());
+    }
+    vector<int> extents;
+    for (int i = 0; i < im.dimensions(); i++) {
+        extents.push_back(((buffer_t *)im)->extent[i]);
+    }
+    std::unique_ptr<Buffer> b(new Buffer(extents, sizeof(T)));
+    memcpy(b->buf.host, im.data(), b->size_in_bytes());
+    b->buf.host_dirty = true;
+    return b;
+}
+
+std::unique_ptr<Buffer> load_buffer(const string &filename, const halide_type_t &t) {
+    if (t.code == halide_type_uint && t.bits == 8) {
+        return load_buffer<uint8_t>(filename);
+    } else if (t.code == halide_type_uint && t.bits == 16) {
+        return load_buffer<uint16_t>(filename);
+    } else if (t.code == halide_type_float && t.bits == 32) {
+        return load_buffer<float>(filename);
+    } else if (t.code == halide_type_float && t.bits == 64) {
+        return load_buffer<double>(filename);
+    }
+    fail("Can only load images into uint8, uint16, float32 or float64 buffers, not %s",
+         type_to_string(t).c_str());
+    return nullptr;
+}
+
+void describe(const Filter &f) {
+    const halide_filter_metadata_t *md = f.metadata;
+    printf("%s (target %s)\n", md->name, md->target);
+    for (int i = 0; i < md->num_arguments; i++) {
+        const halide_filter_argument_t &a = md->arguments[i];
+        const char *kind =
+            a.kind == halide_argument_kind_input_scalar ? "scalar" :
+            a.kind == halide_argument_kind_input_buffer ? "input" : "output";
+        printf("  %-24s %-8s %-8s", a.name, kind, type_to_string(a.type).c_str());
+        if (a.kind != halide_argument_kind_input_scalar) {
+            printf(" %d-D", a.dimensions);
+        }
+        printf("\n");
+    }
+}
+
+double percentile(const vector<double> &sorted, double p) {
+    size_t i = (size_t)std::ceil(p * sorted.size());
+    i = std::min(std::max(i, (size_t)1), sorted.size());
+    return sorted[i - 1];
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    vector<Filter> filters;
+    halide_enumerate_registered_filters(nullptr, &filters, enumerate_func);
+    if (filters.empty()) {
+        fail("No filters are registered. Compile them with the register_metadata "
+             "target feature, and link them in with --whole-archive or equivalent.");
+    }
+
+    string filter_name;
+    int warmup = 1, samples = 10, iterations = 1;
+    vector<int> default_output_extents;
+    bool list = false;
+    map<string, string> values;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        size_t eq = arg.find('=');
+        string key = arg.substr(0, eq);
+        string value = eq == string::npos ? "" : arg.substr(eq + 1);
+        if (key == "--help" || key == "-h") {
+            printf(usage, argv[0]);
+            return 0;
+        } else if (key == "--list") {
+            list = true;
+        } else if (key == "--filter") {
+            filter_name = value;
+        } else if (key == "--warmup") {
+            warmup = atoi(value.c_str());
+        } else if (key == "--samples") {
+            samples = atoi(value.c_str());
+        } else if (key == "--iterations") {
+            iterations = atoi(value.c_str());
+        } else if (key == "--output_extents") {
+            if (!parse_extents(value, &default_output_extents)) {
+                fail("Bad value for --output_extents: %s", value.c_str());
+            }
+        } else if (key.compare(0, 2, "--") == 0 || eq == string::npos) {
+            fail("Unknown flag or malformed argument: %s", arg.c_str());
+        } else {
+            values[key] = value;
+        }
+    }
+    if (warmup < 0 || samples < 1 || iterations < 1) {
+        fail("--warmup must be non-negative, and --samples and --iterations positive%s");
+    }
+
+    if (list) {
+        for (const Filter &f : filters) {
+            describe(f);
+        }
+        return 0;
+    }
+
+    const Filter *filter = nullptr;
+    for (const Filter &f : filters) {
+        if (filter_name.empty() ? filters.size() == 1 : filter_name == f.metadata->name) {
+            filter = &f;
+        }
+    }
+    if (!filter) {
+        fail(filter_name.empty() ?
+             "More than one filter is linked in; choose one with --filter%s" :
+             "No filter named %s is linked in; use --list to see them",
+             filter_name.c_str());
+    }
+    const halide_filter_metadata_t *md = filter->metadata;
+
+    // Build the argument list. Inputs first, so that outputs can
+    // default to the shape of the first input.
+    const int num_args = md->num_arguments;
+    vector<void *> args(num_args, nullptr);
+    vector<halide_scalar_value_t> scalars(num_args);
+    vector<std::unique_ptr<Buffer>> buffers(num_args);
+    vector<int> first_input_extents;
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < num_args; i++) {
+            const halide_filter_argument_t &a = md->arguments[i];
+            bool is_output = a.kind == halide_argument_kind_output_buffer;
+            if (is_output != (pass == 1)) continue;
+
+            auto it = values.find(a.name);
+            bool given = it != values.end();
+            string value = given ? it->second : "";
+            if (given) {
+                values.erase(it);
+            }
+
+            if (a.kind == halide_argument_kind_input_scalar) {
+                if (given) {
+                    if (!parse_scalar(value, a.type, &scalars[i])) {
+                        fail("Bad value for scalar argument %s", a.name);
+                    }
+                } else if (a.def) {
+                    scalars[i] = *a.def;
+                } else {
+                    memset(&scalars[i], 0, sizeof(scalars[i]));
+                }
+                args[i] = &scalars[i];
+                continue;
+            }
+
+            vector<int> extents;
+            if (given && parse_extents(value, &extents)) {
+                buffers[i].reset(new Buffer(extents, (a.type.bits + 7) / 8));
+                if (!is_output) {
+                    buffers[i]->fill_random(a.type, (uint32_t)i);
+                }
+            } else if (given && !is_output) {
+                buffers[i] = load_buffer(value, a.type);
+            } else if (given) {
+                fail("Output %s must be given as a list of extents", a.name);
+            } else if (!is_output) {
+                fail("No value given for input buffer %s", a.name);
+            } else {
+                extents = default_output_extents.empty() ? first_input_extents : default_output_extents;
+                if (extents.empty()) {
+                    fail("No extents given for output %s, and there is no input to copy them from", a.name);
+                }
+                extents.resize(a.dimensions, 1);
+                buffers[i].reset(new Buffer(extents, (a.type.bits + 7) / 8));
+            }
+
+            int dims = 0;
+            while (dims < 4 && buffers[i]->buf.extent[dims]) dims++;
+            if (dims != a.dimensions) {
+                fail("Buffer %s has the wrong number of dimensions", a.name);
+            }
+            if (!is_output && first_input_extents.empty()) {
+                first_input_extents.assign(buffers[i]->buf.extent, buffers[i]->buf.extent + dims);
+            }
+            args[i] = &buffers[i]->buf;
+        }
+    }
+    if (!values.empty()) {
+        fail("%s is not an argument of this filter", values.begin()->first.c_str());
+    }
+
+    auto run_once = [&]() {
+        int result = filter->argv_func(args.data());
+        if (result != 0) {
+            fprintf(stderr, "Error: %s returned %d\n", md->name, result);
+            exit(-1);
+        }
+        for (int i = 0; i < num_args; i++) {
+            if (md->arguments[i].kind == halide_argument_kind_output_buffer &&
+                buffers[i]->buf.dev) {
+                halide_device_sync(nullptr, &buffers[i]->buf);
+            }
+        }
+    };
+
+    for (int i = 0; i < warmup; i++) {
+        run_once();
+    }
+
+    // Times are per call, in milliseconds.
+    vector<double> times;
+    for (int s = 0; s < samples; s++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            run_once();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        times.push_back(std::chrono::duration<double, std::milli>(end - start).count() / iterations);
+    }
+    std::sort(times.begin(), times.end());
+    double median = times.size() % 2 ? times[times.size() / 2] :
+        (times[times.size() / 2 - 1] + times[times.size() / 2]) / 2;
+
+    // Throughput is measured in pixels of the first output, where a
+    // pixel is a point in its first two dimensions.
+    double megapixels = 0;
+    for (int i = 0; i < num_args; i++) {
+        if (md->arguments[i].kind == halide_argument_kind_output_buffer) {
+            const buffer_t &b = buffers[i]->buf;
+            megapixels = (double)std::max(b.extent[0], 1) * std::max(b.extent[1], 1) / 1e6;
+            break;
+        }
+    }
+
+    printf("{\n");
+    printf("  \"filter\": \"%s\",\n", md->name);
+    printf("  \"target\": \"%s\",\n", md->target);
+    printf("  \"samples\": %d,\n", samples);
+    printf("  \"iterations\": %d,\n", iterations);
+    printf("  \"min_ms\": %f,\n", times.front());
+    printf("  \"median_ms\": %f,\n", median);
+    printf("  \"p99_ms\": %f,\n", percentile(times, 0.99));
+    printf("  \"megapixels_per_second\": %f\n", median > 0 ? megapixels / (median / 1e3) : 0.0);
+    printf("}\n");
+
+    return 0;
+}
@@ -0,0 +1,110 @@
+#!/usr/bin/env python
+"""Compare two sets of benchmark results and flag significant changes.
+
+The inputs are files written by benchmark_report (apps/support/benchmark.h)
+when the HL_BENCHMARK_OUTPUT environment variable is set, e.g.
+
+    HL_BENCHMARK_OUTPUT=before.json make performance_matrix_multiplication
+    ... change something ...
+    HL_BENCHMARK_OUTPUT=after.json make performance_matrix_multiplication
+    python tools/compare_benchmarks.py before.json after.json
+
+A benchmark counts as changed if a two-sided Mann-Whitney U test on the
+samples of the two runs is significant, and the medians differ by more
+than the threshold. The exit status is 1 if anything regressed.
+"""
+
+from __future__ import print_function
+
+import argparse
+import json
+import math
+import sys
+
+
+def load(filename):
+    """Returns a dict from benchmark name to result. Later results for
+    the same name replace earlier ones."""
+    results = {}
+    with open(filename) as f:
+        for line in f:
+            line = line.strip()
+            if line:
+                r = json.loads(line)
+                results[r['name']] = r
+    return results
+
+
+def mann_whitney_p(a, b):
+    """Two-sided p-value of the Mann-Whitney U test, using the normal
+    approximation with a correction for ties."""
+    n1, n2 = len(a), len(b)
+    if n1 == 0 or n2 == 0:
+        return 1.0
+    values = sorted([(x, 0) for x in a] + [(x, 1) for x in b])
+    ranks = [0.0] * len(values)
+    tie_term = 0.0
+    i = 0
+    while i < len(values):
+        j = i
+        while j + 1 < len(values) and values[j + 1][0] == values[i][0]:
+            j += 1
+        # Ranks are 1-based; tied values share the average rank.
+        for k in range(i, j + 1):
+            ranks[k] = (i + j) / 2.0 + 1
+        t = j - i + 1
+        tie_term += t ** 3 - t
+        i = j + 1
+    r1 = sum(r for r, (_, which) in zip(ranks, values) if which == 0)
+    u = r1 - n1 * (n1 + 1) / 2.0
+    n = n1 + n2
+    mean = n1 * n2 / 2.0
+    var = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1)))
+    if var <= 0:
+        return 1.0
+    z = (abs(u - mean) - 0.5) / math.sqrt(var)
+    return math.erfc(max(z, 0) / math.sqrt(2))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('before')
+    parser.add_argument('after')
+    parser.add_argument('--threshold', type=float, default=0.05,
+                        help='Smallest relative change in the median to report (default 0.05).')
+    parser.add_argument('--alpha', type=float, default=0.01,
+                        help='Significance level of the test (default 0.01).')
+    args = parser.parse_args()
+
+    before = load(args.before)
+    after = load(args.after)
+
+    regressions = 0
+    print('%-60s %12s %12s %8s  %s' % ('benchmark', 'before (ms)', 'after (ms)', 'change', ''))
+    for name in sorted(set(before) | set(after)):
+        if name not in before or name not in after:
+            print('%-60s only in %s' % (name, args.before if name in before else args.after))
+            continue
+        b, a = before[name], after[name]
+        change = a['median'] / b['median'] - 1 if b['median'] > 0 else 0.0
+        p = mann_whitney_p(b['samples'], a['samples'])
+        verdict = ''
+        if p < args.alpha and abs(change) > args.threshold:
+            if change > 0:
+                verdict = 'REGRESSION'
+                regressions += 1
+            else:
+                verdict = 'improvement'
+        if a.get('noisy') or b.get('noisy') or a.get('drifted') or b.get('drifted'):
+            verdict += ' (noisy)'
+        print('%-60s %12.4f %12.4f %+7.1f%%  %s' %
+              (name, b['median'] * 1e3, a['median'] * 1e3, change * 100, verdict.strip()))
+
+    if regressions:
+        print('%d benchmark(s) regressed' % regressions)
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -7,6 +7,7 @@
 #define HALIDE_TOOLS_IMAGE_H
 
 #include <cassert>
+#include <cstddef>
 #include <cstdlib>
 #include <limits>
 #include <memory>
@@ -21,8 +22,19 @@ namespace Tools {
 template<typename T>
 class Image {
     struct Contents {
-        Contents(const buffer_t &b, uint8_t *a) : buf(b), ref_count(1), alloc(a) {}
-        buffer_t buf;
+        Contents(const buffer_t &b, uint8_t *a) : nd_buf(), buf(nd_buf.buf), ref_count(1), alloc(a) {
+            buf = b;
+            if (halide_buffer_dimensions(&b) > 4) {
+                // Share the dimensions beyond the fourth with the
+                // halide_nd_buffer_t b belongs to.
+                nd_buf.extra_dim = ((const halide_nd_buffer_t *)&b)->extra_dim;
+            }
+        }
+        halide_nd_buffer_t nd_buf;
+        buffer_t &buf;
+        // Storage for the dimensions beyond the fourth, if this Image
+        // allocated them.
+        std::vector<halide_dimension_t> extra_dims;
         int ref_count;
         uint8_t *alloc;
 
@@ -65,6 +77,13 @@ class Image {
         if (z) size *= z;
         if (w) size *= w;
 
+        uint8_t *ptr = allocate(size, buf);
+        contents = new Contents(buf, ptr);
+    }
+
+    // Allocate host memory for the given number of elements and point
+    // buf at it. Returns the allocation to free.
+    static uint8_t *allocate(size_t size, buffer_t &buf) {
         // Conservatively align images to 128 bytes. This is enough
         // alignment for all the platforms we might use.
         const size_t alignment = 128;
@@ -74,7 +93,44 @@ class Image {
         buf.host_dirty = false;
         buf.dev_dirty = false;
         buf.dev = 0;
+        return ptr;
+    }
+
+    void initialize(const std::vector<int> &sizes) {
+        if (sizes.size() <= 4) {
+            initialize(sizes.size() > 0 ? sizes[0] : 1,
+                       sizes.size() > 1 ? sizes[1] : 0,
+                       sizes.size() > 2 ? sizes[2] : 0,
+                       sizes.size() > 3 ? sizes[3] : 0,
+                       false);
+            return;
+        }
+
+        // The dimensions are only counted up to the first zero
+        // extent, so every extent must be non-zero.
+        assert(sizes.size() <= HALIDE_BUFFER_MAX_DIMENSIONS);
+        buffer_t buf = {0};
+        std::vector<halide_dimension_t> extra_dims(sizes.size() - 4);
+        int stride = 1;
+        for (size_t i = 0; i < sizes.size(); i++) {
+            assert(sizes[i] > 0);
+            if (i < 4) {
+                buf.extent[i] = sizes[i];
+                buf.stride[i] = stride;
+            } else {
+                extra_dims[i - 4].min = 0;
+                extra_dims[i - 4].extent = sizes[i];
+                extra_dims[i - 4].stride = stride;
+            }
+            stride *= sizes[i];
+        }
+        buf.elem_size = sizeof(T);
+
+        uint8_t *ptr = allocate(stride, buf);
         contents = new Contents(buf, ptr);
+        contents->extra_dims.swap(extra_dims);
+        contents->nd_buf.extra_dim = &contents->extra_dims[0];
+        contents->buf.extra_dimensions = (uint8_t)contents->extra_dims.size();
     }
 
     // Returns the dimension sizes of a statically sized array from inner to outer.
@@ -111,6 +167,19 @@ public:
         initialize(x, y, z, w, interleaved);
     }
 
+    // Allocate an image with the given extents, which may have more
+    // than four dimensions.
+    explicit Image(const std::vector<int> &sizes) {
+        initialize(sizes);
+    }
+
+    // Wrap an existing buffer_t without copying its contents. The
+    // memory it points to (including any dimensions beyond the
+    // fourth, if it is part of a halide_nd_buffer_t) must outlive
+    // this Image.
+    explicit Image(const buffer_t *b) : contents(new Contents(*b, NULL)) {
+    }
+
     Image(const Image &other) : contents(other.contents) {
         if (contents) {
             contents->ref_count++;
@@ -227,6 +296,17 @@ public:
         return ptr[s0 * x + s1 * y + s2 * z + s3 * w];
     }
 
+    /** Access an element of an image of any dimensionality, given a
+     * coordinate per dimension. Make sure you've called copy_to_host
+     * first. */
+    T &operator()(const std::vector<int> &pos) {
+        return *address_of(pos);
+    }
+
+    const T &operator()(const std::vector<int> &pos) const {
+        return *address_of(pos);
+    }
+
     operator buffer_t *() const {
         return &(contents->buf);
     }
@@ -244,24 +324,28 @@ public:
     }
 
     int dimensions() const {
-        for (int i = 0; i < 4; i++) {
-            if (contents->buf.extent[i] == 0) {
-                return i;
-            }
-        }
-        return 4;
+        return halide_buffer_dimensions(&contents->buf);
     }
 
     int stride(int dim) const {
-        return contents->buf.stride[dim];
+        return halide_buffer_dim(&contents->buf, dim).stride;
     }
 
     int min(int dim) const {
-        return contents->buf.min[dim];
+        return halide_buffer_dim(&contents->buf, dim).min;
     }
 
     int extent(int dim) const {
-        return contents->buf.extent[dim];
+        return halide_buffer_dim(&contents->buf, dim).extent;
+    }
+
+    T *address_of(const std::vector<int> &pos) const {
+        ptrdiff_t offset = 0;
+        for (size_t i = 0; i < pos.size(); i++) {
+            halide_dimension_t d = halide_buffer_dim(&contents->buf, (int)i);
+            offset += (ptrdiff_t)(pos[i] - d.min) * d.stride;
+        }
+        return (T *)contents->buf.host + offset;
     }
 
     void set_min(int x, int y = 0, int z = 0, int w = 0) {
@@ -1,16 +1,38 @@
 // This simple PNG IO library works with *both* the Halide::Image<T> type *and*
 // the simple halide_image.h version. Also now includes PPM support for faster load/save.
+//
+// For large inputs, load_mapped() maps PGM, PPM and .hraw files into memory
+// and describes the pixels where they lie, without reading or copying them.
+// .hraw is a trivial uncompressed format (see Internal::RawHeader) that can
+// hold any buffer of up to four dimensions.
 
 #ifndef HALIDE_IMAGE_IO_H
 #define HALIDE_IMAGE_IO_H
 
 #include <algorithm>
+#include <cctype>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
 #include <string>
 #include <vector>
 
+#ifndef HALIDE_NOTHREADS
+#include <thread>
+#endif
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "HalideRuntime.h"
+
 #ifndef HALIDE_NOPNG
 #include "png.h"
 #endif
@@ -89,15 +111,13 @@ inline bool is_little_endian() {
     return ((char *) &value)[0] == 1;
 }
 
-inline void swap_endian_16(bool little_endian, uint16_t &value) {
-    if (little_endian) {
-        value = ((value & 0xff)<<8)|((value & 0xff00)>>8);
-    }
-}
-
 struct FileOpener {
     FileOpener(const char* filename, const char* mode) : f(fopen(filename, mode)) {
-        // nothing
+        // Buffer writes in large blocks; libpng in particular writes
+        // a few bytes at a time.
+        if (f != nullptr && mode[0] == 'w') {
+            setvbuf(f, nullptr, _IOFBF, 1 << 20);
+        }
     }
     ~FileOpener() {
         if (f != nullptr) {
@@ -137,6 +157,287 @@ struct PngRowPointers {
 };
 #endif // HALIDE_NOPNG
 
+// A 16-bit sample stored most significant byte first, as in PNG, PGM
+// and PPM files. Converting through this type rather than swapping
+// bytes in place keeps the conversion loops free of branches on the
+// host byte order, so they vectorize.
+struct BigEndian16 {
+    uint8_t bytes[2];
+};
+
+template<typename T>
+inline void convert(BigEndian16 in, T &out) {
+    convert((uint16_t)((in.bytes[0] << 8) | in.bytes[1]), out);
+}
+
+template<typename T>
+inline void convert(T in, BigEndian16 &out) {
+    uint16_t value;
+    convert(in, value);
+    out.bytes[0] = value >> 8;
+    out.bytes[1] = value & 0xff;
+}
+
+// Convert n samples spaced src_stride elements apart into n elements
+// spaced dst_stride apart. The dense case is split out so that the
+// compiler can vectorize it.
+template<typename S, typename D>
+inline void convert_samples(const S *src, int src_stride, D *dst, int dst_stride, int n) {
+    if (src_stride == 1 && dst_stride == 1) {
+        for (int i = 0; i < n; i++) {
+            convert(src[i], dst[i]);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            convert(src[i * src_stride], dst[i * dst_stride]);
+        }
+    }
+}
+
+// Call f(begin, end) on disjoint ranges covering [0, n). If there are
+// at least a few megabytes of work, the ranges are handed to
+// separate threads. Define HALIDE_NOTHREADS to always run on the
+// calling thread.
+template<typename F>
+void parallel_for(int n, size_t bytes, F f) {
+#ifndef HALIDE_NOTHREADS
+    const size_t min_bytes_per_thread = 1 << 20;
+    size_t threads = std::min<size_t>(std::thread::hardware_concurrency(), bytes / min_bytes_per_thread);
+    threads = std::min<size_t>(threads, n);
+    if (threads > 1) {
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < threads; i++) {
+            workers.emplace_back(f, (int)(n * i / threads), (int)(n * (i + 1) / threads));
+        }
+        f(0, (int)(n / threads));
+        for (std::thread &t : workers) {
+            t.join();
+        }
+        return;
+    }
+#endif
+    f(0, n);
+}
+
+// The contents of a file, mapped into memory where the platform
+// supports it and read into a heap allocation otherwise. The mapping
+// is private and writable: pixels can be modified in place (for
+// example byte-swapped) without touching the file, and only the
+// pages written to are copied.
+struct MappedFile {
+    MappedFile(const char *filename) : data(nullptr), size(0) {
+#ifdef _WIN32
+        FileOpener f(filename, "rb");
+        if (f.f == nullptr || _fseeki64(f.f, 0, SEEK_END) != 0) return;
+        int64_t end = _ftelli64(f.f);
+        if (end <= 0 || _fseeki64(f.f, 0, SEEK_SET) != 0) return;
+        allocation.resize((size_t)end);
+        if (fread(&allocation[0], 1, allocation.size(), f.f) != allocation.size()) return;
+        data = &allocation[0];
+        size = allocation.size();
+#else
+        int fd = open(filename, O_RDONLY);
+        if (fd < 0) return;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void *p = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data = (uint8_t *)p;
+                size = st.st_size;
+            }
+        }
+        close(fd);
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (data != nullptr) {
+            munmap(data, size);
+        }
+#endif
+    }
+
+    // Hint that the whole file is about to be read from front to back.
+    // The advice values are not flags, so they take separate calls.
+    void will_read() {
+#if !defined(_WIN32) && defined(MADV_WILLNEED)
+        if (data != nullptr) {
+            madvise(data, size, MADV_SEQUENTIAL);
+            madvise(data, size, MADV_WILLNEED);
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    uint8_t *data;
+    size_t size;
+#ifdef _WIN32
+    std::vector<uint8_t> allocation;
+#endif
+};
+
+// Parse the header of a binary PGM (P5) or PPM (P6) file, and
+// describe its pixels with a buffer_t pointing into the file. The
+// samples are left big-endian. PGM files have two dimensions; PPM
+// files have three, with the channels interleaved.
+template<CheckFunc check>
+bool parse_pnm(const MappedFile &f, const char *format, buffer_t *buf, int *bit_depth) {
+    size_t pos = 0;
+    // Read an unsigned decimal, skipping whitespace and comments.
+    auto next_int = [&](int *value) {
+        while (pos < f.size) {
+            if (f.data[pos] == '#') {
+                while (pos < f.size && f.data[pos] != '\n') pos++;
+            } else if (isspace(f.data[pos])) {
+                pos++;
+            } else {
+                break;
+            }
+        }
+        int64_t v = 0;
+        size_t start = pos;
+        while (pos < f.size && isdigit(f.data[pos]) && v <= 0x7fffffff) {
+            v = v * 10 + (f.data[pos++] - '0');
+        }
+        *value = (int)v;
+        return pos > start && v <= 0x7fffffff;
+    };
+
+    bool is_ppm = format[1] == 'P';
+    if (!check(f.size >= 2 && (f.data[0] == 'P' || f.data[0] == 'p') && f.data[1] == (is_ppm ? '6' : '5'),
+               "Input is not binary %s\n", format)) return false;
+    pos = 2;
+    int width = 0, height = 0, maxval = 0;
+    if (!check(next_int(&width) && next_int(&height), "Could not read %s width and height\n", format)) return false;
+    if (!check(next_int(&maxval), "Could not read %s max value\n", format)) return false;
+    if (maxval == 255) { *bit_depth = 8; }
+    else if (maxval == 65535) { *bit_depth = 16; }
+    else if (!check(false, "Invalid bit depth in %s\n", format)) { return false; }
+    // A single whitespace character separates the header from the data.
+    pos++;
+
+    int channels = is_ppm ? 3 : 1;
+    size_t bytes = (size_t)width * height * channels * (*bit_depth / 8);
+    if (!check(pos <= f.size && f.size - pos >= bytes, "Could not read %s %d-bit data\n", format, *bit_depth)) return false;
+
+    memset(buf, 0, sizeof(*buf));
+    buf->host = f.data + pos;
+    buf->elem_size = *bit_depth / 8;
+    buf->extent[0] = width;
+    buf->extent[1] = height;
+    buf->stride[0] = channels;
+    buf->stride[1] = width * channels;
+    if (is_ppm) {
+        buf->extent[2] = channels;
+        buf->stride[2] = 1;
+    }
+    return true;
+}
+
+// The header of a .hraw file: a simple uncompressed format holding
+// a buffer of any type with up to four dimensions, and any strides,
+// in the byte order of the machine that wrote it. The header is
+// padded to raw_data_alignment bytes, so that the pixels of a mapped
+// file are page aligned.
+struct RawHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t byte_order;
+    uint8_t type_code, type_bits;
+    uint16_t dimensions;
+    int32_t min[4], extent[4], stride[4];
+    uint64_t data_offset;
+};
+
+const char raw_magic[4] = {'H', 'R', 'A', 'W'};
+const uint32_t raw_version = 1;
+const uint32_t raw_byte_order = 0x01020304;
+const size_t raw_data_alignment = 4096;
+
+template<typename T>
+inline halide_type_t raw_type() {
+    return halide_type_t(!std::numeric_limits<T>::is_integer ? halide_type_float :
+                         std::numeric_limits<T>::is_signed ? halide_type_int : halide_type_uint,
+                         sizeof(T) * 8);
+}
+
+// Parse the header of a .hraw file, and describe its pixels with a
+// buffer_t pointing into the file.
+template<CheckFunc check>
+bool parse_raw(const MappedFile &f, buffer_t *buf, halide_type_t *type) {
+    RawHeader h;
+    if (!check(f.size >= sizeof(h), "File is too small to be a raw image\n")) return false;
+    memcpy(&h, f.data, sizeof(h));
+    if (!check(memcmp(h.magic, raw_magic, sizeof(raw_magic)) == 0, "Input is not a raw image\n")) return false;
+    if (!check(h.version == raw_version, "Unsupported raw image version %d\n", (int)h.version)) return false;
+    if (!check(h.byte_order == raw_byte_order, "Raw image was written with a different byte order\n")) return false;
+    if (!check(h.dimensions <= 4 && h.type_bits > 0 && h.type_bits <= 64, "Malformed raw image header\n")) return false;
+
+    memset(buf, 0, sizeof(*buf));
+    *type = halide_type_t((halide_type_code_t)h.type_code, h.type_bits);
+    buf->elem_size = (h.type_bits + 7) / 8;
+    // The data offset is that of the element at the min coordinates;
+    // check that the elements furthest from it in each direction are
+    // inside the file.
+    int64_t lo = 0, hi = 0;
+    for (int i = 0; i < h.dimensions; i++) {
+        if (!check(h.extent[i] > 0, "Malformed raw image header\n")) return false;
+        int64_t span = (int64_t)(h.extent[i] - 1) * h.stride[i] * buf->elem_size;
+        (span < 0 ? lo : hi) += span;
+        buf->min[i] = h.min[i];
+        buf->extent[i] = h.extent[i];
+        buf->stride[i] = h.stride[i];
+    }
+    if (!check((int64_t)h.data_offset + lo >= (int64_t)sizeof(h) &&
+               h.data_offset + hi + buf->elem_size <= f.size,
+               "Raw image data extends beyond the end of the file\n")) return false;
+    buf->host = f.data + h.data_offset;
+    return true;
+}
+
+// Copy the rows with indices in [begin, end) of a buffer with the
+// given extents between two layouts. A row is a run along dimension
+// 0; rows are numbered with dimension 1 varying fastest.
+inline void copy_rows(const uint8_t *src, const int *src_stride,
+                      uint8_t *dst, const int *dst_stride,
+                      const int *extent, int elem_size, int begin, int end) {
+    for (int r = begin; r < end; r++) {
+        int y = r % extent[1], z = (r / extent[1]) % extent[2], w = r / (extent[1] * extent[2]);
+        const uint8_t *s = src + ((int64_t)y * src_stride[1] + (int64_t)z * src_stride[2] + (int64_t)w * src_stride[3]) * elem_size;
+        uint8_t *d = dst + ((int64_t)y * dst_stride[1] + (int64_t)z * dst_stride[2] + (int64_t)w * dst_stride[3]) * elem_size;
+        if (src_stride[0] == 1 && dst_stride[0] == 1) {
+            memcpy(d, s, (size_t)extent[0] * elem_size);
+        } else {
+            for (int x = 0; x < extent[0]; x++) {
+                memcpy(d + (int64_t)x * dst_stride[0] * elem_size, s + (int64_t)x * src_stride[0] * elem_size, elem_size);
+            }
+        }
+    }
+}
+
+// Write an image in chunks of whole rows of a few megabytes each. The
+// rows are converted into a chunk (in parallel) by
+// fill(chunk, first_row, last_row), and each chunk is written with a
+// single fwrite.
+template<typename F>
+bool write_rows(FILE *f, int rows, size_t row_bytes, F fill) {
+    if (rows == 0) return true;
+    int rows_per_chunk = (int)std::max<size_t>(1, (4 << 20) / std::max<size_t>(row_bytes, 1));
+    rows_per_chunk = std::min(rows_per_chunk, rows);
+    std::vector<uint8_t> chunk(rows_per_chunk * row_bytes);
+    for (int y = 0; y < rows; y += rows_per_chunk) {
+        int n = std::min(rows_per_chunk, rows - y);
+        parallel_for(n, n * row_bytes, [&](int begin, int end) {
+            fill(&chunk[0] + begin * row_bytes, y + begin, y + end);
+        });
+        if (fwrite(&chunk[0], row_bytes, n, f) != (size_t)n) return false;
+    }
+    return true;
+}
+
 }  // namespace Internal
 
 
@@ -198,32 +499,24 @@ bool load_png(const std::string &filename, ImageType *im) {
     if (!check((bit_depth == 8) || (bit_depth == 16), "Can only handle 8-bit or 16-bit pngs\n")) return false;
 
     // convert the data to ImageType::ElemType
-
-    int c_stride = (im->channels() == 1) ? 0 : im->stride(2);
-    typename ImageType::ElemType *ptr = (typename ImageType::ElemType*)im->data();
-    if (bit_depth == 8) {
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *srcPtr = (uint8_t *)(row_pointers.p[y]);
-            for (int x = 0; x < im->width(); x++) {
-                for (int c = 0; c < im->channels(); c++) {
-                    Internal::convert(*srcPtr++, ptr[c*c_stride]);
+    typedef typename ImageType::ElemType T;
+    T *ptr = (T *)im->data();
+    int x_stride = im->stride(0), y_stride = im->stride(1);
+    int c_stride = (channels == 1) ? 0 : im->stride(2);
+    size_t bytes = (size_t)width * height * channels * (sizeof(T) + bit_depth / 8);
+    Internal::parallel_for(height, bytes, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            const uint8_t *row = (const uint8_t *)(row_pointers.p[y]);
+            for (int c = 0; c < channels; c++) {
+                T *out = ptr + (int64_t)y * y_stride + (int64_t)c * c_stride;
+                if (bit_depth == 8) {
+                    Internal::convert_samples(row + c, channels, out, x_stride, width);
+                } else {
+                    Internal::convert_samples((const Internal::BigEndian16 *)row + c, channels, out, x_stride, width);
                 }
-                ptr++;
             }
         }
-    } else if (bit_depth == 16) {
-        for (int y = 0; y < im->height(); y++) {
-            uint8_t *srcPtr = (uint8_t *)(row_pointers.p[y]);
-            for (int x = 0; x < im->width(); x++) {
-                for (int c = 0; c < im->channels(); c++) {
-                    uint16_t hi = (*srcPtr++) << 8;
-                    uint16_t lo = hi | (*srcPtr++);
-                    Internal::convert(lo, ptr[c*c_stride]);
-                }
-                ptr++;
-            }
-        }
-    }
+    });
 
     png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
@@ -285,36 +578,26 @@ bool save_png(ImageType &im, const std::string &filename) {
 
     // im.copyToHost(); // in case the image is on the gpu
 
-    int c_stride = (im.channels() == 1) ? 0 : im.stride(2);
-    typename ImageType::ElemType *srcPtr = (typename ImageType::ElemType*)im.data();
-
-    for (int y = 0; y < im.height(); y++) {
-        uint8_t *dstPtr = (uint8_t *)(row_pointers.p[y]);
-        if (bit_depth == 16) {
-            // convert to uint16_t
-            for (int x = 0; x < im.width(); x++) {
-                for (int c = 0; c < im.channels(); c++) {
-                    uint16_t out;
-                    Internal::convert(srcPtr[c*c_stride], out);
-                    *dstPtr++ = out >> 8;
-                    *dstPtr++ = out & 0xff;
-                }
-                srcPtr++;
-            }
-        } else if (bit_depth == 8) {
-            // convert to uint8_t
-            for (int x = 0; x < im.width(); x++) {
-                for (int c = 0; c < im.channels(); c++) {
-                    uint8_t out;
-                    Internal::convert(srcPtr[c*c_stride], out);
-                    *dstPtr++ = out;
+    typedef typename ImageType::ElemType T;
+    const T *srcPtr = (const T *)im.data();
+    int width = im.width(), height = im.height(), channels = im.channels();
+    int x_stride = im.stride(0);
+    int y_stride = im.dimensions() > 1 ? im.stride(1) : 0;
+    int c_stride = (channels == 1) ? 0 : im.stride(2);
+    size_t bytes = (size_t)width * height * channels * (sizeof(T) + bit_depth / 8);
+    Internal::parallel_for(height, bytes, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            uint8_t *row = (uint8_t *)(row_pointers.p[y]);
+            for (int c = 0; c < channels; c++) {
+                const T *in = srcPtr + (int64_t)y * y_stride + (int64_t)c * c_stride;
+                if (bit_depth == 8) {
+                    Internal::convert_samples(in, x_stride, row + c, channels, width);
+                } else {
+                    Internal::convert_samples(in, x_stride, (Internal::BigEndian16 *)row + c, channels, width);
                 }
-                srcPtr++;
             }
-        } else {
-            if (!check(bit_depth == 8 || bit_depth == 16, "We only support saving 8- and 16-bit images.")) return false;
         }
-    }
+    });
 
     // write data
     if (!check(!setjmp(png_jmpbuf(png_ptr)), "[write_png_file] Error during writing bytes")) return false;
@@ -332,251 +615,315 @@ bool save_png(ImageType &im, const std::string &filename) {
 #endif // HALIDE_NOPNG
 }
 
-template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool load_pgm(const std::string &filename, ImageType *im) {
-
-    /* open file and test for it being a pgm */
-    Internal::FileOpener f(filename.c_str(), "rb");
-    if (!check(f.f != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
-
-    int width, height, maxval;
-    char header[256];
-    char buf[1024];
-    bool fmt_binary = false;
-
-    f.readLine(buf, 1024);
-    if (!check(sscanf(buf, "%255s", header) == 1, "Could not read PGM header\n")) return false;
-    if (header == std::string("P5") || header == std::string("p5"))
-        fmt_binary = true;
-    if (!check(fmt_binary, "Input is not binary PGM\n")) return false;
-
-    f.readLine(buf, 1024);
-    if (!check(sscanf(buf, "%d %d\n", &width, &height) == 2, "Could not read PGM width and height\n")) return false;
-    f.readLine(buf, 1024);
-    if (!check(sscanf(buf, "%d", &maxval) == 1, "Could not read PGM max value\n")) return false;
-
-    int bit_depth = 0;
-    if (maxval == 255) { bit_depth = 8; }
-    else if (maxval == 65535) { bit_depth = 16; }
-    else if (!check(false, "Invalid bit depth in PGM\n")) { return false; }
+namespace Internal {
 
-    // Graymap
-    *im = ImageType(width, height);
+// Load a binary PGM or PPM file into a planar image, converting the
+// samples to ImageType::ElemType.
+template<typename ImageType, CheckFunc check>
+bool load_pnm(const std::string &filename, const char *format, ImageType *im) {
+    MappedFile f(filename.c_str());
+    if (!check(f.data != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
+    buffer_t src;
+    int bit_depth;
+    if (!parse_pnm<check>(f, format, &src, &bit_depth)) return false;
+    f.will_read();
+
+    int width = src.extent[0], height = src.extent[1];
+    int channels = src.extent[2] ? src.extent[2] : 1;
+    *im = channels == 1 ? ImageType(width, height) : ImageType(width, height, channels);
 
     // convert the data to ImageType::ElemType
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height);
-        if (!check(fread((void *) &data[0], sizeof(uint8_t), width*height, f.f) == (size_t) (width*height), "Could not read PGM 8-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        uint8_t *p = &data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                Internal::convert(*p++, *im_data++);
+    typedef typename ImageType::ElemType T;
+    T *dst = (T *)im->data();
+    int x_stride = im->stride(0), y_stride = im->stride(1);
+    int c_stride = (channels == 1) ? 0 : im->stride(2);
+    size_t bytes = (size_t)width * height * channels * (sizeof(T) + src.elem_size);
+    parallel_for(height, bytes, [&](int begin, int end) {
+        for (int y = begin; y < end; y++) {
+            for (int c = 0; c < channels; c++) {
+                const uint8_t *in = src.host + ((size_t)y * src.stride[1] + c * src.stride[2]) * src.elem_size;
+                T *out = dst + (int64_t)y * y_stride + (int64_t)c * c_stride;
+                if (bit_depth == 8) {
+                    convert_samples(in, src.stride[0], out, x_stride, width);
+                } else {
+                    convert_samples((const BigEndian16 *)in, src.stride[0], out, x_stride, width);
+                }
             }
         }
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height);
-        if (!check(fread((void *) &data[0], sizeof(uint16_t), width*height, f.f) == (size_t) (width*height), "Could not read PGM 16-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        uint16_t *p = &data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint16_t value = *p++;
-                Internal::swap_endian_16(little_endian, value);
-                Internal::convert(value, *im_data++);
+    });
+    im->set_host_dirty();
+    return true;
+}
+
+// Save the given number of channels of an image, starting at
+// first_channel, as a binary PGM (one channel) or PPM (three).
+template<typename ImageType, CheckFunc check>
+bool save_pnm(ImageType &im, const std::string &filename, const char *format, int first_channel, int channels) {
+    im.copy_to_host();
+
+    typedef typename ImageType::ElemType T;
+    int bit_depth = sizeof(T) == 1 ? 8 : 16;
+    int width = im.width(), height = im.height();
+
+    FileOpener f(filename.c_str(), "wb");
+    if (!check(f.f != nullptr, "File %s could not be opened for writing\n", filename.c_str())) return false;
+    fprintf(f.f, "P%d\n%d %d\n%d\n", channels == 1 ? 5 : 6, width, height, (1 << bit_depth) - 1);
+
+    int x_stride = im.stride(0);
+    int y_stride = im.dimensions() > 1 ? im.stride(1) : 0;
+    int c_stride = im.dimensions() > 2 ? im.stride(2) : 0;
+    const T *src = (const T *)im.data() + (int64_t)first_channel * c_stride;
+    size_t row_bytes = (size_t)width * channels * (bit_depth / 8);
+    bool ok = write_rows(f.f, height, row_bytes, [&](uint8_t *out, int begin, int end) {
+        for (int y = begin; y < end; y++, out += row_bytes) {
+            for (int c = 0; c < channels; c++) {
+                const T *in = src + (int64_t)y * y_stride + (int64_t)c * c_stride;
+                if (bit_depth == 8) {
+                    convert_samples(in, x_stride, out + c, channels, width);
+                } else {
+                    convert_samples(in, x_stride, (BigEndian16 *)out + c, channels, width);
+                }
             }
         }
-    }
-    (*im)(0,0,0) = (*im)(0,0,0);      /* Mark dirty inside read/write functions. */
+    });
+    return check(ok, "Could not write %s %d-bit data\n", format, bit_depth);
+}
 
-    return true;
+}  // namespace Internal
+
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_pgm(const std::string &filename, ImageType *im) {
+    return Internal::load_pnm<ImageType, check>(filename, "PGM", im);
 }
 
 // "im" is not const-ref because copy_to_host() is not const.
 // Optional channel parameter for specifying which color to save as a graymap
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool save_pgm(ImageType &im, const std::string &filename, unsigned int channel = 0) {
+    if (!check(channel < (unsigned int)im.channels(), "Selected channel %d not available in image\n", channel)) return false;
+    return Internal::save_pnm<ImageType, check>(im, filename, "PGM", channel, 1);
+}
+
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_ppm(const std::string &filename, ImageType *im) {
+    return Internal::load_pnm<ImageType, check>(filename, "PPM", im);
+}
+
+// "im" is not const-ref because copy_to_host() is not const.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool save_ppm(ImageType &im, const std::string &filename) {
+    if (!check(im.channels() >= 3, "Can't write PPM files with fewer than 3 channels\n")) return false;
+    return Internal::save_pnm<ImageType, check>(im, filename, "PPM", 0, 3);
+}
+
+// Load a .hraw file (see Internal::RawHeader). The element type
+// stored in the file must be ImageType::ElemType. The image gets the
+// dimensions and mins of the file, and a planar layout.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_raw(const std::string &filename, ImageType *im) {
+    Internal::MappedFile f(filename.c_str());
+    if (!check(f.data != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
+    buffer_t src;
+    halide_type_t type;
+    if (!Internal::parse_raw<check>(f, &src, &type)) return false;
+    typedef typename ImageType::ElemType T;
+    halide_type_t t = Internal::raw_type<T>();
+    if (!check(type.code == t.code && type.bits == t.bits,
+               "Raw image element type does not match the image type\n")) return false;
+    f.will_read();
+
+    *im = ImageType(src.extent[0], src.extent[1], src.extent[2], src.extent[3]);
+    im->set_min(src.min[0], src.min[1], src.min[2], src.min[3]);
+    int dims = im->dimensions();
+    int extent[4], src_stride[4], dst_stride[4];
+    for (int i = 0; i < 4; i++) {
+        extent[i] = i < dims ? src.extent[i] : 1;
+        src_stride[i] = src.stride[i];
+        dst_stride[i] = i < dims ? im->stride(i) : 0;
+    }
+    uint8_t *dst = (uint8_t *)im->data();
+    int rows = extent[1] * extent[2] * extent[3];
+    Internal::parallel_for(rows, (size_t)rows * extent[0] * sizeof(T), [&](int begin, int end) {
+        Internal::copy_rows(src.host, src_stride, dst, dst_stride, extent, sizeof(T), begin, end);
+    });
+    im->set_host_dirty();
+    return true;
+}
+
+// Save an image as a .hraw file, densely packed in dimension order.
+// "im" is not const-ref because copy_to_host() is not const.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool save_raw(ImageType &im, const std::string &filename) {
     im.copy_to_host();
 
-    unsigned int bit_depth = sizeof(typename ImageType::ElemType) == 1 ? 8: 16;
-    unsigned int num_channels = im.channels();
+    typedef typename ImageType::ElemType T;
+    Internal::RawHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, Internal::raw_magic, sizeof(h.magic));
+    h.version = Internal::raw_version;
+    h.byte_order = Internal::raw_byte_order;
+    halide_type_t t = Internal::raw_type<T>();
+    h.type_code = t.code;
+    h.type_bits = t.bits;
+    h.dimensions = im.dimensions();
+    h.data_offset = Internal::raw_data_alignment;
+
+    int extent[4], src_stride[4];
+    const int row_stride[4] = {1, 0, 0, 0};
+    bool dense = true;
+    int32_t stride = 1;
+    for (int i = 0; i < 4; i++) {
+        if (i < h.dimensions) {
+            h.min[i] = im.min(i);
+            h.extent[i] = extent[i] = im.extent(i);
+            h.stride[i] = stride;
+            src_stride[i] = im.stride(i);
+            dense = dense && src_stride[i] == stride;
+            stride *= extent[i];
+        } else {
+            extent[i] = 1;
+            src_stride[i] = 0;
+        }
+    }
 
-    if (!check(channel >= 0, "Selected channel %d not available in image\n", channel)) return false;
-    if (!check(channel < num_channels, "Selected channel %d not available in image\n", channel)) return false;
     Internal::FileOpener f(filename.c_str(), "wb");
     if (!check(f.f != nullptr, "File %s could not be opened for writing\n", filename.c_str())) return false;
-    fprintf(f.f, "P5\n%d %d\n%d\n", im.width(), im.height(), (1<<bit_depth)-1);
-    int width = im.width(), height = im.height();
-
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height);
-        uint8_t *p = &data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                Internal::convert(im(x, y, channel), *p++);
-            }
-        }
-        if (!check(fwrite((void *) &data[0], sizeof(uint8_t), width*height, f.f) == (size_t) (width*height), "Could not write PGM 8-bit data\n")) return false;
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height);
-        uint16_t *p = &data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint16_t value;
-                Internal::convert(im(x, y, channel), value);
-                Internal::swap_endian_16(little_endian, value);
-                *p++ = value;
-            }
-        }
-        if (!check(fwrite((void *) &data[0], sizeof(uint16_t), width*height, f.f) == (size_t) (width*height), "Could not write PGM 16-bit data\n")) return false;
+    std::vector<uint8_t> header(Internal::raw_data_alignment, 0);
+    memcpy(&header[0], &h, sizeof(h));
+    if (!check(fwrite(&header[0], 1, header.size(), f.f) == header.size(), "Could not write raw image header\n")) return false;
+
+    const uint8_t *src = (const uint8_t *)im.data();
+    int rows = extent[1] * extent[2] * extent[3];
+    size_t row_bytes = (size_t)extent[0] * sizeof(T);
+    bool ok;
+    if (dense) {
+        ok = fwrite(src, row_bytes, rows, f.f) == (size_t)rows;
     } else {
-        return check(false, "We only support saving 8- and 16-bit images.");
+        ok = Internal::write_rows(f.f, rows, row_bytes, [&](uint8_t *out, int begin, int end) {
+            for (int r = begin; r < end; r++, out += row_bytes) {
+                Internal::copy_rows(src, src_stride, out, row_stride, extent, sizeof(T), r, r + 1);
+            }
+        });
     }
-    return true;
+    return check(ok, "Could not write raw image data\n");
 }
 
-template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool load_ppm(const std::string &filename, ImageType *im) {
+// An image whose pixels are read straight out of a private memory
+// mapping of a file by load_mapped, without being copied or
+// converted. Pages are only read from disk when they are first
+// touched, and writes to the pixels are not written back to the file.
+class MappedImage {
+    std::shared_ptr<Internal::MappedFile> file;
+    buffer_t buf;
+    halide_type_t elem_type;
 
-    /* open file and test for it being a ppm */
-    Internal::FileOpener f(filename.c_str(), "rb");
-    if (!check(f.f != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
+public:
+    MappedImage() : buf() {}
 
-    int width, height, maxval;
-    char header[256];
-    char buf[1024];
-    bool fmt_binary = false;
+    MappedImage(std::shared_ptr<Internal::MappedFile> file, const buffer_t &buf, halide_type_t type) :
+        file(file), buf(buf), elem_type(type) {}
 
-    f.readLine(buf, 1024);
-    if (!check(sscanf(buf, "%255s", header) == 1, "Could not read PPM header\n")) return false;
-    if (header == std::string("P6") || header == std::string("p6"))
-        fmt_binary = true;
-    if (!check(fmt_binary, "Input is not binary PPM\n")) return false;
+    bool defined() const {
+        return file != nullptr;
+    }
 
-    f.readLine(buf, 1024);
-    if (!check(sscanf(buf, "%d %d\n", &width, &height) == 2, "Could not read PPM width and height\n")) return false;
-    f.readLine(buf, 1024);
-    if (!check(sscanf(buf, "%d", &maxval) == 1, "Could not read PPM max value\n")) return false;
+    halide_type_t type() const {
+        return elem_type;
+    }
 
-    int bit_depth = 0;
-    if (maxval == 255) { bit_depth = 8; }
-    else if (maxval == 65535) { bit_depth = 16; }
-    else if (!check(false, "Invalid bit depth in PPM\n")) { return false; }
+    buffer_t *raw_buffer() {
+        return &buf;
+    }
 
-    int channels = 3;
-    *im = ImageType(width, height, channels);
+    operator buffer_t *() {
+        return &buf;
+    }
 
-    // convert the data to ImageType::ElemType
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height*3);
-        if (!check(fread((void *) &data[0], sizeof(uint8_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not read PPM 8-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        uint8_t *row = &data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                Internal::convert(*row++, im_data[(0*height+y)*width+x]);
-                Internal::convert(*row++, im_data[(1*height+y)*width+x]);
-                Internal::convert(*row++, im_data[(2*height+y)*width+x]);
-            }
-        }
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height*3);
-        if (!check(fread((void *) &data[0], sizeof(uint16_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not read PPM 16-bit data\n")) return false;
-        typename ImageType::ElemType *im_data = (typename ImageType::ElemType*) im->data();
-        uint16_t *row = &data[0];
-        for (int y = 0; y < height; y++) {
-            for (int x = 0; x < width; x++) {
-                uint16_t value;
-                value = *row++;
-                Internal::swap_endian_16(little_endian, value);
-                Internal::convert(value, im_data[(0*height+y)*width+x]);
-                value = *row++;
-                Internal::swap_endian_16(little_endian, value);
-                Internal::convert(value, im_data[(1*height+y)*width+x]);
-                value = *row++;
-                Internal::swap_endian_16(little_endian, value);
-                Internal::convert(value, im_data[(2*height+y)*width+x]);
+    template<typename T>
+    T *data() const {
+        return (T *)buf.host;
+    }
+
+    int dimensions() const {
+        for (int i = 0; i < 4; i++) {
+            if (buf.extent[i] == 0) {
+                return i;
             }
         }
+        return 4;
     }
-    (*im)(0,0,0) = (*im)(0,0,0);      /* Mark dirty inside read/write functions. */
 
-    return true;
-}
+    int width() const {
+        return dimensions() > 0 ? buf.extent[0] : 1;
+    }
 
-// "im" is not const-ref because copy_to_host() is not const.
-template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
-bool save_ppm(ImageType &im, const std::string &filename) {
-    im.copy_to_host();
+    int height() const {
+        return dimensions() > 1 ? buf.extent[1] : 1;
+    }
 
-    unsigned int bit_depth = sizeof(typename ImageType::ElemType) == 1 ? 8: 16;
+    int channels() const {
+        return dimensions() > 2 ? buf.extent[2] : 1;
+    }
 
-    Internal::FileOpener f(filename.c_str(), "wb");
-    if (!check(f.f != nullptr, "File %s could not be opened for writing\n", filename.c_str())) return false;
-    fprintf(f.f, "P6\n%d %d\n%d\n", im.width(), im.height(), (1<<bit_depth)-1);
-    int width = im.width(), height = im.height(), channels = im.channels();
+    int min(int dim) const {
+        return buf.min[dim];
+    }
 
-    if (bit_depth == 8) {
-        std::vector<uint8_t> data(width*height*3);
-        uint8_t *p = &data[0];
-        // unroll inner loop for 3 channel RGB (common case)
-        if (channels == 3) {
-            for (int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    Internal::convert(im(x, y, 0), *p++);
-                    Internal::convert(im(x, y, 1), *p++);
-                    Internal::convert(im(x, y, 2), *p++);
-                }
-            }
-        } else {
-            for (int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    for (int c = 0; c < channels; c++) {
-                        Internal::convert(im(x, y, c), *p++);
-                    }
-                }
-            }
+    int extent(int dim) const {
+        return buf.extent[dim];
+    }
+
+    int stride(int dim) const {
+        return buf.stride[dim];
+    }
+
+    // Wrap the pixels in a Halide::Image<T> or Halide::Tools::Image<T>
+    // without copying them. Returns an undefined image if T is not
+    // the element type of the file. The MappedImage must outlive the
+    // result.
+    template<typename ImageType>
+    ImageType image() const {
+        halide_type_t t = Internal::raw_type<typename ImageType::ElemType>();
+        if (!defined() || t.code != elem_type.code || t.bits != elem_type.bits) {
+            return ImageType();
         }
-        if (!check(fwrite((void *) &data[0], sizeof(uint8_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not write PPM 8-bit data\n")) return false;
-    } else if (bit_depth == 16) {
-        int little_endian = Internal::is_little_endian();
-        std::vector<uint16_t> data(width*height*3);
-        uint16_t *p = &data[0];
-        // unroll inner loop for 3 channel RGB (common case)
-        if (channels == 3) {
-            for (int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    uint16_t value0, value1, value2;
-                    Internal::convert(im(x, y, 0), value0);
-                    Internal::swap_endian_16(little_endian, value0);
-                    *p++ = value0;
-                    Internal::convert(im(x, y, 1), value1);
-                    Internal::swap_endian_16(little_endian, value1);
-                    *p++ = value1;
-                    Internal::convert(im(x, y, 2), value2);
-                    Internal::swap_endian_16(little_endian, value2);
-                    *p++ = value2;
-                }
-            }
-        } else {
-            for (int y = 0; y < height; y++) {
-                for (int x = 0; x < width; x++) {
-                    for (int c = 0; c < channels; c++) {
-                        uint16_t value;
-                        Internal::convert(im(x, y, c), value);
-                        Internal::swap_endian_16(little_endian, value);
-                        *p++ = value;
-                    }
+        return ImageType(&buf);
+    }
+};
+
+// Map a .pgm, .ppm or .hraw file into memory, and describe its pixels
+// in place. PGM and PPM files give uint8 or uint16 images of width x
+// height, or width x height x 3 with the channels interleaved;
+// 16-bit samples are byte-swapped in place on little-endian
+// machines, which reads the whole file. .hraw files keep the type,
+// mins and strides they were saved with. The pixels have whatever
+// alignment their offset in the file gives them.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+bool load_mapped(const std::string &filename, MappedImage *im) {
+    std::shared_ptr<Internal::MappedFile> f(new Internal::MappedFile(filename.c_str()));
+    if (!check(f->data != nullptr, "File %s could not be opened for reading\n", filename.c_str())) return false;
+    buffer_t buf;
+    halide_type_t type;
+    bool is_pgm = Internal::ends_with_ignore_case(filename, ".pgm");
+    if (is_pgm || Internal::ends_with_ignore_case(filename, ".ppm")) {
+        int bit_depth;
+        if (!Internal::parse_pnm<check>(*f, is_pgm ? "PGM" : "PPM", &buf, &bit_depth)) return false;
+        type = halide_type_t(halide_type_uint, bit_depth);
+        if (bit_depth == 16 && Internal::is_little_endian()) {
+            size_t row_bytes = (size_t)buf.stride[1] * 2;
+            Internal::parallel_for(buf.extent[1], buf.extent[1] * row_bytes, [&](int begin, int end) {
+                uint8_t *p = buf.host + begin * row_bytes;
+                for (size_t i = 0; i < (end - begin) * row_bytes; i += 2) {
+                    std::swap(p[i], p[i + 1]);
                 }
-            }
+            });
         }
-        if (!check(fwrite((void *) &data[0], sizeof(uint16_t), width*height*3, f.f) == (size_t) (width*height*3), "Could not write PPM 16-bit data\n")) return false;
+    } else if (Internal::ends_with_ignore_case(filename, ".hraw")) {
+        if (!Internal::parse_raw<check>(*f, &buf, &type)) return false;
     } else {
-        return check(false, "We only support saving 8- and 16-bit images.");
+        return check(false, "[load_mapped] unsupported file extension (pgm|ppm|hraw supported)");
     }
+    *im = MappedImage(f, buf, type);
     return true;
 }
 
@@ -589,8 +936,10 @@ bool load(const std::string &filename, ImageType *im) {
         return load_pgm<ImageType, check>(filename, im);
     } else if (Internal::ends_with_ignore_case(filename, ".ppm")) {
         return load_ppm<ImageType, check>(filename, im);
+    } else if (Internal::ends_with_ignore_case(filename, ".hraw")) {
+        return load_raw<ImageType, check>(filename, im);
     } else {
-        return check(false, "[load] unsupported file extension (png|pgm|ppm supported)");
+        return check(false, "[load] unsupported file extension (png|pgm|ppm|hraw supported)");
     }
 }
 // Returns false upon failure.
@@ -602,8 +951,10 @@ bool save(ImageType &im, const std::string &filename) {
         return save_pgm<ImageType, check>(im, filename);
     } else if (Internal::ends_with_ignore_case(filename, ".ppm")) {
         return save_ppm<ImageType, check>(im, filename);
+    } else if (Internal::ends_with_ignore_case(filename, ".hraw")) {
+        return save_raw<ImageType, check>(im, filename);
     } else {
-        return check(false, "[save] unsupported file extension (png|pgm|ppm supported)");
+        return check(false, "[save] unsupported file extension (png|pgm|ppm|hraw supported)");
     }
 }
 
@@ -636,6 +987,19 @@ void save_image(ImageType &im, const std::string &filename) {
     (void) save<ImageType, Internal::CheckFail>(im, filename);
 }
 
+// Fancy wrapper to call load_mapped() with CheckFail; this allows you
+// to simply use
+//
+//    MappedImage mapped = load_mapped_image("filename");
+//    Image<uint8_t> im = mapped.image<Image<uint8_t>>();
+//
+// without bothering to check error results (all errors simply abort).
+inline MappedImage load_mapped_image(const std::string &filename) {
+    MappedImage im;
+    (void) load_mapped<Internal::CheckFail>(filename, &im);
+    return im;
+}
+
 }  // namespace Tools
 }  // namespace Halide
 
@@ -0,0 +1,592 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <map>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#ifdef _MSC_VER
+#include <io.h>
+typedef int64_t ssize_t;
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+using std::map;
+using std::vector;
+using std::string;
+
+// The first 48 bytes of a tracing packet are metadata
+const int packet_header_size = 48;
+
+// A struct representing a single Halide tracing packet. See
+// src/runtime/tracing.cpp for the writer.
+struct Packet {
+    uint32_t id, parent;
+    uint8_t event, type, bits, width, value_idx, num_int_args;
+    char name[packet_header_size - 14];
+    uint8_t payload[4096 - packet_header_size]; // Not all of this will be used, but this is the max possible packet size.
+
+    size_t value_bytes() const {
+        size_t bytes_per_elem = 1;
+        while (bytes_per_elem*8 < bits) bytes_per_elem <<= 1;
+        return bytes_per_elem * width;
+    }
+
+    size_t int_args_bytes() const {
+        return sizeof(int) * num_int_args;
+    }
+
+    size_t payload_bytes() const {
+        return value_bytes() + int_args_bytes();
+    }
+
+    int get_int_arg(int idx) const {
+        return ((const int *)(payload + value_bytes()))[idx];
+    }
+
+    // Grab a packet from stdin. Returns false when stdin closes.
+    bool read_from_stdin() {
+        if (!read_stdin(this, packet_header_size)) {
+            return false;
+        }
+        if (!read_stdin(payload, payload_bytes())) {
+            fprintf(stderr, "Unexpected EOF mid-packet");
+        }
+        name[sizeof(name)-1] = 0;
+        return true;
+    }
+
+private:
+    // Do a blocking read of some number of bytes from stdin.
+    bool read_stdin(void *d, ssize_t size) {
+        uint8_t *dst = (uint8_t *)d;
+        if (!size) return true;
+        for (;;) {
+            ssize_t s = read(0, dst, size);
+            if (s == 0) {
+                // EOF
+                return false;
+            } else if (s < 0) {
+                perror("Failed during read");
+                exit(-1);
+                return 0;
+            } else if (s == size) {
+                return true;
+            }
+            size -= s;
+            dst += s;
+        }
+    }
+};
+
+uint64_t hash_combine(uint64_t h, uint64_t x) {
+    // The finalizer from MurmurHash3, applied to each word mixed in.
+    h ^= x + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Estimates the number of distinct hashes added to it in a fixed
+// amount of memory (HyperLogLog).
+class DistinctCounter {
+    static const int log_buckets = 10;
+    uint8_t buckets[1 << log_buckets];
+
+public:
+    DistinctCounter() {
+        clear();
+    }
+
+    void clear() {
+        memset(buckets, 0, sizeof(buckets));
+    }
+
+    void add(uint64_t h) {
+        int b = (int)(h >> (64 - log_buckets));
+        uint64_t rest = (h << log_buckets) | (1ULL << (log_buckets - 1));
+        uint8_t rank = 1;
+        while (!(rest & (1ULL << 63))) {
+            rest <<= 1;
+            rank++;
+        }
+        buckets[b] = std::max(buckets[b], rank);
+    }
+
+    double estimate() const {
+        const int m = 1 << log_buckets;
+        double sum = 0;
+        int zeros = 0;
+        for (int i = 0; i < m; i++) {
+            sum += ldexp(1.0, -buckets[i]);
+            if (buckets[i] == 0) zeros++;
+        }
+        double e = (0.7213 / (1 + 1.079 / m)) * m * m / sum;
+        if (e < 2.5 * m && zeros) {
+            // Small range correction.
+            e = m * log((double)m / zeros);
+        }
+        return e;
+    }
+};
+
+// A simulated fully-associative LRU cache of unbounded size, which
+// reports the reuse distance (the number of distinct lines touched
+// since the last access) of each access. To bound memory, only lines
+// whose hash falls below a threshold are tracked (spatial sampling);
+// when more than max_lines are tracked, the threshold is halved and
+// the lines above it are dropped. Distances measured on the sample
+// are scaled up by the sampling rate.
+class ReuseDistance {
+    // Position in time of the last access to each tracked line, and
+    // a Fenwick tree with a one at the last access to each line, so
+    // that the number of lines touched since a given time is a
+    // prefix sum.
+    std::unordered_map<uint64_t, uint32_t> last_access;
+    vector<uint32_t> tree;
+    uint32_t now;
+    size_t max_lines;
+    uint64_t threshold;
+
+    void update(uint32_t t, int delta) {
+        for (t++; t < tree.size(); t += t & (~t + 1)) {
+            tree[t] += delta;
+        }
+    }
+
+    uint32_t count_up_to(uint32_t t) const {
+        uint32_t result = 0;
+        for (t++; t > 0; t -= t & (~t + 1)) {
+            result += tree[t];
+        }
+        return result;
+    }
+
+    // Renumber the live entries densely from zero, once the clock
+    // reaches the end of the tree.
+    void compact() {
+        vector<std::pair<uint32_t, uint64_t>> live;
+        live.reserve(last_access.size());
+        for (const auto &e : last_access) {
+            live.push_back({e.second, e.first});
+        }
+        std::sort(live.begin(), live.end());
+        std::fill(tree.begin(), tree.end(), 0);
+        now = 0;
+        for (const auto &e : live) {
+            last_access[e.second] = now;
+            update(now, 1);
+            now++;
+        }
+    }
+
+public:
+    ReuseDistance(size_t max_lines) :
+        tree(4 * max_lines + 1, 0), now(0), max_lines(max_lines), threshold(1ULL << 32) {}
+
+    // The fraction of lines that are tracked.
+    double sampling_rate() const {
+        return (double)threshold / (1ULL << 32);
+    }
+
+    bool sampled(uint64_t h) const {
+        return (h >> 32) < threshold;
+    }
+
+    // Record an access to a line, which must be sampled. Returns the
+    // estimated reuse distance in lines, or -1 if this is the first
+    // access to it.
+    double access(uint64_t h) {
+        if (now + 1 >= tree.size()) {
+            compact();
+        }
+        double distance = -1;
+        auto it = last_access.find(h);
+        if (it != last_access.end()) {
+            distance = (count_up_to(now) - count_up_to(it->second)) / sampling_rate();
+            update(it->second, -1);
+            it->second = now;
+        } else {
+            last_access[h] = now;
+        }
+        update(now, 1);
+        now++;
+
+        while (last_access.size() > max_lines) {
+            threshold /= 2;
+            for (auto i = last_access.begin(); i != last_access.end(); ) {
+                if (!sampled(i->first)) {
+                    update(i->second, -1);
+                    i = last_access.erase(i);
+                } else {
+                    ++i;
+                }
+            }
+        }
+        return distance;
+    }
+};
+
+// A size in bytes, optionally suffixed with K, M or G.
+bool parse_size(const char *str, uint64_t *result) {
+    char *end;
+    double size = strtod(str, &end);
+    switch (*end) {
+    case 'k': case 'K':
+        size *= 1024; end++; break;
+    case 'm': case 'M':
+        size *= 1024 * 1024; end++; break;
+    case 'g': case 'G':
+        size *= 1024 * 1024 * 1024; end++; break;
+    }
+    if (*end || end == str || size <= 0) {
+        return false;
+    }
+    *result = (uint64_t)size;
+    return true;
+}
+
+string format_size(double bytes) {
+    const char *suffixes[] = {"B", "KB", "MB", "GB", "TB"};
+    int i = 0;
+    while (bytes >= 1024 && i < 4) {
+        bytes /= 1024;
+        i++;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), i == 0 ? "%.0f %s" : "%.1f %s", bytes, suffixes[i]);
+    return buf;
+}
+
+// The number of reuse distance buckets. Bucket 0 holds distances
+// below one line, and bucket i distances in [2^(i-1), 2^i) lines.
+const int num_distance_buckets = 48;
+
+// Statistics gathered about one Func.
+struct FuncStats {
+    string qualified_name;
+    size_t first_packet_idx = 0;
+    uint64_t loads = 0, stores = 0;
+    int num_realizations = 0, num_productions = 0;
+
+    // The distinct sites stored to and lines touched.
+    DistinctCounter sites_stored, lines_touched;
+
+    // Over the sampled accesses: the number of accesses, those that
+    // were first touches, the reuse distance histogram, and the
+    // misses at each cache size.
+    uint64_t sampled = 0, cold = 0;
+    uint64_t distances[num_distance_buckets] = {0};
+    vector<uint64_t> misses;
+
+    void report(const vector<uint64_t> &cache_sizes, uint64_t line_size) const {
+        printf("Func %s:\n"
+               " number of realizations: %d\n"
+               " number of productions: %d\n"
+               " number of loads: %llu\n"
+               " number of stores: %llu\n",
+               qualified_name.c_str(), num_realizations, num_productions,
+               (unsigned long long)loads, (unsigned long long)stores);
+        if (stores) {
+            double distinct = std::max(1.0, std::min((double)stores, sites_stored.estimate()));
+            printf(" distinct sites stored: %.0f (each computed %.2f times on average)\n",
+                   distinct, stores / distinct);
+        }
+        printf(" footprint: %s\n", format_size(lines_touched.estimate() * line_size).c_str());
+        if (!sampled) {
+            return;
+        }
+        printf(" reuse distance (%llu sampled accesses):\n", (unsigned long long)sampled);
+        printf("   first touch: %5.1f%%\n", 100.0 * cold / sampled);
+        for (int i = 0; i < num_distance_buckets; i++) {
+            if (!distances[i]) continue;
+            double lo = i == 0 ? 0 : ldexp((double)line_size, i - 1);
+            printf("   %9s - %-9s %5.1f%%\n", format_size(lo).c_str(),
+                   format_size(ldexp((double)line_size, i)).c_str(),
+                   100.0 * distances[i] / sampled);
+        }
+        for (size_t i = 0; i < cache_sizes.size(); i++) {
+            printf(" miss rate with a %s cache: %.1f%%\n",
+                   format_size((double)cache_sizes[i]).c_str(), 100.0 * misses[i] / sampled);
+        }
+    }
+};
+
+void usage() {
+    fprintf(stderr,
+            "\n"
+            "HalideTraceStats accepts Halide-generated binary tracing packets\n"
+            "from stdin, and prints statistics about the locality of the loads\n"
+            "and stores to each traced Func to stdout. It runs in bounded\n"
+            "memory, so it can be used on traces too large to store.\n"
+            "\n"
+            "E.g.:\n"
+            " HL_TRACE=2 <command to make pipeline> && \\\n"
+            " HL_TRACE_FILE=/dev/stdout <command to run pipeline> | \\\n"
+            " HalideTraceStats -c 32K,256K,8M\n"
+            "\n"
+            "For each Func it reports the number of loads and stores, how many\n"
+            "times each site was computed on average (more than one means\n"
+            "redundant recompute), the Func's footprint, a histogram of the\n"
+            "LRU reuse distance of accesses to it, and the miss rates of\n"
+            "fully-associative LRU caches of the given sizes. It also reports\n"
+            "the working set of the whole pipeline over time.\n"
+            "\n"
+            "Memory addresses aren't traced, so each Func is assumed to be\n"
+            "stored densely with its first dimension innermost, and each\n"
+            "realization of a Func is assumed to reuse the same memory.\n"
+            "\n"
+            "The arguments to HalideTraceStats are: \n"
+            " -c sizes: A comma-separated list of cache sizes to simulate, with\n"
+            "    optional K, M, or G suffixes. Defaults to 32K,256K,8M.\n"
+            "\n"
+            " -l line size: The size of a cache line in bytes. Defaults to 64.\n"
+            "\n"
+            " -w window: The number of accesses over which to measure each\n"
+            "    working set. Defaults to 1000000.\n"
+            "\n"
+            " -m max lines: The maximum number of cache lines to track when\n"
+            "    computing reuse distances. Beyond this, lines are sampled.\n"
+            "    Defaults to 1000000, which uses about 100MB.\n"
+            "\n"
+            " -v: Print the working set of every window, not just a summary.\n"
+        );
+}
+
+int run(int argc, char **argv) {
+    static_assert(sizeof(Packet) == 4096, "");
+
+    vector<uint64_t> cache_sizes = {32 * 1024, 256 * 1024, 8 * 1024 * 1024};
+    uint64_t line_size = 64;
+    uint64_t window = 1000000;
+    uint64_t max_lines = 1000000;
+    bool verbose = false;
+
+    // Parse command line args
+    int i = 1;
+    while (i < argc) {
+        string next = argv[i];
+        if (next == "-c") {
+            if (i + 1 >= argc) {
+                usage();
+                return -1;
+            }
+            cache_sizes.clear();
+            string sizes = argv[++i];
+            size_t start = 0;
+            while (start <= sizes.size()) {
+                size_t end = std::min(sizes.find(',', start), sizes.size());
+                uint64_t size;
+                if (!parse_size(sizes.substr(start, end - start).c_str(), &size)) {
+                    usage();
+                    return -1;
+                }
+                cache_sizes.push_back(size);
+                start = end + 1;
+            }
+        } else if (next == "-l" || next == "-w" || next == "-m") {
+            uint64_t value;
+            if (i + 1 >= argc || !parse_size(argv[++i], &value)) {
+                usage();
+                return -1;
+            }
+            if (next == "-l") {
+                line_size = value;
+            } else if (next == "-w") {
+                window = value;
+            } else {
+                max_lines = value;
+            }
+        } else if (next == "-v") {
+            verbose = true;
+        } else {
+            usage();
+            return -1;
+        }
+        i++;
+    }
+
+    std::sort(cache_sizes.begin(), cache_sizes.end());
+
+    struct PipelineInfo {
+        string name;
+        uint32_t id;
+    };
+
+    map<uint32_t, PipelineInfo> pipeline_info;
+    map<string, FuncStats> func_stats;
+    // Small integer ids for each Func, to mix into the hash of the
+    // lines they touch.
+    map<string, uint64_t> func_ids;
+
+    ReuseDistance reuse(max_lines);
+
+    // The working set of each window of accesses.
+    DistinctCounter window_lines;
+    uint64_t accesses = 0;
+    vector<double> working_sets;
+
+    size_t packet_clock = 0;
+    Packet p;
+    while (p.read_from_stdin()) {
+        packet_clock++;
+
+        // It's a pipeline begin/end event
+        if (p.event == 8) {
+            pipeline_info[p.id] = {p.name, p.id};
+            continue;
+        } else if (p.event == 9) {
+            pipeline_info.erase(p.id);
+            continue;
+        }
+
+        PipelineInfo pipeline = pipeline_info[p.parent];
+
+        string qualified_name = pipeline.name + ":" + p.name;
+
+        FuncStats &fs = func_stats[qualified_name];
+        if (fs.first_packet_idx == 0) {
+            fs.first_packet_idx = packet_clock;
+            fs.qualified_name = qualified_name;
+            fs.misses.resize(cache_sizes.size(), 0);
+            func_ids.insert({qualified_name, func_ids.size()});
+        }
+
+        switch (p.event) {
+        case 0: // load
+        case 1: // store
+        {
+            if (p.event == 1) {
+                fs.stores += p.width;
+            } else {
+                fs.loads += p.width;
+            }
+            uint64_t func_id = func_ids[qualified_name];
+            int dims = p.num_int_args / p.width;
+            int64_t elem_size = (int64_t)(p.value_bytes() / p.width);
+            for (int lane = 0; lane < p.width; lane++) {
+                // The site identifies the value, the line the cache
+                // line it's assumed to be stored in.
+                uint64_t site = hash_combine(func_id, p.value_idx);
+                uint64_t line = site;
+                for (int d = 0; d < dims; d++) {
+                    int64_t coord = p.get_int_arg(d * p.width + lane);
+                    site = hash_combine(site, (uint64_t)coord);
+                    if (d == 0) {
+                        int64_t byte = coord * elem_size;
+                        coord = (byte >= 0 ? byte : byte - (int64_t)line_size + 1) / (int64_t)line_size;
+                    }
+                    line = hash_combine(line, (uint64_t)coord);
+                }
+                if (p.event == 1) {
+                    fs.sites_stored.add(site);
+                }
+                fs.lines_touched.add(line);
+                window_lines.add(line);
+                if (++accesses % window == 0) {
+                    working_sets.push_back(window_lines.estimate() * line_size);
+                    window_lines.clear();
+                }
+
+                if (reuse.sampled(line)) {
+                    double distance = reuse.access(line);
+                    fs.sampled++;
+                    if (distance < 0) {
+                        fs.cold++;
+                        for (size_t c = 0; c < cache_sizes.size(); c++) {
+                            fs.misses[c]++;
+                        }
+                    } else {
+                        int bucket = distance < 1 ? 0 : std::min(num_distance_buckets - 1, 1 + (int)log2(distance));
+                        fs.distances[bucket]++;
+                        for (size_t c = 0; c < cache_sizes.size(); c++) {
+                            if (distance * line_size >= cache_sizes[c]) {
+                                fs.misses[c]++;
+                            }
+                        }
+                    }
+                }
+            }
+            break;
+        }
+        case 2: // begin realization
+            fs.num_realizations++;
+            pipeline_info[p.id] = pipeline;
+            break;
+        case 3: // end realization
+            pipeline_info.erase(p.parent);
+            break;
+        case 4: // produce
+            pipeline_info[p.id] = pipeline;
+            fs.num_productions++;
+            break;
+        case 5: // update
+            break;
+        case 6: // consume
+            break;
+        case 7: // end consume
+            pipeline_info.erase(p.parent);
+            break;
+        default:
+            fprintf(stderr, "Unknown tracing event code: %d\n", p.event);
+            exit(-1);
+        }
+    }
+
+    if (accesses % window) {
+        working_sets.push_back(window_lines.estimate() * line_size);
+    }
+
+    printf("Total number of Funcs: %d\n", (int)func_stats.size());
+    printf("Total number of accesses: %llu\n", (unsigned long long)accesses);
+    printf("Reuse distances sampled at a rate of %g\n", reuse.sampling_rate());
+
+    if (!working_sets.empty()) {
+        double peak = 0, total = 0;
+        for (double w : working_sets) {
+            peak = std::max(peak, w);
+            total += w;
+        }
+        printf("Working set per %llu accesses: mean %s, peak %s\n",
+               (unsigned long long)window,
+               format_size(total / working_sets.size()).c_str(),
+               format_size(peak).c_str());
+        if (verbose) {
+            for (size_t w = 0; w < working_sets.size(); w++) {
+                printf(" %llu: %s\n", (unsigned long long)(w * window),
+                       format_size(working_sets[w]).c_str());
+            }
+        }
+    }
+
+    // Print stats about each Func in the order they first appear.
+    vector<const FuncStats *> funcs;
+    for (const auto &f : func_stats) {
+        funcs.push_back(&f.second);
+    }
+    std::sort(funcs.begin(), funcs.end(), [](const FuncStats *a, const FuncStats *b) {
+        return a->first_packet_idx < b->first_packet_idx;
+    });
+    for (const FuncStats *f : funcs) {
+        f->report(cache_sizes, line_size);
+    }
+
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    return run(argc, argv);
+}